@@ -59,6 +59,50 @@
 # define ABI_TYPE  uint32_t
 #endif
 
+/* When ATOMIC_MMU_LOOKUP has taken the address locks for an access that
+   the host cannot perform atomically, use plain loads and stores, which
+   need not be naturally aligned.  */
+#define ATOMIC_LOCKED_LD(P) ({                                          \
+        typeof(*(P)) val_;                                              \
+        memcpy(&val_, (P), sizeof(val_));                               \
+        val_;                                                           \
+    })
+
+#define ATOMIC_LOCKED_RMW(P, NEW, RET) ({                               \
+        typeof(*(P)) old_ = ATOMIC_LOCKED_LD(P), new_ = (NEW);          \
+        memcpy((P), &new_, sizeof(new_));                               \
+        RET;                                                            \
+    })
+
+#define ATOMIC_LOCKED_CMPXCHG(P, C, N) ({                               \
+        typeof(*(P)) cmp_ = (C), new_ = (N);                            \
+        typeof(*(P)) old_ = ATOMIC_LOCKED_LD(P);                        \
+        if (old_ == cmp_) {                                             \
+            memcpy((P), &new_, sizeof(new_));                           \
+        }                                                               \
+        old_;                                                           \
+    })
+
+#define ATOMIC_LOCKED_fetch_add(P, V)  ATOMIC_LOCKED_RMW(P, old_ + (V), old_)
+#define ATOMIC_LOCKED_fetch_and(P, V)  ATOMIC_LOCKED_RMW(P, old_ & (V), old_)
+#define ATOMIC_LOCKED_fetch_or(P, V)   ATOMIC_LOCKED_RMW(P, old_ | (V), old_)
+#define ATOMIC_LOCKED_fetch_xor(P, V)  ATOMIC_LOCKED_RMW(P, old_ ^ (V), old_)
+#define ATOMIC_LOCKED_add_fetch(P, V)  ATOMIC_LOCKED_RMW(P, old_ + (V), new_)
+#define ATOMIC_LOCKED_and_fetch(P, V)  ATOMIC_LOCKED_RMW(P, old_ & (V), new_)
+#define ATOMIC_LOCKED_or_fetch(P, V)   ATOMIC_LOCKED_RMW(P, old_ | (V), new_)
+#define ATOMIC_LOCKED_xor_fetch(P, V)  ATOMIC_LOCKED_RMW(P, old_ ^ (V), new_)
+
+#define ATOMIC_LD(P)                                                    \
+    (ATOMIC_MMU_LOCKED ? ATOMIC_LOCKED_LD(P) : atomic_read__nocheck(P))
+#define ATOMIC_CMPXCHG(P, C, N)                                         \
+    (ATOMIC_MMU_LOCKED ? ATOMIC_LOCKED_CMPXCHG(P, C, N)                 \
+     : atomic_cmpxchg__nocheck(P, C, N))
+#define ATOMIC_XCHG(P, V)                                               \
+    (ATOMIC_MMU_LOCKED ? ATOMIC_LOCKED_RMW(P, (V), old_)                \
+     : atomic_xchg__nocheck(P, V))
+#define ATOMIC_RMW(X, P, V)                                             \
+    (ATOMIC_MMU_LOCKED ? ATOMIC_LOCKED_##X(P, V) : atomic_##X(P, V))
+
 #define ATOMIC_TRACE_RMW do {                                           \
         uint8_t info = glue(trace_mem_build_info_no_se, MEND)(SHIFT, false); \
                                                                         \
@@ -103,7 +147,7 @@ ABI_TYPE ATOMIC_NAME(cmpxchg)(CPUArchState *env, target_ulong addr,
 #if DATA_SIZE == 16
     ret = atomic16_cmpxchg(haddr, cmpv, newv);
 #else
-    ret = atomic_cmpxchg__nocheck(haddr, cmpv, newv);
+    ret = ATOMIC_CMPXCHG(haddr, cmpv, newv);
 #endif
     ATOMIC_MMU_CLEANUP;
     return ret;
@@ -142,7 +186,7 @@ ABI_TYPE ATOMIC_NAME(xchg)(CPUArchState *env, target_ulong addr,
     DATA_TYPE ret;
 
     ATOMIC_TRACE_RMW;
-    ret = atomic_xchg__nocheck(haddr, val);
+    ret = ATOMIC_XCHG(haddr, val);
     ATOMIC_MMU_CLEANUP;
     return ret;
 }
@@ -156,7 +200,7 @@ ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, target_ulong addr,       \
     DATA_TYPE ret;                                                  \
                                                                     \
     ATOMIC_TRACE_RMW;                                               \
-    ret = atomic_##X(haddr, val);                                   \
+    ret = ATOMIC_RMW(X, haddr, val);                                \
     ATOMIC_MMU_CLEANUP;                                             \
     return ret;                                                     \
 }
@@ -189,10 +233,10 @@ ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, target_ulong addr,       \
                                                                     \
     ATOMIC_TRACE_RMW;                                               \
     smp_mb();                                                       \
-    cmp = atomic_read__nocheck(haddr);                              \
+    cmp = ATOMIC_LD(haddr);                                         \
     do {                                                            \
         old = cmp; new = FN(old, val);                              \
-        cmp = atomic_cmpxchg__nocheck(haddr, old, new);             \
+        cmp = ATOMIC_CMPXCHG(haddr, old, new);                      \
     } while (cmp != old);                                           \
     ATOMIC_MMU_CLEANUP;                                             \
     return RET;                                                     \
@@ -237,7 +281,7 @@ ABI_TYPE ATOMIC_NAME(cmpxchg)(CPUArchState *env, target_ulong addr,
 #if DATA_SIZE == 16
     ret = atomic16_cmpxchg(haddr, BSWAP(cmpv), BSWAP(newv));
 #else
-    ret = atomic_cmpxchg__nocheck(haddr, BSWAP(cmpv), BSWAP(newv));
+    ret = ATOMIC_CMPXCHG(haddr, BSWAP(cmpv), BSWAP(newv));
 #endif
     ATOMIC_MMU_CLEANUP;
     return BSWAP(ret);
@@ -277,7 +321,7 @@ ABI_TYPE ATOMIC_NAME(xchg)(CPUArchState *env, target_ulong addr,
     ABI_TYPE ret;
 
     ATOMIC_TRACE_RMW;
-    ret = atomic_xchg__nocheck(haddr, BSWAP(val));
+    ret = ATOMIC_XCHG(haddr, BSWAP(val));
     ATOMIC_MMU_CLEANUP;
     return BSWAP(ret);
 }
@@ -291,7 +335,7 @@ ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, target_ulong addr,       \
     DATA_TYPE ret;                                                  \
                                                                     \
     ATOMIC_TRACE_RMW;                                               \
-    ret = atomic_##X(haddr, BSWAP(val));                            \
+    ret = ATOMIC_RMW(X, haddr, BSWAP(val));                         \
     ATOMIC_MMU_CLEANUP;                                             \
     return BSWAP(ret);                                              \
 }
@@ -322,10 +366,10 @@ ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, target_ulong addr,       \
                                                                     \
     ATOMIC_TRACE_RMW;                                               \
     smp_mb();                                                       \
-    ldn = atomic_read__nocheck(haddr);                              \
+    ldn = ATOMIC_LD(haddr);                                         \
     do {                                                            \
         ldo = ldn; old = BSWAP(ldo); new = FN(old, val);            \
-        ldn = atomic_cmpxchg__nocheck(haddr, ldo, BSWAP(new));      \
+        ldn = ATOMIC_CMPXCHG(haddr, ldo, BSWAP(new));               \
     } while (ldo != ldn);                                           \
     ATOMIC_MMU_CLEANUP;                                             \
     return RET;                                                     \
@@ -359,6 +403,22 @@ GEN_ATOMIC_HELPER_FN(add_fetch, ADD, DATA_TYPE, new)
 #undef ATOMIC_TRACE_LD
 #undef ATOMIC_TRACE_RMW
 
+#undef ATOMIC_LD
+#undef ATOMIC_CMPXCHG
+#undef ATOMIC_XCHG
+#undef ATOMIC_RMW
+#undef ATOMIC_LOCKED_LD
+#undef ATOMIC_LOCKED_RMW
+#undef ATOMIC_LOCKED_CMPXCHG
+#undef ATOMIC_LOCKED_fetch_add
+#undef ATOMIC_LOCKED_fetch_and
+#undef ATOMIC_LOCKED_fetch_or
+#undef ATOMIC_LOCKED_fetch_xor
+#undef ATOMIC_LOCKED_add_fetch
+#undef ATOMIC_LOCKED_and_fetch
+#undef ATOMIC_LOCKED_or_fetch
+#undef ATOMIC_LOCKED_xor_fetch
+
 #undef BSWAP
 #undef ABI_TYPE
 #undef DATA_TYPE
@@ -248,6 +248,8 @@ void cpu_exec_step_atomic(CPUState *cpu)
             mmap_unlock();
         }
 
+        trace_exec_step_atomic(cpu, pc);
+        atomic_set(&cpu->exclusive_steps, cpu->exclusive_steps + 1);
         start_exclusive();
 
         /* Since we got here, we know that parallel_cpus must be true.  */
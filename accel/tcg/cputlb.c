@@ -33,6 +33,7 @@
 #include "exec/helper-proto.h"
 #include "qemu/atomic.h"
 #include "qemu/atomic128.h"
+#include "fastmem.h"
 
 /* DEBUG defines, enable DEBUG_TLB_LOG to log to the CPU_LOG_MMU target */
 /* #define DEBUG_TLB */
@@ -74,11 +75,223 @@ QEMU_BUILD_BUG_ON(sizeof(target_ulong) > sizeof(run_on_cpu_data));
 QEMU_BUILD_BUG_ON(NB_MMU_MODES > 16);
 #define ALL_MMUIDX_BITS ((1 << NB_MMU_MODES) - 1)
 
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB
+static inline size_t sizeof_tlb(CPUArchState *env, uintptr_t mmu_idx)
+{
+    return env->tlb_mask[mmu_idx] + (1 << CPU_TLB_ENTRY_BITS);
+}
+
+static void tlb_window_reset(CPUTLBWindow *window, int64_t ns,
+                             size_t max_entries)
+{
+    window->begin_ns = ns;
+    window->max_entries = max_entries;
+}
+
+static void tlb_dyn_init(CPUArchState *env)
+{
+    int i;
+
+    for (i = 0; i < NB_MMU_MODES; i++) {
+        CPUTLBDesc *desc = &env->tlb_desc[i];
+        size_t n_entries = 1 << CPU_TLB_DYN_DEFAULT_BITS;
+
+        tlb_window_reset(&desc->window, get_clock_realtime(), 0);
+        desc->n_used_entries = 0;
+        env->tlb_mask[i] = (n_entries - 1) << CPU_TLB_ENTRY_BITS;
+        env->tlb_table[i] = g_new(CPUTLBEntry, n_entries);
+        env->iotlb[i] = g_new(CPUIOTLBEntry, n_entries);
+        memset(env->tlb_table[i], -1, sizeof_tlb(env, i));
+    }
+}
+
+static void tlb_dyn_destroy(CPUArchState *env)
+{
+    int i;
+
+    for (i = 0; i < NB_MMU_MODES; i++) {
+        g_free(env->tlb_table[i]);
+        g_free(env->iotlb[i]);
+        env->tlb_table[i] = NULL;
+        env->iotlb[i] = NULL;
+    }
+}
+
+/**
+ * tlb_mmu_resize_locked() - perform TLB resize bookkeeping; resize if necessary
+ * @env: CPU that owns the TLB
+ * @mmu_idx: MMU index of the TLB
+ *
+ * Called with tlb_lock held.
+ *
+ * We have two main constraints when resizing a TLB: (1) we only resize it
+ * on a TLB flush (otherwise we'd have to take a perf hit by either rehashing
+ * the array or unnecessarily flushing it), which means we do not control how
+ * frequently the resizing can occur; (2) we don't have access to the guest's
+ * future scheduling decisions, and therefore have to decide the magnitude of
+ * the resize based on past observations.
+ *
+ * In general, a memory-hungry process can benefit greatly from an appropriately
+ * sized TLB, since a guest TLB miss is very expensive. This doesn't mean that
+ * we just have to make the TLB as large as possible; while an oversized TLB
+ * results in minimal TLB miss rates, it also takes longer to be flushed
+ * (flushes can be _very_ frequent), and the reduced locality can also hurt
+ * performance.
+ *
+ * To achieve near-optimal performance for all kinds of workloads, we:
+ *
+ * 1. Aggressively increase the size of the TLB when the use rate of the
+ * TLB being flushed is high, since it is likely that in the near future this
+ * memory-hungry process will execute again, and its memory hungriness will
+ * probably be similar.
+ *
+ * 2. Slowly reduce the size of the TLB as the use rate declines over a
+ * reasonably large time window. The rationale is that if in such a time window
+ * we have not observed a high TLB use rate, it is likely that we won't observe
+ * it in the near future. In that case, once a time window expires we downsize
+ * the TLB to match the maximum use rate observed in the window.
+ *
+ * 3. Try to keep the maximum use rate in a time window in the 30-70% range,
+ * since in that range performance is likely near-optimal. Recall that the TLB
+ * is direct mapped, so we want the use rate to be low (or at least not too
+ * high), since otherwise we are likely to have a significant amount of
+ * conflict misses.
+ */
+static void tlb_mmu_resize_locked(CPUArchState *env, int mmu_idx)
+{
+    CPUTLBDesc *desc = &env->tlb_desc[mmu_idx];
+    size_t old_size = tlb_n_entries(env, mmu_idx);
+    size_t rate;
+    size_t new_size = old_size;
+    int64_t now = get_clock_realtime();
+    int64_t window_len_ms = 100;
+    int64_t window_len_ns = window_len_ms * 1000 * 1000;
+    bool window_expired = now > desc->window.begin_ns + window_len_ns;
+
+    if (desc->n_used_entries > desc->window.max_entries) {
+        desc->window.max_entries = desc->n_used_entries;
+    }
+    rate = desc->window.max_entries * 100 / old_size;
+
+    if (rate > 70) {
+        new_size = MIN(old_size << 1, 1 << CPU_TLB_DYN_MAX_BITS);
+    } else if (rate < 30 && window_expired) {
+        size_t ceil = pow2ceil(desc->window.max_entries);
+        size_t expected_rate = desc->window.max_entries * 100 / ceil;
+
+        /*
+         * Avoid undersizing when the max number of entries seen is just below
+         * a pow2. For instance, if max_entries == 1025, the expected use rate
+         * would be 1025/2048==50%. However, if max_entries == 1023, we'd get
+         * 1023/1024==99.9% use rate, so we'd likely end up doubling the size
+         * later. Thus, make sure that the expected use rate remains below 70%.
+         * (and since we double the size, that means the lowest rate we'd
+         * expect to get is 35%, which is still in the 30-70% range where
+         * we consider that the size is appropriate.)
+         */
+        if (expected_rate > 70) {
+            ceil *= 2;
+        }
+        new_size = MAX(ceil, 1 << CPU_TLB_DYN_MIN_BITS);
+    }
+
+    if (new_size == old_size) {
+        if (window_expired) {
+            tlb_window_reset(&desc->window, now, desc->n_used_entries);
+        }
+        return;
+    }
+
+    g_free(env->tlb_table[mmu_idx]);
+    g_free(env->iotlb[mmu_idx]);
+
+    tlb_window_reset(&desc->window, now, 0);
+    /* desc->n_used_entries is cleared by the caller */
+    env->tlb_mask[mmu_idx] = (new_size - 1) << CPU_TLB_ENTRY_BITS;
+    env->tlb_table[mmu_idx] = g_try_new(CPUTLBEntry, new_size);
+    env->iotlb[mmu_idx] = g_try_new(CPUIOTLBEntry, new_size);
+    /*
+     * If the allocations fail, try smaller sizes. We just freed some
+     * memory, so going back to half of new_size has a good chance of working.
+     * Increased memory pressure elsewhere in the system might cause the
+     * allocations to fail though, so we progressively reduce the allocation
+     * size, aborting if we cannot even allocate the smallest TLB we support.
+     */
+    while (env->tlb_table[mmu_idx] == NULL || env->iotlb[mmu_idx] == NULL) {
+        if (new_size == (1 << CPU_TLB_DYN_MIN_BITS)) {
+            error_report("%s: %s", __func__, strerror(errno));
+            abort();
+        }
+        new_size = MAX(new_size >> 1, 1 << CPU_TLB_DYN_MIN_BITS);
+        env->tlb_mask[mmu_idx] = (new_size - 1) << CPU_TLB_ENTRY_BITS;
+
+        g_free(env->tlb_table[mmu_idx]);
+        g_free(env->iotlb[mmu_idx]);
+        env->tlb_table[mmu_idx] = g_try_new(CPUTLBEntry, new_size);
+        env->iotlb[mmu_idx] = g_try_new(CPUIOTLBEntry, new_size);
+    }
+}
+
+static inline void tlb_table_flush_by_mmuidx(CPUArchState *env, int mmu_idx)
+{
+    tlb_mmu_resize_locked(env, mmu_idx);
+    memset(env->tlb_table[mmu_idx], -1, sizeof_tlb(env, mmu_idx));
+    env->tlb_desc[mmu_idx].n_used_entries = 0;
+}
+
+static inline void tlb_n_used_entries_inc(CPUArchState *env, uintptr_t mmu_idx)
+{
+    env->tlb_desc[mmu_idx].n_used_entries++;
+}
+
+static inline void tlb_n_used_entries_dec(CPUArchState *env, uintptr_t mmu_idx)
+{
+    env->tlb_desc[mmu_idx].n_used_entries--;
+}
+
+#else /* !TCG_TARGET_IMPLEMENTS_DYN_TLB */
+
+static inline void tlb_dyn_init(CPUArchState *env)
+{
+}
+
+static inline void tlb_dyn_destroy(CPUArchState *env)
+{
+}
+
+static inline void tlb_table_flush_by_mmuidx(CPUArchState *env, int mmu_idx)
+{
+    memset(env->tlb_table[mmu_idx], -1, sizeof(env->tlb_table[0]));
+}
+
+static inline void tlb_n_used_entries_inc(CPUArchState *env, uintptr_t mmu_idx)
+{
+}
+
+static inline void tlb_n_used_entries_dec(CPUArchState *env, uintptr_t mmu_idx)
+{
+}
+#endif /* TCG_TARGET_IMPLEMENTS_DYN_TLB */
+
 void tlb_init(CPUState *cpu)
 {
     CPUArchState *env = cpu->env_ptr;
 
     qemu_spin_init(&env->tlb_lock);
+    tlb_dyn_init(env);
+    if (tcg_fastmem) {
+        fastmem_init_cpu(cpu);
+    }
+}
+
+void tlb_destroy(CPUState *cpu)
+{
+    CPUArchState *env = cpu->env_ptr;
+
+    if (tcg_fastmem) {
+        fastmem_destroy_cpu(cpu);
+    }
+    tlb_dyn_destroy(env);
 }
 
 /* flush_all_helper: run fn across all cpus
@@ -121,6 +334,7 @@ size_t tlb_flush_count(void)
 static void tlb_flush_nocheck(CPUState *cpu)
 {
     CPUArchState *env = cpu->env_ptr;
+    int mmu_idx;
 
     /* The QOM tests will trigger tlb_flushes without setting up TCG
      * so we bug out here in that case.
@@ -140,7 +354,10 @@ static void tlb_flush_nocheck(CPUState *cpu)
      * that do not hold the lock are performed by the same owner thread.
      */
     qemu_spin_lock(&env->tlb_lock);
-    memset(env->tlb_table, -1, sizeof(env->tlb_table));
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        tlb_table_flush_by_mmuidx(env, mmu_idx);
+        fastmem_unmap_all(env, mmu_idx);
+    }
     memset(env->tlb_v_table, -1, sizeof(env->tlb_v_table));
     qemu_spin_unlock(&env->tlb_lock);
 
@@ -201,8 +418,9 @@ static void tlb_flush_by_mmuidx_async_work(CPUState *cpu, run_on_cpu_data data)
         if (test_bit(mmu_idx, &mmu_idx_bitmask)) {
             tlb_debug("%d\n", mmu_idx);
 
-            memset(env->tlb_table[mmu_idx], -1, sizeof(env->tlb_table[0]));
+            tlb_table_flush_by_mmuidx(env, mmu_idx);
             memset(env->tlb_v_table[mmu_idx], -1, sizeof(env->tlb_v_table[0]));
+            fastmem_unmap_all(env, mmu_idx);
         }
     }
     qemu_spin_unlock(&env->tlb_lock);
@@ -262,24 +480,53 @@ static inline bool tlb_hit_page_anyprot(CPUTLBEntry *tlb_entry,
            tlb_hit_page(tlb_entry->addr_code, page);
 }
 
+/**
+ * tlb_entry_is_empty - return true if the entry is not in use
+ * @te: pointer to CPUTLBEntry
+ */
+static inline bool tlb_entry_is_empty(const CPUTLBEntry *te)
+{
+    return te->addr_read == -1 && te->addr_write == -1 && te->addr_code == -1;
+}
+
 /* Called with tlb_lock held */
-static inline void tlb_flush_entry_locked(CPUTLBEntry *tlb_entry,
+static inline bool tlb_flush_entry_locked(CPUTLBEntry *tlb_entry,
                                           target_ulong page)
 {
     if (tlb_hit_page_anyprot(tlb_entry, page)) {
         memset(tlb_entry, -1, sizeof(*tlb_entry));
+        return true;
     }
+    return false;
 }
 
 /* Called with tlb_lock held */
-static inline void tlb_flush_vtlb_page_locked(CPUArchState *env, int mmu_idx,
+static inline bool tlb_flush_vtlb_page_locked(CPUArchState *env, int mmu_idx,
                                               target_ulong page)
 {
+    bool flushed = false;
     int k;
 
     assert_cpu_is_self(ENV_GET_CPU(env));
     for (k = 0; k < CPU_VTLB_SIZE; k++) {
-        tlb_flush_entry_locked(&env->tlb_v_table[mmu_idx][k], page);
+        flushed |= tlb_flush_entry_locked(&env->tlb_v_table[mmu_idx][k], page);
+    }
+    return flushed;
+}
+
+/* Called with tlb_lock held */
+static void tlb_flush_page_locked(CPUArchState *env, int mmu_idx,
+                                  target_ulong page)
+{
+    bool flushed = false;
+
+    if (tlb_flush_entry_locked(tlb_entry(env, mmu_idx, page), page)) {
+        tlb_n_used_entries_dec(env, mmu_idx);
+        flushed = true;
+    }
+    flushed |= tlb_flush_vtlb_page_locked(env, mmu_idx, page);
+    if (flushed) {
+        fastmem_unmap_page(env, mmu_idx, page);
     }
 }
 
@@ -306,8 +553,7 @@ static void tlb_flush_page_async_work(CPUState *cpu, run_on_cpu_data data)
     addr &= TARGET_PAGE_MASK;
     qemu_spin_lock(&env->tlb_lock);
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
-        tlb_flush_entry_locked(tlb_entry(env, mmu_idx, addr), addr);
-        tlb_flush_vtlb_page_locked(env, mmu_idx, addr);
+        tlb_flush_page_locked(env, mmu_idx, addr);
     }
     qemu_spin_unlock(&env->tlb_lock);
 
@@ -348,8 +594,7 @@ static void tlb_flush_page_by_mmuidx_async_work(CPUState *cpu,
     qemu_spin_lock(&env->tlb_lock);
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         if (test_bit(mmu_idx, &mmu_idx_bitmap)) {
-            tlb_flush_entry_locked(tlb_entry(env, mmu_idx, addr), addr);
-            tlb_flush_vtlb_page_locked(env, mmu_idx, addr);
+            tlb_flush_page_locked(env, mmu_idx, addr);
         }
     }
     qemu_spin_unlock(&env->tlb_lock);
@@ -479,9 +724,9 @@ void tlb_unprotect_code(ram_addr_t ram_addr)
  * te->addr_write with atomic_set. We don't need to worry about this for
  * oversized guests as MTTCG is disabled for them.
  *
- * Called with tlb_lock held.
+ * Called with tlb_lock held.  Returns true if the entry was changed.
  */
-static void tlb_reset_dirty_range_locked(CPUTLBEntry *tlb_entry,
+static bool tlb_reset_dirty_range_locked(CPUTLBEntry *tlb_entry,
                                          uintptr_t start, uintptr_t length)
 {
     uintptr_t addr = tlb_entry->addr_write;
@@ -496,8 +741,22 @@ static void tlb_reset_dirty_range_locked(CPUTLBEntry *tlb_entry,
             atomic_set(&tlb_entry->addr_write,
                        tlb_entry->addr_write | TLB_NOTDIRTY);
 #endif
+            return true;
         }
     }
+    return false;
+}
+
+/* Called with tlb_lock held */
+static void tlb_reset_dirty_locked(CPUArchState *env, int mmu_idx,
+                                   CPUTLBEntry *tlb_entry,
+                                   uintptr_t start, uintptr_t length)
+{
+    if (tlb_reset_dirty_range_locked(tlb_entry, start, length)) {
+        /* Write-protect the page in the fastmem window as well.  */
+        fastmem_map_page(env, mmu_idx,
+                         tlb_entry->addr_write & TARGET_PAGE_MASK, tlb_entry);
+    }
 }
 
 /*
@@ -524,26 +783,29 @@ void tlb_reset_dirty(CPUState *cpu, ram_addr_t start1, ram_addr_t length)
     qemu_spin_lock(&env->tlb_lock);
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         unsigned int i;
+        unsigned int n = tlb_n_entries(env, mmu_idx);
 
-        for (i = 0; i < CPU_TLB_SIZE; i++) {
-            tlb_reset_dirty_range_locked(&env->tlb_table[mmu_idx][i], start1,
-                                         length);
+        for (i = 0; i < n; i++) {
+            tlb_reset_dirty_locked(env, mmu_idx, &env->tlb_table[mmu_idx][i],
+                                   start1, length);
         }
 
         for (i = 0; i < CPU_VTLB_SIZE; i++) {
-            tlb_reset_dirty_range_locked(&env->tlb_v_table[mmu_idx][i], start1,
-                                         length);
+            tlb_reset_dirty_locked(env, mmu_idx, &env->tlb_v_table[mmu_idx][i],
+                                   start1, length);
         }
     }
     qemu_spin_unlock(&env->tlb_lock);
 }
 
 /* Called with tlb_lock held */
-static inline void tlb_set_dirty1_locked(CPUTLBEntry *tlb_entry,
+static inline void tlb_set_dirty1_locked(CPUArchState *env, int mmu_idx,
+                                         CPUTLBEntry *tlb_entry,
                                          target_ulong vaddr)
 {
     if (tlb_entry->addr_write == (vaddr | TLB_NOTDIRTY)) {
         tlb_entry->addr_write = vaddr;
+        fastmem_map_page(env, mmu_idx, vaddr, tlb_entry);
     }
 }
 
@@ -559,13 +821,15 @@ void tlb_set_dirty(CPUState *cpu, target_ulong vaddr)
     vaddr &= TARGET_PAGE_MASK;
     qemu_spin_lock(&env->tlb_lock);
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
-        tlb_set_dirty1_locked(tlb_entry(env, mmu_idx, vaddr), vaddr);
+        tlb_set_dirty1_locked(env, mmu_idx, tlb_entry(env, mmu_idx, vaddr),
+                              vaddr);
     }
 
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         int k;
         for (k = 0; k < CPU_VTLB_SIZE; k++) {
-            tlb_set_dirty1_locked(&env->tlb_v_table[mmu_idx][k], vaddr);
+            tlb_set_dirty1_locked(env, mmu_idx, &env->tlb_v_table[mmu_idx][k],
+                                  vaddr);
         }
     }
     qemu_spin_unlock(&env->tlb_lock);
@@ -678,14 +942,22 @@ void tlb_set_page_with_attrs(CPUState *cpu, target_ulong vaddr,
      * Only evict the old entry to the victim tlb if it's for a
      * different page; otherwise just overwrite the stale data.
      */
-    if (!tlb_hit_page_anyprot(te, vaddr_page)) {
+    if (!tlb_hit_page_anyprot(te, vaddr_page) && !tlb_entry_is_empty(te)) {
         unsigned vidx = env->vtlb_index++ % CPU_VTLB_SIZE;
         CPUTLBEntry *tv = &env->tlb_v_table[mmu_idx][vidx];
 
+        /* The entry that drops out of the victim tlb leaves fastmem too. */
+        if (!(tv->addr_read & ~TARGET_PAGE_MASK)) {
+            fastmem_unmap_page(env, mmu_idx, tv->addr_read);
+        }
+
         /* Evict the old entry into the victim tlb.  */
         copy_tlb_helper_locked(tv, te);
         env->iotlb_v[mmu_idx][vidx] = env->iotlb[mmu_idx][index];
     }
+    if (!tlb_entry_is_empty(te)) {
+        tlb_n_used_entries_dec(env, mmu_idx);
+    }
 
     /* refill the tlb */
     /*
@@ -736,6 +1008,8 @@ void tlb_set_page_with_attrs(CPUState *cpu, target_ulong vaddr,
     }
 
     copy_tlb_helper_locked(te, &tn);
+    tlb_n_used_entries_inc(env, mmu_idx);
+    fastmem_map_page(env, mmu_idx, vaddr_page, te);
     qemu_spin_unlock(&env->tlb_lock);
 }
 
@@ -921,6 +1195,9 @@ static bool victim_tlb_hit(CPUArchState *env, size_t mmu_idx, size_t index,
             copy_tlb_helper_locked(&tmptlb, tlb);
             copy_tlb_helper_locked(tlb, vtlb);
             copy_tlb_helper_locked(vtlb, &tmptlb);
+            if (tlb_entry_is_empty(&tmptlb)) {
+                tlb_n_used_entries_inc(env, mmu_idx);
+            }
             qemu_spin_unlock(&env->tlb_lock);
 
             CPUIOTLBEntry tmpio, *io = &env->iotlb[mmu_idx][index];
@@ -937,6 +1214,84 @@ static bool victim_tlb_hit(CPUArchState *env, size_t mmu_idx, size_t index,
   victim_tlb_hit(env, mmu_idx, index, offsetof(CPUTLBEntry, TY), \
                  (ADDR) & TARGET_PAGE_MASK)
 
+#if TCG_FASTMEM
+/*
+ * A store faulted on a RAM page that is only write-protected for dirty
+ * tracking.  If no TB was translated from the page, do what the slow path
+ * does for such a store: mark the page dirty, which lets tlb_set_dirty()
+ * make the window writable.  The whole page is marked, because later
+ * stores to it are no longer seen.  Return false if the page holds code.
+ * If the window still cannot map the page, the retried store faults again
+ * and takes the slow path then.
+ */
+static bool tlb_fastmem_set_dirty(CPUState *cpu, CPUTLBEntry *entry,
+                                  target_ulong addr)
+{
+    ram_addr_t ram_addr;
+
+    ram_addr = qemu_ram_addr_from_host_nofail((void *)((uintptr_t)addr +
+                                                       entry->addend));
+    if (!cpu_physical_memory_get_dirty_flag(ram_addr, DIRTY_MEMORY_CODE)) {
+        return false;
+    }
+    cpu_physical_memory_set_dirty_range(ram_addr & TARGET_PAGE_MASK,
+                                        TARGET_PAGE_SIZE,
+                                        DIRTY_CLIENTS_NOCODE);
+    if (!cpu_physical_memory_is_clean(ram_addr)) {
+        tlb_set_dirty(cpu, addr);
+    }
+    return true;
+}
+
+/*
+ * Called from the SIGSEGV handler when generated code faults at @addr in
+ * the fastmem window of @mmu_idx.  Usually the page is just not in the TLB
+ * yet: fill it, which maps the page in the window, and return so that the
+ * host retries the access.  A guest exception unwinds from tlb_fill() as
+ * it does for the slow path.  Stores to clean RAM pages are handled here
+ * too, see tlb_fastmem_set_dirty().  Anything else the window cannot map,
+ * such as MMIO or a store to a page that contains code, restarts the
+ * guest instruction in a TB that goes through the TLB.
+ */
+void tlb_fastmem_fault(CPUState *cpu, int mmu_idx, target_ulong addr,
+                       bool is_write, uintptr_t retaddr)
+{
+    CPUArchState *env = cpu->env_ptr;
+    uintptr_t index = tlb_index(env, mmu_idx, addr);
+    CPUTLBEntry *entry = tlb_entry(env, mmu_idx, addr);
+    int prot;
+
+    atomic_set(&cpu->fastmem_faults, cpu->fastmem_faults + 1);
+
+    if (is_write) {
+        if (!tlb_hit(tlb_addr_write(entry), addr) &&
+            !VICTIM_TLB_HIT(addr_write, addr)) {
+            tlb_fill(cpu, addr, 1, MMU_DATA_STORE, mmu_idx, retaddr);
+        }
+    } else {
+        if (!tlb_hit(entry->addr_read, addr) &&
+            !VICTIM_TLB_HIT(addr_read, addr)) {
+            tlb_fill(cpu, addr, 1, MMU_DATA_LOAD, mmu_idx, retaddr);
+        }
+    }
+
+    entry = tlb_entry(env, mmu_idx, addr);
+    if (is_write &&
+        tlb_addr_write(entry) == ((addr & TARGET_PAGE_MASK) | TLB_NOTDIRTY) &&
+        tlb_fastmem_set_dirty(cpu, entry, addr)) {
+        /* tlb_set_dirty() remapped the page; retry the store */
+        return;
+    }
+    qemu_spin_lock(&env->tlb_lock);
+    prot = fastmem_map_page(env, mmu_idx, addr & TARGET_PAGE_MASK, entry);
+    qemu_spin_unlock(&env->tlb_lock);
+
+    if (!(prot & (is_write ? PROT_WRITE : PROT_READ))) {
+        cpu_loop_exit_fastmem(cpu, retaddr);
+    }
+}
+#endif
+
 /* NOTE: this function can trigger an exception */
 /* NOTE2: the returned address is not exactly the physical address: it
  * is actually a ram_addr_t (in system mode; the user mode emulation
@@ -993,11 +1348,54 @@ void probe_write(CPUArchState *env, target_ulong addr, int size, int mmu_idx,
     }
 }
 
-/* Probe for a read-modify-write atomic operation.  Do not allow unaligned
- * operations, or io operations to proceed.  Return the host address.  */
+/* With tcg_atomic_locks, the atomic operations that the host cannot
+ * perform natively are serialized by a table of spinlocks.  Each lock
+ * covers the 8-byte granules of host memory that hash to it, and an
+ * operation takes the locks of all the granules that it touches, so
+ * that overlapping operations always share at least one lock.
+ */
+#define ATOMIC_LOCK_BITS    10
+#define ATOMIC_LOCK_GRAIN   3
+
+static QemuSpin atomic_locks[1 << ATOMIC_LOCK_BITS];
+
+typedef struct AtomicLocks {
+    QemuSpin *first;
+    QemuSpin *last;
+} AtomicLocks;
+
+static void atomic_locks_acquire(AtomicLocks *locks, void *haddr, int size)
+{
+    uintptr_t mask = (1 << ATOMIC_LOCK_BITS) - 1;
+    uintptr_t i = ((uintptr_t)haddr >> ATOMIC_LOCK_GRAIN) & mask;
+    uintptr_t j = ((uintptr_t)haddr + size - 1) >> ATOMIC_LOCK_GRAIN & mask;
+
+    /* Always lock in index order, so that we cannot deadlock.  */
+    locks->first = &atomic_locks[MIN(i, j)];
+    locks->last = &atomic_locks[MAX(i, j)];
+    qemu_spin_lock(locks->first);
+    if (locks->last != locks->first) {
+        qemu_spin_lock(locks->last);
+    }
+}
+
+static void atomic_locks_release(AtomicLocks *locks)
+{
+    if (locks->last != locks->first) {
+        qemu_spin_unlock(locks->last);
+    }
+    qemu_spin_unlock(locks->first);
+    /* The atomic helpers are full barriers.  */
+    smp_mb();
+}
+
+/* Probe for a read-modify-write atomic operation.  Do not allow io
+ * operations to proceed, nor unaligned operations unless they can be
+ * serialized with the atomic locks, in which case they are taken and
+ * LOCKS is filled in.  Return the host address.  */
 static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
                                TCGMemOpIdx oi, uintptr_t retaddr,
-                               NotDirtyInfo *ndi)
+                               NotDirtyInfo *ndi, AtomicLocks *locks)
 {
     size_t mmu_idx = get_mmuidx(oi);
     uintptr_t index = tlb_index(env, mmu_idx, addr);
@@ -1006,10 +1404,12 @@ static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
     TCGMemOp mop = get_memop(oi);
     int a_bits = get_alignment_bits(mop);
     int s_bits = mop & MO_SIZE;
+    bool need_locks = false;
     void *hostaddr;
 
     /* Adjust the given return address.  */
     retaddr -= GETPC_ADJ;
+    locks->first = NULL;
 
     /* Enforce guest required alignment.  */
     if (unlikely(a_bits > 0 && (addr & ((1 << a_bits) - 1)))) {
@@ -1022,9 +1422,14 @@ static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
     if (unlikely(addr & ((1 << s_bits) - 1))) {
         /* We get here if guest alignment was not requested,
            or was not enforced by cpu_unaligned_access above.
-           We might widen the access and emulate, but for now
-           mark an exception and exit the cpu loop.  */
-        goto stop_the_world;
+           Within a page, the access can be serialized with the
+           atomic locks.  Otherwise mark an exception and exit
+           the cpu loop.  */
+        if (!tcg_atomic_locks || s_bits > MO_64 ||
+            ((addr ^ (addr + (1 << s_bits) - 1)) & TARGET_PAGE_MASK)) {
+            goto stop_the_world;
+        }
+        need_locks = true;
     }
 
     /* Check TLB entry and enforce page permissions.  */
@@ -1063,6 +1468,9 @@ static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
                                       1 << s_bits);
     }
 
+    if (unlikely(need_locks)) {
+        atomic_locks_acquire(locks, hostaddr, 1 << s_bits);
+    }
     return hostaddr;
 
  stop_the_world:
@@ -1097,10 +1505,15 @@ static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
 #define EXTRA_ARGS     , TCGMemOpIdx oi, uintptr_t retaddr
 #define ATOMIC_NAME(X) \
     HELPER(glue(glue(glue(atomic_ ## X, SUFFIX), END), _mmu))
-#define ATOMIC_MMU_DECLS NotDirtyInfo ndi
-#define ATOMIC_MMU_LOOKUP atomic_mmu_lookup(env, addr, oi, retaddr, &ndi)
+#define ATOMIC_MMU_DECLS NotDirtyInfo ndi; AtomicLocks locks
+#define ATOMIC_MMU_LOOKUP \
+    atomic_mmu_lookup(env, addr, oi, retaddr, &ndi, &locks)
+#define ATOMIC_MMU_LOCKED unlikely(locks.first != NULL)
 #define ATOMIC_MMU_CLEANUP                              \
     do {                                                \
+        if (unlikely(locks.first != NULL)) {            \
+            atomic_locks_release(&locks);               \
+        }                                               \
         if (unlikely(ndi.active)) {                     \
             memory_notdirty_write_complete(&ndi);       \
         }                                               \
@@ -1132,7 +1545,8 @@ static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
 #undef ATOMIC_MMU_LOOKUP
 #define EXTRA_ARGS         , TCGMemOpIdx oi
 #define ATOMIC_NAME(X)     HELPER(glue(glue(atomic_ ## X, SUFFIX), END))
-#define ATOMIC_MMU_LOOKUP  atomic_mmu_lookup(env, addr, oi, GETPC(), &ndi)
+#define ATOMIC_MMU_LOOKUP \
+    atomic_mmu_lookup(env, addr, oi, GETPC(), &ndi, &locks)
 
 #define DATA_SIZE 1
 #include "atomic_template.h"
@@ -0,0 +1,349 @@
+/*
+ * Direct access to guest RAM from generated code (fastmem)
+ *
+ * With -accel tcg,fastmem=on, every vCPU reserves for each MMU mode a
+ * window of host address space that mirrors the whole guest virtual
+ * address space.  Whenever the TLB maps a page of RAM, the same page of
+ * the file backing the RAMBlock is mapped at the corresponding address of
+ * the window: read-only, unless the TLB entry lets stores through without
+ * going to the slow path.  Generated code then accesses guest memory by
+ * adding the guest address to the base of the window, without looking up
+ * the TLB.
+ *
+ * Everything else (pages that are not in the TLB, MMIO, watchpoints,
+ * pages whose writes must be tracked) is left inaccessible.  Accessing it
+ * raises SIGSEGV, and tlb_fastmem_fault() either fills the TLB and the
+ * window and lets the host retry the access, or restarts the guest
+ * instruction in a TB that goes through the TLB.
+ *
+ * A window never grants more than the TLB does, so cputlb.c calls in here
+ * whenever it removes a page or makes it write-protected.
+ *
+ * Each page mapped in a window splits the reservation into more VMAs, and
+ * the host limits how many a process can have (vm.max_map_count).  So a
+ * window is reset as a whole once it has had a share of that limit mapped
+ * into it; the pages that are still in use fault back in.  If the host
+ * runs out of mappings anyway, all the windows of the vCPU are reset and
+ * stay empty, and its memory accesses go through the TLB.  Once the limit
+ * is exceeded even that reset fails, so a few mappings are set aside at
+ * startup and given back to make room for it.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include <sys/mman.h>
+#include "qemu/units.h"
+#include "qemu-common.h"
+#include "cpu.h"
+#include "exec/exec-all.h"
+#include "exec/cpu_ldst.h"
+#include "exec/ram_addr.h"
+#include "qemu/bitops.h"
+#include "qemu/cutils.h"
+#include "qemu/error-report.h"
+#include "sysemu/cpus.h"
+#include "sysemu/sysemu.h"
+#include "fastmem.h"
+
+#if TCG_FASTMEM
+
+#define FASTMEM_WINDOW_SIZE (1ull << TARGET_LONG_BITS)
+/* Kept inaccessible, for accesses that cross the end of the window */
+#define FASTMEM_GUARD_SIZE  (64 * KiB)
+
+/* Hashed set of the TBs that must go through the TLB */
+#define FASTMEM_SLOW_BITS   16
+static unsigned long fastmem_slow_pcs[BITS_TO_LONGS(1 << FASTMEM_SLOW_BITS)];
+
+static struct sigaction fastmem_old_sigsegv;
+
+/* Pages that a window can have mapped before it is reset */
+static unsigned int fastmem_max_mapped;
+
+/* Mappings that are unmapped when a window cannot be reset otherwise */
+#define FASTMEM_BALLAST     8
+static void *fastmem_ballast[FASTMEM_BALLAST];
+static int fastmem_ballast_used;
+
+static void fastmem_signal_handler(int sig, siginfo_t *info, void *puc)
+{
+    ucontext_t *uc = puc;
+    CPUState *cpu = current_cpu;
+    uintptr_t addr = (uintptr_t)info->si_addr;
+    /* The pc of the faulting insn, adjusted as in handle_cpu_signal() */
+    uintptr_t pc = uc->uc_mcontext.gregs[REG_RIP] + GETPC_ADJ;
+    bool is_write = (uc->uc_mcontext.gregs[REG_ERR] >> 1) & 1;
+    int mmu_idx;
+
+    for (mmu_idx = 0; cpu && mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        CPUArchState *env = cpu->env_ptr;
+        uintptr_t base = env->fastmem_base[mmu_idx];
+
+        if (base && addr - base < FASTMEM_WINDOW_SIZE + FASTMEM_GUARD_SIZE) {
+            /*
+             * We may leave the handler with a longjmp, which does not
+             * restore the signal mask.
+             */
+            sigprocmask(SIG_SETMASK, &uc->uc_sigmask, NULL);
+            if (addr - base >= FASTMEM_WINDOW_SIZE) {
+                cpu_loop_exit_fastmem(cpu, pc);
+            }
+            tlb_fastmem_fault(cpu, mmu_idx, addr - base, is_write, pc);
+            return;
+        }
+    }
+
+    /* Not ours: fault again with the previous disposition.  */
+    sigaction(sig, &fastmem_old_sigsegv, NULL);
+}
+
+/*
+ * Leave half of vm.max_map_count to the rest of QEMU, and share the other
+ * half between all the windows.  A page mapped in the middle of a window
+ * costs two VMAs.
+ */
+static unsigned int fastmem_get_max_mapped(void)
+{
+    unsigned long max_map_count = 65530, val;
+    const char *end;
+    gchar *contents;
+
+    if (g_file_get_contents("/proc/sys/vm/max_map_count", &contents,
+                            NULL, NULL)) {
+        if (qemu_strtoul(contents, &end, 10, &val) == 0 && val) {
+            max_map_count = val;
+        }
+        g_free(contents);
+    }
+    return MAX(max_map_count / 2 / (2 * max_cpus * NB_MMU_MODES), 16);
+}
+
+void fastmem_init_cpu(CPUState *cpu)
+{
+    static bool handler_installed;
+    CPUArchState *env = cpu->env_ptr;
+    int mmu_idx;
+
+    /* -icount is only known once the accelerator is configured */
+    if (use_icount) {
+        error_report("fastmem is not compatible with icount");
+        exit(1);
+    }
+    if (TARGET_PAGE_SIZE < qemu_real_host_page_size) {
+        error_report("fastmem needs guest pages at least as large as "
+                     "host pages");
+        exit(1);
+    }
+
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        void *p = mmap(NULL, FASTMEM_WINDOW_SIZE + FASTMEM_GUARD_SIZE,
+                       PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                       -1, 0);
+
+        if (p == MAP_FAILED) {
+            error_report("fastmem: cannot reserve the guest address space: %s",
+                         strerror(errno));
+            exit(1);
+        }
+        env->fastmem_base[mmu_idx] = (uintptr_t)p;
+        env->fastmem_mapped[mmu_idx] = 0;
+    }
+    env->fastmem_off = false;
+
+    if (!handler_installed) {
+        struct sigaction act = {
+            .sa_sigaction = fastmem_signal_handler,
+            .sa_flags = SA_SIGINFO,
+        };
+        int i;
+
+        fastmem_max_mapped = fastmem_get_max_mapped();
+        /* Shared anonymous mappings never merge, so each is one VMA */
+        for (i = 0; i < FASTMEM_BALLAST; i++) {
+            fastmem_ballast[i] = mmap(NULL, qemu_real_host_page_size,
+                                      PROT_NONE, MAP_SHARED | MAP_ANONYMOUS,
+                                      -1, 0);
+        }
+        sigaction(SIGSEGV, &act, &fastmem_old_sigsegv);
+        handler_installed = true;
+    }
+}
+
+void fastmem_destroy_cpu(CPUState *cpu)
+{
+    CPUArchState *env = cpu->env_ptr;
+    int mmu_idx;
+
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        uintptr_t base = env->fastmem_base[mmu_idx];
+
+        if (base) {
+            env->fastmem_base[mmu_idx] = 0;
+            munmap((void *)base, FASTMEM_WINDOW_SIZE + FASTMEM_GUARD_SIZE);
+        }
+    }
+}
+
+void fastmem_init_thread(void)
+{
+    sigset_t set;
+
+    /* qemu_thread_create() starts the thread with all signals blocked */
+    sigemptyset(&set);
+    sigaddset(&set, SIGSEGV);
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+}
+
+static bool fastmem_try_reset(uintptr_t addr, size_t size)
+{
+    return mmap((void *)addr, size, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED,
+                -1, 0) != MAP_FAILED;
+}
+
+/*
+ * The host is out of mappings: make all the windows of the vCPU
+ * inaccessible and stop mapping pages in them.  Replacing a whole window
+ * with a single mapping cannot need more VMAs; it is only refused when
+ * the process is already past the limit, and then unmapping one of the
+ * ballast mappings brings it back under.
+ */
+static void fastmem_disable(CPUArchState *env)
+{
+    int mmu_idx, i;
+
+    if (!env->fastmem_off) {
+        warn_report("fastmem: out of host mappings, vCPU %d now accesses "
+                    "memory through the TLB", ENV_GET_CPU(env)->cpu_index);
+    }
+    env->fastmem_off = true;
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        /*
+         * A failed MAP_FIXED may leave a hole, which an unrelated mapping
+         * could later fill; generated code would then access it.
+         */
+        while (!fastmem_try_reset(env->fastmem_base[mmu_idx],
+                                  FASTMEM_WINDOW_SIZE)) {
+            i = errno == ENOMEM ? atomic_fetch_inc(&fastmem_ballast_used)
+                                : FASTMEM_BALLAST;
+            if (i >= FASTMEM_BALLAST) {
+                error_report("fastmem: cannot unmap guest memory: %s",
+                             strerror(errno));
+                abort();
+            }
+            if (fastmem_ballast[i] != MAP_FAILED) {
+                munmap(fastmem_ballast[i], qemu_real_host_page_size);
+            }
+        }
+        env->fastmem_mapped[mmu_idx] = 0;
+    }
+}
+
+static void fastmem_reset(CPUArchState *env, int mmu_idx,
+                          uintptr_t addr, size_t size)
+{
+    if (!fastmem_try_reset(addr, size)) {
+        fastmem_disable(env);
+    } else if (size == FASTMEM_WINDOW_SIZE) {
+        env->fastmem_mapped[mmu_idx] = 0;
+    }
+}
+
+int fastmem_map_page(CPUArchState *env, int mmu_idx, target_ulong vaddr,
+                     const CPUTLBEntry *te)
+{
+    uintptr_t base = env->fastmem_base[mmu_idx];
+    RAMBlock *block;
+    ram_addr_t offset;
+    int prot = PROT_READ;
+
+    if (!base || env->fastmem_off) {
+        return PROT_NONE;
+    }
+
+    /*
+     * The page must be RAM that loads can access directly, and come from a
+     * shared mapping of a file, whose pages we can map a second time.
+     */
+    if (te->addr_read & ~TARGET_PAGE_MASK) {
+        goto unmap;
+    }
+    block = qemu_ram_block_from_host((void *)((uintptr_t)vaddr + te->addend),
+                                     false, &offset);
+    if (!block || block->fd < 0 || !qemu_ram_is_shared(block) ||
+        qemu_ram_pagesize(block) != qemu_real_host_page_size) {
+        goto unmap;
+    }
+
+    /*
+     * Pages are not tracked individually, so this also counts the ones
+     * that are mapped again or unmapped since; it is only an upper bound.
+     */
+    if (env->fastmem_mapped[mmu_idx] >= fastmem_max_mapped) {
+        fastmem_reset(env, mmu_idx, base, FASTMEM_WINDOW_SIZE);
+        if (env->fastmem_off) {
+            return PROT_NONE;
+        }
+    }
+
+    if (tlb_addr_write(te) == vaddr) {
+        prot |= PROT_WRITE;
+    }
+    if (mmap((void *)(base + vaddr), TARGET_PAGE_SIZE, prot,
+             MAP_SHARED | MAP_FIXED, block->fd, offset) != MAP_FAILED) {
+        env->fastmem_mapped[mmu_idx]++;
+        return prot;
+    }
+    if (errno == ENOMEM) {
+        fastmem_disable(env);
+        return PROT_NONE;
+    }
+
+ unmap:
+    fastmem_reset(env, mmu_idx, base + vaddr, TARGET_PAGE_SIZE);
+    return PROT_NONE;
+}
+
+void fastmem_unmap_page(CPUArchState *env, int mmu_idx, target_ulong vaddr)
+{
+    uintptr_t base = env->fastmem_base[mmu_idx];
+
+    if (base && !env->fastmem_off) {
+        fastmem_reset(env, mmu_idx, base + vaddr, TARGET_PAGE_SIZE);
+    }
+}
+
+void fastmem_unmap_all(CPUArchState *env, int mmu_idx)
+{
+    uintptr_t base = env->fastmem_base[mmu_idx];
+
+    /* Most TLB flushes find the window already empty */
+    if (base && !env->fastmem_off && env->fastmem_mapped[mmu_idx]) {
+        fastmem_reset(env, mmu_idx, base, FASTMEM_WINDOW_SIZE);
+    }
+}
+
+static unsigned long fastmem_slow_hash(tb_page_addr_t phys_pc)
+{
+    return ((uint64_t)phys_pc * 0x9e3779b97f4a7c15ull)
+           >> (64 - FASTMEM_SLOW_BITS);
+}
+
+void fastmem_mark_slow(tb_page_addr_t phys_pc)
+{
+    set_bit_atomic(fastmem_slow_hash(phys_pc), fastmem_slow_pcs);
+}
+
+bool fastmem_is_slow(tb_page_addr_t phys_pc)
+{
+    return test_bit(fastmem_slow_hash(phys_pc), fastmem_slow_pcs);
+}
+
+void fastmem_clear_slow(void)
+{
+    bitmap_zero(fastmem_slow_pcs, 1 << FASTMEM_SLOW_BITS);
+}
+
+#endif /* TCG_FASTMEM */
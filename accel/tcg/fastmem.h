@@ -0,0 +1,98 @@
+/*
+ * Direct access to guest RAM from generated code (fastmem).
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#ifndef ACCEL_TCG_FASTMEM_H
+#define ACCEL_TCG_FASTMEM_H
+
+#include "tcg.h"
+
+#if TCG_FASTMEM
+
+/* Reserve the windows of @cpu; called from tlb_init().  */
+void fastmem_init_cpu(CPUState *cpu);
+
+/* Release the windows of @cpu; called from tlb_destroy().  */
+void fastmem_destroy_cpu(CPUState *cpu);
+
+/* Let the calling vCPU thread take the faults of its windows.  */
+void fastmem_init_thread(void);
+
+/*
+ * Make the page at @vaddr in the window of @mmu_idx mirror the TLB entry
+ * @te, and return the host protection that it got.  Only RAM that can be
+ * mapped a second time is mapped; anything else, as well as a page that
+ * the TLB entry sends to the slow path, is left inaccessible.
+ *
+ * Called with tlb_lock held.
+ */
+int fastmem_map_page(CPUArchState *env, int mmu_idx, target_ulong vaddr,
+                     const CPUTLBEntry *te);
+
+/* Make a page, or the whole window, of @mmu_idx inaccessible again.  */
+void fastmem_unmap_page(CPUArchState *env, int mmu_idx, target_ulong vaddr);
+void fastmem_unmap_all(CPUArchState *env, int mmu_idx);
+
+/* Handle a fault on a window; see tlb_fastmem_fault() in cputlb.c.  */
+void tlb_fastmem_fault(CPUState *cpu, int mmu_idx, target_ulong addr,
+                       bool is_write, uintptr_t retaddr);
+
+/*
+ * Remember that the TB at @phys_pc could not use fastmem, so that it is
+ * retranslated with CF_NOFASTMEM.  False positives only cost speed.
+ */
+void fastmem_mark_slow(tb_page_addr_t phys_pc);
+bool fastmem_is_slow(tb_page_addr_t phys_pc);
+
+/* Forget the TBs marked slow; called from tb_flush().  */
+void fastmem_clear_slow(void);
+
+#else
+
+static inline void fastmem_init_cpu(CPUState *cpu)
+{
+}
+
+static inline void fastmem_destroy_cpu(CPUState *cpu)
+{
+}
+
+static inline void fastmem_init_thread(void)
+{
+}
+
+#ifndef CONFIG_USER_ONLY
+static inline int fastmem_map_page(CPUArchState *env, int mmu_idx,
+                                   target_ulong vaddr, const CPUTLBEntry *te)
+{
+    return 0;
+}
+
+static inline void fastmem_unmap_page(CPUArchState *env, int mmu_idx,
+                                      target_ulong vaddr)
+{
+}
+
+static inline void fastmem_unmap_all(CPUArchState *env, int mmu_idx)
+{
+}
+#endif
+
+static inline void fastmem_mark_slow(tb_page_addr_t phys_pc)
+{
+}
+
+static inline bool fastmem_is_slow(tb_page_addr_t phys_pc)
+{
+    return false;
+}
+
+static inline void fastmem_clear_slow(void)
+{
+}
+
+#endif /* TCG_FASTMEM */
+
+#endif /* ACCEL_TCG_FASTMEM_H */
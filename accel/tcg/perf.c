@@ -0,0 +1,270 @@
+/*
+ * Linux perf perf-<pid>.map and jit-<pid>.dump integration.
+ *
+ * Without these, samples taken by a host profiler in the code_gen_buffer
+ * cannot be attributed to anything.  The perf map is a simple text file
+ * listing the address ranges of the translated blocks; the jitdump also
+ * contains a copy of the code, so that "perf annotate" works, and lets
+ * perf tell apart different blocks translated to the same address after
+ * a tb_flush.  The format is described in the Linux kernel sources in
+ * tools/perf/Documentation/jitdump-specification.txt.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include <sys/mman.h>
+#include "qemu/error-report.h"
+#include "qemu/thread.h"
+#include "cpu.h"
+#include "disas/disas.h"
+#include "elf.h"
+#include "perf.h"
+
+static QemuMutex perf_lock;
+static FILE *perfmap;
+static FILE *jitdump;
+static void *jitdump_marker;
+static size_t jitdump_marker_size;
+static uint64_t jitdump_code_index;
+
+static const void *prologue_start;
+static size_t prologue_size;
+
+#define JITHEADER_MAGIC     0x4A695444
+#define JITHEADER_VERSION   1
+
+struct jitheader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+};
+
+enum jit_record_type {
+    JIT_CODE_LOAD = 0,
+};
+
+struct jr_prefix {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+};
+
+struct jr_code_load {
+    struct jr_prefix p;
+
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+};
+
+/* perf matches the timestamps against its own, taken with -k 1.  */
+static uint64_t get_timestamp(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t get_e_machine(void)
+{
+    Elf64_Ehdr elf_header;
+    FILE *exe;
+    size_t n;
+
+    QEMU_BUILD_BUG_ON(offsetof(Elf32_Ehdr, e_machine) !=
+                      offsetof(Elf64_Ehdr, e_machine));
+
+    exe = fopen("/proc/self/exe", "r");
+    if (exe == NULL) {
+        return EM_NONE;
+    }
+    n = fread(&elf_header, sizeof(elf_header), 1, exe);
+    fclose(exe);
+    if (n != 1) {
+        return EM_NONE;
+    }
+    return elf_header.e_machine;
+}
+
+static void perf_report_prologue_locked(void);
+
+static void perf_init(void)
+{
+    static bool initialized;
+
+    if (!initialized) {
+        qemu_mutex_init(&perf_lock);
+        /* linux-user also calls perf_exit() before exiting with _exit().  */
+        atexit(perf_exit);
+        initialized = true;
+    }
+}
+
+void perf_enable_perfmap(void)
+{
+    char map_file[32];
+
+    perf_init();
+    snprintf(map_file, sizeof(map_file), "/tmp/perf-%d.map", getpid());
+    perfmap = fopen(map_file, "w");
+    if (perfmap == NULL) {
+        warn_report("Could not open %s: %s, proceeding without perfmap",
+                    map_file, strerror(errno));
+        return;
+    }
+    qemu_mutex_lock(&perf_lock);
+    perf_report_prologue_locked();
+    qemu_mutex_unlock(&perf_lock);
+}
+
+void perf_enable_jitdump(void)
+{
+    struct jitheader header;
+    char jitdump_file[32];
+
+    perf_init();
+    snprintf(jitdump_file, sizeof(jitdump_file), "jit-%d.dump", getpid());
+    jitdump = fopen(jitdump_file, "w+");
+    if (jitdump == NULL) {
+        warn_report("Could not open %s: %s, proceeding without jitdump",
+                    jitdump_file, strerror(errno));
+        return;
+    }
+
+    /*
+     * perf finds the jitdump through this mapping of it, which must be
+     * executable; it is never touched otherwise.
+     */
+    jitdump_marker_size = qemu_real_host_page_size;
+    jitdump_marker = mmap(NULL, jitdump_marker_size, PROT_READ | PROT_EXEC,
+                          MAP_PRIVATE, fileno(jitdump), 0);
+    if (jitdump_marker == MAP_FAILED) {
+        warn_report("Could not map %s: %s, proceeding without jitdump",
+                    jitdump_file, strerror(errno));
+        fclose(jitdump);
+        jitdump = NULL;
+        return;
+    }
+
+    header.magic = JITHEADER_MAGIC;
+    header.version = JITHEADER_VERSION;
+    header.total_size = sizeof(header);
+    header.elf_mach = get_e_machine();
+    header.pad1 = 0;
+    header.pid = getpid();
+    header.timestamp = get_timestamp();
+    header.flags = 0;
+    fwrite(&header, sizeof(header), 1, jitdump);
+
+    qemu_mutex_lock(&perf_lock);
+    perf_report_prologue_locked();
+    qemu_mutex_unlock(&perf_lock);
+}
+
+static void write_perfmap_entry(const void *start, size_t size,
+                                const char *name)
+{
+    fprintf(perfmap, "%"PRIxPTR" %zx %s\n", (uintptr_t)start, size, name);
+}
+
+static void write_jr_code_load(const void *start, size_t size,
+                               const char *name)
+{
+    struct jr_code_load load_event;
+    size_t name_size = strlen(name) + 1;
+
+    load_event.p.id = JIT_CODE_LOAD;
+    load_event.p.total_size = sizeof(load_event) + name_size + size;
+    load_event.p.timestamp = get_timestamp();
+    load_event.pid = getpid();
+    load_event.tid = qemu_get_thread_id();
+    load_event.vma = (uintptr_t)start;
+    load_event.code_addr = (uintptr_t)start;
+    load_event.code_size = size;
+    load_event.code_index = jitdump_code_index++;
+    fwrite(&load_event, sizeof(load_event), 1, jitdump);
+    fwrite(name, name_size, 1, jitdump);
+    fwrite(start, size, 1, jitdump);
+}
+
+static void perf_report_prologue_locked(void)
+{
+    if (prologue_start == NULL) {
+        return;
+    }
+    if (perfmap) {
+        write_perfmap_entry(prologue_start, prologue_size, "tcg-prologue");
+    }
+    if (jitdump) {
+        write_jr_code_load(prologue_start, prologue_size, "tcg-prologue");
+    }
+}
+
+void perf_report_prologue(const void *start, size_t size)
+{
+    prologue_start = start;
+    prologue_size = size;
+    if (perfmap || jitdump) {
+        qemu_mutex_lock(&perf_lock);
+        perf_report_prologue_locked();
+        qemu_mutex_unlock(&perf_lock);
+    }
+}
+
+void perf_report_code(uint64_t guest_pc, const void *start, size_t size)
+{
+    const char *symbol;
+    char *name;
+
+    if (!perfmap && !jitdump) {
+        return;
+    }
+
+    symbol = lookup_symbol(guest_pc);
+
+    if (symbol && symbol[0]) {
+        name = g_strdup_printf("guest-0x%"PRIx64" %s", guest_pc, symbol);
+    } else {
+        name = g_strdup_printf("guest-0x%"PRIx64, guest_pc);
+    }
+
+    qemu_mutex_lock(&perf_lock);
+    if (perfmap) {
+        write_perfmap_entry(start, size, name);
+    }
+    if (jitdump) {
+        write_jr_code_load(start, size, name);
+    }
+    qemu_mutex_unlock(&perf_lock);
+
+    g_free(name);
+}
+
+void perf_exit(void)
+{
+    if (!perfmap && !jitdump) {
+        return;
+    }
+    qemu_mutex_lock(&perf_lock);
+    if (perfmap) {
+        fclose(perfmap);
+        perfmap = NULL;
+    }
+    if (jitdump) {
+        munmap(jitdump_marker, jitdump_marker_size);
+        fclose(jitdump);
+        jitdump = NULL;
+    }
+    qemu_mutex_unlock(&perf_lock);
+}
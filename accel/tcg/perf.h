@@ -0,0 +1,25 @@
+/*
+ * Linux perf perf-<pid>.map and jit-<pid>.dump integration.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#ifndef ACCEL_TCG_PERF_H
+#define ACCEL_TCG_PERF_H
+
+/* Start writing /tmp/perf-<pid>.map.  */
+void perf_enable_perfmap(void);
+
+/* Start writing ./jit-<pid>.dump, for use with "perf record -k 1".  */
+void perf_enable_jitdump(void);
+
+/* Note the location of the prologue; reported once either is enabled.  */
+void perf_report_prologue(const void *start, size_t size);
+
+/* Report the host code of a newly created TB, named after its guest pc.  */
+void perf_report_code(uint64_t guest_pc, const void *start, size_t size);
+
+/* Flush and close the output files; also registered with atexit().  */
+void perf_exit(void);
+
+#endif /* ACCEL_TCG_PERF_H */
@@ -0,0 +1,412 @@
+/*
+ * Persistent translation block cache for user-mode emulation
+ *
+ * Short-lived guest processes spend much of their time translating the
+ * same code over and over.  When enabled with -tb-cache, the host code of
+ * every translated block is recorded together with the relocations that
+ * TCG noted while generating it, and written out when the guest exits.
+ * The next run with the same QEMU binary, guest executable, CPU model and
+ * guest_base maps that file and copies blocks out of it instead of
+ * translating them, after checking that the guest code they were
+ * translated from is unchanged.
+ *
+ * Only blocks that reference nothing but themselves, the prologue and
+ * functions in the QEMU executable are cached; TCG marks any other block
+ * as unsafe while it is generated.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include <sys/mman.h>
+#include "qemu/units.h"
+#include "qemu-common.h"
+#include "cpu.h"
+#include "exec/exec-all.h"
+#include "exec/cpu_ldst.h"
+#include "exec/tb-cache.h"
+#include "exec/tb-hash.h"
+#include "exec/log.h"
+#include "qemu/bswap.h"
+#include "qemu/error-report.h"
+#include "tcg.h"
+
+#define TB_CACHE_MAGIC      "QEMUTBC"
+#define TB_CACHE_VERSION    2
+
+/* Stop recording once this much has been added in a single run.  */
+#define TB_CACHE_MAX_NEW_BYTES  (256 * MiB)
+
+typedef struct TBCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nb_entries;
+    uint64_t size;
+} TBCacheHeader;
+
+/*
+ * An entry is followed by its relocations, the guest code it was
+ * translated from and the host code plus search data, and is padded
+ * to a multiple of 8 bytes.
+ */
+typedef struct TBCacheEntry {
+    uint64_t pc;
+    uint64_t cs_base;
+    uint32_t flags;
+    uint32_t cflags;
+    uint32_t trace_vcpu_dstate;
+    uint16_t size;
+    uint16_t icount;
+    uint32_t code_size;
+    uint32_t search_size;
+    uint16_t jmp_reset_offset[2];
+    uint32_t jmp_insn_offset[2];
+    uint32_t nb_relocs;
+    uint32_t total_size;
+} TBCacheEntry;
+
+bool tb_cache_active;
+
+static struct {
+    char *path;
+    void *map;
+    size_t map_size;
+    GHashTable *entries;
+    GPtrArray *new_entries;
+    size_t new_bytes;
+    bool saved;
+} tbc;
+
+static inline TCGTBCReloc *entry_relocs(const TBCacheEntry *e)
+{
+    return (TCGTBCReloc *)(e + 1);
+}
+
+static inline uint8_t *entry_guest_code(const TBCacheEntry *e)
+{
+    return (uint8_t *)(entry_relocs(e) + e->nb_relocs);
+}
+
+static inline uint8_t *entry_host_code(const TBCacheEntry *e)
+{
+    return entry_guest_code(e) + e->size;
+}
+
+static size_t entry_size(uint32_t nb_relocs, uint32_t size,
+                         uint32_t code_size, uint32_t search_size)
+{
+    size_t n = sizeof(TBCacheEntry) + nb_relocs * sizeof(TCGTBCReloc);
+
+    return ROUND_UP(n + size + code_size + search_size, 8);
+}
+
+static guint entry_hash(gconstpointer p)
+{
+    const TBCacheEntry *e = p;
+
+    return tb_hash_func(0, e->pc, e->flags, e->cflags, e->trace_vcpu_dstate);
+}
+
+static gboolean entry_equal(gconstpointer a, gconstpointer b)
+{
+    const TBCacheEntry *ea = a;
+    const TBCacheEntry *eb = b;
+
+    return ea->pc == eb->pc &&
+           ea->cs_base == eb->cs_base &&
+           ea->flags == eb->flags &&
+           ea->cflags == eb->cflags &&
+           ea->trace_vcpu_dstate == eb->trace_vcpu_dstate;
+}
+
+static void tb_cache_load(void)
+{
+    const TBCacheHeader *hdr;
+    struct stat st;
+    size_t off;
+    uint32_t i;
+    void *map;
+    int fd;
+
+    fd = open(tbc.path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(*hdr)) {
+        close(fd);
+        return;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+
+    hdr = map;
+    if (memcmp(hdr->magic, TB_CACHE_MAGIC, sizeof(hdr->magic)) ||
+        hdr->version != TB_CACHE_VERSION || hdr->size != st.st_size) {
+        munmap(map, st.st_size);
+        return;
+    }
+    tbc.map = map;
+    tbc.map_size = st.st_size;
+
+    off = sizeof(*hdr);
+    for (i = 0; i < hdr->nb_entries; i++) {
+        const TBCacheEntry *e = map + off;
+
+        if (off + sizeof(*e) > tbc.map_size ||
+            e->total_size < sizeof(*e) ||
+            e->total_size > tbc.map_size - off ||
+            e->nb_relocs > TCG_MAX_TBC_RELOCS ||
+            entry_size(e->nb_relocs, e->size, e->code_size,
+                       e->search_size) != e->total_size) {
+            warn_report("tb-cache: %s is corrupt, ignoring the rest of it",
+                        tbc.path);
+            break;
+        }
+        g_hash_table_replace(tbc.entries, (gpointer)e, (gpointer)e);
+        off += e->total_size;
+    }
+}
+
+void tb_cache_init(const char *dir, const char *cpu_model,
+                   const char *exec_file)
+{
+    struct stat self, exe;
+    char *key, *sum;
+
+    if (!TCG_TARGET_HAS_TB_CACHE || !TCG_TARGET_HAS_direct_jump) {
+        warn_report("tb-cache: not supported on this host");
+        return;
+    }
+    if (stat("/proc/self/exe", &self) < 0 || stat(exec_file, &exe) < 0) {
+        return;
+    }
+    if (g_mkdir_with_parents(dir, 0755) < 0) {
+        warn_report("tb-cache: cannot create %s: %s", dir, strerror(errno));
+        return;
+    }
+
+    /*
+     * Everything that affects the generated code but is not part of the
+     * per-TB key goes into the name of the cache file.
+     */
+    key = g_strdup_printf("%s %s %s %" PRIu64 ":%" PRIu64 ":%" PRId64
+                          ":%" PRId64 " %" PRIu64 ":%" PRIu64 ":%" PRId64
+                          ":%" PRId64 " %lx %lx %d %d",
+                          QEMU_VERSION, TARGET_NAME, cpu_model,
+                          (uint64_t)self.st_dev, (uint64_t)self.st_ino,
+                          (int64_t)self.st_size, (int64_t)self.st_mtime,
+                          (uint64_t)exe.st_dev, (uint64_t)exe.st_ino,
+                          (int64_t)exe.st_size, (int64_t)exe.st_mtime,
+                          guest_base, reserved_va, qemu_icache_linesize,
+                          tcg_superblocks);
+    sum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, key, -1);
+    tbc.path = g_strdup_printf("%s/%s.tbc", dir, sum);
+    g_free(sum);
+    g_free(key);
+
+    tbc.entries = g_hash_table_new(entry_hash, entry_equal);
+    tbc.new_entries = g_ptr_array_new_with_free_func(g_free);
+    tb_cache_load();
+
+    tcg_init_ctx.tbc_recording = true;
+    tb_cache_active = true;
+}
+
+static bool tb_cache_relocate(const TBCacheEntry *e, tcg_insn_unit *code)
+{
+    const TCGTBCReloc *r = entry_relocs(e);
+    uint32_t i;
+
+    for (i = 0; i < e->nb_relocs; i++, r++) {
+        void *where = (void *)code + r->offset;
+        uintptr_t base;
+
+        if (r->offset + (r->type == TCG_TBC_RELOC_PC32 ? 4 : 8) >
+            e->code_size) {
+            return false;
+        }
+        switch (r->base) {
+        case TCG_TBC_BASE_SELF:
+            base = (uintptr_t)code;
+            break;
+        case TCG_TBC_BASE_PROLOGUE:
+            base = (uintptr_t)tcg_ctx->code_gen_prologue;
+            break;
+        case TCG_TBC_BASE_BINARY:
+            base = (uintptr_t)tcg_tbc_reloc;
+            break;
+        default:
+            return false;
+        }
+
+        switch (r->type) {
+        case TCG_TBC_RELOC_PC32:
+        {
+            intptr_t disp = base + r->addend - ((uintptr_t)where + 4);
+
+            if (disp != (int32_t)disp) {
+                return false;
+            }
+            stl_he_p(where, disp);
+            break;
+        }
+        case TCG_TBC_RELOC_ABS64:
+            stq_he_p(where, base + r->addend);
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+int tb_cache_restore(TranslationBlock *tb, int *search_size)
+{
+    TBCacheEntry key = {
+        .pc = tb->pc,
+        .cs_base = tb->cs_base,
+        .flags = tb->flags,
+        .cflags = tb->cflags & CF_HASH_MASK,
+        .trace_vcpu_dstate = tb->trace_vcpu_dstate,
+    };
+    const TBCacheEntry *e;
+    void *buf = tb->tc.ptr;
+
+    /* Keep the -d logs complete.  */
+    if (qemu_loglevel_mask(CPU_LOG_TB_IN_ASM | CPU_LOG_TB_OP |
+                           CPU_LOG_TB_OP_OPT | CPU_LOG_TB_OUT_ASM)) {
+        return -1;
+    }
+
+    e = g_hash_table_lookup(tbc.entries, &key);
+    if (e == NULL) {
+        return -1;
+    }
+    if (page_check_range(tb->pc, e->size, PAGE_READ) ||
+        memcmp(g2h(tb->pc), entry_guest_code(e), e->size)) {
+        return -1;
+    }
+    if (buf + e->code_size + e->search_size > tcg_ctx->code_gen_highwater) {
+        return -1;
+    }
+
+    memcpy(buf, entry_host_code(e), e->code_size + e->search_size);
+    if (!tb_cache_relocate(e, buf)) {
+        return -1;
+    }
+
+    tb->size = e->size;
+    tb->icount = e->icount;
+    tb->jmp_reset_offset[0] = e->jmp_reset_offset[0];
+    tb->jmp_reset_offset[1] = e->jmp_reset_offset[1];
+    tb->jmp_target_arg[0] = e->jmp_insn_offset[0];
+    tb->jmp_target_arg[1] = e->jmp_insn_offset[1];
+    flush_icache_range((uintptr_t)buf,
+                       (uintptr_t)buf + e->code_size + e->search_size);
+
+    *search_size = e->search_size;
+    return e->code_size;
+}
+
+void tb_cache_record(TranslationBlock *tb, int gen_code_size,
+                     int search_size)
+{
+    TCGContext *s = tcg_ctx;
+    TBCacheEntry *e;
+    size_t total;
+
+    if (s->tbc_unsafe || tbc.new_bytes >= TB_CACHE_MAX_NEW_BYTES) {
+        return;
+    }
+
+    total = entry_size(s->tbc_nb_relocs, tb->size, gen_code_size,
+                       search_size);
+    e = g_malloc0(total);
+    e->pc = tb->pc;
+    e->cs_base = tb->cs_base;
+    e->flags = tb->flags;
+    e->cflags = tb->cflags & CF_HASH_MASK;
+    e->trace_vcpu_dstate = tb->trace_vcpu_dstate;
+    e->size = tb->size;
+    e->icount = tb->icount;
+    e->code_size = gen_code_size;
+    e->search_size = search_size;
+    e->jmp_reset_offset[0] = tb->jmp_reset_offset[0];
+    e->jmp_reset_offset[1] = tb->jmp_reset_offset[1];
+    e->jmp_insn_offset[0] = tb->jmp_target_arg[0];
+    e->jmp_insn_offset[1] = tb->jmp_target_arg[1];
+    e->nb_relocs = s->tbc_nb_relocs;
+    e->total_size = total;
+
+    memcpy(entry_relocs(e), s->tbc_relocs,
+           s->tbc_nb_relocs * sizeof(TCGTBCReloc));
+    memcpy(entry_guest_code(e), g2h(tb->pc), tb->size);
+    memcpy(entry_host_code(e), tb->tc.ptr, gen_code_size + search_size);
+
+    g_hash_table_replace(tbc.entries, e, e);
+    g_ptr_array_add(tbc.new_entries, e);
+    tbc.new_bytes += total;
+}
+
+void tb_cache_save(void)
+{
+    TBCacheHeader hdr = {
+        .magic = TB_CACHE_MAGIC,
+        .version = TB_CACHE_VERSION,
+    };
+    GHashTableIter iter;
+    gpointer value;
+    char *tmp;
+    FILE *f;
+
+    if (!tb_cache_active || tbc.saved || tbc.new_entries->len == 0) {
+        return;
+    }
+    mmap_lock();
+    tbc.saved = true;
+
+    /*
+     * Write to a temporary file and rename it, so that concurrent runs
+     * always see a complete cache; the last one to exit wins.
+     */
+    tmp = g_strdup_printf("%s.%d", tbc.path, getpid());
+    f = fopen(tmp, "wb");
+    if (f == NULL) {
+        goto out;
+    }
+
+    hdr.size = sizeof(hdr);
+    hdr.nb_entries = g_hash_table_size(tbc.entries);
+    g_hash_table_iter_init(&iter, tbc.entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        hdr.size += ((TBCacheEntry *)value)->total_size;
+    }
+
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1) {
+        goto fail;
+    }
+    g_hash_table_iter_init(&iter, tbc.entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        TBCacheEntry *e = value;
+
+        if (fwrite(e, e->total_size, 1, f) != 1) {
+            goto fail;
+        }
+    }
+    if (fclose(f) == 0 && rename(tmp, tbc.path) == 0) {
+        goto out;
+    }
+    f = NULL;
+ fail:
+    if (f) {
+        fclose(f);
+    }
+    unlink(tmp);
+ out:
+    g_free(tmp);
+    mmap_unlock();
+}
@@ -163,7 +163,21 @@ void *HELPER(lookup_tb_ptr)(CPUArchState *env)
     return tb->tc.ptr;
 }
 
+/* A return that the return address stack failed to predict */
+void *HELPER(lookup_tb_ptr_ret)(CPUArchState *env)
+{
+    CPUState *cpu = ENV_GET_CPU(env);
+
+    atomic_set(&cpu->tb_ras_misses, cpu->tb_ras_misses + 1);
+    return HELPER(lookup_tb_ptr)(env);
+}
+
 void HELPER(exit_atomic)(CPUArchState *env)
 {
     cpu_loop_exit_atomic(ENV_GET_CPU(env), GETPC());
 }
+
+void HELPER(exit_superblock)(CPUArchState *env, void *tb)
+{
+    cpu_loop_exit_superblock(ENV_GET_CPU(env), tb, GETPC());
+}
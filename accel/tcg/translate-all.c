@@ -47,12 +47,19 @@
 #endif
 #else
 #include "exec/ram_addr.h"
+#include "sysemu/sysemu.h"
 #endif
 
 #include "exec/cputlb.h"
 #include "exec/tb-hash.h"
+#include "exec/tb-cache.h"
 #include "translate-all.h"
+#include "fastmem.h"
+#ifdef CONFIG_LINUX
+#include "perf.h"
+#endif
 #include "qemu/bitmap.h"
+#include "qemu/cutils.h"
 #include "qemu/error-report.h"
 #include "qemu/timer.h"
 #include "qemu/main-loop.h"
@@ -215,6 +222,14 @@ TCGContext tcg_init_ctx;
 __thread TCGContext *tcg_ctx;
 TBContext tb_ctx;
 bool parallel_cpus;
+/* Retranslate hot TBs as superblocks; see cpu_loop_exit_superblock */
+bool tcg_superblocks;
+/* Predict returns with a per-vCPU stack; see translator_ras_push */
+bool tcg_return_stack;
+/* Serialize unaligned atomics with address locks; see atomic_mmu_lookup */
+bool tcg_atomic_locks;
+/* Access guest RAM directly from generated code; see accel/tcg/fastmem.c */
+bool tcg_fastmem;
 
 static void page_table_config_init(void)
 {
@@ -282,6 +297,15 @@ static target_long decode_sleb128(uint8_t **pp)
     return val;
 }
 
+/* Every SEARCH_CHECKPOINT_INSNS insns the search table restarts from
+   the seed values, and a checkpoint records where that line begins.  */
+#define SEARCH_CHECKPOINT_INSNS  16
+
+static inline int search_checkpoints(int icount)
+{
+    return (icount - 1) / SEARCH_CHECKPOINT_INSNS;
+}
+
 /* Encode the data collected about the instructions while compiling TB.
    Place the data at BLOCK, and return the number of bytes consumed.
 
@@ -292,26 +316,48 @@ static target_long decode_sleb128(uint8_t **pp)
    Each line of the table is encoded as sleb128 deltas from the previous
    line.  The seed for the first line is { tb->pc, 0..., tb->tc.ptr }.
    That is, the first column is seeded with the guest pc, the last column
-   with the host pc, and the middle columns with zeros.  */
+   with the host pc, and the middle columns with zeros.
+
+   Every SEARCH_CHECKPOINT_INSNS lines the deltas are taken from the seed
+   again, so that decoding can start there.  For each such line, a pair
+   of uint16_t in front of the encoded table holds the host pc offset at
+   which its insn starts and the offset of the line within the table.  */
 
 static int encode_search(TranslationBlock *tb, uint8_t *block)
 {
     uint8_t *highwater = tcg_ctx->code_gen_highwater;
-    uint8_t *p = block;
+    int nb_checkpoints = search_checkpoints(tb->icount);
+    uint16_t *checkpoint = NULL;
+    uint8_t *p = block, *table;
     int i, j, n;
 
+    if (nb_checkpoints) {
+        checkpoint = QEMU_ALIGN_PTR_UP(block, sizeof(uint16_t));
+        p = (uint8_t *)(checkpoint + 2 * nb_checkpoints);
+        if (unlikely(p > highwater)) {
+            return -1;
+        }
+    }
+    table = p;
+
     for (i = 0, n = tb->icount; i < n; ++i) {
+        bool seed = i % SEARCH_CHECKPOINT_INSNS == 0;
         target_ulong prev;
 
+        if (seed && i != 0) {
+            tcg_debug_assert(p - table <= UINT16_MAX);
+            *checkpoint++ = tcg_ctx->gen_insn_end_off[i - 1];
+            *checkpoint++ = p - table;
+        }
         for (j = 0; j < TARGET_INSN_START_WORDS; ++j) {
-            if (i == 0) {
+            if (seed) {
                 prev = (j == 0 ? tb->pc : 0);
             } else {
                 prev = tcg_ctx->gen_insn_data[i - 1][j];
             }
             p = encode_sleb128(p, tcg_ctx->gen_insn_data[i][j] - prev);
         }
-        prev = (i == 0 ? 0 : tcg_ctx->gen_insn_end_off[i - 1]);
+        prev = (seed ? 0 : tcg_ctx->gen_insn_end_off[i - 1]);
         p = encode_sleb128(p, tcg_ctx->gen_insn_end_off[i] - prev);
 
         /* Test for (pending) buffer overflow.  The assumption is that any
@@ -337,11 +383,9 @@ static int cpu_restore_state_from_tb(CPUState *cpu, TranslationBlock *tb,
     uintptr_t host_pc = (uintptr_t)tb->tc.ptr;
     CPUArchState *env = cpu->env_ptr;
     uint8_t *p = tb->tc.ptr + tb->tc.size;
-    int i, j, num_insns = tb->icount;
-#ifdef CONFIG_PROFILER
-    TCGProfile *prof = &tcg_ctx->prof;
-    int64_t ti = profile_getclock();
-#endif
+    int i, j, first, num_insns = tb->icount;
+    int nb_checkpoints = search_checkpoints(num_insns);
+    int64_t ti = get_clock();
 
     searched_pc -= GETPC_ADJ;
 
@@ -349,9 +393,32 @@ static int cpu_restore_state_from_tb(CPUState *cpu, TranslationBlock *tb,
         return -1;
     }
 
+    /* Skip the lines before the last checkpoint at or below searched_pc */
+    first = 0;
+    if (nb_checkpoints) {
+        const uint16_t *checkpoint = QEMU_ALIGN_PTR_UP(p, sizeof(uint16_t));
+        uintptr_t offset = searched_pc - host_pc;
+
+        p = (uint8_t *)(checkpoint + 2 * nb_checkpoints);
+        for (i = nb_checkpoints; i > 0; i--) {
+            if (offset >= checkpoint[2 * i - 2]) {
+                first = i * SEARCH_CHECKPOINT_INSNS;
+                p += checkpoint[2 * i - 1];
+                break;
+            }
+        }
+    }
+
     /* Reconstruct the stored insn data while looking for the point at
        which the end of the insn exceeds the searched_pc.  */
-    for (i = 0; i < num_insns; ++i) {
+    for (i = first; i < num_insns; ++i) {
+        if (i % SEARCH_CHECKPOINT_INSNS == 0) {
+            data[0] = tb->pc;
+            for (j = 1; j < TARGET_INSN_START_WORDS; ++j) {
+                data[j] = 0;
+            }
+            host_pc = (uintptr_t)tb->tc.ptr;
+        }
         for (j = 0; j < TARGET_INSN_START_WORDS; ++j) {
             data[j] += decode_sleb128(&p);
         }
@@ -371,11 +438,10 @@ static int cpu_restore_state_from_tb(CPUState *cpu, TranslationBlock *tb,
     }
     restore_state_to_opc(env, tb, data);
 
-#ifdef CONFIG_PROFILER
-    atomic_set(&prof->restore_time,
-                prof->restore_time + profile_getclock() - ti);
-    atomic_set(&prof->restore_count, prof->restore_count + 1);
-#endif
+    atomic_set(&cpu->tb_restore_count, cpu->tb_restore_count + 1);
+    atomic_set(&cpu->tb_restore_insns, cpu->tb_restore_insns + i - first + 1);
+    atomic_set_i64(&cpu->tb_restore_time,
+                   cpu->tb_restore_time + get_clock() - ti);
     return 0;
 }
 
@@ -1029,6 +1095,82 @@ static inline void *alloc_code_gen_buffer(void)
                         PAGE_EXECUTE_READWRITE);
 }
 #else
+#ifdef CONFIG_LINUX
+/* Return the size of the huge pages the host can map the buffer with.  */
+static size_t host_huge_page_size(void)
+{
+    gchar *contents;
+    const char *end;
+    uint64_t size = 0;
+
+    if (g_file_get_contents("/sys/kernel/mm/transparent_hugepage/"
+                            "hpage_pmd_size", &contents, NULL, NULL)) {
+        if (qemu_strtou64(contents, &end, 10, &size) < 0 ||
+            !is_power_of_2(size) || size <= qemu_real_host_page_size) {
+            size = 0;
+        }
+        g_free(contents);
+    }
+    return size;
+}
+
+/* Bound on the TCG threads the buffer is split between, see tcg_region_init */
+static inline size_t code_gen_max_threads(void)
+{
+#ifdef CONFIG_USER_ONLY
+    return 1;
+#else
+    return max_cpus;
+#endif
+}
+
+/*
+ * Back the buffer with huge pages, to make the host iTLB cover much more
+ * translated code. Explicit huge pages are used if enough of them are
+ * reserved: they then also become the unit of the region guard pages, so
+ * we only use them when each region can be several huge pages. Otherwise
+ * align the buffer so that transparent huge pages can back all of it.
+ */
+static void *alloc_code_gen_buffer_huge(void *start, size_t size,
+                                        int prot, int flags)
+{
+    size_t huge = host_huge_page_size();
+    void *buf, *aligned;
+
+    if (!huge) {
+        return MAP_FAILED;
+    }
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    if (size >= 4 * huge * code_gen_max_threads()) {
+        size_t huge_size = ROUND_UP(size, huge);
+
+        buf = mmap(start, huge_size, prot,
+                   flags | MAP_HUGETLB | (ctz64(huge) << MAP_HUGE_SHIFT),
+                   -1, 0);
+        if (buf != MAP_FAILED) {
+            tcg_ctx->code_gen_buffer_size = huge_size;
+            tcg_ctx->code_gen_buffer_page_size = huge;
+            tcg_ctx->code_gen_buffer_huge_size = huge;
+            return buf;
+        }
+    }
+#endif
+
+    buf = mmap(start, size + huge, prot, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    aligned = QEMU_ALIGN_PTR_UP(buf, huge);
+    if (aligned != buf) {
+        munmap(buf, aligned - buf);
+    }
+    munmap(aligned + size, buf + huge - aligned);
+    tcg_ctx->code_gen_buffer_huge_size = huge;
+    return aligned;
+}
+#endif
+
 static inline void *alloc_code_gen_buffer(void)
 {
     int prot = PROT_WRITE | PROT_READ | PROT_EXEC;
@@ -1065,6 +1207,14 @@ static inline void *alloc_code_gen_buffer(void)
 #  endif
 # endif
 
+#if defined(CONFIG_LINUX) && !defined(__mips__)
+    buf = alloc_code_gen_buffer_huge((void *)start, size, prot, flags);
+    if (buf != MAP_FAILED) {
+        size = tcg_ctx->code_gen_buffer_size;
+        goto done;
+    }
+#endif
+
     buf = mmap((void *)start, size, prot, flags, -1, 0);
     if (buf == MAP_FAILED) {
         return NULL;
@@ -1102,6 +1252,9 @@ static inline void *alloc_code_gen_buffer(void)
     }
 #endif
 
+#if defined(CONFIG_LINUX) && !defined(__mips__)
+ done:
+#endif
     /* Request large pages for the buffer.  */
     qemu_madvise(buf, size, QEMU_MADV_HUGEPAGE);
 
@@ -1255,6 +1408,7 @@ static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
 
     qht_reset_size(&tb_ctx.htable, CODE_GEN_HTABLE_SIZE);
     page_flush_tb();
+    fastmem_clear_slow();
 
     tcg_region_reset_all();
     /* XXX: flush processor icache at this point if cache flush is
@@ -1274,6 +1428,54 @@ void tb_flush(CPUState *cpu)
     }
 }
 
+static gboolean tb_evict_iter(gpointer key, gpointer value, gpointer data)
+{
+    TranslationBlock *tb = value;
+
+    /* TBs that were already invalidated are skipped by tb_phys_invalidate */
+    tb_phys_invalidate(tb, -1);
+    return false;
+}
+
+/*
+ * Make room in code_gen_buffer by evicting the oldest regions, unlinking
+ * just the TBs they contain.  This keeps steady-state workloads with a
+ * large code footprint from periodically retranslating everything.
+ */
+static void do_tb_evict(CPUState *cpu, run_on_cpu_data tb_flush_count)
+{
+    int n;
+
+    mmap_lock();
+    /* A flush already made room */
+    if (tb_ctx.tb_flush_count != tb_flush_count.host_int) {
+        goto done;
+    }
+
+    n = tcg_region_evict(tb_evict_iter, NULL);
+    if (n < 0) {
+        do_tb_flush(cpu, tb_flush_count);
+    } else {
+        atomic_set(&tb_ctx.region_evict_count,
+                   tb_ctx.region_evict_count + n);
+        /* The return stacks can point to TBs whose memory will be reused */
+        CPU_FOREACH(cpu) {
+            cpu_tb_ras_clear(cpu);
+        }
+    }
+
+done:
+    mmap_unlock();
+}
+
+static void tb_evict(CPUState *cpu)
+{
+    unsigned tb_flush_count = atomic_mb_read(&tb_ctx.tb_flush_count);
+
+    async_safe_run_on_cpu(cpu, do_tb_evict,
+                          RUN_ON_CPU_HOST_INT(tb_flush_count));
+}
+
 /*
  * Formerly ifdef DEBUG_TB_CHECK. These debug functions are user-mode-only,
  * so in order to prevent bit rot we compile them unconditionally in user-mode,
@@ -1686,6 +1888,9 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 
     phys_pc = get_page_addr_code(env, pc);
 
+    if (tcg_fastmem && fastmem_is_slow(phys_pc)) {
+        cflags |= CF_NOFASTMEM;
+    }
     if (phys_pc == -1) {
         /* Generate a temporary TB with 1 insn in it */
         cflags &= ~CF_COUNT_MASK;
@@ -1695,8 +1900,8 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
  buffer_overflow:
     tb = tb_alloc(pc);
     if (unlikely(!tb)) {
-        /* flush must be done */
-        tb_flush(cpu);
+        /* eviction or flush must be done */
+        tb_evict(cpu);
         mmap_unlock();
         /* Make the execution loop process the flush as soon as possible.  */
         cpu->exception_index = EXCP_INTERRUPT;
@@ -1705,13 +1910,24 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 
     gen_code_buf = tcg_ctx->code_gen_ptr;
     tb->tc.ptr = gen_code_buf;
+    tb->tc.cold_ptr = NULL;
+    tb->tc.cold_size = 0;
     tb->pc = pc;
     tb->cs_base = cs_base;
     tb->flags = flags;
     tb->cflags = cflags;
     tb->trace_vcpu_dstate = *cpu->trace_dstate;
+    tb->exec_count = 0;
     tcg_ctx->tb_cflags = cflags;
 
+    if (tb_cache_active && !(cflags & CF_NOCACHE)) {
+        gen_code_size = tb_cache_restore(tb, &search_size);
+        if (gen_code_size >= 0) {
+            tb->tc.size = gen_code_size;
+            goto restored;
+        }
+    }
+
 #ifdef CONFIG_PROFILER
     /* includes aborted translations because of exceptions */
     atomic_set(&prof->tb_count1, prof->tb_count1 + 1);
@@ -1758,6 +1974,14 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
         goto buffer_overflow;
     }
     tb->tc.size = gen_code_size;
+    if (tcg_ctx->code_gen_cold_buffer) {
+        tb->tc.cold_ptr = tcg_ctx->cold_gen_ptr;
+        tb->tc.cold_size = tcg_ctx->cold_gen_size;
+    }
+
+    if (tb_cache_active && !(cflags & CF_NOCACHE)) {
+        tb_cache_record(tb, gen_code_size, search_size);
+    }
 
 #ifdef CONFIG_PROFILER
     atomic_set(&prof->code_time, prof->code_time + profile_getclock() - ti);
@@ -1769,14 +1993,24 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 #ifdef DEBUG_DISAS
     if (qemu_loglevel_mask(CPU_LOG_TB_OUT_ASM) &&
         qemu_log_in_addr_range(tb->pc)) {
+        void *code_ptr = tb->tc.ptr;
+        size_t code_len = gen_code_size;
+
         qemu_log_lock();
         qemu_log("OUT: [size=%d]\n", gen_code_size);
+        if (tb->tc.cold_size) {
+            /* The slow paths and the constant pool follow the hot code */
+            log_disas(code_ptr, code_len);
+            qemu_log("OUT (cold): [size=%zu]\n", tb->tc.cold_size);
+            code_ptr = tb->tc.cold_ptr;
+            code_len = tb->tc.cold_size;
+        }
         if (tcg_ctx->data_gen_ptr) {
-            size_t code_size = tcg_ctx->data_gen_ptr - tb->tc.ptr;
-            size_t data_size = gen_code_size - code_size;
+            size_t code_size = tcg_ctx->data_gen_ptr - code_ptr;
+            size_t data_size = code_len - code_size;
             size_t i;
 
-            log_disas(tb->tc.ptr, code_size);
+            log_disas(code_ptr, code_size);
 
             for (i = 0; i < data_size; i += sizeof(tcg_target_ulong)) {
                 if (sizeof(tcg_target_ulong) == 8) {
@@ -1790,7 +2024,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
                 }
             }
         } else {
-            log_disas(tb->tc.ptr, gen_code_size);
+            log_disas(code_ptr, code_len);
         }
         qemu_log("\n");
         qemu_log_flush();
@@ -1798,6 +2032,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     }
 #endif
 
+ restored:
     atomic_set(&tcg_ctx->code_gen_ptr, (void *)
         ROUND_UP((uintptr_t)gen_code_buf + gen_code_size + search_size,
                  CODE_GEN_ALIGN));
@@ -1835,9 +2070,18 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 
         orig_aligned -= ROUND_UP(sizeof(*tb), qemu_icache_linesize);
         atomic_set(&tcg_ctx->code_gen_ptr, (void *)orig_aligned);
+        if (tb->tc.cold_ptr) {
+            atomic_set(&tcg_ctx->code_gen_cold_ptr, tb->tc.cold_ptr);
+        }
         return existing_tb;
     }
     tcg_tb_insert(tb);
+#ifdef CONFIG_LINUX
+    perf_report_code(pc, tb->tc.ptr, tb->tc.size);
+    if (tb->tc.cold_size) {
+        perf_report_code(pc, tb->tc.cold_ptr, tb->tc.cold_size);
+    }
+#endif
     return tb;
 }
 
@@ -2133,7 +2377,47 @@ void tb_check_watchpoint(CPUState *cpu)
     }
 }
 
+/*
+ * Called from the start of @tb once it has run TB_SUPERBLOCK_THRESHOLD
+ * times.  Invalidate it and go back to the main loop, which retranslates
+ * it as a superblock: the blocks it jumps to are translated together with
+ * it, so that they are optimized and register-allocated as a whole.
+ */
+void cpu_loop_exit_superblock(CPUState *cpu, TranslationBlock *tb,
+                              uintptr_t retaddr)
+{
+    mmap_lock();
+    tb_phys_invalidate(tb, -1);
+    mmap_unlock();
+
+    cpu->cflags_next_tb = curr_cflags() | CF_SUPERBLOCK;
+    cpu_loop_exit_restore(cpu, retaddr);
+}
+
 #ifndef CONFIG_USER_ONLY
+/*
+ * Called when a fastmem access of @tb faults on a page that the fastmem
+ * window cannot map.  Go back to the main loop, which restarts at the
+ * faulting instruction in a TB that goes through the TLB.  @tb itself is
+ * invalidated and retranslated the same way, as are the TBs that later
+ * start at its address, so that the next access does not fault again.
+ */
+void cpu_loop_exit_fastmem(CPUState *cpu, uintptr_t retaddr)
+{
+    TranslationBlock *tb = tcg_tb_lookup(retaddr);
+
+    atomic_set(&cpu->fastmem_slow_exits, cpu->fastmem_slow_exits + 1);
+    if (tb && !(tb_cflags(tb) & CF_NOCACHE)) {
+        fastmem_mark_slow(tb->page_addr[0] + (tb->pc & ~TARGET_PAGE_MASK));
+        mmap_lock();
+        tb_phys_invalidate(tb, -1);
+        mmap_unlock();
+    }
+
+    cpu->cflags_next_tb = curr_cflags() | CF_NOFASTMEM;
+    cpu_loop_exit_restore(cpu, retaddr);
+}
+
 /* in deterministic execution mode, instructions doing device I/Os
  * must be at the end of the TB.
  *
@@ -2213,6 +2497,7 @@ void tb_flush_jmp_cache(CPUState *cpu, target_ulong addr)
        overlap the flushed page.  */
     tb_jmp_cache_clear_page(cpu, addr - TARGET_PAGE_SIZE);
     tb_jmp_cache_clear_page(cpu, addr);
+    cpu_tb_ras_clear(cpu);
 }
 
 static void print_qht_statistics(FILE *f, fprintf_function cpu_fprintf,
@@ -2256,6 +2541,7 @@ static void print_qht_statistics(FILE *f, fprintf_function cpu_fprintf,
 struct tb_tree_stats {
     size_t nb_tbs;
     size_t host_size;
+    size_t cold_size;
     size_t target_size;
     size_t max_target_size;
     size_t direct_jmp_count;
@@ -2270,6 +2556,7 @@ static gboolean tb_tree_stats_iter(gpointer key, gpointer value, gpointer data)
 
     tst->nb_tbs++;
     tst->host_size += tb->tc.size;
+    tst->cold_size += tb->tc.cold_size;
     tst->target_size += tb->size;
     if (tb->size > tst->max_target_size) {
         tst->max_target_size = tb->size;
@@ -2286,6 +2573,72 @@ static gboolean tb_tree_stats_iter(gpointer key, gpointer value, gpointer data)
     return false;
 }
 
+static void dump_exclusive_info(FILE *f, fprintf_function cpu_fprintf)
+{
+    size_t steps = 0;
+    CPUState *cpu;
+
+    CPU_FOREACH(cpu) {
+        steps += atomic_read(&cpu->exclusive_steps);
+    }
+    cpu_fprintf(f, "Exclusive steps     %zu\n", steps);
+    if (steps) {
+        CPU_FOREACH(cpu) {
+            cpu_fprintf(f, "  cpu #%-13d%zu\n", cpu->cpu_index,
+                        atomic_read(&cpu->exclusive_steps));
+        }
+    }
+}
+
+static void dump_restore_info(FILE *f, fprintf_function cpu_fprintf)
+{
+    size_t count = 0, insns = 0;
+    int64_t time = 0;
+    CPUState *cpu;
+
+    CPU_FOREACH(cpu) {
+        count += atomic_read(&cpu->tb_restore_count);
+        insns += atomic_read(&cpu->tb_restore_insns);
+        time += atomic_read_i64(&cpu->tb_restore_time);
+    }
+    cpu_fprintf(f, "TB restore count    %zu\n", count);
+    cpu_fprintf(f, "  avg insns decoded %0.1f\n",
+                count ? (double)insns / count : 0);
+    cpu_fprintf(f, "  avg time          %0.1f ns\n",
+                count ? (double)time / count : 0);
+}
+
+static void dump_fastmem_info(FILE *f, fprintf_function cpu_fprintf)
+{
+    size_t faults = 0, slow_exits = 0;
+    CPUState *cpu;
+
+    CPU_FOREACH(cpu) {
+        faults += atomic_read(&cpu->fastmem_faults);
+        slow_exits += atomic_read(&cpu->fastmem_slow_exits);
+    }
+    cpu_fprintf(f, "Fastmem faults      %zu\n", faults);
+    cpu_fprintf(f, "  to slow path      %zu\n", slow_exits);
+}
+
+static void dump_halt_poll_info(FILE *f, fprintf_function cpu_fprintf)
+{
+    size_t polls = 0, successes = 0;
+    int64_t time = 0;
+    CPUState *cpu;
+
+    CPU_FOREACH(cpu) {
+        polls += atomic_read(&cpu->halt_poll_attempts);
+        successes += atomic_read(&cpu->halt_poll_successes);
+        time += atomic_read_i64(&cpu->halt_poll_time);
+    }
+    cpu_fprintf(f, "Halt polls          %zu\n", polls);
+    cpu_fprintf(f, "  successful        %zu (%0.1f%%)\n", successes,
+                polls ? (double)successes * 100 / polls : 0);
+    cpu_fprintf(f, "  avg time          %0.1f ns\n",
+                polls ? (double)time / polls : 0);
+}
+
 void dump_exec_info(FILE *f, fprintf_function cpu_fprintf)
 {
     struct tb_tree_stats tst = {};
@@ -2310,6 +2663,14 @@ void dump_exec_info(FILE *f, fprintf_function cpu_fprintf)
     cpu_fprintf(f, "TB avg host size    %zu bytes (expansion ratio: %0.1f)\n",
                 nb_tbs ? tst.host_size / nb_tbs : 0,
                 tst.target_size ? (double)tst.host_size / tst.target_size : 0);
+    if (tst.cold_size) {
+        cpu_fprintf(f, "TB avg cold size    %zu bytes\n",
+                    nb_tbs ? tst.cold_size / nb_tbs : 0);
+    }
+    cpu_fprintf(f, "code buffer pages   %s\n",
+                tcg_ctx->code_gen_buffer_page_size ? "hugetlb" :
+                tcg_ctx->code_gen_buffer_huge_size ? "transparent huge" :
+                "normal");
     cpu_fprintf(f, "cross page TB count %zu (%zu%%)\n", tst.cross_page,
             nb_tbs ? (tst.cross_page * 100) / nb_tbs : 0);
     cpu_fprintf(f, "direct jump count   %zu (%zu%%) (2 jumps=%zu %zu%%)\n",
@@ -2326,7 +2687,24 @@ void dump_exec_info(FILE *f, fprintf_function cpu_fprintf)
     cpu_fprintf(f, "TB flush count      %u\n",
                 atomic_read(&tb_ctx.tb_flush_count));
     cpu_fprintf(f, "TB invalidate count %zu\n", tcg_tb_phys_invalidate_count());
+    cpu_fprintf(f, "Region evict count  %u\n",
+                atomic_read(&tb_ctx.region_evict_count));
+    if (tcg_return_stack) {
+        size_t ras_hits = 0, ras_misses = 0;
+        CPUState *cpu;
+
+        CPU_FOREACH(cpu) {
+            ras_hits += atomic_read(&cpu->tb_ras_hits);
+            ras_misses += atomic_read(&cpu->tb_ras_misses);
+        }
+        cpu_fprintf(f, "Return stack hits   %zu\n", ras_hits);
+        cpu_fprintf(f, "Return stack misses %zu\n", ras_misses);
+    }
     cpu_fprintf(f, "TLB flush count     %zu\n", tlb_flush_count());
+    dump_exclusive_info(f, cpu_fprintf);
+    dump_restore_info(f, cpu_fprintf);
+    dump_fastmem_info(f, cpu_fprintf);
+    dump_halt_poll_info(f, cpu_fprintf);
     tcg_dump_info(f, cpu_fprintf);
 }
 
@@ -15,6 +15,8 @@
 #include "tcg/tcg-op.h"
 #include "exec/exec-all.h"
 #include "exec/gen-icount.h"
+#include "exec/helper-gen.h"
+#include "exec/tb-hash.h"
 #include "exec/log.h"
 #include "exec/translator.h"
 
@@ -31,6 +33,202 @@ void translator_loop_temp_check(DisasContextBase *db)
     }
 }
 
+/* Executions of a TB before it is retranslated as a superblock */
+#define TB_SUPERBLOCK_THRESHOLD 1000
+
+/* Maximum number of jumps followed in a superblock */
+#define TB_SUPERBLOCK_MAX_JUMPS 8
+
+bool translator_follow_jump(DisasContextBase *db, target_ulong pc_end,
+                            target_ulong dest)
+{
+    if (!(tb_cflags(db->tb) & CF_SUPERBLOCK)
+        || db->num_jumps >= TB_SUPERBLOCK_MAX_JUMPS
+        || db->num_insns >= db->max_insns
+        || tcg_op_buf_full()) {
+        return false;
+    }
+    /*
+     * Stay within the page of the first instruction, and do not go
+     * backwards past it, so that [pc_first, pc_max) covers all the
+     * translated code and page invalidation keeps working.
+     */
+    if (dest < db->pc_first
+        || (dest & TARGET_PAGE_MASK) != (db->pc_first & TARGET_PAGE_MASK)) {
+        return false;
+    }
+    db->pc_max = MAX(db->pc_max, pc_end);
+    db->num_jumps++;
+    return true;
+}
+
+/*
+ * Count the executions of the TB, and have it retranslated as a
+ * superblock once it is hot.  Only done where the front end supports
+ * superblocks, and not when the number of instructions matters.
+ *
+ * With MTTCG, vCPUs running the same TB race on the counter.  A lost
+ * increment only delays the retranslation, and the threshold test is
+ * an inequality so that the count cannot step over it.
+ */
+static void gen_superblock_check(DisasContextBase *db)
+{
+#ifdef TARGET_SUPPORTS_SUPERBLOCKS
+    TCGv_ptr tb_ptr;
+    TCGv_i32 count;
+    TCGLabel *cold;
+
+    if (!tcg_superblocks || db->singlestep_enabled || singlestep
+        || (tb_cflags(db->tb) & (CF_SUPERBLOCK | CF_NOCACHE | CF_USE_ICOUNT |
+                                 CF_LAST_IO | CF_COUNT_MASK))) {
+        return;
+    }
+
+    count = tcg_temp_new_i32();
+    cold = gen_new_label();
+
+    tb_ptr = tcg_const_tb_ptr(db->tb);
+    tcg_gen_ld_i32(count, tb_ptr, offsetof(TranslationBlock, exec_count));
+    tcg_gen_addi_i32(count, count, 1);
+    tcg_gen_st_i32(count, tb_ptr, offsetof(TranslationBlock, exec_count));
+    tcg_temp_free_ptr(tb_ptr);
+    tcg_gen_brcondi_i32(TCG_COND_LTU, count, TB_SUPERBLOCK_THRESHOLD, cold);
+
+    /* Temporaries do not live across the branch */
+    tb_ptr = tcg_const_tb_ptr(db->tb);
+    gen_helper_exit_superblock(cpu_env, tb_ptr);
+    tcg_temp_free_ptr(tb_ptr);
+    gen_set_label(cold);
+
+    tcg_temp_free_i32(count);
+#endif
+}
+
+#define RAS_OFFSET(field) (-ENV_OFFSET + offsetof(CPUState, field))
+
+/* Point @entry at tb_ras[@top], relative to cpu_env */
+static void gen_ras_entry(TCGv_ptr entry, TCGv_i32 top)
+{
+    TCGv_i32 ofs = tcg_temp_new_i32();
+
+    QEMU_BUILD_BUG_ON(sizeof(TBReturnEntry) != 16);
+    tcg_gen_shli_i32(ofs, top, 4);
+    tcg_gen_ext_i32_ptr(entry, ofs);
+    tcg_gen_add_ptr(entry, entry, cpu_env);
+    tcg_temp_free_i32(ofs);
+}
+
+void translator_ras_push(DisasContextBase *db, target_ulong ret_pc)
+{
+    TCGv_i32 top;
+    TCGv_ptr entry, tb;
+    TCGv_i64 pc;
+
+    if (!tcg_return_stack) {
+        return;
+    }
+
+    top = tcg_temp_new_i32();
+    entry = tcg_temp_new_ptr();
+    tb = tcg_temp_new_ptr();
+    pc = tcg_const_i64(ret_pc);
+
+    tcg_gen_ld_i32(top, cpu_env, RAS_OFFSET(tb_ras_top));
+    tcg_gen_addi_i32(top, top, 1);
+    tcg_gen_andi_i32(top, top, TB_RAS_SIZE - 1);
+    tcg_gen_st_i32(top, cpu_env, RAS_OFFSET(tb_ras_top));
+
+    /* The hash is a constant, so this is a single load */
+    tcg_gen_ld_ptr(tb, cpu_env,
+                   RAS_OFFSET(tb_jmp_cache[tb_jmp_cache_hash_func(ret_pc)]));
+    gen_ras_entry(entry, top);
+    tcg_gen_st_i64(pc, entry, RAS_OFFSET(tb_ras[0].pc));
+    tcg_gen_st_ptr(tb, entry, RAS_OFFSET(tb_ras[0].tb));
+
+    tcg_temp_free_i64(pc);
+    tcg_temp_free_ptr(tb);
+    tcg_temp_free_ptr(entry);
+    tcg_temp_free_i32(top);
+}
+
+void translator_ras_lookup_and_goto_ptr(DisasContextBase *db, TCGv dest,
+                                        uint32_t flags)
+{
+    TCGv_i32 top, t32;
+    TCGv_ptr entry, tb, ptr;
+    TCGv_i64 pc, dest64;
+    TCGv dest_local, t;
+    TCGLabel *miss;
+
+    if (!tcg_return_stack || !TCG_TARGET_HAS_goto_ptr
+        || qemu_loglevel_mask(CPU_LOG_TB_NOCHAIN)) {
+        tcg_gen_lookup_and_goto_ptr();
+        return;
+    }
+
+    top = tcg_temp_new_i32();
+    entry = tcg_temp_new_ptr();
+    pc = tcg_temp_new_i64();
+    dest64 = tcg_temp_new_i64();
+    /* These are used after the first branch */
+    tb = tcg_temp_local_new_ptr();
+    dest_local = tcg_temp_local_new();
+    miss = gen_new_label();
+
+    tcg_gen_mov_tl(dest_local, dest);
+    tcg_gen_extu_tl_i64(dest64, dest);
+
+    /* Pop the prediction */
+    tcg_gen_ld_i32(top, cpu_env, RAS_OFFSET(tb_ras_top));
+    gen_ras_entry(entry, top);
+    tcg_gen_subi_i32(top, top, 1);
+    tcg_gen_andi_i32(top, top, TB_RAS_SIZE - 1);
+    tcg_gen_st_i32(top, cpu_env, RAS_OFFSET(tb_ras_top));
+    tcg_gen_ld_i64(pc, entry, RAS_OFFSET(tb_ras[0].pc));
+    tcg_gen_ld_ptr(tb, entry, RAS_OFFSET(tb_ras[0].tb));
+    tcg_gen_brcond_i64(TCG_COND_NE, pc, dest64, miss);
+    tcg_gen_brcondi_ptr(TCG_COND_EQ, tb, 0, miss);
+
+    tcg_temp_free_i64(dest64);
+    tcg_temp_free_i64(pc);
+    tcg_temp_free_ptr(entry);
+    tcg_temp_free_i32(top);
+
+    /*
+     * Check the TB as tb_lookup__cpu_state would.  The state that selects
+     * TBs is known at translation time.
+     */
+    t = tcg_temp_new();
+    tcg_gen_ld_tl(t, tb, offsetof(TranslationBlock, pc));
+    tcg_gen_brcond_tl(TCG_COND_NE, t, dest_local, miss);
+    tcg_gen_ld_tl(t, tb, offsetof(TranslationBlock, cs_base));
+    tcg_gen_brcondi_tl(TCG_COND_NE, t, db->tb->cs_base, miss);
+    tcg_temp_free(t);
+
+    t32 = tcg_temp_new_i32();
+    tcg_gen_ld_i32(t32, tb, offsetof(TranslationBlock, flags));
+    tcg_gen_brcondi_i32(TCG_COND_NE, t32, flags, miss);
+    tcg_gen_ld_i32(t32, tb, offsetof(TranslationBlock, cflags));
+    tcg_gen_andi_i32(t32, t32, CF_HASH_MASK | CF_INVALID);
+    tcg_gen_brcondi_i32(TCG_COND_NE, t32, curr_cflags(), miss);
+    tcg_temp_free_i32(t32);
+
+    ptr = tcg_temp_new_ptr();
+    tcg_gen_ld_ptr(ptr, cpu_env, RAS_OFFSET(tb_ras_hits));
+    tcg_gen_addi_ptr(ptr, ptr, 1);
+    tcg_gen_st_ptr(ptr, cpu_env, RAS_OFFSET(tb_ras_hits));
+    tcg_gen_ld_ptr(ptr, tb, offsetof(TranslationBlock, tc.ptr));
+    tcg_gen_op1i(INDEX_op_goto_ptr, tcgv_ptr_arg(ptr));
+
+    gen_set_label(miss);
+    gen_helper_lookup_tb_ptr_ret(ptr, cpu_env);
+    tcg_gen_op1i(INDEX_op_goto_ptr, tcgv_ptr_arg(ptr));
+    tcg_temp_free_ptr(ptr);
+
+    tcg_temp_free(dest_local);
+    tcg_temp_free_ptr(tb);
+}
+
 void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
                      CPUState *cpu, TranslationBlock *tb)
 {
@@ -43,6 +241,8 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
     db->is_jmp = DISAS_NEXT;
     db->num_insns = 0;
     db->singlestep_enabled = cpu->singlestep_enabled;
+    db->pc_max = db->pc_first;
+    db->num_jumps = 0;
 
     /* Instruction counting */
     db->max_insns = tb_cflags(db->tb) & CF_COUNT_MASK;
@@ -64,6 +264,7 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
 
     /* Start translating.  */
     gen_tb_start(db->tb);
+    gen_superblock_check(db);
     ops->tb_start(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
 
@@ -125,7 +326,7 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
     gen_tb_end(db->tb, db->num_insns - bp_insn);
 
     /* The disas_log hook may use these values rather than recompute.  */
-    db->tb->size = db->pc_next - db->pc_first;
+    db->tb->size = MAX(db->pc_max, db->pc_next) - db->pc_first;
     db->tb->icount = db->num_insns;
 
 #ifdef DEBUG_DISAS
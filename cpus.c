@@ -49,10 +49,15 @@
 #include "qemu/option.h"
 #include "qemu/bitmap.h"
 #include "qemu/seqlock.h"
+#include "qemu/processor.h"
 #include "tcg.h"
 #include "hw/nmi.h"
 #include "sysemu/replay.h"
 #include "hw/boards.h"
+#ifdef CONFIG_LINUX
+#include "accel/tcg/perf.h"
+#endif
+#include "accel/tcg/fastmem.h"
 
 #ifdef CONFIG_LINUX
 
@@ -83,6 +88,12 @@ static unsigned int throttle_percentage;
 #define CPU_THROTTLE_PCT_MAX 99
 #define CPU_THROTTLE_TIMESLICE_NS 10000000
 
+/* halt polling controls, see qemu_tcg_halt_poll() */
+#define HALT_POLL_START_NS 10000
+static int64_t halt_poll_max_ns;
+static int64_t halt_poll_grow;
+static int64_t halt_poll_shrink;
+
 bool cpu_is_stopped(CPUState *cpu)
 {
     return cpu->stopped || !runstate_is_running();
@@ -229,6 +240,47 @@ void qemu_tcg_configure(QemuOpts *opts, Error **errp)
     } else {
         mttcg_enabled = default_mttcg_enabled();
     }
+
+    tcg_superblocks = qemu_opt_get_bool(opts, "superblocks", false);
+    tcg_return_stack = qemu_opt_get_bool(opts, "return-stack", false);
+    tcg_atomic_locks = qemu_opt_get_bool(opts, "atomic-locks", false);
+
+    if (qemu_opt_get_bool(opts, "fastmem", false)) {
+#if TCG_FASTMEM
+        tcg_fastmem = true;
+#else
+        error_setg(errp, "fastmem is not supported for this guest and host");
+        return;
+#endif
+    }
+
+    halt_poll_max_ns = qemu_opt_get_number(opts, "halt-poll-max-ns", 0);
+    halt_poll_grow = qemu_opt_get_number(opts, "halt-poll-grow", 0);
+    halt_poll_shrink = qemu_opt_get_number(opts, "halt-poll-shrink", 0);
+    if (halt_poll_max_ns < 0 || halt_poll_grow < 0 || halt_poll_shrink < 0) {
+        error_setg(errp, "halt polling parameters must not be negative");
+        return;
+    }
+    if (halt_poll_max_ns && !mttcg_enabled) {
+        warn_report("halt polling is only supported with multi-threaded TCG");
+    }
+
+    if (qemu_opt_get_bool(opts, "perfmap", false)) {
+#ifdef CONFIG_LINUX
+        perf_enable_perfmap();
+#else
+        error_setg(errp, "perfmap is only supported on Linux hosts");
+        return;
+#endif
+    }
+    if (qemu_opt_get_bool(opts, "jitdump", false)) {
+#ifdef CONFIG_LINUX
+        perf_enable_jitdump();
+#else
+        error_setg(errp, "jitdump is only supported on Linux hosts");
+        return;
+#endif
+    }
 }
 
 /* The current number of executed instructions is based on what we
@@ -1232,8 +1284,68 @@ static void qemu_tcg_rr_wait_io_event(CPUState *cpu)
     qemu_wait_io_event_common(cpu);
 }
 
+/*
+ * Put an idle TCG vCPU to sleep, but first spin for a while waiting to be
+ * kicked, so that an interrupt arriving shortly afterwards does not pay for
+ * waking up the thread.  Like KVM's halt_poll_ns, the polling time of each
+ * vCPU grows while it is woken up within halt_poll_max_ns of going idle, and
+ * shrinks when it sleeps for longer than that.
+ */
+static void qemu_tcg_halt_poll(CPUState *cpu)
+{
+    int64_t start = get_clock();
+    int64_t poll_ns = cpu->halt_poll_ns;
+    int64_t idle_ns;
+
+    if (poll_ns) {
+        /*
+         * Everything that makes the vCPU busy again goes through
+         * qemu_cpu_kick(), which sets exit_request, so there is no need
+         * to take the BQL to check cpu_thread_is_idle() while spinning.
+         */
+        qemu_mutex_unlock_iothread();
+        while (!atomic_read(&cpu->exit_request) &&
+               get_clock() - start < poll_ns) {
+            cpu_relax();
+        }
+        qemu_mutex_lock_iothread();
+
+        atomic_set(&cpu->halt_poll_attempts, cpu->halt_poll_attempts + 1);
+        atomic_set_i64(&cpu->halt_poll_time,
+                       cpu->halt_poll_time + get_clock() - start);
+        if (!cpu_thread_is_idle(cpu)) {
+            atomic_set(&cpu->halt_poll_successes,
+                       cpu->halt_poll_successes + 1);
+            return;
+        }
+    }
+
+    while (cpu_thread_is_idle(cpu)) {
+        qemu_cond_wait(cpu->halt_cond, &qemu_global_mutex);
+    }
+
+    idle_ns = get_clock() - start;
+    if (idle_ns > halt_poll_max_ns) {
+        if (halt_poll_shrink) {
+            poll_ns /= halt_poll_shrink;
+        } else {
+            poll_ns = 0;
+        }
+    } else if (poll_ns < halt_poll_max_ns) {
+        poll_ns = poll_ns ? poll_ns * (halt_poll_grow ?: 2)
+                          : HALT_POLL_START_NS;
+        poll_ns = MIN(poll_ns, halt_poll_max_ns);
+    }
+    atomic_set_i64(&cpu->halt_poll_ns, poll_ns);
+}
+
 static void qemu_wait_io_event(CPUState *cpu)
 {
+    if (tcg_enabled() && halt_poll_max_ns) {
+        if (cpu_thread_is_idle(cpu)) {
+            qemu_tcg_halt_poll(cpu);
+        }
+    }
     while (cpu_thread_is_idle(cpu)) {
         qemu_cond_wait(cpu->halt_cond, &qemu_global_mutex);
     }
@@ -1464,6 +1576,9 @@ static void *qemu_tcg_rr_cpu_thread_fn(void *arg)
     assert(tcg_enabled());
     rcu_register_thread();
     tcg_register_thread();
+    if (tcg_fastmem) {
+        fastmem_init_thread();
+    }
 
     qemu_mutex_lock_iothread();
     qemu_thread_get_self(cpu->thread);
@@ -1701,6 +1816,9 @@ static void *qemu_tcg_cpu_thread_fn(void *arg)
 
     rcu_register_thread();
     tcg_register_thread();
+    if (tcg_fastmem) {
+        fastmem_init_thread();
+    }
 
     qemu_mutex_lock_iothread();
     qemu_thread_get_self(cpu->thread);
@@ -2341,6 +2459,17 @@ CpuInfoFastList *qmp_query_cpus_fast(Error **errp)
             info->value->props = props;
         }
 
+        if (tcg_enabled() && halt_poll_max_ns) {
+            CpuHaltPollInfo *poll = g_malloc0(sizeof(*poll));
+
+            poll->poll_ns = atomic_read_i64(&cpu->halt_poll_ns);
+            poll->polls = atomic_read(&cpu->halt_poll_attempts);
+            poll->successful_polls = atomic_read(&cpu->halt_poll_successes);
+            poll->poll_time_ns = atomic_read_i64(&cpu->halt_poll_time);
+            info->value->has_halt_poll = true;
+            info->value->halt_poll = poll;
+        }
+
         info->value->arch = sysemu_target_to_cpuinfo_arch(target);
         info->value->target = target;
         if (target == SYS_EMU_TARGET_S390X) {
@@ -37,6 +37,76 @@ int dma_memory_set(AddressSpace *as, dma_addr_t addr, uint8_t c, dma_addr_t len)
     return error;
 }
 
+static void dma_ring_cache_remap(DMARingCache *cache)
+{
+    address_space_cache_destroy(&cache->mrc);
+    cache->mrc = MEMORY_REGION_CACHE_INVALID;
+    if (cache->size) {
+        address_space_cache_init(&cache->mrc, cache->as,
+                                 cache->base, cache->size, true);
+    }
+    trace_dma_ring_cache_map(cache, cache->base, cache->size,
+                             dma_ring_cache_is_direct(cache, 0, cache->size));
+}
+
+static void dma_ring_cache_commit(MemoryListener *listener)
+{
+    DMARingCache *cache = container_of(listener, DMARingCache, listener);
+
+    /*
+     * Commits for other address spaces, or that left the memory map of
+     * ours unchanged, keep the same FlatView.
+     */
+    if (cache->size &&
+        cache->mrc.fv != address_space_to_flatview(cache->as)) {
+        dma_ring_cache_remap(cache);
+    }
+}
+
+void dma_ring_cache_init(DMARingCache *cache, AddressSpace *as)
+{
+    cache->as = as;
+    cache->base = 0;
+    cache->size = 0;
+    cache->mrc = MEMORY_REGION_CACHE_INVALID;
+    cache->listener = (MemoryListener) {
+        .commit = dma_ring_cache_commit,
+    };
+    memory_listener_register(&cache->listener, as);
+}
+
+void dma_ring_cache_destroy(DMARingCache *cache)
+{
+    memory_listener_unregister(&cache->listener);
+    address_space_cache_destroy(&cache->mrc);
+    cache->mrc = MEMORY_REGION_CACHE_INVALID;
+    cache->size = 0;
+}
+
+bool dma_ring_cache_map(DMARingCache *cache, dma_addr_t base, dma_addr_t size)
+{
+    if (base != cache->base || size != cache->size) {
+        cache->base = base;
+        cache->size = size;
+        dma_ring_cache_remap(cache);
+    }
+    if (!size) {
+        return false;
+    }
+
+    /*
+     * Windows that are not direct RAM, for example behind an IOMMU, are
+     * still usable through the dma_memory_rw() fallback.
+     */
+    return dma_ring_cache_is_direct(cache, 0, size) ||
+           dma_memory_valid(cache->as, base, size, DMA_DIRECTION_FROM_DEVICE);
+}
+
+void dma_ring_cache_unmap(DMARingCache *cache)
+{
+    dma_ring_cache_map(cache, 0, 0);
+}
+
 void qemu_sglist_init(QEMUSGList *qsg, DeviceState *dev, int alloc_hint,
                       AddressSpace *as)
 {
@@ -157,7 +227,7 @@ static void dma_blk_cb(void *opaque, int ret)
     if (dbs->iov.size == 0) {
         trace_dma_map_wait(dbs);
         dbs->bh = aio_bh_new(dbs->ctx, reschedule_dma, dbs);
-        cpu_register_map_client(dbs->bh);
+        address_space_register_map_client(dbs->sg->as, dbs->bh);
         return;
     }
 
@@ -183,7 +253,7 @@ static void dma_aio_cancel(BlockAIOCB *acb)
         blk_aio_cancel_async(dbs->acb);
     }
     if (dbs->bh) {
-        cpu_unregister_map_client(dbs->bh);
+        address_space_unregister_map_client(dbs->sg->as, dbs->bh);
         qemu_bh_delete(dbs->bh);
         dbs->bh = NULL;
     }
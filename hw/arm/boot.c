@@ -769,6 +769,7 @@ static void do_cpu_reset(void *opaque)
             }
         }
     }
+    arm_rebuild_hflags(env);
 }
 
 /**
@@ -237,20 +237,13 @@ static void ahci_trigger_irq(AHCIState *s, AHCIDevice *d,
     ahci_check_irq(s);
 }
 
-static void map_page(AddressSpace *as, uint8_t **ptr, uint64_t addr,
-                     uint32_t wanted)
+static bool map_page(DMARingCache *cache, uint64_t addr, uint32_t wanted)
 {
-    hwaddr len = wanted;
-
-    if (*ptr) {
-        dma_memory_unmap(as, *ptr, len, DMA_DIRECTION_FROM_DEVICE, len);
-    }
-
-    *ptr = dma_memory_map(as, addr, &len, DMA_DIRECTION_FROM_DEVICE);
-    if (len < wanted) {
-        dma_memory_unmap(as, *ptr, len, DMA_DIRECTION_FROM_DEVICE, len);
-        *ptr = NULL;
+    if (!dma_ring_cache_map(cache, addr, wanted)) {
+        dma_ring_cache_unmap(cache);
+        return false;
     }
+    return true;
 }
 
 /**
@@ -715,9 +708,8 @@ static char *ahci_pretty_buffer_fis(uint8_t *fis, int cmd_len)
 static bool ahci_map_fis_address(AHCIDevice *ad)
 {
     AHCIPortRegs *pr = &ad->port_regs;
-    map_page(ad->hba->as, &ad->res_fis,
-             ((uint64_t)pr->fis_addr_hi << 32) | pr->fis_addr, 256);
-    if (ad->res_fis != NULL) {
+    if (map_page(&ad->res_fis,
+                 ((uint64_t)pr->fis_addr_hi << 32) | pr->fis_addr, 256)) {
         pr->cmd |= PORT_CMD_FIS_ON;
         return true;
     }
@@ -728,23 +720,20 @@ static bool ahci_map_fis_address(AHCIDevice *ad)
 
 static void ahci_unmap_fis_address(AHCIDevice *ad)
 {
-    if (ad->res_fis == NULL) {
+    if (!(ad->port_regs.cmd & PORT_CMD_FIS_ON)) {
         trace_ahci_unmap_fis_address_null(ad->hba, ad->port_no);
         return;
     }
     ad->port_regs.cmd &= ~PORT_CMD_FIS_ON;
-    dma_memory_unmap(ad->hba->as, ad->res_fis, 256,
-                     DMA_DIRECTION_FROM_DEVICE, 256);
-    ad->res_fis = NULL;
+    dma_ring_cache_unmap(&ad->res_fis);
 }
 
 static bool ahci_map_clb_address(AHCIDevice *ad)
 {
     AHCIPortRegs *pr = &ad->port_regs;
-    ad->cur_cmd = NULL;
-    map_page(ad->hba->as, &ad->lst,
-             ((uint64_t)pr->lst_addr_hi << 32) | pr->lst_addr, 1024);
-    if (ad->lst != NULL) {
+    ad->cur_slot = -1;
+    if (map_page(&ad->lst,
+                 ((uint64_t)pr->lst_addr_hi << 32) | pr->lst_addr, 1024)) {
         pr->cmd |= PORT_CMD_LIST_ON;
         return true;
     }
@@ -755,14 +744,12 @@ static bool ahci_map_clb_address(AHCIDevice *ad)
 
 static void ahci_unmap_clb_address(AHCIDevice *ad)
 {
-    if (ad->lst == NULL) {
+    if (!(ad->port_regs.cmd & PORT_CMD_LIST_ON)) {
         trace_ahci_unmap_clb_address_null(ad->hba, ad->port_no);
         return;
     }
     ad->port_regs.cmd &= ~PORT_CMD_LIST_ON;
-    dma_memory_unmap(ad->hba->as, ad->lst, 1024,
-                     DMA_DIRECTION_FROM_DEVICE, 1024);
-    ad->lst = NULL;
+    dma_ring_cache_unmap(&ad->lst);
 }
 
 static void ahci_write_fis_sdb(AHCIState *s, NCQTransferState *ncq_tfs)
@@ -770,23 +757,24 @@ static void ahci_write_fis_sdb(AHCIState *s, NCQTransferState *ncq_tfs)
     AHCIDevice *ad = ncq_tfs->drive;
     AHCIPortRegs *pr = &ad->port_regs;
     IDEState *ide_state;
-    SDBFIS *sdb_fis;
+    SDBFIS sdb_fis;
 
-    if (!ad->res_fis ||
+    if (!(pr->cmd & PORT_CMD_FIS_ON) ||
         !(pr->cmd & PORT_CMD_FIS_RX)) {
         return;
     }
 
-    sdb_fis = (SDBFIS *)&ad->res_fis[RES_FIS_SDBFIS];
     ide_state = &ad->port.ifs[0];
 
-    sdb_fis->type = SATA_FIS_TYPE_SDB;
+    sdb_fis.type = SATA_FIS_TYPE_SDB;
     /* Interrupt pending & Notification bit */
-    sdb_fis->flags = 0x40; /* Interrupt bit, always 1 for NCQ */
-    sdb_fis->status = ide_state->status & 0x77;
-    sdb_fis->error = ide_state->error;
+    sdb_fis.flags = 0x40; /* Interrupt bit, always 1 for NCQ */
+    sdb_fis.status = ide_state->status & 0x77;
+    sdb_fis.error = ide_state->error;
     /* update SAct field in SDB_FIS */
-    sdb_fis->payload = cpu_to_le32(ad->finished);
+    sdb_fis.payload = cpu_to_le32(ad->finished);
+    dma_ring_cache_write(&ad->res_fis, RES_FIS_SDBFIS,
+                         &sdb_fis, sizeof(sdb_fis));
 
     /* Update shadow registers (except BSY 0x80 and DRQ 0x08) */
     pr->tfdata = (ad->port.ifs[0].error << 8) |
@@ -796,7 +784,7 @@ static void ahci_write_fis_sdb(AHCIState *s, NCQTransferState *ncq_tfs)
     ad->finished = 0;
 
     /* Trigger IRQ if interrupt bit is set (which currently, it always is) */
-    if (sdb_fis->flags & 0x40) {
+    if (sdb_fis.flags & 0x40) {
         ahci_trigger_irq(s, ad, AHCI_PORT_IRQ_BIT_SDBS);
     }
 }
@@ -804,15 +792,13 @@ static void ahci_write_fis_sdb(AHCIState *s, NCQTransferState *ncq_tfs)
 static void ahci_write_fis_pio(AHCIDevice *ad, uint16_t len, bool pio_fis_i)
 {
     AHCIPortRegs *pr = &ad->port_regs;
-    uint8_t *pio_fis;
+    uint8_t pio_fis[20];
     IDEState *s = &ad->port.ifs[0];
 
-    if (!ad->res_fis || !(pr->cmd & PORT_CMD_FIS_RX)) {
+    if (!(pr->cmd & PORT_CMD_FIS_ON) || !(pr->cmd & PORT_CMD_FIS_RX)) {
         return;
     }
 
-    pio_fis = &ad->res_fis[RES_FIS_PSFIS];
-
     pio_fis[0] = SATA_FIS_TYPE_PIO_SETUP;
     pio_fis[1] = (pio_fis_i ? (1 << 6) : 0);
     pio_fis[2] = s->status;
@@ -834,6 +820,8 @@ static void ahci_write_fis_pio(AHCIDevice *ad, uint16_t len, bool pio_fis_i)
     pio_fis[17] = len >> 8;
     pio_fis[18] = 0;
     pio_fis[19] = 0;
+    dma_ring_cache_write(&ad->res_fis, RES_FIS_PSFIS,
+                         pio_fis, sizeof(pio_fis));
 
     /* Update shadow registers: */
     pr->tfdata = (ad->port.ifs[0].error << 8) |
@@ -847,16 +835,14 @@ static void ahci_write_fis_pio(AHCIDevice *ad, uint16_t len, bool pio_fis_i)
 static bool ahci_write_fis_d2h(AHCIDevice *ad)
 {
     AHCIPortRegs *pr = &ad->port_regs;
-    uint8_t *d2h_fis;
+    uint8_t d2h_fis[20];
     int i;
     IDEState *s = &ad->port.ifs[0];
 
-    if (!ad->res_fis || !(pr->cmd & PORT_CMD_FIS_RX)) {
+    if (!(pr->cmd & PORT_CMD_FIS_ON) || !(pr->cmd & PORT_CMD_FIS_RX)) {
         return false;
     }
 
-    d2h_fis = &ad->res_fis[RES_FIS_RFIS];
-
     d2h_fis[0] = SATA_FIS_TYPE_REGISTER_D2H;
     d2h_fis[1] = (1 << 6); /* interrupt bit */
     d2h_fis[2] = s->status;
@@ -875,6 +861,8 @@ static bool ahci_write_fis_d2h(AHCIDevice *ad)
     for (i = 14; i < 20; i++) {
         d2h_fis[i] = 0;
     }
+    dma_ring_cache_write(&ad->res_fis, RES_FIS_RFIS,
+                         d2h_fis, sizeof(d2h_fis));
 
     /* Update shadow registers: */
     pr->tfdata = (ad->port.ifs[0].error << 8) |
@@ -1099,6 +1087,32 @@ static void execute_ncq_command(NCQTransferState *ncq_tfs)
 }
 
 
+static bool get_cmd_header(AHCIState *s, uint8_t port, uint8_t slot,
+                           AHCICmdHdr *cmd)
+{
+    if (port >= s->ports || slot >= AHCI_MAX_CMDS ||
+        !(s->dev[port].port_regs.cmd & PORT_CMD_LIST_ON)) {
+        memset(cmd, 0, sizeof(*cmd));
+        return false;
+    }
+
+    dma_ring_cache_read(&s->dev[port].lst, slot * sizeof(AHCICmdHdr),
+                        cmd, sizeof(*cmd));
+    return true;
+}
+
+/* Update the transferred byte count of a command in guest memory */
+static void set_cmd_status(AHCIState *s, uint8_t port, uint8_t slot,
+                           uint32_t status)
+{
+    uint32_t val = cpu_to_le32(status);
+
+    dma_ring_cache_write(&s->dev[port].lst,
+                         slot * sizeof(AHCICmdHdr) +
+                         offsetof(AHCICmdHdr, status),
+                         &val, sizeof(val));
+}
+
 static void process_ncq_command(AHCIState *s, int port, uint8_t *cmd_fis,
                                 uint8_t slot)
 {
@@ -1106,6 +1120,7 @@ static void process_ncq_command(AHCIState *s, int port, uint8_t *cmd_fis,
     NCQFrame *ncq_fis = (NCQFrame*)cmd_fis;
     uint8_t tag = ncq_fis->tag >> 3;
     NCQTransferState *ncq_tfs = &ad->ncq_tfs[tag];
+    AHCICmdHdr cmd;
     size_t size;
 
     g_assert(is_ncq(ncq_fis->command));
@@ -1118,7 +1133,6 @@ static void process_ncq_command(AHCIState *s, int port, uint8_t *cmd_fis,
     ncq_tfs->used = 1;
     ncq_tfs->drive = ad;
     ncq_tfs->slot = slot;
-    ncq_tfs->cmdh = &((AHCICmdHdr *)ad->lst)[slot];
     ncq_tfs->cmd = ncq_fis->command;
     ncq_tfs->lba = ((uint64_t)ncq_fis->lba5 << 40) |
                    ((uint64_t)ncq_fis->lba4 << 32) |
@@ -1152,7 +1166,8 @@ static void process_ncq_command(AHCIState *s, int port, uint8_t *cmd_fis,
         ncq_tfs->sector_count = 0x10000;
     }
     size = ncq_tfs->sector_count * 512;
-    ahci_populate_sglist(ad, &ncq_tfs->sglist, ncq_tfs->cmdh, size, 0);
+    get_cmd_header(s, port, slot, &cmd);
+    ahci_populate_sglist(ad, &ncq_tfs->sglist, &cmd, size, 0);
 
     if (ncq_tfs->sglist.size < size) {
         error_report("ahci: PRDT length for NCQ command (0x%zx) "
@@ -1173,21 +1188,15 @@ static void process_ncq_command(AHCIState *s, int port, uint8_t *cmd_fis,
     execute_ncq_command(ncq_tfs);
 }
 
-static AHCICmdHdr *get_cmd_header(AHCIState *s, uint8_t port, uint8_t slot)
-{
-    if (port >= s->ports || slot >= AHCI_MAX_CMDS) {
-        return NULL;
-    }
-
-    return s->dev[port].lst ? &((AHCICmdHdr *)s->dev[port].lst)[slot] : NULL;
-}
-
 static void handle_reg_h2d_fis(AHCIState *s, int port,
                                uint8_t slot, uint8_t *cmd_fis)
 {
     IDEState *ide_state = &s->dev[port].port.ifs[0];
-    AHCICmdHdr *cmd = get_cmd_header(s, port, slot);
-    uint16_t opts = le16_to_cpu(cmd->opts);
+    AHCICmdHdr cmd;
+    uint16_t opts;
+
+    get_cmd_header(s, port, slot, &cmd);
+    opts = le16_to_cpu(cmd.opts);
 
     if (cmd_fis[1] & 0x0F) {
         trace_handle_reg_h2d_fis_pmp(s, port, cmd_fis[1],
@@ -1261,7 +1270,7 @@ static void handle_reg_h2d_fis(AHCIState *s, int port,
     ide_state->error = 0;
     s->dev[port].done_first_drq = false;
     /* Reset transferred byte counter */
-    cmd->status = 0;
+    set_cmd_status(s, port, slot, 0);
 
     /* We're ready to process the command in FIS byte 2. */
     ide_exec_cmd(&s->dev[port].port, cmd_fis[2]);
@@ -1271,7 +1280,7 @@ static int handle_cmd(AHCIState *s, int port, uint8_t slot)
 {
     IDEState *ide_state;
     uint64_t tbl_addr;
-    AHCICmdHdr *cmd;
+    AHCICmdHdr cmd;
     uint8_t *cmd_fis;
     dma_addr_t cmd_len;
 
@@ -1281,13 +1290,12 @@ static int handle_cmd(AHCIState *s, int port, uint8_t slot)
         return -1;
     }
 
-    if (!s->dev[port].lst) {
+    if (!get_cmd_header(s, port, slot, &cmd)) {
         trace_handle_cmd_nolist(s, port);
         return -1;
     }
-    cmd = get_cmd_header(s, port, slot);
     /* remember current slot handle for later */
-    s->dev[port].cur_cmd = cmd;
+    s->dev[port].cur_slot = slot;
 
     /* The device we are working for */
     ide_state = &s->dev[port].port.ifs[0];
@@ -1296,7 +1304,7 @@ static int handle_cmd(AHCIState *s, int port, uint8_t slot)
         return -1;
     }
 
-    tbl_addr = le64_to_cpu(cmd->tbl_addr);
+    tbl_addr = le64_to_cpu(cmd.tbl_addr);
     cmd_len = 0x80;
     cmd_fis = dma_memory_map(s->as, tbl_addr, &cmd_len,
                              DMA_DIRECTION_FROM_DEVICE);
@@ -1343,13 +1351,19 @@ static void ahci_pio_transfer(IDEDMA *dma)
     AHCIDevice *ad = DO_UPCAST(AHCIDevice, dma, dma);
     IDEState *s = &ad->port.ifs[0];
     uint32_t size = (uint32_t)(s->data_end - s->data_ptr);
-    /* write == ram -> device */
-    uint16_t opts = le16_to_cpu(ad->cur_cmd->opts);
-    int is_write = opts & AHCI_CMD_WRITE;
-    int is_atapi = opts & AHCI_CMD_ATAPI;
+    AHCICmdHdr cmd;
+    uint16_t opts;
+    int is_write;
+    int is_atapi;
     int has_sglist = 0;
     bool pio_fis_i;
 
+    get_cmd_header(ad->hba, ad->port_no, ad->cur_slot, &cmd);
+    opts = le16_to_cpu(cmd.opts);
+    /* write == ram -> device */
+    is_write = opts & AHCI_CMD_WRITE;
+    is_atapi = opts & AHCI_CMD_ATAPI;
+
     /* The PIO Setup FIS is received prior to transfer, but the interrupt
      * is only triggered after data is received.
      *
@@ -1436,8 +1450,10 @@ static int32_t ahci_dma_prepare_buf(IDEDMA *dma, int32_t limit)
 {
     AHCIDevice *ad = DO_UPCAST(AHCIDevice, dma, dma);
     IDEState *s = &ad->port.ifs[0];
+    AHCICmdHdr cmd;
 
-    if (ahci_populate_sglist(ad, &s->sg, ad->cur_cmd,
+    get_cmd_header(ad->hba, ad->port_no, ad->cur_slot, &cmd);
+    if (ahci_populate_sglist(ad, &s->sg, &cmd,
                              limit, s->io_buffer_offset) == -1) {
         trace_ahci_dma_prepare_buf_fail(ad->hba, ad->port_no);
         return -1;
@@ -1456,9 +1472,12 @@ static int32_t ahci_dma_prepare_buf(IDEDMA *dma, int32_t limit)
 static void ahci_commit_buf(IDEDMA *dma, uint32_t tx_bytes)
 {
     AHCIDevice *ad = DO_UPCAST(AHCIDevice, dma, dma);
+    AHCICmdHdr cmd;
 
-    tx_bytes += le32_to_cpu(ad->cur_cmd->status);
-    ad->cur_cmd->status = cpu_to_le32(tx_bytes);
+    if (get_cmd_header(ad->hba, ad->port_no, ad->cur_slot, &cmd)) {
+        set_cmd_status(ad->hba, ad->port_no, ad->cur_slot,
+                       le32_to_cpu(cmd.status) + tx_bytes);
+    }
 }
 
 static int ahci_dma_rw_buf(IDEDMA *dma, int is_write)
@@ -1467,8 +1486,10 @@ static int ahci_dma_rw_buf(IDEDMA *dma, int is_write)
     IDEState *s = &ad->port.ifs[0];
     uint8_t *p = s->io_buffer + s->io_buffer_index;
     int l = s->io_buffer_size - s->io_buffer_index;
+    AHCICmdHdr cmd;
 
-    if (ahci_populate_sglist(ad, &s->sg, ad->cur_cmd, l, s->io_buffer_offset)) {
+    get_cmd_header(ad->hba, ad->port_no, ad->cur_slot, &cmd);
+    if (ahci_populate_sglist(ad, &s->sg, &cmd, l, s->io_buffer_offset)) {
         return 0;
     }
 
@@ -1552,6 +1573,9 @@ void ahci_realize(AHCIState *s, DeviceState *qdev, AddressSpace *as, int ports)
         ad->port_no = i;
         ad->port.dma = &ad->dma;
         ad->port.dma->ops = &ahci_dma_ops;
+        ad->cur_slot = -1;
+        dma_ring_cache_init(&ad->lst, as);
+        dma_ring_cache_init(&ad->res_fis, as);
         ide_register_restart_cb(&ad->port);
     }
     g_free(irqs);
@@ -1569,6 +1593,8 @@ void ahci_uninit(AHCIState *s)
 
             ide_exit(s);
         }
+        dma_ring_cache_destroy(&ad->lst);
+        dma_ring_cache_destroy(&ad->res_fis);
         object_unparent(OBJECT(&ad->port));
     }
 
@@ -1599,6 +1625,8 @@ void ahci_reset(AHCIState *s)
         pr->irq_mask = 0;
         pr->scr_ctl = 0;
         pr->cmd = PORT_CMD_SPIN_UP | PORT_CMD_POWER_ON;
+        dma_ring_cache_unmap(&s->dev[i].lst);
+        dma_ring_cache_unmap(&s->dev[i].res_fis);
         ahci_reset_port(s, i);
     }
 }
@@ -1655,6 +1683,7 @@ static int ahci_state_post_load(void *opaque, int version_id)
     struct AHCIDevice *ad;
     NCQTransferState *ncq_tfs;
     AHCIPortRegs *pr;
+    AHCICmdHdr cmd;
     AHCIState *s = opaque;
 
     for (i = 0; i < s->ports; i++) {
@@ -1697,12 +1726,11 @@ static int ahci_state_post_load(void *opaque, int version_id)
             }
             /* If ncq_tfs->halt is justly set, the engine should be engaged,
              * and the command list buffer should be mapped. */
-            ncq_tfs->cmdh = get_cmd_header(s, i, ncq_tfs->slot);
-            if (!ncq_tfs->cmdh) {
+            if (!get_cmd_header(s, i, ncq_tfs->slot, &cmd)) {
                 return -1;
             }
             ahci_populate_sglist(ncq_tfs->drive, &ncq_tfs->sglist,
-                                 ncq_tfs->cmdh, ncq_tfs->sector_count * 512,
+                                 &cmd, ncq_tfs->sector_count * 512,
                                  0);
             if (ncq_tfs->sector_count != ncq_tfs->sglist.size >> 9) {
                 return -1;
@@ -1726,7 +1754,7 @@ static int ahci_state_post_load(void *opaque, int version_id)
             if (ad->busy_slot < 0 || ad->busy_slot >= AHCI_MAX_CMDS) {
                 return -1;
             }
-            ad->cur_cmd = get_cmd_header(s, i, ad->busy_slot);
+            ad->cur_slot = ad->busy_slot;
         }
     }
 
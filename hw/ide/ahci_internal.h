@@ -292,7 +292,6 @@ typedef struct AHCI_SG {
 typedef struct NCQTransferState {
     AHCIDevice *drive;
     BlockAIOCB *aiocb;
-    AHCICmdHdr *cmdh;
     QEMUSGList sglist;
     BlockAcctCookie acct;
     uint32_t sector_count;
@@ -313,12 +312,12 @@ struct AHCIDevice {
     AHCIPortRegs port_regs;
     struct AHCIState *hba;
     QEMUBH *check_bh;
-    uint8_t *lst;
-    uint8_t *res_fis;
+    DMARingCache lst;
+    DMARingCache res_fis;
     bool done_first_drq;
     int32_t busy_slot;
     bool init_d2h_sent;
-    AHCICmdHdr *cur_cmd;
+    int32_t cur_slot;
     NCQTransferState ncq_tfs[AHCI_MAX_CMDS];
 };
 
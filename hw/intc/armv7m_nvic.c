@@ -380,6 +380,13 @@ bool armv7m_nvic_neg_prio_requested(void *opaque, bool secure)
      */
     NVICState *s = opaque;
 
+    /* The CPU is reset, and recomputes its TB flags, while it is being
+     * realized; that happens before the NVIC is connected to it.
+     */
+    if (!s->cpu) {
+        return false;
+    }
+
     if (s->cpu->env.v7m.faultmask[secure]) {
         return true;
     }
@@ -1994,6 +2001,8 @@ static MemTxResult nvic_sysreg_write(void *opaque, hwaddr addr,
     }
     if (size == 4) {
         nvic_writel(s, offset, value, attrs);
+        /* CCR and the exception state are inputs to the cached TB flags */
+        arm_rebuild_hflags(&s->cpu->env);
         return MEMTX_OK;
     }
     qemu_log_mask(LOG_GUEST_ERROR,
@@ -2104,6 +2113,8 @@ static int nvic_post_load(void *opaque, int version_id)
     }
 
     nvic_recompute_state(s);
+    /* The CPU may have been loaded before us */
+    arm_rebuild_hflags(&s->cpu->env);
 
     return 0;
 }
@@ -2251,6 +2262,9 @@ static void armv7m_nvic_reset(DeviceState *dev)
             s->itns[i] = true;
         }
     }
+
+    /* The execution priority feeds the CPU's cached TB flags */
+    arm_rebuild_hflags(&s->cpu->env);
 }
 
 static void nvic_systick_trigger(void *opaque, int n, int level)
@@ -774,8 +774,9 @@ e1000e_rx_wb_interrupt_cause(E1000ECore *core, int queue_idx,
 }
 
 static uint32_t
-e1000e_txdesc_writeback(E1000ECore *core, dma_addr_t base,
-                        struct e1000_tx_desc *dp, bool *ide, int queue_idx)
+e1000e_txdesc_writeback(E1000ECore *core, DMARingCache *ring,
+                        dma_addr_t offset, struct e1000_tx_desc *dp,
+                        bool *ide, int queue_idx)
 {
     uint32_t txd_upper, txd_lower = le32_to_cpu(dp->lower.data);
 
@@ -789,8 +790,8 @@ e1000e_txdesc_writeback(E1000ECore *core, dma_addr_t base,
     txd_upper = le32_to_cpu(dp->upper.data) | E1000_TXD_STAT_DD;
 
     dp->upper.data = cpu_to_le32(txd_upper);
-    pci_dma_write(core->owner, base + ((char *)&dp->upper - (char *)dp),
-                  &dp->upper, sizeof(dp->upper));
+    dma_ring_cache_write(ring, offset + ((char *)&dp->upper - (char *)dp),
+                         &dp->upper, sizeof(dp->upper));
     return e1000e_tx_wb_interrupt_cause(core, queue_idx);
 }
 
@@ -820,9 +821,9 @@ e1000e_ring_base(E1000ECore *core, const E1000E_RingInfo *r)
 }
 
 static inline uint64_t
-e1000e_ring_head_descr(E1000ECore *core, const E1000E_RingInfo *r)
+e1000e_ring_head_offset(E1000ECore *core, const E1000E_RingInfo *r)
 {
-    return e1000e_ring_base(core, r) + E1000_RING_DESC_LEN * core->mac[r->dh];
+    return E1000_RING_DESC_LEN * core->mac[r->dh];
 }
 
 static inline void
@@ -866,9 +867,19 @@ e1000e_ring_len(E1000ECore *core, const E1000E_RingInfo *r)
     return core->mac[r->dlen];
 }
 
+/* The guest may have moved or resized the ring since it was last used */
+static inline void
+e1000e_ring_cache_map(E1000ECore *core, DMARingCache *cache,
+                      const E1000E_RingInfo *r)
+{
+    dma_ring_cache_map(cache, e1000e_ring_base(core, r),
+                       e1000e_ring_len(core, r));
+}
+
 typedef struct E1000E_TxRing_st {
     const E1000E_RingInfo *i;
     struct e1000e_tx *tx;
+    DMARingCache *cache;
 } E1000E_TxRing;
 
 static inline int
@@ -889,10 +900,12 @@ e1000e_tx_ring_init(E1000ECore *core, E1000E_TxRing *txr, int idx)
 
     txr->i     = &i[idx];
     txr->tx    = &core->tx[idx];
+    txr->cache = &core->tx_ring[idx];
 }
 
 typedef struct E1000E_RxRing_st {
     const E1000E_RingInfo *i;
+    DMARingCache *cache;
 } E1000E_RxRing;
 
 static inline void
@@ -906,12 +919,13 @@ e1000e_rx_ring_init(E1000ECore *core, E1000E_RxRing *rxr, int idx)
     assert(idx < ARRAY_SIZE(i));
 
     rxr->i      = &i[idx];
+    rxr->cache  = &core->rx_ring[idx];
 }
 
 static void
 e1000e_start_xmit(E1000ECore *core, const E1000E_TxRing *txr)
 {
-    dma_addr_t base;
+    dma_addr_t offset;
     struct e1000_tx_desc desc;
     bool ide = false;
     const E1000E_RingInfo *txi = txr->i;
@@ -922,16 +936,19 @@ e1000e_start_xmit(E1000ECore *core, const E1000E_TxRing *txr)
         return;
     }
 
+    e1000e_ring_cache_map(core, txr->cache, txi);
+
     while (!e1000e_ring_empty(core, txi)) {
-        base = e1000e_ring_head_descr(core, txi);
+        offset = e1000e_ring_head_offset(core, txi);
 
-        pci_dma_read(core->owner, base, &desc, sizeof(desc));
+        dma_ring_cache_read(txr->cache, offset, &desc, sizeof(desc));
 
         trace_e1000e_tx_descr((void *)(intptr_t)desc.buffer_addr,
                               desc.lower.data, desc.upper.data);
 
         e1000e_process_tx_desc(core, txr->tx, &desc, txi->idx);
-        cause |= e1000e_txdesc_writeback(core, base, &desc, &ide, txi->idx);
+        cause |= e1000e_txdesc_writeback(core, txr->cache, offset,
+                                         &desc, &ide, txi->idx);
 
         e1000e_ring_advance(core, txi, 1);
     }
@@ -1495,8 +1512,7 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
                              const E1000E_RxRing *rxr,
                              const E1000E_RSSInfo *rss_info)
 {
-    PCIDevice *d = core->owner;
-    dma_addr_t base;
+    dma_addr_t offset;
     uint8_t desc[E1000_MAX_RX_DESC_LEN];
     size_t desc_size;
     size_t desc_offset = 0;
@@ -1511,6 +1527,7 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
     bool is_first = true;
 
     rxi = rxr->i;
+    e1000e_ring_cache_map(core, rxr->cache, rxi);
 
     do {
         hwaddr ba[MAX_PS_BUFFERS];
@@ -1527,11 +1544,12 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
             return;
         }
 
-        base = e1000e_ring_head_descr(core, rxi);
+        offset = e1000e_ring_head_offset(core, rxi);
 
-        pci_dma_read(d, base, &desc, core->rx_desc_len);
+        dma_ring_cache_read(rxr->cache, offset, &desc, core->rx_desc_len);
 
-        trace_e1000e_rx_descr(rxi->idx, base, core->rx_desc_len);
+        trace_e1000e_rx_descr(rxi->idx, rxr->cache->base + offset,
+                              core->rx_desc_len);
 
         e1000e_read_rx_descr(core, desc, &ba);
 
@@ -1605,7 +1623,7 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
 
         e1000e_write_rx_descr(core, desc, is_last ? core->rx_pkt : NULL,
                            rss_info, do_ps ? ps_hdr_len : 0, &bastate.written);
-        pci_dma_write(d, base, &desc, core->rx_desc_len);
+        dma_ring_cache_write(rxr->cache, offset, &desc, core->rx_desc_len);
 
         e1000e_ring_advance(core, rxi,
                             core->rx_desc_len / E1000_MIN_RX_DESC_LEN);
@@ -3330,6 +3348,8 @@ e1000e_core_pci_realize(E1000ECore     *core,
     for (i = 0; i < E1000E_NUM_QUEUES; i++) {
         net_tx_pkt_init(&core->tx[i].tx_pkt, core->owner,
                         E1000E_MAX_TX_FRAGS, core->has_vnet);
+        pci_dma_ring_cache_init(&core->tx_ring[i], core->owner);
+        pci_dma_ring_cache_init(&core->rx_ring[i], core->owner);
     }
 
     net_rx_pkt_init(&core->rx_pkt, core->has_vnet);
@@ -3357,6 +3377,8 @@ e1000e_core_pci_uninit(E1000ECore *core)
     for (i = 0; i < E1000E_NUM_QUEUES; i++) {
         net_tx_pkt_reset(core->tx[i].tx_pkt);
         net_tx_pkt_uninit(core->tx[i].tx_pkt);
+        dma_ring_cache_destroy(&core->tx_ring[i]);
+        dma_ring_cache_destroy(&core->rx_ring[i]);
     }
 
     net_rx_pkt_uninit(core->rx_pkt);
@@ -78,6 +78,9 @@ struct E1000Core {
 
     struct NetRxPkt *rx_pkt;
 
+    DMARingCache tx_ring[E1000E_NUM_QUEUES];
+    DMARingCache rx_ring[E1000E_NUM_QUEUES];
+
     bool has_vnet;
     int max_queue_num;
 
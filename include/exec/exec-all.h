@@ -71,8 +71,12 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 void QEMU_NORETURN cpu_loop_exit(CPUState *cpu);
 void QEMU_NORETURN cpu_loop_exit_restore(CPUState *cpu, uintptr_t pc);
 void QEMU_NORETURN cpu_loop_exit_atomic(CPUState *cpu, uintptr_t pc);
+void QEMU_NORETURN cpu_loop_exit_superblock(CPUState *cpu,
+                                            TranslationBlock *tb,
+                                            uintptr_t pc);
 
 #if !defined(CONFIG_USER_ONLY)
+void QEMU_NORETURN cpu_loop_exit_fastmem(CPUState *cpu, uintptr_t pc);
 void cpu_reloading_memory_map(void);
 /**
  * cpu_address_space_init:
@@ -104,6 +108,11 @@ void cpu_address_space_init(CPUState *cpu, int asidx,
  * @cpu: CPU whose TLB should be initialized
  */
 void tlb_init(CPUState *cpu);
+/**
+ * tlb_destroy - free a CPU's TLB
+ * @cpu: CPU whose TLB should be freed
+ */
+void tlb_destroy(CPUState *cpu);
 /**
  * tlb_flush_page:
  * @cpu: CPU whose TLB should be flushed
@@ -266,6 +275,9 @@ void probe_write(CPUArchState *env, target_ulong addr, int size, int mmu_idx,
 static inline void tlb_init(CPUState *cpu)
 {
 }
+static inline void tlb_destroy(CPUState *cpu)
+{
+}
 static inline void tlb_flush_page(CPUState *cpu, target_ulong addr)
 {
 }
@@ -335,6 +347,8 @@ static inline void tlb_flush_by_mmuidx_all_cpus_synced(CPUState *cpu,
 struct tb_tc {
     void *ptr;    /* pointer to the translated code */
     size_t size;
+    void *cold_ptr; /* slow paths and constant pool, if apart from ptr */
+    size_t cold_size;
 };
 
 struct TranslationBlock {
@@ -351,6 +365,8 @@ struct TranslationBlock {
 #define CF_USE_ICOUNT  0x00020000
 #define CF_INVALID     0x00040000 /* TB is stale. Set with @jmp_lock held */
 #define CF_PARALLEL    0x00080000 /* Generate code for a parallel context */
+#define CF_SUPERBLOCK  0x00100000 /* Follow direct jumps across blocks */
+#define CF_NOFASTMEM   0x00200000 /* Access guest RAM through the TLB */
 /* cflags' mask for hashing/comparison */
 #define CF_HASH_MASK   \
     (CF_COUNT_MASK | CF_LAST_IO | CF_USE_ICOUNT | CF_PARALLEL)
@@ -358,6 +374,9 @@ struct TranslationBlock {
     /* Per-vCPU dynamic tracing state used to generate this TB */
     uint32_t trace_vcpu_dstate;
 
+    /* Number of executions, counted until promotion to a superblock */
+    uint32_t exec_count;
+
     struct tb_tc tc;
 
     /* original tb when cflags has CF_NOCACHE */
@@ -405,6 +424,10 @@ struct TranslationBlock {
 };
 
 extern bool parallel_cpus;
+extern bool tcg_superblocks;
+extern bool tcg_return_stack;
+extern bool tcg_atomic_locks;
+extern bool tcg_fastmem;
 
 /* Hide the atomic_read to make code a little easier on the eyes */
 static inline uint32_t tb_cflags(const TranslationBlock *tb)
@@ -430,6 +430,12 @@ struct MemoryListener {
     QTAILQ_ENTRY(MemoryListener) link_as;
 };
 
+/* Default limit on the bounce buffers that an #AddressSpace hands out */
+#define DEFAULT_MAX_BOUNCE_BUFFER_SIZE 4096
+
+typedef struct BounceBuffer BounceBuffer;
+typedef struct AddressSpaceMapClient AddressSpaceMapClient;
+
 /**
  * AddressSpace: describes a mapping of addresses to #MemoryRegion objects
  */
@@ -446,6 +452,19 @@ struct AddressSpace {
     struct MemoryRegionIoeventfd *ioeventfds;
     QTAILQ_HEAD(memory_listeners_as, MemoryListener) listeners;
     QTAILQ_ENTRY(AddressSpace) address_spaces_link;
+
+    /*
+     * Bounce buffers of address_space_map(), and the clients waiting for
+     * one to be released.  Protected by bounce_lock; bounce_buffer_size is
+     * also read atomically.
+     */
+    QemuMutex bounce_lock;
+    size_t max_bounce_buffer_size;
+    size_t bounce_buffer_size;
+    QLIST_HEAD(, BounceBuffer) bounce_buffers;
+    QLIST_HEAD(, AddressSpaceMapClient) map_client_list;
+    uint64_t bounce_buffer_maps;
+    uint64_t bounce_buffer_waits;
 };
 
 typedef struct AddressSpaceDispatch AddressSpaceDispatch;
@@ -462,6 +481,8 @@ struct FlatView {
     unsigned nr_allocated;
     struct AddressSpaceDispatch *dispatch;
     MemoryRegion *root;
+    /* Where each MemoryRegion was rendered; updated under the BQL.  */
+    GHashTable *deps;
 };
 
 static inline FlatView *address_space_to_flatview(AddressSpace *as)
@@ -1974,8 +1995,11 @@ bool address_space_access_valid(AddressSpace *as, hwaddr addr, int len,
  * May map a subset of the requested range, given by and returned in @plen.
  * May return %NULL if resources needed to perform the mapping are exhausted.
  * Use only for reads OR writes - not for read-modify-write operations.
- * Use cpu_register_map_client() to know when retrying the map operation is
- * likely to succeed.
+ * Use address_space_register_map_client() to know when retrying the map
+ * operation is likely to succeed.
+ *
+ * Memory that is not RAM is copied through bounce buffers, which use up to
+ * max_bounce_buffer_size bytes per address space.
  *
  * @as: #AddressSpace to be accessed
  * @addr: address within that address space
@@ -2000,6 +2024,24 @@ void *address_space_map(AddressSpace *as, hwaddr addr,
 void address_space_unmap(AddressSpace *as, void *buffer, hwaddr len,
                          int is_write, hwaddr access_len);
 
+/* address_space_register_map_client: wait for address_space_map() to succeed
+ *
+ * Schedule @bh once a bounce buffer of @as is released, or right away if one
+ * is available.  @bh is scheduled only once.
+ *
+ * @as: #AddressSpace whose address_space_map() returned %NULL
+ * @bh: bottom half to schedule
+ */
+void address_space_register_map_client(AddressSpace *as, QEMUBH *bh);
+
+/* address_space_unregister_map_client: cancel
+ * address_space_register_map_client()
+ *
+ * @as: #AddressSpace passed to address_space_register_map_client()
+ * @bh: bottom half passed to address_space_register_map_client()
+ */
+void address_space_unregister_map_client(AddressSpace *as, QEMUBH *bh);
+
 
 /* Internal functions, part of the implementation of address_space_read.  */
 MemTxResult address_space_read_full(AddressSpace *as, hwaddr addr,
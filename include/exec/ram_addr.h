@@ -22,6 +22,7 @@
 #ifndef CONFIG_USER_ONLY
 #include "hw/xen/xen.h"
 #include "exec/ramlist.h"
+#include "qemu/cutils.h"
 
 struct RAMBlock {
     struct rcu_head rcu;
@@ -407,6 +408,14 @@ static inline void cpu_physical_memory_clear_dirty_range(ram_addr_t start,
 }
 
 
+/*
+ * Number of words of the dirty bitmap that
+ * cpu_physical_memory_sync_dirty_bitmap() checks at once with
+ * buffer_is_zero(), which is vectorized.  Most of the
+ * bitmap is clean, even while the guest is busy.
+ */
+#define DIRTY_SYNC_ZERO_WORDS 64
+
 static inline
 uint64_t cpu_physical_memory_sync_dirty_bitmap(RAMBlock *rb,
                                                ram_addr_t start,
@@ -435,18 +444,31 @@ uint64_t cpu_physical_memory_sync_dirty_bitmap(RAMBlock *rb,
         src = atomic_rcu_read(
                 &ram_list.dirty_memory[DIRTY_MEMORY_MIGRATION])->blocks;
 
-        for (k = page; k < page + nr; k++) {
-            if (src[idx][offset]) {
-                unsigned long bits = atomic_xchg(&src[idx][offset], 0);
-                unsigned long new_dirty;
-                *real_dirty_pages += ctpopl(bits);
-                new_dirty = ~dest[k];
-                dest[k] |= bits;
-                new_dirty &= bits;
-                num_dirty += ctpopl(new_dirty);
+        for (k = page; k < page + nr; ) {
+            unsigned long chunk = MIN(page + nr - k, DIRTY_SYNC_ZERO_WORDS);
+            unsigned long i;
+
+            chunk = MIN(chunk,
+                        BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE) - offset);
+            if (chunk < DIRTY_SYNC_ZERO_WORDS ||
+                !buffer_is_zero(&src[idx][offset], chunk * sizeof(long))) {
+                for (i = 0; i < chunk; i++) {
+                    if (src[idx][offset + i]) {
+                        unsigned long bits = atomic_xchg(&src[idx][offset + i],
+                                                         0);
+                        unsigned long new_dirty;
+                        *real_dirty_pages += ctpopl(bits);
+                        new_dirty = ~dest[k + i];
+                        dest[k + i] |= bits;
+                        new_dirty &= bits;
+                        num_dirty += ctpopl(new_dirty);
+                    }
+                }
             }
 
-            if (++offset >= BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE)) {
+            k += chunk;
+            offset += chunk;
+            if (offset >= BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE)) {
                 offset = 0;
                 idx++;
             }
@@ -5,6 +5,7 @@
 #include "qemu/thread.h"
 #include "qemu/rcu.h"
 #include "qemu/rcu_queue.h"
+#include "qemu/range-index.h"
 
 typedef struct RAMBlockNotifier RAMBlockNotifier;
 
@@ -49,6 +50,11 @@ typedef struct RAMList {
     RAMBlock *mru_block;
     /* RCU-enabled, writes protected by the ramlist lock. */
     QLIST_HEAD(, RAMBlock) blocks;
+    /* The blocks by ram_addr_t and by host address; same protection. */
+    RangeIndex blocks_by_offset;
+    RangeIndex blocks_by_host;
+    /* Blocks left out of blocks_by_host because they overlap another one */
+    unsigned unindexed_host_blocks;
     DirtyMemoryBlocks *dirty_memory[DIRTY_MEMORY_NUM];
     uint32_t version;
     QLIST_HEAD(, RAMBlockNotifier) ramblock_notifiers;
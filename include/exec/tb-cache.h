@@ -0,0 +1,61 @@
+/*
+ * Persistent translation block cache
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#ifndef EXEC_TB_CACHE_H
+#define EXEC_TB_CACHE_H
+
+#include "exec/exec-all.h"
+
+#ifdef CONFIG_USER_ONLY
+extern bool tb_cache_active;
+
+/**
+ * tb_cache_init:
+ * @dir: directory holding the cache files
+ * @cpu_model: the -cpu argument, including any feature flags
+ * @exec_file: path to the guest executable
+ *
+ * Load the cached host code for @exec_file, if any, and start recording
+ * newly translated blocks.  Must be called after the prologue has been
+ * generated, since guest_base is part of the cache key.
+ */
+void tb_cache_init(const char *dir, const char *cpu_model,
+                   const char *exec_file);
+
+/**
+ * tb_cache_save:
+ *
+ * Write the cached and the newly recorded blocks back to disk.  Called
+ * when the guest exits; calling it more than once is harmless.
+ */
+void tb_cache_save(void);
+
+/*
+ * Copy the cached host code matching @tb's key into @tb->tc.ptr and
+ * relocate it.  Returns the size of the code, or -1 if there is no
+ * usable entry; *@search_size is set to the size of the search data
+ * that follows the code.
+ */
+int tb_cache_restore(TranslationBlock *tb, int *search_size);
+
+/* Record a newly generated TB whose code is still unchained.  */
+void tb_cache_record(TranslationBlock *tb, int gen_code_size,
+                     int search_size);
+#else
+#define tb_cache_active false
+
+static inline int tb_cache_restore(TranslationBlock *tb, int *search_size)
+{
+    return -1;
+}
+
+static inline void tb_cache_record(TranslationBlock *tb, int gen_code_size,
+                                   int search_size)
+{
+}
+#endif
+
+#endif /* EXEC_TB_CACHE_H */
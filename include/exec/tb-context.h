@@ -35,6 +35,7 @@ struct TBContext {
 
     /* statistics */
     unsigned tb_flush_count;
+    unsigned region_evict_count;
 };
 
 extern TBContext tb_ctx;
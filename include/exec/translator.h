@@ -60,6 +60,9 @@ typedef enum DisasJumpType {
  * @num_insns: Number of translated instructions (including current).
  * @max_insns: Maximum number of instructions to be translated in this TB.
  * @singlestep_enabled: "Hardware" single stepping enabled.
+ * @pc_max: End of the furthest guest instruction translated so far, when
+ *          jumps were followed (see translator_follow_jump).
+ * @num_jumps: Number of jumps followed in this TB.
  *
  * Architecture-agnostic disassembly context.
  */
@@ -71,6 +74,8 @@ typedef struct DisasContextBase {
     int num_insns;
     int max_insns;
     bool singlestep_enabled;
+    target_ulong pc_max;
+    int num_jumps;
 } DisasContextBase;
 
 /**
@@ -141,4 +146,46 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
 
 void translator_loop_temp_check(DisasContextBase *db);
 
+/**
+ * translator_follow_jump:
+ * @db: Disassembly context.
+ * @pc_end: Address of the instruction following the jump.
+ * @dest: Destination of the jump.
+ *
+ * When building a superblock (CF_SUPERBLOCK), a target may translate a
+ * direct jump by continuing the translation at @dest, rather than by
+ * ending the TB; conditional branches then leave the TB through side exits.
+ * Return true if this is allowed, in which case the target must set
+ * db->pc_next to @dest and keep going.
+ *
+ * Targets that use this must define TARGET_SUPPORTS_SUPERBLOCKS.
+ */
+bool translator_follow_jump(DisasContextBase *db, target_ulong pc_end,
+                            target_ulong dest);
+
+/**
+ * translator_ras_push:
+ * @db: Disassembly context.
+ * @ret_pc: Return address of the call being translated.
+ *
+ * With tcg_return_stack, push @ret_pc on the vCPU's return address stack,
+ * along with the TB that the jump cache currently holds for it.
+ */
+void translator_ras_push(DisasContextBase *db, target_ulong ret_pc);
+
+/**
+ * translator_ras_lookup_and_goto_ptr:
+ * @db: Disassembly context.
+ * @dest: Guest pc that the return being translated jumps to.
+ * @flags: TB flags that the TB at @dest is looked up with.
+ *
+ * Like tcg_gen_lookup_and_goto_ptr, but first pop the return address
+ * stack and, if it predicted @dest, jump straight to the TB it holds.
+ * The cs_base must not have changed since the start of the TB, and
+ * @flags must be known at translation time; the pc must already be
+ * written back.
+ */
+void translator_ras_lookup_and_goto_ptr(DisasContextBase *db, TCGv dest,
+                                        uint32_t flags);
+
 #endif  /* EXEC__TRANSLATOR_H */
@@ -344,6 +344,9 @@ struct PCIDevice {
     MemoryRegion rom;
     uint32_t rom_bar;
 
+    /* Limit on the bounce buffers of bus_master_as */
+    uint64_t max_bounce_buffer_size;
+
     /* INTx routing notifier */
     PCIINTxRoutingNotifier intx_routing_notifier;
 
@@ -817,6 +820,11 @@ static inline void pci_dma_sglist_init(QEMUSGList *qsg, PCIDevice *dev,
     qemu_sglist_init(qsg, DEVICE(dev), alloc_hint, pci_get_address_space(dev));
 }
 
+static inline void pci_dma_ring_cache_init(DMARingCache *cache, PCIDevice *dev)
+{
+    dma_ring_cache_init(cache, pci_get_address_space(dev));
+}
+
 extern const VMStateDescription vmstate_pci_device;
 
 #define VMSTATE_PCI_DEVICE(_field, _state) {                         \
@@ -0,0 +1,44 @@
+/*
+ * RCU-safe index of disjoint ranges
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#ifndef QEMU_RANGE_INDEX_H
+#define QEMU_RANGE_INDEX_H
+
+/*
+ * A RangeIndex maps disjoint [start, start + size) ranges to opaque
+ * pointers.  It is a sorted array that is looked up with a binary search.
+ *
+ * Lookups only need to be in an RCU read-side critical section.  Updates
+ * copy the array and must be serialized by the caller; they are meant for
+ * indexes that change rarely but are looked up often.
+ *
+ * A zero-initialized RangeIndex is empty.
+ */
+
+typedef struct RangeIndexTable RangeIndexTable;
+
+typedef struct RangeIndex {
+    RangeIndexTable *table;
+} RangeIndex;
+
+/* Free @ri, which must not be in use by any reader anymore.  */
+void range_index_destroy(RangeIndex *ri);
+
+/*
+ * Add [@start, @start + @size) to @ri, with @opaque as its value.  The
+ * range must not be empty.  Return false, leaving @ri unchanged, if it
+ * overlaps a range that is already in @ri.
+ */
+bool range_index_insert(RangeIndex *ri, uint64_t start, uint64_t size,
+                        void *opaque);
+
+/* Remove the range that starts at @start.  */
+void range_index_remove(RangeIndex *ri, uint64_t start);
+
+/* Return the value of the range that contains @addr, or NULL.  */
+void *range_index_lookup(RangeIndex *ri, uint64_t addr);
+
+#endif
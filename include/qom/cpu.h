@@ -251,6 +251,19 @@ struct hax_vcpu_state;
 #define TB_JMP_CACHE_BITS 12
 #define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
 
+#define TB_RAS_BITS 4
+#define TB_RAS_SIZE (1 << TB_RAS_BITS)
+
+/*
+ * An entry of the return address stack: the guest pc following a call,
+ * and the TB that the jump cache held for it at the time of the call.
+ * Sized so that generated code can index the stack with a shift.
+ */
+typedef struct TBReturnEntry {
+    uint64_t pc;
+    struct TranslationBlock *tb;
+} QEMU_ALIGNED(16) TBReturnEntry;
+
 /* work queue */
 
 /* The union type allows passing of 64 bit target pointers on 32 bit
@@ -369,6 +382,37 @@ struct CPUState {
     /* Accessed in parallel; all accesses must be atomic */
     struct TranslationBlock *tb_jmp_cache[TB_JMP_CACHE_SIZE];
 
+    /*
+     * Return address stack, updated by generated code when
+     * tcg_return_stack is set.  The TBs are only valid as long as the
+     * jump cache is, so it is cleared together with it.
+     */
+    TBReturnEntry tb_ras[TB_RAS_SIZE];
+    uint32_t tb_ras_top;
+    size_t tb_ras_hits;
+    size_t tb_ras_misses;
+
+    /* Atomic operations emulated with all other vCPUs stopped */
+    size_t exclusive_steps;
+
+    /* Precise state restores from generated code, for "info jit" */
+    size_t tb_restore_count;
+    size_t tb_restore_insns;
+    int64_t tb_restore_time;
+
+    /* Faults of fastmem accesses, and those that needed the slow path */
+    size_t fastmem_faults;
+    size_t fastmem_slow_exits;
+
+    /*
+     * Halt polling window of a TCG vCPU and its statistics, updated by
+     * the vCPU thread with the BQL held.
+     */
+    int64_t halt_poll_ns;
+    size_t halt_poll_attempts;
+    size_t halt_poll_successes;
+    int64_t halt_poll_time;
+
     struct GDBRegisterState *gdb_regs;
     int gdb_num_regs;
     int gdb_num_g_regs;
@@ -451,6 +495,15 @@ extern struct CPUTailQ cpus;
 
 extern __thread CPUState *current_cpu;
 
+static inline void cpu_tb_ras_clear(CPUState *cpu)
+{
+    unsigned int i;
+
+    for (i = 0; i < TB_RAS_SIZE; i++) {
+        atomic_set(&cpu->tb_ras[i].tb, NULL);
+    }
+}
+
 static inline void cpu_tb_jmp_cache_clear(CPUState *cpu)
 {
     unsigned int i;
@@ -458,6 +511,7 @@ static inline void cpu_tb_jmp_cache_clear(CPUState *cpu)
     for (i = 0; i < TB_JMP_CACHE_SIZE; i++) {
         atomic_set(&cpu->tb_jmp_cache[i], NULL);
     }
+    cpu_tb_ras_clear(cpu);
 }
 
 /**
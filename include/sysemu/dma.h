@@ -185,6 +185,67 @@ DEFINE_LDST_DMA(q, q, 64, be);
 
 #undef DEFINE_LDST_DMA
 
+/*
+ * A DMARingCache keeps a window of guest memory, typically a ring of
+ * descriptors, mapped with a #MemoryRegionCache.  While the window is RAM,
+ * dma_ring_cache_read() and dma_ring_cache_write() access it directly
+ * instead of translating the address for every descriptor.  The mapping
+ * is refreshed whenever the memory map of the address space changes.
+ *
+ * Offsets are relative to the base of the window.  Accesses that fall
+ * outside the window, or to a window that is not directly accessible RAM
+ * (MMIO, or memory behind an IOMMU), go through dma_memory_rw() as usual.
+ *
+ * The cache is not thread-safe: it must only be used with the BQL held.
+ */
+typedef struct DMARingCache {
+    AddressSpace *as;
+    dma_addr_t base;
+    dma_addr_t size;
+    MemoryRegionCache mrc;
+    MemoryListener listener;
+} DMARingCache;
+
+void dma_ring_cache_init(DMARingCache *cache, AddressSpace *as);
+void dma_ring_cache_destroy(DMARingCache *cache);
+
+/*
+ * Make @cache cover the @size bytes at @base; this is cheap if it already
+ * does.  Return true if all of them can be accessed, directly or not.
+ */
+bool dma_ring_cache_map(DMARingCache *cache, dma_addr_t base, dma_addr_t size);
+void dma_ring_cache_unmap(DMARingCache *cache);
+
+static inline bool dma_ring_cache_is_direct(DMARingCache *cache,
+                                            dma_addr_t offset, dma_addr_t len)
+{
+    return cache->mrc.ptr &&
+           offset < cache->mrc.len && len <= cache->mrc.len - offset;
+}
+
+static inline int dma_ring_cache_read(DMARingCache *cache, dma_addr_t offset,
+                                      void *buf, dma_addr_t len)
+{
+    if (likely(dma_ring_cache_is_direct(cache, offset, len))) {
+        dma_barrier(cache->as, DMA_DIRECTION_TO_DEVICE);
+        address_space_read_cached(&cache->mrc, offset, buf, len);
+        return 0;
+    }
+    return dma_memory_read(cache->as, cache->base + offset, buf, len);
+}
+
+static inline int dma_ring_cache_write(DMARingCache *cache, dma_addr_t offset,
+                                       const void *buf, dma_addr_t len)
+{
+    if (likely(dma_ring_cache_is_direct(cache, offset, len))) {
+        dma_barrier(cache->as, DMA_DIRECTION_FROM_DEVICE);
+        address_space_write_cached(&cache->mrc, offset, (void *)buf, len);
+        address_space_cache_invalidate(&cache->mrc, offset, len);
+        return 0;
+    }
+    return dma_memory_write(cache->as, cache->base + offset, buf, len);
+}
+
 struct ScatterGatherEntry {
     dma_addr_t base;
     dma_addr_t len;
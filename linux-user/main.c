@@ -30,6 +30,8 @@
 #include "qemu/help_option.h"
 #include "cpu.h"
 #include "exec/exec-all.h"
+#include "exec/tb-cache.h"
+#include "accel/tcg/perf.h"
 #include "tcg.h"
 #include "qemu/timer.h"
 #include "qemu/envlist.h"
@@ -366,6 +368,32 @@ static void handle_arg_singlestep(const char *arg)
     singlestep = 1;
 }
 
+static const char *tb_cache_dir;
+static void handle_arg_tb_cache(const char *arg)
+{
+    tb_cache_dir = arg;
+}
+
+static void handle_arg_superblocks(const char *arg)
+{
+    tcg_superblocks = true;
+}
+
+static void handle_arg_return_stack(const char *arg)
+{
+    tcg_return_stack = true;
+}
+
+static void handle_arg_perfmap(const char *arg)
+{
+    perf_enable_perfmap();
+}
+
+static void handle_arg_jitdump(const char *arg)
+{
+    perf_enable_jitdump();
+}
+
 static void handle_arg_strace(const char *arg)
 {
     do_strace = 1;
@@ -430,6 +458,16 @@ static const struct qemu_argument arg_table[] = {
      "pagesize",   "set the host page size to 'pagesize'"},
     {"singlestep", "QEMU_SINGLESTEP",  false, handle_arg_singlestep,
      "",           "run in singlestep mode"},
+    {"tb-cache",   "QEMU_TB_CACHE",    true,  handle_arg_tb_cache,
+     "dir",        "keep translated code in directory 'dir' across runs"},
+    {"superblocks", "QEMU_SUPERBLOCKS", false, handle_arg_superblocks,
+     "",           "retranslate hot code as superblocks (x86 guests only)"},
+    {"return-stack", "QEMU_RETURN_STACK", false, handle_arg_return_stack,
+     "",           "predict returns with a return address stack"},
+    {"perfmap",    "QEMU_PERFMAP",     false, handle_arg_perfmap,
+     "",           "Generate a /tmp/perf-${pid}.map file for perf"},
+    {"jitdump",    "QEMU_JITDUMP",     false, handle_arg_jitdump,
+     "",           "Generate a jit-${pid}.dump file for perf"},
     {"strace",     "QEMU_STRACE",      false, handle_arg_strace,
      "",           "log system calls"},
     {"seed",       "QEMU_RAND_SEED",   true,  handle_arg_randseed,
@@ -806,6 +844,11 @@ int main(int argc, char **argv, char **envp)
     tcg_prologue_init(tcg_ctx);
     tcg_region_init();
 
+    /* Breakpoints and singlestep change the code without changing the key */
+    if (tb_cache_dir && !gdbstub_port && !singlestep) {
+        tb_cache_init(tb_cache_dir, cpu_model, filename);
+    }
+
     target_cpu_copy_regs(env, regs);
 
     if (gdbstub_port) {
@@ -23,6 +23,7 @@
 #include "qemu/bitops.h"
 #include "qemu/error-report.h"
 #include "qom/object.h"
+#include "qemu/timer.h"
 #include "trace-root.h"
 
 #include "exec/memory-internal.h"
@@ -33,10 +34,20 @@
 #include "migration/vmstate.h"
 
 //#define DEBUG_UNASSIGNED
+/* #define DEBUG_FLATVIEW_UPDATE */
 
 static unsigned memory_region_transaction_depth;
 static bool memory_region_update_pending;
 static bool ioeventfd_update_pending;
+/*
+ * The regions whose changes are pending, each with a GArray of the changed
+ * AddrRanges relative to the start of the region, so that the next commit
+ * only renders again the address ranges they cover.
+ * memory_region_topology_invalid asks for all FlatViews to be rendered from
+ * scratch instead.
+ */
+static GHashTable *memory_region_changed;
+static bool memory_region_topology_invalid = true;
 static bool global_dirty_log = false;
 
 static QTAILQ_HEAD(memory_listeners, MemoryListener) memory_listeners
@@ -47,6 +58,14 @@ static QTAILQ_HEAD(, AddressSpace) address_spaces
 
 static GHashTable *flat_views;
 
+static struct {
+    uint64_t commits;
+    uint64_t views_rendered;
+    uint64_t views_updated;
+    uint64_t views_reused;
+    int64_t time_ns;
+} topology_stats;
+
 typedef struct AddrRange AddrRange;
 
 /*
@@ -58,6 +77,13 @@ struct AddrRange {
     Int128 size;
 };
 
+/* Where a FlatView rendered a region */
+typedef struct FlatViewDep {
+    AddrRange range;        /* hull of the rendered ranges */
+    Int128 origin;          /* address of offset 0 of the region */
+    bool multiple_origins;  /* rendered at different addresses */
+} FlatViewDep;
+
 static AddrRange addrrange_make(Int128 start, Int128 size)
 {
     return (AddrRange) { start, size };
@@ -250,6 +276,8 @@ static FlatView *flatview_new(MemoryRegion *mr_root)
     view = g_new0(FlatView, 1);
     view->ref = 1;
     view->root = mr_root;
+    view->deps = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                       NULL, g_free);
     memory_region_ref(mr_root);
     trace_flatview_new(view, mr_root);
 
@@ -285,6 +313,9 @@ static void flatview_destroy(FlatView *view)
         memory_region_unref(view->ranges[i].mr);
     }
     g_free(view->ranges);
+    if (view->deps) {
+        g_hash_table_unref(view->deps);
+    }
     memory_region_unref(view->root);
     g_free(view);
 }
@@ -335,6 +366,22 @@ static void flatview_simplify(FlatView *view)
     }
 }
 
+static bool flatview_equal(FlatView *a, FlatView *b)
+{
+    unsigned i;
+
+    if (a->nr != b->nr) {
+        return false;
+    }
+    for (i = 0; i < a->nr; i++) {
+        if (!flatrange_equal(&a->ranges[i], &b->ranges[i])
+            || a->ranges[i].dirty_log_mask != b->ranges[i].dirty_log_mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static bool memory_region_big_endian(MemoryRegion *mr)
 {
 #ifdef TARGET_WORDS_BIGENDIAN
@@ -585,6 +632,34 @@ static AddressSpace *memory_region_to_address_space(MemoryRegion *mr)
     return NULL;
 }
 
+/*
+ * Record that @mr, with offset 0 at @origin, was rendered into @range of
+ * @view.  A change to @mr cannot affect @view outside the ranges recorded
+ * for it: adding or moving a subregion changes its container at the
+ * subregion's address, and resizing a region invalidates the whole
+ * topology.
+ */
+static void flatview_add_dep(FlatView *view, MemoryRegion *mr, Int128 origin,
+                             AddrRange range)
+{
+    FlatViewDep *dep = g_hash_table_lookup(view->deps, mr);
+    Int128 start, end;
+
+    if (!dep) {
+        dep = g_new0(FlatViewDep, 1);
+        dep->range = range;
+        dep->origin = origin;
+        g_hash_table_insert(view->deps, mr, dep);
+        return;
+    }
+
+    /* Keep the hull when the region is rendered more than once */
+    start = int128_min(dep->range.start, range.start);
+    end = int128_max(addrrange_end(dep->range), addrrange_end(range));
+    dep->range = addrrange_make(start, int128_sub(end, start));
+    dep->multiple_origins |= !int128_eq(dep->origin, origin);
+}
+
 /* Render a memory region into the global view.  Ranges in @view obscure
  * ranges in @mr.
  */
@@ -602,10 +677,6 @@ static void render_memory_region(FlatView *view,
     FlatRange fr;
     AddrRange tmp;
 
-    if (!mr->enabled) {
-        return;
-    }
-
     int128_addto(&base, int128_make64(mr->addr));
     readonly |= mr->readonly;
 
@@ -617,6 +688,12 @@ static void render_memory_region(FlatView *view,
 
     clip = addrrange_intersection(tmp, clip);
 
+    /* Disabled regions are recorded too, since enabling them changes @view */
+    flatview_add_dep(view, mr, base, clip);
+    if (!mr->enabled) {
+        return;
+    }
+
     if (mr->alias) {
         int128_subfrom(&base, int128_make64(mr->alias->addr));
         int128_subfrom(&base, int128_make64(mr->alias_offset));
@@ -716,10 +793,22 @@ static MemoryRegion *memory_region_get_flatview_root(MemoryRegion *mr)
     return NULL;
 }
 
+static void flatview_build_dispatch(FlatView *view)
+{
+    int i;
+
+    view->dispatch = address_space_dispatch_new(view);
+    for (i = 0; i < view->nr; i++) {
+        MemoryRegionSection mrs =
+            section_from_flat_range(&view->ranges[i], view);
+        flatview_add_to_dispatch(view, &mrs);
+    }
+    address_space_dispatch_compact(view->dispatch);
+}
+
 /* Render a memory topology into a list of disjoint absolute ranges. */
 static FlatView *generate_memory_topology(MemoryRegion *mr)
 {
-    int i;
     FlatView *view;
 
     view = flatview_new(mr);
@@ -729,17 +818,215 @@ static FlatView *generate_memory_topology(MemoryRegion *mr)
                              addrrange_make(int128_zero(), int128_2_64()), false);
     }
     flatview_simplify(view);
+    flatview_build_dispatch(view);
+    g_hash_table_replace(flat_views, mr, view);
+    topology_stats.views_rendered++;
 
-    view->dispatch = address_space_dispatch_new(view);
-    for (i = 0; i < view->nr; i++) {
-        MemoryRegionSection mrs =
-            section_from_flat_range(&view->ranges[i], view);
-        flatview_add_to_dispatch(view, &mrs);
+    return view;
+}
+
+static gint addrrange_compare(gconstpointer a, gconstpointer b)
+{
+    const AddrRange *ra = a, *rb = b;
+
+    if (int128_lt(ra->start, rb->start)) {
+        return -1;
+    }
+    return int128_gt(ra->start, rb->start);
+}
+
+/*
+ * Return the sorted, disjoint address ranges of @view that the pending
+ * changes may affect.
+ */
+static GArray *flatview_changed_ranges(FlatView *view)
+{
+    GArray *ranges = g_array_new(false, false, sizeof(AddrRange));
+    GHashTableIter iter;
+    gpointer mr, changes;
+    unsigned i, n;
+
+    if (!memory_region_changed) {
+        return ranges;
+    }
+
+    g_hash_table_iter_init(&iter, memory_region_changed);
+    while (g_hash_table_iter_next(&iter, &mr, &changes)) {
+        FlatViewDep *dep = g_hash_table_lookup(view->deps, mr);
+
+        if (!dep) {
+            continue;
+        }
+        if (dep->multiple_origins) {
+            g_array_append_val(ranges, dep->range);
+            continue;
+        }
+        for (i = 0; i < ((GArray *)changes)->len; i++) {
+            AddrRange r = g_array_index((GArray *)changes, AddrRange, i);
+
+            r.start = int128_add(r.start, dep->origin);
+            if (addrrange_intersects(r, dep->range)) {
+                r = addrrange_intersection(r, dep->range);
+                g_array_append_val(ranges, r);
+            }
+        }
+    }
+    if (!ranges->len) {
+        return ranges;
+    }
+
+    /* Merge the ranges that overlap or touch */
+    g_array_sort(ranges, addrrange_compare);
+    for (i = 1, n = 0; i < ranges->len; i++) {
+        AddrRange *last = &g_array_index(ranges, AddrRange, n);
+        AddrRange *cur = &g_array_index(ranges, AddrRange, i);
+
+        if (int128_le(cur->start, addrrange_end(*last))) {
+            Int128 end = int128_max(addrrange_end(*last), addrrange_end(*cur));
+
+            last->size = int128_sub(end, last->start);
+        } else {
+            g_array_index(ranges, AddrRange, ++n) = *cur;
+        }
+    }
+    g_array_set_size(ranges, n + 1);
+    return ranges;
+}
+
+/* Copy to @view the parts of the ranges of @old that lie outside @holes. */
+static void flatview_copy_outside(FlatView *view, FlatView *old, GArray *holes)
+{
+    unsigned i, h = 0;
+
+    for (i = 0; i < old->nr; i++) {
+        FlatRange fr = old->ranges[i];
+        Int128 start = fr.addr.start;
+        Int128 end = addrrange_end(fr.addr);
+
+        while (int128_lt(start, end)) {
+            AddrRange *hole = NULL;
+            FlatRange piece = fr;
+            Int128 next;
+
+            while (h < holes->len &&
+                   int128_le(addrrange_end(g_array_index(holes, AddrRange, h)),
+                             start)) {
+                h++;
+            }
+            if (h < holes->len) {
+                hole = &g_array_index(holes, AddrRange, h);
+                if (int128_le(hole->start, start)) {
+                    start = addrrange_end(*hole);
+                    continue;
+                }
+            }
+
+            next = hole ? int128_min(end, hole->start) : end;
+            piece.offset_in_region +=
+                int128_get64(int128_sub(start, fr.addr.start));
+            piece.addr = addrrange_make(start, int128_sub(next, start));
+            flatview_insert(view, view->nr, &piece);
+            start = next;
+        }
+    }
+}
+
+/*
+ * Forget the regions rendered only inside @holes; they are recorded again
+ * when the holes are rendered, possibly at a different address.
+ */
+static gboolean flatview_dep_in_holes(gpointer key, gpointer value,
+                                      gpointer opaque)
+{
+    FlatViewDep *dep = value;
+    GArray *holes = opaque;
+    unsigned i;
+
+    for (i = 0; i < holes->len; i++) {
+        AddrRange *hole = &g_array_index(holes, AddrRange, i);
+
+        if (int128_ge(dep->range.start, hole->start) &&
+            int128_le(addrrange_end(dep->range), addrrange_end(*hole))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef DEBUG_FLATVIEW_UPDATE
+/* Check that @view matches the result of rendering everything again. */
+static void flatview_check_update(FlatView *view)
+{
+    FlatView *ref = flatview_new(view->root);
+
+    if (view->root) {
+        render_memory_region(ref, view->root, int128_zero(),
+                             addrrange_make(int128_zero(), int128_2_64()),
+                             false);
+    }
+    flatview_simplify(ref);
+    if (!flatview_equal(ref, view)) {
+        error_report("FlatView of %s differs from a full rendering",
+                     view->root ? memory_region_name(view->root) : "(null)");
+        abort();
+    }
+    flatview_unref(ref);
+}
+#endif
+
+/*
+ * Bring @old up to date with the pending changes, rendering again only the
+ * address ranges that they affect.  If nothing visible changed, @old is
+ * kept together with its dispatch tree.
+ */
+static FlatView *flatview_update(FlatView *old)
+{
+    GArray *changed = flatview_changed_ranges(old);
+    FlatView *view;
+    unsigned i;
+
+    if (!changed->len) {
+        g_array_free(changed, true);
+        goto reuse;
+    }
+
+    view = flatview_new(old->root);
+    g_hash_table_unref(view->deps);
+    view->deps = old->deps;
+    old->deps = NULL;
+    g_hash_table_foreach_remove(view->deps, flatview_dep_in_holes, changed);
+
+    flatview_copy_outside(view, old, changed);
+    for (i = 0; i < changed->len; i++) {
+        render_memory_region(view, view->root, int128_zero(),
+                             g_array_index(changed, AddrRange, i), false);
+    }
+    flatview_simplify(view);
+    g_array_free(changed, true);
+
+    if (flatview_equal(view, old)) {
+        old->deps = view->deps;
+        view->deps = NULL;
+        flatview_unref(view);
+        goto reuse;
     }
-    address_space_dispatch_compact(view->dispatch);
-    g_hash_table_replace(flat_views, mr, view);
 
+#ifdef DEBUG_FLATVIEW_UPDATE
+    flatview_check_update(view);
+#endif
+    flatview_build_dispatch(view);
+    g_hash_table_replace(flat_views, view->root, view);
+    topology_stats.views_updated++;
     return view;
+
+reuse:
+#ifdef DEBUG_FLATVIEW_UPDATE
+    flatview_check_update(old);
+#endif
+    flatview_ref(old);
+    g_hash_table_replace(flat_views, old->root, old);
+    topology_stats.views_reused++;
+    return old;
 }
 
 static void address_space_add_del_ioeventfds(AddressSpace *as,
@@ -929,36 +1216,101 @@ static void flatviews_init(void)
 
 static void flatviews_reset(void)
 {
+    GHashTable *old_views = flat_views;
     AddressSpace *as;
 
-    if (flat_views) {
-        g_hash_table_unref(flat_views);
-        flat_views = NULL;
-    }
+    flat_views = NULL;
     flatviews_init();
 
-    /* Render unique FVs */
+    /* Render unique FVs, starting from the previous ones when possible */
     QTAILQ_FOREACH(as, &address_spaces, address_spaces_link) {
         MemoryRegion *physmr = memory_region_get_flatview_root(as->root);
+        FlatView *old_view;
 
         if (g_hash_table_lookup(flat_views, physmr)) {
             continue;
         }
 
-        generate_memory_topology(physmr);
+        old_view = old_views ? g_hash_table_lookup(old_views, physmr) : NULL;
+        if (old_view && !memory_region_topology_invalid) {
+            flatview_update(old_view);
+        } else {
+            generate_memory_topology(physmr);
+        }
+    }
+
+    if (old_views) {
+        g_hash_table_unref(old_views);
+    }
+    if (memory_region_changed) {
+        g_hash_table_remove_all(memory_region_changed);
     }
+    memory_region_topology_invalid = false;
 }
 
-static void address_space_set_flatview(AddressSpace *as)
+/*
+ * Note that the pending transaction changed @size bytes of @mr at @offset,
+ * for example where a subregion is added to its container.
+ */
+static void memory_region_topology_changed_range(MemoryRegion *mr,
+                                                 Int128 offset, Int128 size)
+{
+    AddrRange range = addrrange_make(offset, size);
+    GArray *changes;
+
+    if (!memory_region_changed) {
+        memory_region_changed =
+            g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                  (GDestroyNotify)g_array_unref);
+    }
+    changes = g_hash_table_lookup(memory_region_changed, mr);
+    if (!changes) {
+        changes = g_array_new(false, false, sizeof(AddrRange));
+        g_hash_table_insert(memory_region_changed, mr, changes);
+    }
+    g_array_append_val(changes, range);
+    memory_region_update_pending = true;
+}
+
+/* Note that the pending transaction changed all of @mr. */
+static void memory_region_topology_changed(MemoryRegion *mr)
+{
+    memory_region_topology_changed_range(mr, int128_zero(), int128_2_64());
+}
+
+static void memory_region_topology_invalidate(void)
+{
+    memory_region_topology_invalid = true;
+    memory_region_update_pending = true;
+}
+
+/* Returns whether the address space switched to a different FlatView. */
+static bool address_space_set_flatview(AddressSpace *as)
 {
     FlatView *old_view = address_space_to_flatview(as);
     MemoryRegion *physmr = memory_region_get_flatview_root(as->root);
     FlatView *new_view = g_hash_table_lookup(flat_views, physmr);
+    MemoryListener *listener;
+    FlatRange *fr;
 
     assert(new_view);
 
     if (old_view == new_view) {
-        return;
+        /*
+         * Listeners that collect the whole map between begin and commit
+         * (e.g. vhost) still expect to see every unchanged range.
+         */
+        QTAILQ_FOREACH(listener, &as->listeners, link_as) {
+            if (!listener->region_nop) {
+                continue;
+            }
+            FOR_EACH_FLAT_RANGE(fr, new_view) {
+                MemoryRegionSection mrs = section_from_flat_range(fr, new_view);
+
+                listener->region_nop(listener, &mrs);
+            }
+        }
+        return false;
     }
 
     if (old_view) {
@@ -992,6 +1344,7 @@ static void address_space_set_flatview(AddressSpace *as)
     if (old_view) {
         flatview_unref(old_view);
     }
+    return true;
 }
 
 static void address_space_update_topology(AddressSpace *as)
@@ -1021,17 +1374,33 @@ void memory_region_transaction_commit(void)
     --memory_region_transaction_depth;
     if (!memory_region_transaction_depth) {
         if (memory_region_update_pending) {
+            int64_t start = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+            uint64_t rendered = topology_stats.views_rendered;
+            uint64_t updated = topology_stats.views_updated;
+            uint64_t reused = topology_stats.views_reused;
+            int64_t elapsed;
+
             flatviews_reset();
 
             MEMORY_LISTENER_CALL_GLOBAL(begin, Forward);
 
             QTAILQ_FOREACH(as, &address_spaces, address_spaces_link) {
-                address_space_set_flatview(as);
-                address_space_update_ioeventfds(as);
+                if (address_space_set_flatview(as) ||
+                    ioeventfd_update_pending) {
+                    address_space_update_ioeventfds(as);
+                }
             }
             memory_region_update_pending = false;
             ioeventfd_update_pending = false;
             MEMORY_LISTENER_CALL_GLOBAL(commit, Forward);
+
+            elapsed = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - start;
+            topology_stats.commits++;
+            topology_stats.time_ns += elapsed;
+            trace_memory_region_transaction_commit(
+                topology_stats.views_rendered - rendered,
+                topology_stats.views_updated - updated,
+                topology_stats.views_reused - reused, elapsed);
         } else if (ioeventfd_update_pending) {
             QTAILQ_FOREACH(as, &address_spaces, address_spaces_link) {
                 address_space_update_ioeventfds(as);
@@ -1961,7 +2330,9 @@ void memory_region_set_log(MemoryRegion *mr, bool log, unsigned client)
 
     memory_region_transaction_begin();
     mr->dirty_log_mask = (mr->dirty_log_mask & ~mask) | (log * mask);
-    memory_region_update_pending |= mr->enabled;
+    if (mr->enabled) {
+        memory_region_topology_changed(mr);
+    }
     memory_region_transaction_commit();
 }
 
@@ -2034,7 +2405,9 @@ void memory_region_set_readonly(MemoryRegion *mr, bool readonly)
     if (mr->readonly != readonly) {
         memory_region_transaction_begin();
         mr->readonly = readonly;
-        memory_region_update_pending |= mr->enabled;
+        if (mr->enabled) {
+            memory_region_topology_changed(mr);
+        }
         memory_region_transaction_commit();
     }
 }
@@ -2044,7 +2417,9 @@ void memory_region_rom_device_set_romd(MemoryRegion *mr, bool romd_mode)
     if (mr->romd_mode != romd_mode) {
         memory_region_transaction_begin();
         mr->romd_mode = romd_mode;
-        memory_region_update_pending |= mr->enabled;
+        if (mr->enabled) {
+            memory_region_topology_changed(mr);
+        }
         memory_region_transaction_commit();
     }
 }
@@ -2309,7 +2684,15 @@ static void memory_region_update_container_subregions(MemoryRegion *subregion)
     }
     QTAILQ_INSERT_TAIL(&mr->subregions, subregion, subregions_link);
 done:
-    memory_region_update_pending |= mr->enabled && subregion->enabled;
+    /*
+     * Even a disabled subregion must be rendered once, so that enabling it
+     * later knows which ranges to update.
+     */
+    if (mr->enabled) {
+        memory_region_topology_changed_range(mr,
+                                             int128_make64(subregion->addr),
+                                             subregion->size);
+    }
     memory_region_transaction_commit();
 }
 
@@ -2347,8 +2730,14 @@ void memory_region_del_subregion(MemoryRegion *mr,
     assert(subregion->container == mr);
     subregion->container = NULL;
     QTAILQ_REMOVE(&mr->subregions, subregion, subregions_link);
+    /*
+     * The ranges recorded for the subregion are where it was rendered,
+     * even if memory_region_set_address() already changed its address.
+     */
+    if (mr->enabled) {
+        memory_region_topology_changed(subregion);
+    }
     memory_region_unref(subregion);
-    memory_region_update_pending |= mr->enabled && subregion->enabled;
     memory_region_transaction_commit();
 }
 
@@ -2359,7 +2748,7 @@ void memory_region_set_enabled(MemoryRegion *mr, bool enabled)
     }
     memory_region_transaction_begin();
     mr->enabled = enabled;
-    memory_region_update_pending = true;
+    memory_region_topology_changed(mr);
     memory_region_transaction_commit();
 }
 
@@ -2375,7 +2764,7 @@ void memory_region_set_size(MemoryRegion *mr, uint64_t size)
     }
     memory_region_transaction_begin();
     mr->size = s;
-    memory_region_update_pending = true;
+    memory_region_topology_invalidate();
     memory_region_transaction_commit();
 }
 
@@ -2412,7 +2801,9 @@ void memory_region_set_alias_offset(MemoryRegion *mr, hwaddr offset)
 
     memory_region_transaction_begin();
     mr->alias_offset = offset;
-    memory_region_update_pending |= mr->enabled;
+    if (mr->enabled) {
+        memory_region_topology_changed(mr);
+    }
     memory_region_transaction_commit();
 }
 
@@ -2535,7 +2926,7 @@ void memory_global_dirty_log_start(void)
 
     /* Refresh DIRTY_LOG_MIGRATION bit.  */
     memory_region_transaction_begin();
-    memory_region_update_pending = true;
+    memory_region_topology_invalidate();
     memory_region_transaction_commit();
 }
 
@@ -2545,7 +2936,7 @@ static void memory_global_dirty_log_do_stop(void)
 
     /* Refresh DIRTY_LOG_MIGRATION bit.  */
     memory_region_transaction_begin();
-    memory_region_update_pending = true;
+    memory_region_topology_invalidate();
     memory_region_transaction_commit();
 
     MEMORY_LISTENER_CALL_GLOBAL(log_global_stop, Reverse);
@@ -2692,6 +3083,13 @@ void address_space_init(AddressSpace *as, MemoryRegion *root, const char *name)
     QTAILQ_INIT(&as->listeners);
     QTAILQ_INSERT_TAIL(&address_spaces, as, address_spaces_link);
     as->name = g_strdup(name ? name : "anonymous");
+    qemu_mutex_init(&as->bounce_lock);
+    as->max_bounce_buffer_size = DEFAULT_MAX_BOUNCE_BUFFER_SIZE;
+    as->bounce_buffer_size = 0;
+    as->bounce_buffer_maps = 0;
+    as->bounce_buffer_waits = 0;
+    QLIST_INIT(&as->bounce_buffers);
+    QLIST_INIT(&as->map_client_list);
     address_space_update_topology(as);
     address_space_update_ioeventfds(as);
 }
@@ -2699,6 +3097,9 @@ void address_space_init(AddressSpace *as, MemoryRegion *root, const char *name)
 static void do_address_space_destroy(AddressSpace *as)
 {
     assert(QTAILQ_EMPTY(&as->listeners));
+    assert(QLIST_EMPTY(&as->bounce_buffers));
+    assert(QLIST_EMPTY(&as->map_client_list));
+    qemu_mutex_destroy(&as->bounce_lock);
 
     flatview_unref(as->current_map);
     g_free(as->name);
@@ -3024,6 +3425,13 @@ void mtree_info(fprintf_function mon_printf, void *f, bool flatview,
         g_hash_table_foreach_remove(views, mtree_info_flatview_free, 0);
         g_hash_table_unref(views);
 
+        mon_printf(f, "Topology updates: %" PRIu64 " commits in %" PRId64
+                   " us; FlatViews rendered %" PRIu64 ", updated %" PRIu64
+                   ", reused %" PRIu64 "\n", topology_stats.commits,
+                   topology_stats.time_ns / SCALE_US,
+                   topology_stats.views_rendered, topology_stats.views_updated,
+                   topology_stats.views_reused);
+
         return;
     }
 
@@ -3032,6 +3440,13 @@ void mtree_info(fprintf_function mon_printf, void *f, bool flatview,
     QTAILQ_FOREACH(as, &address_spaces, address_spaces_link) {
         mon_printf(f, "address-space: %s\n", as->name);
         mtree_print_mr(mon_printf, f, as->root, 1, 0, &ml_head, owner);
+        if (as->bounce_buffer_maps || as->bounce_buffer_waits) {
+            mon_printf(f, "  bounce buffers: %" PRIu64 " maps, %" PRIu64
+                       " waits, %zu/%zu bytes in use\n",
+                       as->bounce_buffer_maps, as->bounce_buffer_waits,
+                       atomic_read(&as->bounce_buffer_size),
+                       as->max_bounce_buffer_size);
+        }
         mon_printf(f, "\n");
     }
 
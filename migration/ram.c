@@ -1572,6 +1572,115 @@ static void migration_bitmap_sync_range(RAMState *rs, RAMBlock *rb,
                                               &rs->num_dirty_pages_period);
 }
 
+/*
+ * Large guests sync their dirty bitmap with several threads, each taking
+ * DIRTY_SYNC_CHUNK_SIZE bytes of a RAMBlock at a time.  A chunk covers
+ * whole words of both the global dirty bitmap and the RAMBlock's own,
+ * so the threads never write to the same word.
+ */
+#define DIRTY_SYNC_CHUNK_SIZE       (1ULL << 30)
+#define DIRTY_SYNC_RAM_PER_THREAD   (64 * DIRTY_SYNC_CHUNK_SIZE)
+#define DIRTY_SYNC_MAX_THREADS      8
+
+typedef struct {
+    RAMBlock *block;
+    ram_addr_t start;
+    ram_addr_t length;
+} DirtySyncChunk;
+
+typedef struct {
+    QemuThread thread;
+    DirtySyncChunk *chunks;
+    int nr_chunks;
+    int *next_chunk;
+    uint64_t num_dirty;
+    uint64_t real_dirty_pages;
+} DirtySyncThread;
+
+static void dirty_sync_do_chunks(DirtySyncThread *t)
+{
+    int i;
+
+    while ((i = atomic_fetch_inc(t->next_chunk)) < t->nr_chunks) {
+        DirtySyncChunk *c = &t->chunks[i];
+
+        t->num_dirty +=
+            cpu_physical_memory_sync_dirty_bitmap(c->block, c->start,
+                                                  c->length,
+                                                  &t->real_dirty_pages);
+    }
+}
+
+static void *dirty_sync_thread(void *opaque)
+{
+    rcu_register_thread();
+    dirty_sync_do_chunks(opaque);
+    rcu_unregister_thread();
+    return NULL;
+}
+
+/* Called with the RCU read lock and rs->bitmap_mutex held */
+static void migration_bitmap_sync_blocks(RAMState *rs)
+{
+    DirtySyncThread threads[DIRTY_SYNC_MAX_THREADS] = {};
+    DirtySyncChunk *chunks;
+    RAMBlock *block;
+    uint64_t total = 0;
+    int nr_threads, nr_chunks = 0, next_chunk = 0;
+    int i;
+
+    RAMBLOCK_FOREACH_MIGRATABLE(block) {
+        total += block->used_length;
+        nr_chunks += DIV_ROUND_UP(block->used_length, DIRTY_SYNC_CHUNK_SIZE);
+    }
+
+    nr_threads = MIN(total / DIRTY_SYNC_RAM_PER_THREAD,
+                     DIRTY_SYNC_MAX_THREADS);
+    if (nr_threads <= 1) {
+        RAMBLOCK_FOREACH_MIGRATABLE(block) {
+            migration_bitmap_sync_range(rs, block, 0, block->used_length);
+        }
+        return;
+    }
+
+    chunks = g_new(DirtySyncChunk, nr_chunks);
+    nr_chunks = 0;
+    RAMBLOCK_FOREACH_MIGRATABLE(block) {
+        ram_addr_t start;
+
+        for (start = 0; start < block->used_length;
+             start += DIRTY_SYNC_CHUNK_SIZE) {
+            chunks[nr_chunks].block = block;
+            chunks[nr_chunks].start = start;
+            chunks[nr_chunks].length = MIN(block->used_length - start,
+                                           DIRTY_SYNC_CHUNK_SIZE);
+            nr_chunks++;
+        }
+    }
+
+    /* The migration thread takes its share of the chunks too */
+    for (i = 0; i < nr_threads; i++) {
+        threads[i].chunks = chunks;
+        threads[i].nr_chunks = nr_chunks;
+        threads[i].next_chunk = &next_chunk;
+        if (i) {
+            qemu_thread_create(&threads[i].thread, "dirtysync",
+                               dirty_sync_thread, &threads[i],
+                               QEMU_THREAD_JOINABLE);
+        }
+    }
+    dirty_sync_do_chunks(&threads[0]);
+
+    for (i = 0; i < nr_threads; i++) {
+        if (i) {
+            qemu_thread_join(&threads[i].thread);
+        }
+        rs->migration_dirty_pages += threads[i].num_dirty;
+        rs->num_dirty_pages_period += threads[i].real_dirty_pages;
+    }
+    g_free(chunks);
+}
+
 /**
  * ram_pagesize_summary: calculate all the pagesizes of a VM
  *
@@ -1635,7 +1744,7 @@ static void migration_update_rates(RAMState *rs, int64_t end_time)
 
 static void migration_bitmap_sync(RAMState *rs)
 {
-    RAMBlock *block;
+    int64_t start_time = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
     int64_t end_time;
     uint64_t bytes_xfer_now;
 
@@ -1650,13 +1759,13 @@ static void migration_bitmap_sync(RAMState *rs)
 
     qemu_mutex_lock(&rs->bitmap_mutex);
     rcu_read_lock();
-    RAMBLOCK_FOREACH_MIGRATABLE(block) {
-        migration_bitmap_sync_range(rs, block, 0, block->used_length);
-    }
+    migration_bitmap_sync_blocks(rs);
     ram_counters.remaining = ram_bytes_remaining();
     rcu_read_unlock();
     qemu_mutex_unlock(&rs->bitmap_mutex);
 
+    ram_counters.dirty_sync_time =
+        qemu_clock_get_us(QEMU_CLOCK_REALTIME) - start_time;
     trace_migration_bitmap_sync_end(rs->num_dirty_pages_period);
 
     end_time = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
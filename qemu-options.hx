@@ -118,9 +118,20 @@ Select CPU model (@code{-cpu help} for list and additional feature selection)
 ETEXI
 
 DEF("accel", HAS_ARG, QEMU_OPTION_accel,
-    "-accel [accel=]accelerator[,thread=single|multi]\n"
+    "-accel [accel=]accelerator[,thread=single|multi][,superblocks=on|off]\n"
+    "                [,return-stack=on|off][,atomic-locks=on|off][,fastmem=on|off]\n"
+    "                [,halt-poll-max-ns=n][,halt-poll-grow=n][,halt-poll-shrink=n]\n"
+    "                [,perfmap=on|off][,jitdump=on|off]\n"
     "                select accelerator (kvm, xen, hax, hvf, whpx or tcg; use 'help' for a list)\n"
-    "                thread=single|multi (enable multi-threaded TCG)\n", QEMU_ARCH_ALL)
+    "                thread=single|multi (enable multi-threaded TCG)\n"
+    "                superblocks=on|off (retranslate hot code across jumps, TCG only)\n"
+    "                return-stack=on|off (predict guest returns, TCG only)\n"
+    "                atomic-locks=on|off (lock unaligned atomics, TCG only)\n"
+    "                fastmem=on|off (access guest RAM without TLB lookups, TCG only)\n"
+    "                halt-poll-max-ns=n (poll idle vCPUs for up to n ns, multi-threaded TCG only)\n"
+    "                halt-poll-grow=n, halt-poll-shrink=n (scale the polling time)\n"
+    "                perfmap=on|off (write /tmp/perf-<pid>.map for perf, TCG only)\n"
+    "                jitdump=on|off (write jit-<pid>.dump for perf, TCG only)\n", QEMU_ARCH_ALL)
 STEXI
 @item -accel @var{name}[,prop=@var{value}[,...]]
 @findex -accel
@@ -134,6 +145,75 @@ Controls number of TCG threads. When the TCG is multi-threaded there will be one
 thread per vCPU therefor taking advantage of additional host cores. The default
 is to enable multi-threading where both the back-end and front-ends support it and
 no incompatible TCG features have been enabled (e.g. icount/replay).
+@item superblocks=on|off
+Count the executions of each translation block, and retranslate the ones
+that are executed often into superblocks that follow direct jumps and
+leave through side exits on conditional branches, so that TCG can optimize
+them as a whole.  This costs a little for code that is run rarely, and is
+only implemented for x86 guests.  Disabled by default.
+@item return-stack=on|off
+Keep a per-vCPU stack of the return addresses of guest calls, so that the
+code generated for a return can jump directly to the translation of its
+caller when the prediction is right, instead of calling into the TB lookup
+code.  The number of hits and misses is shown by @code{info jit}.  Only
+implemented for x86 guests.  Disabled by default.
+@item atomic-locks=on|off
+With multi-threaded TCG, an atomic operation that the host cannot perform
+natively, such as one that is not naturally aligned, normally stops all
+other vCPUs while it executes.  With this option, such operations on RAM
+that do not cross a page boundary are instead serialized against each
+other by a table of locks hashed by address.  They are then no longer
+atomic with respect to the aligned atomic operations and plain accesses of
+other vCPUs, so only enable this for guests that use the same alignment
+for all accesses to a given atomic variable.  The number of operations
+that still stop the other vCPUs is shown by @code{info jit}.  Disabled by
+default.
+@item fastmem=on|off
+Reserve for each vCPU a range of host address space that mirrors the
+guest virtual address space, and map there the pages of guest RAM that
+the vCPU's TLB holds, so that generated code can access them without
+looking up the TLB.  Accesses that need more care, for example to MMIO
+or to pages that contain translated code, fault and are redone by the
+usual slow path; the translation blocks that do so are retranslated
+without fastmem.  Every TLB fill and flush costs a system call.
+
+Only RAM that is a shared mapping of a file with pages of the host page
+size can be mapped, so guest RAM should come from a memory backend such
+as @code{-object memory-backend-memfd,id=ram,size=1G,share=on} used with
+@code{-numa node,memdev=ram}.  Only available for guests with 32-bit
+virtual addresses on 64-bit x86 Linux hosts, and not with
+@option{-icount}.  The number of faults is shown by @code{info jit}.
+Disabled by default.
+@item halt-poll-max-ns=@var{n}
+With multi-threaded TCG, let a vCPU that becomes idle, for example because
+the guest executed a halt instruction, busy-wait for up to @var{n}
+nanoseconds before it goes to sleep.  An interrupt that arrives during
+this time is handled without the latency of waking up the vCPU thread,
+at the cost of host CPU time.  The polling time of each vCPU adapts to
+how long it usually stays idle, within the limit of @var{n}.  The number
+of polls and how many of them ended with the vCPU woken up are shown by
+@code{info jit} and @code{query-cpus-fast}.  0, the default, disables
+polling.
+@item halt-poll-grow=@var{n}
+Multiply the polling time of a vCPU by @var{n} when it was woken up
+shortly after it stopped polling.  0 selects the default of 2.
+@item halt-poll-shrink=@var{n}
+Divide the polling time of a vCPU by @var{n} when it stayed idle for
+longer than @var{halt-poll-max-ns}.  0, the default, disables polling
+until the vCPU is again woken up shortly after halting.
+@item perfmap=on|off
+Write the address range and guest address of each translated block to
+@file{/tmp/perf-<pid>.map}, so that @command{perf report} can attribute
+samples taken in TCG-generated code.  Entries are never removed, so
+after the translation cache is flushed the file can list several blocks
+for the same host address; use @option{jitdump} to tell them apart.
+Only available on Linux hosts.
+@item jitdump=on|off
+Write the translated blocks, including their code, to
+@file{jit-<pid>.dump} in the current directory.  Record with
+@code{perf record -k 1} and merge with @code{perf inject -j} to be able
+to use @command{perf annotate} on the generated code.  Only available on
+Linux hosts.
 @end table
 ETEXI
 
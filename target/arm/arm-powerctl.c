@@ -129,6 +129,7 @@ static void arm_set_cpu_on_async_work(CPUState *target_cpu_state,
 
     /* Start the new CPU at the requested address */
     cpu_set_pc(target_cpu_state, info->entry);
+    arm_rebuild_hflags(&target_cpu->env);
 
     g_free(info);
 
@@ -259,6 +259,7 @@ typedef struct CPUARMState {
     uint32_t thumb; /* cpsr[5]. 0 = arm mode, 1 = thumb mode. */
     uint32_t condexec_bits; /* IT bits.  cpsr[15:10,26:25].  */
     uint64_t daif; /* exception masks, in the bits they are in PSTATE */
+    uint32_t hflags; /* cached TB flags, see arm_rebuild_hflags() */
 
     uint64_t elr_el[4]; /* AArch64 exception link regs  */
     uint64_t sp_el[4]; /* AArch64 banked stack pointers */
@@ -3073,6 +3074,21 @@ static inline uint32_t arm_regime_tbi1(CPUARMState *env, ARMMMUIdx mmu_idx)
 }
 #endif
 
+/**
+ * arm_rebuild_hflags:
+ * @env: CPUARMState
+ *
+ * Recompute the part of the TB flags that is cached in env->hflags.
+ * This must be called whenever any of the state it is derived from
+ * changes: the exception level, AArch64/AArch32 state, security state,
+ * data endianness, and the system registers controlling translation,
+ * FP/SVE traps and singlestep. Fields that are cheap to read directly
+ * (Thumb and IT state, VFP vector length and stride, FPEXC.EN, the
+ * XScale CPAR and PSTATE.SS) are not cached and are merged in by
+ * cpu_get_tb_cpu_state().
+ */
+void arm_rebuild_hflags(CPUARMState *env);
+
 void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
                           target_ulong *cs_base, uint32_t *flags);
 
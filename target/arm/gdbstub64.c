@@ -65,6 +65,7 @@ int aarch64_cpu_gdb_write_register(CPUState *cs, uint8_t *mem_buf, int n)
     case 33:
         /* CPSR */
         pstate_write(env, tmp);
+        arm_rebuild_hflags(env);
         return 4;
     }
     /* Unknown register.  */
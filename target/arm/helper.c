@@ -6320,6 +6320,11 @@ void cpsr_write(CPUARMState *env, uint32_t val, uint32_t mask,
     }
     mask &= ~CACHED_CPSR_BITS;
     env->uncached_cpsr = (env->uncached_cpsr & ~mask) | (val & mask);
+
+    if (mask & (CPSR_M | CPSR_E)) {
+        /* Mode and data endianness are part of the cached TB flags */
+        arm_rebuild_hflags(env);
+    }
 }
 
 /* Sign/zero extend */
@@ -6778,6 +6783,8 @@ static void switch_v7m_security_state(CPUARMState *env, bool new_secstate)
         env->regs[13] = new_ss_msp;
         env->v7m.other_sp = new_ss_psp;
     }
+
+    arm_rebuild_hflags(env);
 }
 
 void HELPER(v7m_bxns)(CPUARMState *env, uint32_t dest)
@@ -7810,7 +7817,7 @@ gen_invep:
     return false;
 }
 
-void arm_v7m_cpu_do_interrupt(CPUState *cs)
+static void do_v7m_interrupt(CPUState *cs)
 {
     ARMCPU *cpu = ARM_CPU(cs);
     CPUARMState *env = &cpu->env;
@@ -7998,6 +8005,18 @@ void arm_v7m_cpu_do_interrupt(CPUState *cs)
     v7m_exception_taken(cpu, lr, false, ignore_stackfaults);
 }
 
+void arm_v7m_cpu_do_interrupt(CPUState *cs)
+{
+    ARMCPU *cpu = ARM_CPU(cs);
+
+    do_v7m_interrupt(cs);
+
+    /* Exception entry and return change the mode, the security state
+     * and the execution priority, all of which feed the TB flags.
+     */
+    arm_rebuild_hflags(&cpu->env);
+}
+
 /* Function used to synchronize QEMU's AArch64 register set with AArch32
  * register set.  This is necessary when switching between AArch32 and AArch64
  * execution state.
@@ -8728,6 +8747,7 @@ void arm_cpu_do_interrupt(CPUState *cs)
     } else {
         arm_cpu_do_interrupt_aarch32(cs);
     }
+    arm_rebuild_hflags(env);
 
     arm_call_el_change_hook(cpu);
 
@@ -12826,8 +12846,11 @@ int fp_exception_el(CPUARMState *env, int cur_el)
     return 0;
 }
 
-void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
-                          target_ulong *cs_base, uint32_t *pflags)
+/* Compute the TB flags that only change when the CPU changes mode,
+ * exception level or security state, or when a system register is written.
+ * The rest are filled in by cpu_get_tb_cpu_state().
+ */
+static uint32_t rebuild_hflags(CPUARMState *env)
 {
     ARMMMUIdx mmu_idx = core_to_arm_mmu_idx(env, cpu_mmu_index(env, false));
     int current_el = arm_current_el(env);
@@ -12837,7 +12860,6 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
     if (is_a64(env)) {
         ARMCPU *cpu = arm_env_get_cpu(env);
 
-        *pc = env->pc;
         flags = ARM_TBFLAG_AARCH64_STATE_MASK;
         /* Get control bits for tagged addresses */
         flags |= (arm_regime_tbi0(env, mmu_idx) << ARM_TBFLAG_TBI0_SHIFT);
@@ -12859,21 +12881,14 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
             flags |= zcr_len << ARM_TBFLAG_ZCR_LEN_SHIFT;
         }
     } else {
-        *pc = env->regs[15];
-        flags = (env->thumb << ARM_TBFLAG_THUMB_SHIFT)
-            | (env->vfp.vec_len << ARM_TBFLAG_VECLEN_SHIFT)
-            | (env->vfp.vec_stride << ARM_TBFLAG_VECSTRIDE_SHIFT)
-            | (env->condexec_bits << ARM_TBFLAG_CONDEXEC_SHIFT)
-            | (arm_sctlr_b(env) << ARM_TBFLAG_SCTLR_B_SHIFT);
+        flags = arm_sctlr_b(env) << ARM_TBFLAG_SCTLR_B_SHIFT;
         if (!(access_secure_reg(env))) {
             flags |= ARM_TBFLAG_NS_MASK;
         }
-        if (env->vfp.xregs[ARM_VFP_FPEXC] & (1 << 30)
-            || arm_el_is_aa64(env, 1)) {
+        /* FPEXC.EN is checked in cpu_get_tb_cpu_state() */
+        if (arm_el_is_aa64(env, 1)) {
             flags |= ARM_TBFLAG_VFPEN_MASK;
         }
-        flags |= (extract32(env->cp15.c15_cpar, 0, 2)
-                  << ARM_TBFLAG_XSCALE_CPAR_SHIFT);
     }
 
     flags |= (arm_to_core_mmu_idx(mmu_idx) << ARM_TBFLAG_MMUIDX_SHIFT);
@@ -12884,18 +12899,10 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
      *     0            x       Inactive (the TB flag for SS is always 0)
      *     1            0       Active-pending
      *     1            1       Active-not-pending
+     * PSTATE.SS itself is added by cpu_get_tb_cpu_state().
      */
     if (arm_singlestep_active(env)) {
         flags |= ARM_TBFLAG_SS_ACTIVE_MASK;
-        if (is_a64(env)) {
-            if (env->pstate & PSTATE_SS) {
-                flags |= ARM_TBFLAG_PSTATE_SS_MASK;
-            }
-        } else {
-            if (env->uncached_cpsr & PSTATE_SS) {
-                flags |= ARM_TBFLAG_PSTATE_SS_MASK;
-            }
-        }
     }
     if (arm_cpu_data_is_big_endian(env)) {
         flags |= ARM_TBFLAG_BE_DATA_MASK;
@@ -12916,6 +12923,58 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
         flags |= ARM_TBFLAG_STACKCHECK_MASK;
     }
 
+    return flags;
+}
+
+void arm_rebuild_hflags(CPUARMState *env)
+{
+    env->hflags = rebuild_hflags(env);
+}
+
+void HELPER(rebuild_hflags)(CPUARMState *env)
+{
+    arm_rebuild_hflags(env);
+}
+
+/* With --enable-debug-tcg, cross-check the cached flags against a full
+ * recompute to catch any state change that did not call arm_rebuild_hflags().
+ */
+static inline void check_hflags(CPUARMState *env)
+{
+#ifdef CONFIG_DEBUG_TCG
+    g_assert_cmphex(env->hflags, ==, rebuild_hflags(env));
+#endif
+}
+
+void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
+                          target_ulong *cs_base, uint32_t *pflags)
+{
+    uint32_t flags = env->hflags;
+    uint32_t pstate_for_ss;
+
+    check_hflags(env);
+
+    if (flags & ARM_TBFLAG_AARCH64_STATE_MASK) {
+        *pc = env->pc;
+        pstate_for_ss = env->pstate;
+    } else {
+        *pc = env->regs[15];
+        flags |= (env->thumb << ARM_TBFLAG_THUMB_SHIFT)
+            | (env->vfp.vec_len << ARM_TBFLAG_VECLEN_SHIFT)
+            | (env->vfp.vec_stride << ARM_TBFLAG_VECSTRIDE_SHIFT)
+            | (env->condexec_bits << ARM_TBFLAG_CONDEXEC_SHIFT);
+        if (env->vfp.xregs[ARM_VFP_FPEXC] & (1 << 30)) {
+            flags |= ARM_TBFLAG_VFPEN_MASK;
+        }
+        flags |= (extract32(env->cp15.c15_cpar, 0, 2)
+                  << ARM_TBFLAG_XSCALE_CPAR_SHIFT);
+        pstate_for_ss = env->uncached_cpsr;
+    }
+
+    if ((flags & ARM_TBFLAG_SS_ACTIVE_MASK) && (pstate_for_ss & PSTATE_SS)) {
+        flags |= ARM_TBFLAG_PSTATE_SS_MASK;
+    }
+
     *pflags = flags;
     *cs_base = 0;
 }
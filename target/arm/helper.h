@@ -60,6 +60,7 @@ DEF_HELPER_1(check_breakpoints, void, env)
 DEF_HELPER_3(cpsr_write, void, env, i32, i32)
 DEF_HELPER_2(cpsr_write_eret, void, env, i32)
 DEF_HELPER_1(cpsr_read, i32, env)
+DEF_HELPER_FLAGS_1(rebuild_hflags, TCG_CALL_NO_RWG, void, env)
 
 DEF_HELPER_3(v7m_msr, void, env, i32, i32)
 DEF_HELPER_2(v7m_mrs, i32, env, i32)
@@ -389,6 +389,7 @@ uint32_t HELPER(usat16)(CPUARMState *env, uint32_t x, uint32_t shift)
 void HELPER(setend)(CPUARMState *env)
 {
     env->uncached_cpsr ^= CPSR_E;
+    arm_rebuild_hflags(env);
 }
 
 /* Function checks whether WFx (WFI/WFE) instructions are set up to be trapped.
@@ -887,6 +888,8 @@ void HELPER(msr_i_pstate)(CPUARMState *env, uint32_t op, uint32_t imm)
     default:
         g_assert_not_reached();
     }
+    /* PSTATE.D affects whether singlestep is active */
+    arm_rebuild_hflags(env);
 }
 
 void HELPER(clear_pstate_ss)(CPUARMState *env)
@@ -1106,6 +1109,7 @@ void HELPER(exception_return)(CPUARMState *env)
      * el0_a64 is return_to_aa64, else el0_a64 is ignored.
      */
     aarch64_sve_change_el(env, cur_el, new_el, return_to_aa64);
+    arm_rebuild_hflags(env);
 
     qemu_mutex_lock_iothread();
     arm_call_el_change_hook(arm_env_get_cpu(env));
@@ -1129,6 +1133,7 @@ illegal_return:
     if (!arm_singlestep_active(env)) {
         env->pstate &= ~PSTATE_SS;
     }
+    arm_rebuild_hflags(env);
     qemu_log_mask(LOG_GUEST_ERROR, "Illegal exception return at EL%d: "
                   "resuming execution at 0x%" PRIx64 "\n", cur_el, env->pc);
 }
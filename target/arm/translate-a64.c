@@ -1741,6 +1741,8 @@ static void handle_sys(DisasContext *s, uint32_t insn, bool isread,
         } else {
             tcg_gen_st_i64(tcg_rt, cpu_env, ri->fieldoffset);
         }
+        /* The write may have changed state cached in env->hflags */
+        gen_helper_rebuild_hflags(cpu_env);
     }
 
     if ((tb_cflags(s->base.tb) & CF_USE_ICOUNT) && (ri->type & ARM_CP_IO)) {
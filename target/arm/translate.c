@@ -8602,6 +8602,8 @@ static int disas_coproc_insn(DisasContext *s, uint32_t insn)
                     store_cpu_offset(tmp, ri->fieldoffset);
                 }
             }
+            /* The write may have changed state cached in env->hflags */
+            gen_helper_rebuild_hflags(cpu_env);
         }
 
         if ((tb_cflags(s->base.tb) & CF_USE_ICOUNT) && (ri->type & ARM_CP_IO)) {
@@ -11596,6 +11598,7 @@ static void disas_thumb2_insn(DisasContext *s, uint32_t insn)
                             gen_helper_v7m_msr(cpu_env, addr, tmp);
                             tcg_temp_free_i32(addr);
                             tcg_temp_free_i32(tmp);
+                            gen_helper_rebuild_hflags(cpu_env);
                             gen_lookup_tb(s);
                             break;
                         }
@@ -12863,6 +12866,7 @@ static void disas_thumb_insn(DisasContext *s, uint32_t insn)
                         tcg_temp_free_i32(addr);
                     }
                     tcg_temp_free_i32(tmp);
+                    gen_helper_rebuild_hflags(cpu_env);
                     gen_lookup_tb(s);
                 } else {
                     if (insn & (1 << 4)) {
@@ -21,6 +21,49 @@
 #include "cpu.h"
 #include "exec/helper-proto.h"
 
+/*
+ * The TB flags record the CC_OP value that the TB is entered with, so
+ * that the translator can compute the flags inline from the start.  Only
+ * the common values fit in HF_CC_OP_MASK; index 0 stands for all others,
+ * for which the TB starts with CC_OP_DYNAMIC.
+ */
+const CCOp tb_flags_cc_op[16] = {
+    CC_OP_DYNAMIC,
+    CC_OP_EFLAGS,
+    CC_OP_CLR,
+    CC_OP_SUBB,
+    CC_OP_SUBW,
+    CC_OP_SUBL,
+    CC_OP_SUBQ,
+    CC_OP_LOGICB,
+    CC_OP_LOGICL,
+    CC_OP_LOGICQ,
+    CC_OP_ADDL,
+    CC_OP_ADDQ,
+    CC_OP_INCL,
+    CC_OP_INCQ,
+    CC_OP_DECL,
+    CC_OP_DECQ,
+};
+
+const uint8_t cc_op_tb_flags[CC_OP_NB] = {
+    [CC_OP_EFLAGS] = 1,
+    [CC_OP_CLR] = 2,
+    [CC_OP_SUBB] = 3,
+    [CC_OP_SUBW] = 4,
+    [CC_OP_SUBL] = 5,
+    [CC_OP_SUBQ] = 6,
+    [CC_OP_LOGICB] = 7,
+    [CC_OP_LOGICL] = 8,
+    [CC_OP_LOGICQ] = 9,
+    [CC_OP_ADDL] = 10,
+    [CC_OP_ADDQ] = 11,
+    [CC_OP_INCL] = 12,
+    [CC_OP_INCQ] = 13,
+    [CC_OP_DECL] = 14,
+    [CC_OP_DECQ] = 15,
+};
+
 const uint8_t parity_table[256] = {
     CC_P, 0, 0, CC_P, 0, CC_P, CC_P, 0,
     0, CC_P, CC_P, 0, CC_P, 0, 0, CC_P,
@@ -39,6 +39,9 @@
 /* Maximum instruction code size */
 #define TARGET_MAX_INSN_SIZE 16
 
+/* The translator can follow direct jumps to build superblocks */
+#define TARGET_SUPPORTS_SUPERBLOCKS
+
 /* support for self modifying code even if the modified instruction is
    close to the modifying instruction */
 #define TARGET_HAS_PRECISE_SMC
@@ -177,6 +180,8 @@ typedef enum X86Seg {
 #define HF_IOBPT_SHIFT      24 /* an io breakpoint enabled */
 #define HF_MPX_EN_SHIFT     25 /* MPX Enabled (CR4+XCR0+BNDCFGx) */
 #define HF_MPX_IU_SHIFT     26 /* BND registers in-use */
+#define HF_AVX_EN_SHIFT     27 /* AVX Enabled (CR4+XCR0) */
+#define HF_CC_OP_SHIFT      28 /* TB flags only: CC_OP on entry, 4 bits */
 
 #define HF_CPL_MASK          (3 << HF_CPL_SHIFT)
 #define HF_INHIBIT_IRQ_MASK  (1 << HF_INHIBIT_IRQ_SHIFT)
@@ -202,6 +207,8 @@ typedef enum X86Seg {
 #define HF_IOBPT_MASK        (1 << HF_IOBPT_SHIFT)
 #define HF_MPX_EN_MASK       (1 << HF_MPX_EN_SHIFT)
 #define HF_MPX_IU_MASK       (1 << HF_MPX_IU_SHIFT)
+#define HF_AVX_EN_MASK       (1 << HF_AVX_EN_SHIFT)
+#define HF_CC_OP_MASK        (15U << HF_CC_OP_SHIFT)
 
 /* hflags2 */
 
@@ -1166,8 +1173,10 @@ typedef struct CPUX86State {
     float_status mmx_status; /* for 3DNow! float ops */
     float_status sse_status;
     uint32_t mxcsr;
-    ZMMReg xmm_regs[CPU_NB_REGS == 8 ? 8 : 32];
+    /* Aligned for the TCG vector operations; so are the temporaries.  */
+    ZMMReg xmm_regs[CPU_NB_REGS == 8 ? 8 : 32] QEMU_ALIGNED(16);
     ZMMReg xmm_t0;
+    ZMMReg xmm_t1;
     MMXReg mmx_t0;
 
     XMMReg ymmh_regs[CPU_NB_REGS];
@@ -1522,6 +1531,7 @@ int cpu_get_pic_interrupt(CPUX86State *s);
 void cpu_set_ferr(CPUX86State *s);
 /* mpx_helper.c */
 void cpu_sync_bndcs_hflags(CPUX86State *env);
+void cpu_sync_avx_hflag(CPUX86State *env);
 
 /* this function must always be used to load data in the segment
    cache: it synchronizes the hflags with the segment cache values */
@@ -1762,13 +1772,18 @@ void tcg_x86_init(void);
 #include "hw/i386/apic.h"
 #endif
 
+/* cc_helper.c: the common CC_OP values that TBs are specialized for */
+extern const uint8_t cc_op_tb_flags[CC_OP_NB];
+extern const CCOp tb_flags_cc_op[16];
+
 static inline void cpu_get_tb_cpu_state(CPUX86State *env, target_ulong *pc,
                                         target_ulong *cs_base, uint32_t *flags)
 {
     *cs_base = env->segs[R_CS].base;
     *pc = *cs_base + env->eip;
     *flags = env->hflags |
-        (env->eflags & (IOPL_MASK | TF_MASK | RF_MASK | VM_MASK | AC_MASK));
+        (env->eflags & (IOPL_MASK | TF_MASK | RF_MASK | VM_MASK | AC_MASK)) |
+        ((uint32_t)cc_op_tb_flags[env->cc_op] << HF_CC_OP_SHIFT);
 }
 
 void do_cpu_init(X86CPU *cpu);
@@ -216,6 +216,11 @@ SSE_HELPER_CMP(cmpnlt, FPU_CMPNLT)
 SSE_HELPER_CMP(cmpnle, FPU_CMPNLE)
 SSE_HELPER_CMP(cmpord, FPU_CMPORD)
 
+DEF_HELPER_4(vcmpps, void, env, Reg, Reg, i32)
+DEF_HELPER_4(vcmpss, void, env, Reg, Reg, i32)
+DEF_HELPER_4(vcmppd, void, env, Reg, Reg, i32)
+DEF_HELPER_4(vcmpsd, void, env, Reg, Reg, i32)
+
 DEF_HELPER_3(ucomiss, void, env, Reg, Reg)
 DEF_HELPER_3(comiss, void, env, Reg, Reg)
 DEF_HELPER_3(ucomisd, void, env, Reg, Reg)
@@ -346,6 +351,18 @@ DEF_HELPER_4(glue(aeskeygenassist, SUFFIX), void, env, Reg, Reg, i32)
 DEF_HELPER_4(glue(pclmulqdq, SUFFIX), void, env, Reg, Reg, i32)
 #endif
 
+/* AVX and AVX2 op helpers */
+#if SHIFT == 1
+DEF_HELPER_3(glue(vpermilps, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(glue(vpermilpd, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(glue(vpsllvd, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(glue(vpsllvq, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(glue(vpsrlvd, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(glue(vpsrlvq, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(glue(vpsravd, SUFFIX), void, env, Reg, Reg)
+DEF_HELPER_3(vpermd, void, env, Reg, Reg)
+#endif
+
 #undef SHIFT
 #undef Reg
 #undef SUFFIX
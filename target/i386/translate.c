@@ -23,6 +23,7 @@
 #include "disas/disas.h"
 #include "exec/exec-all.h"
 #include "tcg-op.h"
+#include "tcg-op-gvec.h"
 #include "exec/cpu_ldst.h"
 #include "exec/translator.h"
 
@@ -101,10 +102,12 @@ typedef struct DisasContext {
     int rex_x, rex_b;
 #endif
     int vex_l;  /* vex vector length */
+    int vex_w;  /* vex W bit */
     int vex_v;  /* vex vvvv register, without 1's complement.  */
     int ss32;   /* 32 bit stack segment */
     CCOp cc_op;  /* current CC operation */
     bool cc_op_dirty;
+    bool cc_op_entry;  /* CC_OP_DYNAMIC still holds the value on entry */
 #ifdef TARGET_X86_64
     bool x86_64_hregs;
 #endif
@@ -238,6 +241,7 @@ static void set_cc_op(DisasContext *s, CCOp op)
     if (s->cc_op == op) {
         return;
     }
+    s->cc_op_entry = false;
 
     /* Discard CC computation that will no longer be used.  */
     dead = cc_op_live[s->cc_op] & ~cc_op_live[op];
@@ -276,6 +280,27 @@ static void gen_update_cc_op(DisasContext *s)
     }
 }
 
+/* Return true if the CC_OP bits of the TB flags are known at translation
+   time when leaving the TB with CC_OP stored in env.  The next TB is
+   looked up with them, so this is required for chaining to it.  */
+static bool cc_op_tb_flags_known(DisasContext *s, CCOp cc_op)
+{
+    return cc_op != CC_OP_DYNAMIC || s->cc_op_entry;
+}
+
+/* Return the TB flags that the next TB is looked up with when leaving
+   the TB with CC_OP stored in env.  */
+static uint32_t cc_op_next_tb_flags(DisasContext *s, CCOp cc_op)
+{
+    uint32_t flags = s->flags & ~HF_CC_OP_MASK;
+
+    tcg_debug_assert(cc_op_tb_flags_known(s, cc_op));
+    if (cc_op == CC_OP_DYNAMIC) {
+        return flags | (s->base.tb->flags & HF_CC_OP_MASK);
+    }
+    return flags | ((uint32_t)cc_op_tb_flags[cc_op] << HF_CC_OP_SHIFT);
+}
+
 #ifdef TARGET_X86_64
 
 #define NB_OP_SIZES 4
@@ -850,6 +875,8 @@ static CCPrepare gen_prepare_eflags_s(DisasContext *s, TCGv reg)
 /* compute eflags.O to reg */
 static CCPrepare gen_prepare_eflags_o(DisasContext *s, TCGv reg)
 {
+    TCGMemOp size;
+
     switch (s->cc_op) {
     case CC_OP_ADOX:
     case CC_OP_ADCOX:
@@ -857,7 +884,34 @@ static CCPrepare gen_prepare_eflags_o(DisasContext *s, TCGv reg)
                              .mask = -1, .no_setcond = true };
     case CC_OP_CLR:
     case CC_OP_POPCNT:
+    case CC_OP_LOGICB ... CC_OP_LOGICQ:
         return (CCPrepare) { .cond = TCG_COND_NEVER, .mask = -1 };
+    case CC_OP_SUBB ... CC_OP_SUBQ:
+        /* (CC_SRCT ^ CC_SRC) & (CC_SRCT ^ CC_DST), in the sign bit */
+        size = s->cc_op - CC_OP_SUBB;
+        tcg_gen_xor_tl(s->tmp4, s->cc_srcT, cpu_cc_src);
+        tcg_gen_xor_tl(s->tmp0, s->cc_srcT, cpu_cc_dst);
+        goto add_sub;
+    case CC_OP_ADDB ... CC_OP_ADDQ:
+        /* (SRC1 ^ CC_DST) & (CC_SRC ^ CC_DST), in the sign bit */
+        size = s->cc_op - CC_OP_ADDB;
+        tcg_gen_sub_tl(s->tmp4, cpu_cc_dst, cpu_cc_src);
+        tcg_gen_xor_tl(s->tmp4, s->tmp4, cpu_cc_dst);
+        tcg_gen_xor_tl(s->tmp0, cpu_cc_src, cpu_cc_dst);
+    add_sub:
+        tcg_gen_and_tl(s->tmp4, s->tmp4, s->tmp0);
+        return (CCPrepare) { .cond = TCG_COND_NE, .reg = s->tmp4,
+                             .mask = (target_ulong)1 << ((8 << size) - 1) };
+    case CC_OP_INCB ... CC_OP_INCQ:
+    case CC_OP_DECB ... CC_OP_DECQ:
+        /* The result is the most negative resp. positive value */
+        size = (s->cc_op - CC_OP_ADDB) & 3;
+        tcg_gen_mov_tl(s->tmp4, cpu_cc_dst);
+        gen_extu(size, s->tmp4);
+        return (CCPrepare) { .cond = TCG_COND_EQ, .reg = s->tmp4,
+                             .mask = -1,
+                             .imm = ((target_ulong)1 << ((8 << size) - 1))
+                                    - (s->cc_op >= CC_OP_DECB) };
     default:
         gen_compute_eflags(s);
         return (CCPrepare) { .cond = TCG_COND_NE, .reg = cpu_cc_src,
@@ -935,6 +989,43 @@ static CCPrepare gen_prepare_cc(DisasContext *s, int b, TCGv reg)
         }
         break;
 
+    case CC_OP_LOGICB ... CC_OP_LOGICQ:
+        /* C and O are clear.  */
+        size = s->cc_op - CC_OP_LOGICB;
+        switch (jcc_op) {
+        case JCC_BE:
+            cc = gen_prepare_eflags_z(s, reg);
+            break;
+        case JCC_L:
+            cc = gen_prepare_eflags_s(s, reg);
+            break;
+        case JCC_LE:
+            t0 = gen_ext_tl(reg, cpu_cc_dst, size, true);
+            cc = (CCPrepare) { .cond = TCG_COND_LE, .reg = t0, .mask = -1 };
+            break;
+        default:
+            goto slow_jcc;
+        }
+        break;
+
+    case CC_OP_ADDB ... CC_OP_ADDQ:
+        size = s->cc_op - CC_OP_ADDB;
+        switch (jcc_op) {
+        case JCC_L:
+            /* S ^ O, computing O as in gen_prepare_eflags_o */
+            tcg_gen_sub_tl(s->tmp4, cpu_cc_dst, cpu_cc_src);
+            tcg_gen_xor_tl(s->tmp4, s->tmp4, cpu_cc_dst);
+            tcg_gen_xor_tl(s->tmp0, cpu_cc_src, cpu_cc_dst);
+            tcg_gen_and_tl(s->tmp4, s->tmp4, s->tmp0);
+            tcg_gen_xor_tl(s->tmp4, s->tmp4, cpu_cc_dst);
+            cc = (CCPrepare) { .cond = TCG_COND_NE, .reg = s->tmp4,
+                               .mask = (target_ulong)1 << ((8 << size) - 1) };
+            break;
+        default:
+            goto slow_jcc;
+        }
+        break;
+
     default:
     slow_jcc:
         /* This actually generates good code for JC, JZ and JS.  */
@@ -1044,12 +1135,15 @@ static inline void gen_jcc1_noeob(DisasContext *s, int b, TCGLabel *l1)
 
 /* Generate a conditional jump to label 'l1' according to jump opcode
    value 'b'. In the fast case, T0 is guaranted not to be used.
-   A translation block must end soon.  */
-static inline void gen_jcc1(DisasContext *s, int b, TCGLabel *l1)
+   A translation block must end soon.  Return the CC_OP that is
+   left in env, although the translator forgets it.  */
+static inline CCOp gen_jcc1(DisasContext *s, int b, TCGLabel *l1)
 {
     CCPrepare cc = gen_prepare_cc(s, b, s->T0);
+    CCOp cc_op;
 
     gen_update_cc_op(s);
+    cc_op = s->cc_op;
     if (cc.mask != -1) {
         tcg_gen_andi_tl(s->T0, cc.reg, cc.mask);
         cc.reg = s->T0;
@@ -1060,17 +1154,29 @@ static inline void gen_jcc1(DisasContext *s, int b, TCGLabel *l1)
     } else {
         tcg_gen_brcondi_tl(cc.cond, cc.reg, cc.imm, l1);
     }
+    return cc_op;
 }
 
 /* XXX: does not work with gdbstub "ice" single step - not a
    serious problem */
-static TCGLabel *gen_jz_ecx_string(DisasContext *s, target_ulong next_eip)
+/* If CMP, the returned label is also branched to after the comparison of
+   cmps/scas, with a different CC_OP in env than on entry.  */
+static TCGLabel *gen_jz_ecx_string(DisasContext *s, target_ulong next_eip,
+                                   bool cmp)
 {
     TCGLabel *l1 = gen_new_label();
     TCGLabel *l2 = gen_new_label();
     gen_op_jnz_ecx(s, s->aflag, l1);
     gen_set_label(l2);
-    gen_jmp_tb(s, next_eip, 1);
+    if (cmp) {
+        /* The CC_OP bits of the next TB's flags are only known at run
+           time, so it cannot be chained to.  */
+        set_cc_op(s, CC_OP_DYNAMIC);
+        gen_jmp_im(s, next_eip);
+        gen_jr(s, s->tmp0);
+    } else {
+        gen_jmp_tb(s, next_eip, 1);
+    }
     gen_set_label(l1);
     return l2;
 }
@@ -1176,7 +1282,7 @@ static inline void gen_repz_ ## op(DisasContext *s, TCGMemOp ot,              \
 {                                                                             \
     TCGLabel *l2;                                                             \
     gen_update_cc_op(s);                                                      \
-    l2 = gen_jz_ecx_string(s, next_eip);                                      \
+    l2 = gen_jz_ecx_string(s, next_eip, false);                               \
     gen_ ## op(s, ot);                                                        \
     gen_op_add_reg_im(s, s->aflag, R_ECX, -1);                                \
     /* a loop would cause two single step exceptions if ECX = 1               \
@@ -1194,7 +1300,7 @@ static inline void gen_repz_ ## op(DisasContext *s, TCGMemOp ot,              \
 {                                                                             \
     TCGLabel *l2;                                                             \
     gen_update_cc_op(s);                                                      \
-    l2 = gen_jz_ecx_string(s, next_eip);                                      \
+    l2 = gen_jz_ecx_string(s, next_eip, true);                                \
     gen_ ## op(s, ot);                                                        \
     gen_op_add_reg_im(s, s->aflag, R_ECX, -1);                                \
     gen_update_cc_op(s);                                                      \
@@ -1439,6 +1545,7 @@ static void gen_shift_flags(DisasContext *s, TCGMemOp ot, TCGv result,
 
     /* The CC_OP value is no longer predictable.  */
     set_cc_op(s, CC_OP_DYNAMIC);
+    s->cc_op_entry = false;
 }
 
 static void gen_shift_rm_T1(DisasContext *s, TCGMemOp ot, int op1,
@@ -1600,6 +1707,7 @@ static void gen_rot_rm_T1(DisasContext *s, TCGMemOp ot, int op1, int is_right)
 
     /* The CC_OP value is no longer predictable.  */ 
     set_cc_op(s, CC_OP_DYNAMIC);
+    s->cc_op_entry = false;
 }
 
 static void gen_rot_rm_im(DisasContext *s, TCGMemOp ot, int op1, int op2,
@@ -2196,11 +2304,13 @@ static inline bool use_goto_tb(DisasContext *s, target_ulong pc)
 #endif
 }
 
-static inline void gen_goto_tb(DisasContext *s, int tb_num, target_ulong eip)
+/* Jump to EIP, leaving the TB with CC_OP stored in env */
+static inline void gen_goto_tb(DisasContext *s, int tb_num, target_ulong eip,
+                               CCOp cc_op)
 {
     target_ulong pc = s->cs_base + eip;
 
-    if (use_goto_tb(s, pc))  {
+    if (use_goto_tb(s, pc) && cc_op_tb_flags_known(s, cc_op)) {
         /* jump to same page: we can use a direct jump */
         tcg_gen_goto_tb(tb_num);
         gen_jmp_im(s, eip);
@@ -2213,19 +2323,56 @@ static inline void gen_goto_tb(DisasContext *s, int tb_num, target_ulong eip)
     }
 }
 
+/* Return true if translation can continue at EIP instead of jumping there */
+static bool gen_follow_jump(DisasContext *s, target_ulong eip)
+{
+    return s->jmp_opt && !(s->base.tb->flags & HF_RF_MASK) &&
+           translator_follow_jump(&s->base, s->pc, s->cs_base + eip);
+}
+
+/* Leave a superblock, without using up one of the goto_tb slots */
+static void gen_side_exit(DisasContext *s, target_ulong eip)
+{
+    gen_jmp_im(s, eip);
+    gen_jr(s, s->tmp0);
+    s->base.is_jmp = DISAS_NEXT;
+}
+
 static inline void gen_jcc(DisasContext *s, int b,
                            target_ulong val, target_ulong next_eip)
 {
     TCGLabel *l1, *l2;
 
-    if (s->jmp_opt) {
+    /*
+     * In a superblock, assume that backward branches are taken and
+     * forward branches are not, and only exit on the unlikely path.
+     */
+    if (val < next_eip && gen_follow_jump(s, val)) {
         l1 = gen_new_label();
         gen_jcc1(s, b, l1);
+        gen_side_exit(s, next_eip);
+        gen_set_label(l1);
+        s->pc = s->cs_base + val;
+        return;
+    }
+    if (val >= next_eip && gen_follow_jump(s, next_eip)) {
+        l1 = gen_new_label();
+        gen_jcc1(s, b ^ 1, l1);
+        gen_side_exit(s, val);
+        gen_set_label(l1);
+        return;
+    }
+
+    if (s->jmp_opt) {
+        CCOp cc_op;
+
+        l1 = gen_new_label();
+        cc_op = gen_jcc1(s, b, l1);
 
-        gen_goto_tb(s, 0, next_eip);
+        gen_goto_tb(s, 0, next_eip, cc_op);
 
         gen_set_label(l1);
-        gen_goto_tb(s, 1, val);
+        gen_goto_tb(s, 1, val, cc_op);
     } else {
         l1 = gen_new_label();
         l2 = gen_new_label();
@@ -2563,9 +2710,12 @@ static void gen_bnd_jmp(DisasContext *s)
 /* Generate an end of block. Trace exception is also generated if needed.
    If INHIBIT, set HF_INHIBIT_IRQ_MASK if it isn't already set.
    If RECHECK_TF, emit a rechecking helper for #DB, ignoring the state of
-   S->TF.  This is used by the syscall/sysret insns.  */
+   S->TF.  This is used by the syscall/sysret insns.
+   If RET_EIP is not NULL, this is a return to RET_EIP, which is predicted
+   using the return address stack.  */
 static void
-do_gen_eob_worker(DisasContext *s, bool inhibit, bool recheck_tf, bool jr)
+do_gen_eob_worker(DisasContext *s, bool inhibit, bool recheck_tf, bool jr,
+                  TCGv ret_eip)
 {
     gen_update_cc_op(s);
 
@@ -2586,6 +2736,17 @@ do_gen_eob_worker(DisasContext *s, bool inhibit, bool recheck_tf, bool jr)
         tcg_gen_exit_tb(NULL, 0);
     } else if (s->tf) {
         gen_helper_single_step(cpu_env);
+    } else if (jr && ret_eip && !inhibit &&
+               cc_op_tb_flags_known(s, s->cc_op)) {
+        /* INHIBIT_IRQ and RF were cleared in env above.  */
+        uint32_t flags = cc_op_next_tb_flags(s, s->cc_op)
+                         & ~(HF_INHIBIT_IRQ_MASK | HF_RF_MASK);
+
+        if (s->cs_base) {
+            tcg_gen_addi_tl(s->tmp0, ret_eip, s->cs_base);
+            ret_eip = s->tmp0;
+        }
+        translator_ras_lookup_and_goto_ptr(&s->base, ret_eip, flags);
     } else if (jr) {
         tcg_gen_lookup_and_goto_ptr();
     } else {
@@ -2597,7 +2758,7 @@ do_gen_eob_worker(DisasContext *s, bool inhibit, bool recheck_tf, bool jr)
 static inline void
 gen_eob_worker(DisasContext *s, bool inhibit, bool recheck_tf)
 {
-    do_gen_eob_worker(s, inhibit, recheck_tf, false);
+    do_gen_eob_worker(s, inhibit, recheck_tf, false, NULL);
 }
 
 /* End of block.
@@ -2616,17 +2777,25 @@ static void gen_eob(DisasContext *s)
 /* Jump to register */
 static void gen_jr(DisasContext *s, TCGv dest)
 {
-    do_gen_eob_worker(s, false, false, true);
+    do_gen_eob_worker(s, false, false, true, NULL);
+}
+
+/* Return to register */
+static void gen_ret_jr(DisasContext *s, TCGv dest)
+{
+    do_gen_eob_worker(s, false, false, true, dest);
 }
 
 /* generate a jump to eip. No segment change must happen before as a
    direct call to the next block may occur */
 static void gen_jmp_tb(DisasContext *s, target_ulong eip, int tb_num)
 {
+    CCOp cc_op = s->cc_op;
+
     gen_update_cc_op(s);
     set_cc_op(s, CC_OP_DYNAMIC);
     if (s->jmp_opt) {
-        gen_goto_tb(s, tb_num, eip);
+        gen_goto_tb(s, tb_num, eip, cc_op);
     } else {
         gen_jmp_im(s, eip);
         gen_eob(s);
@@ -2638,6 +2807,16 @@ static void gen_jmp(DisasContext *s, target_ulong eip)
     gen_jmp_tb(s, eip, 0);
 }
 
+/* A direct jump, which a superblock can follow */
+static void gen_jmp_direct(DisasContext *s, target_ulong eip)
+{
+    if (gen_follow_jump(s, eip)) {
+        s->pc = s->cs_base + eip;
+    } else {
+        gen_jmp(s, eip);
+    }
+}
+
 static inline void gen_ldq_env_A0(DisasContext *s, int offset)
 {
     tcg_gen_qemu_ld_i64(s->tmp1_i64, s->A0, s->mem_index, MO_LEQ);
@@ -2670,12 +2849,23 @@ static inline void gen_sto_env_A0(DisasContext *s, int offset)
     tcg_gen_qemu_st_i64(s->tmp1_i64, s->tmp0, mem_index, MO_LEQ);
 }
 
+/*
+ * The 128-bit lanes and the low 128 and 256 bits of a ZMMReg, as host
+ * vectors for the gvec expanders.
+ */
+#ifdef HOST_WORDS_BIGENDIAN
+#define ZMM_LANE_OFS(n) offsetof(ZMMReg, ZMM_Q(2 * (n) + 1))
+#define ZMM_YMM_OFS     ZMM_LANE_OFS(1)
+#else
+#define ZMM_LANE_OFS(n) offsetof(ZMMReg, ZMM_Q(2 * (n)))
+#define ZMM_YMM_OFS     ZMM_LANE_OFS(0)
+#endif
+#define ZMM_XMM_OFS     ZMM_LANE_OFS(0)
+
 static inline void gen_op_movo(DisasContext *s, int d_offset, int s_offset)
 {
-    tcg_gen_ld_i64(s->tmp1_i64, cpu_env, s_offset + offsetof(ZMMReg, ZMM_Q(0)));
-    tcg_gen_st_i64(s->tmp1_i64, cpu_env, d_offset + offsetof(ZMMReg, ZMM_Q(0)));
-    tcg_gen_ld_i64(s->tmp1_i64, cpu_env, s_offset + offsetof(ZMMReg, ZMM_Q(1)));
-    tcg_gen_st_i64(s->tmp1_i64, cpu_env, d_offset + offsetof(ZMMReg, ZMM_Q(1)));
+    tcg_gen_gvec_mov(MO_64, d_offset + ZMM_XMM_OFS, s_offset + ZMM_XMM_OFS,
+                     16, 16);
 }
 
 static inline void gen_op_movq(DisasContext *s, int d_offset, int s_offset)
@@ -2900,6 +3090,11 @@ static const SSEFunc_0_epp sse_op_table4[8][4] = {
     SSE_FOP(cmpord),
 };
 
+/* The VEX forms of cmpps etc., which take all 32 predicates */
+static const SSEFunc_0_eppi sse_op_table_vcmp[4] = {
+    gen_helper_vcmpps, gen_helper_vcmppd, gen_helper_vcmpss, gen_helper_vcmpsd,
+};
+
 static const SSEFunc_0_epp sse_op_table5[256] = {
     [0x0c] = gen_helper_pi2fw,
     [0x0d] = gen_helper_pi2fd,
@@ -3026,8 +3221,146 @@ static const struct SSEOpHelper_eppi sse_op_table7[256] = {
     [0xdf] = AESNI_OP(aeskeygenassist),
 };
 
-static void gen_sse(CPUX86State *env, DisasContext *s, int b,
-                    target_ulong pc_start, int rex_r)
+/*
+ * Expand the common integer MMX/SSE operations inline with the generic
+ * vector operations, instead of calling their ops_sse.h helper.
+ * Return false if the operation must still go through the helper.
+ */
+static bool gen_sse_gvec(int b, int dofs, int aofs, int bofs, uint32_t sz)
+{
+    switch (b) {
+    case 0x54: /* andps, andpd */
+    case 0xdb: /* pand */
+        tcg_gen_gvec_and(MO_64, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0x55: /* andnps, andnpd */
+    case 0xdf: /* pandn */
+        tcg_gen_gvec_andc(MO_64, dofs, bofs, aofs, sz, sz);
+        break;
+    case 0x56: /* orps, orpd */
+    case 0xeb: /* por */
+        tcg_gen_gvec_or(MO_64, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0x57: /* xorps, xorpd */
+    case 0xef: /* pxor */
+        tcg_gen_gvec_xor(MO_64, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xfc ... 0xfe: /* paddb, paddw, paddl */
+        tcg_gen_gvec_add(b - 0xfc, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xd4: /* paddq */
+        tcg_gen_gvec_add(MO_64, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xf8 ... 0xfb: /* psubb, psubw, psubl, psubq */
+        tcg_gen_gvec_sub(b - 0xf8, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xec ... 0xed: /* paddsb, paddsw */
+        tcg_gen_gvec_ssadd(b - 0xec, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xdc ... 0xdd: /* paddusb, paddusw */
+        tcg_gen_gvec_usadd(b - 0xdc, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xe8 ... 0xe9: /* psubsb, psubsw */
+        tcg_gen_gvec_sssub(b - 0xe8, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xd8 ... 0xd9: /* psubusb, psubusw */
+        tcg_gen_gvec_ussub(b - 0xd8, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0xd5: /* pmullw */
+        tcg_gen_gvec_mul(MO_16, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0x74 ... 0x76: /* pcmpeqb, pcmpeqw, pcmpeql */
+        tcg_gen_gvec_cmp(TCG_COND_EQ, b - 0x74, dofs, aofs, bofs, sz, sz);
+        break;
+    case 0x64 ... 0x66: /* pcmpgtb, pcmpgtw, pcmpgtl */
+        tcg_gen_gvec_cmp(TCG_COND_GT, b - 0x64, dofs, aofs, bofs, sz, sz);
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/* Likewise for the shifts by an immediate of group 12 to 14.  */
+static bool gen_sse_shifti_gvec(int b, int op, int val, int dofs, int aofs,
+                                uint32_t sz)
+{
+    TCGMemOp vece = (b & 3) == 1 ? MO_16 : (b & 3) == 2 ? MO_32 : MO_64;
+    int bits = 8 << vece;
+
+    switch (op) {
+    case 2: /* psrl */
+    case 6: /* psll */
+        if (val >= bits) {
+            tcg_gen_gvec_dup8i(dofs, sz, sz, 0);
+        } else if (op == 2) {
+            tcg_gen_gvec_shri(vece, dofs, aofs, val, sz, sz);
+        } else {
+            tcg_gen_gvec_shli(vece, dofs, aofs, val, sz, sz);
+        }
+        return true;
+    case 4: /* psra */
+        tcg_gen_gvec_sari(vece, dofs, aofs, MIN(val, bits - 1), sz, sz);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * The pshufx insns only move whole lanes, so do that with plain loads
+ * and stores.  B1 selects pshufw, pshufd, pshufhw or pshuflw; the last
+ * two shuffle the words of one quadword and copy the other one.
+ */
+static void gen_pshuf(DisasContext *s, int d_offset, int s_offset, int val,
+                      int b1)
+{
+    int w_base = b1 == 2 ? 4 : 0;
+    int q_copy = b1 == 2 ? 0 : 1;
+    TCGv_i32 t[4];
+    TCGv_i64 q = NULL;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        int n = (val >> (i * 2)) & 3;
+
+        t[i] = tcg_temp_new_i32();
+        if (b1 == 0) {
+            tcg_gen_ld16u_i32(t[i], cpu_env,
+                              s_offset + offsetof(MMXReg, MMX_W(n)));
+        } else if (b1 == 1) {
+            tcg_gen_ld_i32(t[i], cpu_env,
+                           s_offset + offsetof(ZMMReg, ZMM_L(n)));
+        } else {
+            tcg_gen_ld16u_i32(t[i], cpu_env,
+                              s_offset + offsetof(ZMMReg, ZMM_W(w_base + n)));
+        }
+    }
+    if (b1 >= 2) {
+        q = tcg_temp_new_i64();
+        tcg_gen_ld_i64(q, cpu_env, s_offset + offsetof(ZMMReg, ZMM_Q(q_copy)));
+    }
+    for (i = 0; i < 4; i++) {
+        if (b1 == 0) {
+            tcg_gen_st16_i32(t[i], cpu_env,
+                             d_offset + offsetof(MMXReg, MMX_W(i)));
+        } else if (b1 == 1) {
+            tcg_gen_st_i32(t[i], cpu_env,
+                           d_offset + offsetof(ZMMReg, ZMM_L(i)));
+        } else {
+            tcg_gen_st16_i32(t[i], cpu_env,
+                             d_offset + offsetof(ZMMReg, ZMM_W(w_base + i)));
+        }
+        tcg_temp_free_i32(t[i]);
+    }
+    if (b1 >= 2) {
+        tcg_gen_st_i64(q, cpu_env, d_offset + offsetof(ZMMReg, ZMM_Q(q_copy)));
+        tcg_temp_free_i64(q);
+    }
+}
+
+static void gen_sse_legacy(CPUX86State *env, DisasContext *s, int b,
+                           target_ulong pc_start, int rex_r)
 {
     int b1, op1_offset, op2_offset, is_xmm, val;
     int modrm, mod, rm, reg;
@@ -3443,6 +3776,23 @@ static void gen_sse(CPUX86State *env, DisasContext *s, int b,
 	        goto unknown_op;
             }
             val = x86_ldub_code(env, s);
+            sse_fn_epp = sse_op_table2[((b - 1) & 3) * 8 +
+                                       (((modrm >> 3)) & 7)][b1];
+            if (!sse_fn_epp) {
+                goto unknown_op;
+            }
+            if (is_xmm) {
+                rm = (modrm & 7) | REX_B(s);
+                op2_offset = offsetof(CPUX86State,xmm_regs[rm]);
+            } else {
+                rm = (modrm & 7);
+                op2_offset = offsetof(CPUX86State,fpregs[rm].mmx);
+            }
+            op1_offset = op2_offset + (is_xmm ? ZMM_XMM_OFS : 0);
+            if (gen_sse_shifti_gvec(b, (modrm >> 3) & 7, val, op1_offset,
+                                    op1_offset, is_xmm ? 16 : 8)) {
+                break;
+            }
             if (is_xmm) {
                 tcg_gen_movi_tl(s->T0, val);
                 tcg_gen_st32_tl(s->T0, cpu_env,
@@ -3460,18 +3810,6 @@ static void gen_sse(CPUX86State *env, DisasContext *s, int b,
                                 offsetof(CPUX86State, mmx_t0.MMX_L(1)));
                 op1_offset = offsetof(CPUX86State,mmx_t0);
             }
-            sse_fn_epp = sse_op_table2[((b - 1) & 3) * 8 +
-                                       (((modrm >> 3)) & 7)][b1];
-            if (!sse_fn_epp) {
-                goto unknown_op;
-            }
-            if (is_xmm) {
-                rm = (modrm & 7) | REX_B(s);
-                op2_offset = offsetof(CPUX86State,xmm_regs[rm]);
-            } else {
-                rm = (modrm & 7);
-                op2_offset = offsetof(CPUX86State,fpregs[rm].mmx);
-            }
             tcg_gen_addi_ptr(s->ptr0, cpu_env, op2_offset);
             tcg_gen_addi_ptr(s->ptr1, cpu_env, op1_offset);
             sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
@@ -4428,6 +4766,10 @@ static void gen_sse(CPUX86State *env, DisasContext *s, int b,
         case 0x70: /* pshufx insn */
         case 0xc6: /* pshufx insn */
             val = x86_ldub_code(env, s);
+            if (b == 0x70) {
+                gen_pshuf(s, op1_offset, op2_offset, val, b1);
+                break;
+            }
             tcg_gen_addi_ptr(s->ptr0, cpu_env, op1_offset);
             tcg_gen_addi_ptr(s->ptr1, cpu_env, op2_offset);
             /* XXX: introduce a new table? */
@@ -4460,6 +4802,13 @@ static void gen_sse(CPUX86State *env, DisasContext *s, int b,
             sse_fn_eppt(cpu_env, s->ptr0, s->ptr1, s->A0);
             break;
         default:
+            if (is_xmm
+                ? gen_sse_gvec(b, op1_offset + ZMM_XMM_OFS,
+                               op1_offset + ZMM_XMM_OFS,
+                               op2_offset + ZMM_XMM_OFS, 16)
+                : gen_sse_gvec(b, op1_offset, op1_offset, op2_offset, 8)) {
+                break;
+            }
             tcg_gen_addi_ptr(s->ptr0, cpu_env, op1_offset);
             tcg_gen_addi_ptr(s->ptr1, cpu_env, op2_offset);
             sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
@@ -4471,85 +4820,1445 @@ static void gen_sse(CPUX86State *env, DisasContext *s, int b,
     }
 }
 
-/* convert one instruction. s->base.is_jmp is set if the translation must
-   be stopped. Return the next pc value */
-static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
+/* Copy the 128-bit lane @sk of the register at @s_ofs to lane @dk at @d_ofs */
+static void gen_lane_mov(int d_ofs, int dk, int s_ofs, int sk)
 {
-    CPUX86State *env = cpu->env_ptr;
-    int b, prefixes;
-    int shift;
-    TCGMemOp ot, aflag, dflag;
-    int modrm, reg, rm, mod, op, opreg, val;
-    target_ulong next_eip, tval;
-    int rex_w, rex_r;
-    target_ulong pc_start = s->base.pc_next;
+    if (d_ofs != s_ofs || dk != sk) {
+        tcg_gen_gvec_mov(MO_64, d_ofs + ZMM_LANE_OFS(dk),
+                         s_ofs + ZMM_LANE_OFS(sk), 16, 16);
+    }
+}
 
-    s->pc_start = s->pc = pc_start;
-    s->override = -1;
-#ifdef TARGET_X86_64
-    s->rex_x = 0;
-    s->rex_b = 0;
-    s->x86_64_hregs = false;
-#endif
-    s->rip_offset = 0; /* for relative ip address */
-    s->vex_l = 0;
-    s->vex_v = 0;
-    if (sigsetjmp(s->jmpbuf, 0) != 0) {
-        gen_exception(s, EXCP0D_GPF, pc_start - s->cs_base);
-        return s->pc;
+/* VEX.128 operations zero bits 255:128 of the destination register */
+static void gen_clear_ymmh(int reg)
+{
+    tcg_gen_gvec_dup8i(offsetof(CPUX86State, xmm_regs[reg]) + ZMM_LANE_OFS(1),
+                       16, 16, 0);
+}
+
+/* Load or store 16 or 32 bytes at A0, according to VEX.L */
+static void gen_ldx_env_A0(DisasContext *s, int offset, int l)
+{
+    int i;
+
+    for (i = 0; i < (2 << l); i++) {
+        tcg_gen_addi_tl(s->tmp0, s->A0, i * 8);
+        tcg_gen_qemu_ld_i64(s->tmp1_i64, s->tmp0, s->mem_index, MO_LEQ);
+        tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                       offset + offsetof(ZMMReg, ZMM_Q(i)));
     }
+}
 
-    prefixes = 0;
-    rex_w = -1;
-    rex_r = 0;
+static void gen_stx_env_A0(DisasContext *s, int offset, int l)
+{
+    int i;
 
- next_byte:
-    b = x86_ldub_code(env, s);
-    /* Collect prefixes.  */
-    switch (b) {
-    case 0xf3:
-        prefixes |= PREFIX_REPZ;
-        goto next_byte;
-    case 0xf2:
-        prefixes |= PREFIX_REPNZ;
-        goto next_byte;
-    case 0xf0:
-        prefixes |= PREFIX_LOCK;
-        goto next_byte;
-    case 0x2e:
-        s->override = R_CS;
-        goto next_byte;
-    case 0x36:
-        s->override = R_SS;
-        goto next_byte;
-    case 0x3e:
-        s->override = R_DS;
-        goto next_byte;
-    case 0x26:
-        s->override = R_ES;
-        goto next_byte;
-    case 0x64:
-        s->override = R_FS;
-        goto next_byte;
-    case 0x65:
-        s->override = R_GS;
-        goto next_byte;
-    case 0x66:
-        prefixes |= PREFIX_DATA;
-        goto next_byte;
-    case 0x67:
-        prefixes |= PREFIX_ADR;
-        goto next_byte;
-#ifdef TARGET_X86_64
-    case 0x40 ... 0x4f:
-        if (CODE64(s)) {
-            /* REX prefix */
-            rex_w = (b >> 3) & 1;
-            rex_r = (b & 0x4) << 1;
-            s->rex_x = (b & 0x2) << 2;
-            REX_B(s) = (b & 0x1) << 3;
-            /* select uniform byte register addressing */
-            s->x86_64_hregs = true;
+    for (i = 0; i < (2 << l); i++) {
+        tcg_gen_addi_tl(s->tmp0, s->A0, i * 8);
+        tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                       offset + offsetof(ZMMReg, ZMM_Q(i)));
+        tcg_gen_qemu_st_i64(s->tmp1_i64, s->tmp0, s->mem_index, MO_LEQ);
+    }
+}
+
+/*
+ * Masked loads and stores of the 32-bit or 64-bit elements of the YMM
+ * register at @d_ofs, from or to A0.  Only the elements whose mask
+ * element in @m_ofs has its sign bit set are accessed, so that the
+ * others cannot fault; loads zero the others.  Loads go through xmm_t0,
+ * so that the destination is left alone if one of them faults.
+ */
+static void gen_maskmov(DisasContext *s, int d_ofs, int m_ofs, int l,
+                        TCGMemOp ot, bool store)
+{
+    int t0_ofs = offsetof(CPUX86State, xmm_t0);
+    int ofs = l ? ZMM_YMM_OFS : ZMM_XMM_OFS;
+    int i, e_ofs;
+    TCGv a0 = tcg_temp_local_new();
+    TCGLabel *skip;
+
+    tcg_gen_mov_tl(a0, s->A0);
+    if (!store) {
+        tcg_gen_gvec_dup8i(t0_ofs + ofs, 16 << l, 16 << l, 0);
+    }
+    for (i = 0; i < (16 << l) >> ot; i++) {
+        skip = gen_new_label();
+        tcg_gen_ld_i32(s->tmp2_i32, cpu_env, m_ofs + offsetof(ZMMReg,
+                       ZMM_L(ot == MO_64 ? 2 * i + 1 : i)));
+        tcg_gen_brcondi_i32(TCG_COND_GE, s->tmp2_i32, 0, skip);
+        tcg_gen_addi_tl(s->A0, a0, i << ot);
+        if (ot == MO_64) {
+            e_ofs = offsetof(ZMMReg, ZMM_Q(i));
+            if (store) {
+                tcg_gen_ld_i64(s->tmp1_i64, cpu_env, d_ofs + e_ofs);
+                tcg_gen_qemu_st_i64(s->tmp1_i64, s->A0, s->mem_index, MO_LEQ);
+            } else {
+                tcg_gen_qemu_ld_i64(s->tmp1_i64, s->A0, s->mem_index, MO_LEQ);
+                tcg_gen_st_i64(s->tmp1_i64, cpu_env, t0_ofs + e_ofs);
+            }
+        } else {
+            e_ofs = offsetof(ZMMReg, ZMM_L(i));
+            if (store) {
+                tcg_gen_ld_i32(s->tmp2_i32, cpu_env, d_ofs + e_ofs);
+                tcg_gen_qemu_st_i32(s->tmp2_i32, s->A0, s->mem_index,
+                                    MO_LEUL);
+            } else {
+                tcg_gen_qemu_ld_i32(s->tmp2_i32, s->A0, s->mem_index,
+                                    MO_LEUL);
+                tcg_gen_st_i32(s->tmp2_i32, cpu_env, t0_ofs + e_ofs);
+            }
+        }
+        gen_set_label(skip);
+    }
+    if (!store) {
+        tcg_gen_gvec_mov(MO_64, d_ofs + ofs, t0_ofs + ofs, 16 << l, 16 << l);
+    }
+    tcg_temp_free(a0);
+}
+
+/*
+ * vpgatherdd, vpgatherdq, vpgatherqd, vpgatherqq and the vgather FP
+ * forms.  The address is a VSIB memory operand, whose index is a vector
+ * register; the elements whose mask element has its sign bit clear are
+ * not loaded.  Each element is loaded and its mask element cleared in
+ * turn, so that a fault leaves the elements before it done.
+ */
+static void gen_vgather(CPUX86State *env, DisasContext *s, int b, int modrm,
+                        int reg, int vvvv, int l)
+{
+    TCGMemOp ot = s->vex_w ? MO_64 : MO_32;
+    TCGMemOp iot = b & 1 ? MO_64 : MO_32;
+    int d_ofs = offsetof(CPUX86State, xmm_regs[reg]);
+    int m_ofs = offsetof(CPUX86State, xmm_regs[vvvv]);
+    int x_ofs, index, i, n;
+    AddressParts a;
+    TCGv base;
+    TCGLabel *skip;
+
+    /* Peek at the index field of the SIB byte */
+    index = ((x86_ldub_code(env, s) >> 3) & 7) | REX_X(s);
+    s->pc--;
+    if (index == reg || index == vvvv || reg == vvvv) {
+        gen_illegal_opcode(s);
+        return;
+    }
+    x_ofs = offsetof(CPUX86State, xmm_regs[index]);
+
+    a = gen_lea_modrm_0(env, s, modrm);
+    a.index = -1;
+    base = tcg_temp_local_new();
+    tcg_gen_mov_tl(base, gen_lea_modrm_1(s, a));
+
+    n = (16 << l) >> MAX(ot, iot);
+    for (i = 0; i < n; i++) {
+        skip = gen_new_label();
+        tcg_gen_ld_i32(s->tmp2_i32, cpu_env, m_ofs + offsetof(ZMMReg,
+                       ZMM_L(ot == MO_64 ? 2 * i + 1 : i)));
+        tcg_gen_brcondi_i32(TCG_COND_GE, s->tmp2_i32, 0, skip);
+        if (iot == MO_64) {
+            tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                           x_ofs + offsetof(ZMMReg, ZMM_Q(i)));
+            tcg_gen_trunc_i64_tl(s->A0, s->tmp1_i64);
+        } else {
+            tcg_gen_ld32s_tl(s->A0, cpu_env,
+                             x_ofs + offsetof(ZMMReg, ZMM_L(i)));
+        }
+        tcg_gen_shli_tl(s->A0, s->A0, a.scale);
+        tcg_gen_add_tl(s->A0, s->A0, base);
+        gen_lea_v_seg(s, s->aflag, s->A0, a.def_seg, s->override);
+        if (ot == MO_64) {
+            tcg_gen_qemu_ld_i64(s->tmp1_i64, s->A0, s->mem_index, MO_LEQ);
+            tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_Q(i)));
+            tcg_gen_movi_i64(s->tmp1_i64, 0);
+            tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                           m_ofs + offsetof(ZMMReg, ZMM_Q(i)));
+        } else {
+            tcg_gen_qemu_ld_i32(s->tmp2_i32, s->A0, s->mem_index, MO_LEUL);
+            tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_L(i)));
+            tcg_gen_movi_i32(s->tmp2_i32, 0);
+            tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                           m_ofs + offsetof(ZMMReg, ZMM_L(i)));
+        }
+        gen_set_label(skip);
+    }
+    tcg_temp_free(base);
+
+    /* The mask is cleared, and so is the destination above the result */
+    tcg_gen_gvec_dup8i(m_ofs + ZMM_YMM_OFS, 32, 32, 0);
+    if ((n << ot) == 8) {
+        tcg_gen_movi_i64(s->tmp1_i64, 0);
+        tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                       d_ofs + offsetof(ZMMReg, ZMM_Q(1)));
+    }
+    if ((n << ot) <= 16) {
+        gen_clear_ymmh(reg);
+    }
+}
+
+/*
+ * In the VEX opcodes below, bits 11:8 are the VEX.mmmmm opcode map:
+ * 1 for 0f, 2 for 0f 38 and 3 for 0f 3a.
+ */
+
+/* Whether the first source operand comes from VEX.vvvv */
+static bool avx_is_nds(int op, int b1)
+{
+    switch (op) {
+    case 0x151 ... 0x153: /* vsqrt, vrsqrt, vrcp */
+    case 0x15a:           /* vcvtps2pd, vcvtpd2ps */
+        return b1 >= 2;
+    case 0x15b:           /* vcvtdq2ps, vcvtps2dq, vcvttps2dq */
+    case 0x170:           /* vpshufd, vpshufhw, vpshuflw */
+    case 0x1e6:           /* vcvttpd2dq, vcvtdq2pd, vcvtpd2dq */
+    case 0x21c ... 0x21e: /* vpabsb, vpabsw, vpabsd */
+    case 0x241:           /* vphminposuw */
+    case 0x2db:           /* vaesimc */
+    case 0x304:           /* vpermilps */
+    case 0x308 ... 0x309: /* vroundps, vroundpd */
+    case 0x3df:           /* vaeskeygenassist */
+        return false;
+    default:
+        return true;
+    }
+}
+
+/* Whether the form of an operation with VEX.L = @l is part of AVX2 */
+static bool avx_is_avx2(int op, int l)
+{
+    switch (op) {
+    case 0x245 ... 0x247: /* vpsrlvd/q, vpsravd, vpsllvd/q */
+    case 0x258 ... 0x25a: /* vpbroadcastd/q, vbroadcasti128 */
+    case 0x278 ... 0x279: /* vpbroadcastb/w */
+    case 0x28c: case 0x28e: /* vpmaskmovd/q */
+    case 0x290 ... 0x293: /* vpgather, vgather */
+    case 0x302:           /* vpblendd */
+        return true;
+    }
+    if (!l) {
+        return false;
+    }
+
+    switch (op) {
+    case 0x16f: case 0x17f: case 0x1e7: case 0x1f0: /* moves */
+    case 0x17c: case 0x17d: case 0x1c2: case 0x1c6: case 0x1d0: case 0x1e6:
+    case 0x20c ... 0x20f: /* vpermilps/pd, vtestps/pd */
+    case 0x217 ... 0x21a: /* vptest, vbroadcastss/sd/f128 */
+    case 0x22c ... 0x22f: /* vmaskmovps/pd */
+    case 0x304 ... 0x306: /* vpermilps/pd, vperm2f128 */
+    case 0x308 ... 0x30d: /* vround, vblend */
+    case 0x318 ... 0x319: /* vinsertf128, vextractf128 */
+    case 0x340:           /* vdpps */
+    case 0x34a ... 0x34b: /* vblendvps/pd */
+        return false;
+    default:
+        return op >= 0x160;
+    }
+}
+
+/* The immediate operand of a helper, as seen by lane @k */
+static int avx_lane_imm(int op, int b1, int val, int k)
+{
+    switch (op) {
+    case 0x1c6: /* vshufpd; vshufps uses the same bits for both lanes */
+        return b1 ? val >> (2 * k) : val;
+    case 0x30c: /* vblendps */
+        return val >> (4 * k);
+    case 0x30d: /* vblendpd */
+        return val >> (2 * k);
+    case 0x342: /* vmpsadbw */
+        return val >> (3 * k);
+    default:
+        return val;
+    }
+}
+
+/*
+ * VEX-encoded SSE and AVX/AVX2 operations.  The VEX.128 forms zero bits
+ * 255:128 of their destination, while the VEX.256 forms work on both
+ * 128-bit lanes of the YMM registers.  Moves, broadcasts, lane permutes
+ * and the common integer operations are expanded inline; the others run
+ * the 128-bit ops_sse.h helper once per lane.  The few forms that only
+ * differ from SSE by zeroing the upper half go through gen_sse_legacy.
+ */
+static void gen_avx(CPUX86State *env, DisasContext *s, int b,
+                    target_ulong pc_start, int rex_r)
+{
+    target_ulong pc = s->pc;
+    int b0 = b;
+    int b1, op, l, vvvv, modrm, mod, reg, rm, val, i, k;
+    int d_ofs, v_ofs, s_ofs, a_ofs;
+    int t0_ofs = offsetof(CPUX86State, xmm_t0);
+    int t1_ofs = offsetof(CPUX86State, xmm_t1);
+    int dest = -1;
+    bool scalar = false, count = false;
+    TCGMemOp ot;
+    SSEFunc_0_epp sse_fn_epp = NULL;
+    SSEFunc_0_eppi sse_fn_eppi = NULL;
+    SSEFunc_0_ppi sse_fn_ppi = NULL;
+
+    if (s->prefix & PREFIX_DATA) {
+        b1 = 1;
+    } else if (s->prefix & PREFIX_REPZ) {
+        b1 = 2;
+    } else if (s->prefix & PREFIX_REPNZ) {
+        b1 = 3;
+    } else {
+        b1 = 0;
+    }
+    b &= 0xff;
+    if (b == 0x38 || b == 0x3a) {
+        op = (b == 0x38 ? 0x200 : 0x300);
+        b = x86_ldub_code(env, s);
+        if ((b & 0xf0) == 0xf0) {
+            /* BMI1, BMI2 and the other integer extensions */
+            s->pc = pc;
+            gen_sse_legacy(env, s, b0, pc_start, rex_r);
+            return;
+        }
+        op |= b;
+        if (b1 != 1) {
+            goto illegal_op;
+        }
+    } else {
+        op = 0x100 | b;
+    }
+
+    if (!(s->flags & HF_AVX_EN_MASK)) {
+        goto illegal_op;
+    }
+    if (s->flags & HF_TS_MASK) {
+        gen_exception(s, EXCP07_PREX, pc_start - s->cs_base);
+        return;
+    }
+    l = s->vex_l;
+    vvvv = CODE64(s) ? s->vex_v : s->vex_v & 7;
+    v_ofs = offsetof(CPUX86State, xmm_regs[vvvv]);
+    if (avx_is_avx2(op, l)
+        && !(s->cpuid_7_0_ebx_features & CPUID_7_0_EBX_AVX2)) {
+        goto illegal_op;
+    }
+
+    if (op == 0x177) {
+        /* vzeroupper, vzeroall */
+        if (b1 != 0 || vvvv != 0) {
+            goto illegal_op;
+        }
+        for (i = 0; i < (CODE64(s) ? 16 : 8); i++) {
+            if (l) {
+                tcg_gen_gvec_dup8i(offsetof(CPUX86State, xmm_regs[i])
+                                   + ZMM_YMM_OFS, 32, 32, 0);
+            } else {
+                gen_clear_ymmh(i);
+            }
+        }
+        return;
+    }
+
+    modrm = x86_ldub_code(env, s);
+    mod = (modrm >> 6) & 3;
+    reg = ((modrm >> 3) & 7) | rex_r;
+    rm = (modrm & 7) | REX_B(s);
+    d_ofs = offsetof(CPUX86State, xmm_regs[reg]);
+    s_ofs = offsetof(CPUX86State, xmm_regs[rm]);
+    if (op >= 0x300 || op == 0x170 || (op >= 0x1c2 && op <= 0x1c6)) {
+        s->rip_offset = 1;
+    }
+
+    switch (op) {
+    case 0x110: /* vmovups, vmovupd, vmovss, vmovsd */
+    case 0x111:
+        if (b1 < 2) {
+            goto vmov;
+        }
+        if (mod != 3) {
+            if (vvvv != 0) {
+                goto illegal_op;
+            }
+            dest = b == 0x10 ? reg : -1;
+            goto legacy;
+        }
+        /* The register forms merge the element into VEX.vvvv */
+        if (b == 0x11) {
+            reg = rm;
+            s_ofs = d_ofs;
+            d_ofs = offsetof(CPUX86State, xmm_regs[reg]);
+        }
+        if (b1 == 2) {
+            tcg_gen_ld_i32(s->tmp2_i32, cpu_env,
+                           s_ofs + offsetof(ZMMReg, ZMM_L(0)));
+            gen_lane_mov(d_ofs, 0, v_ofs, 0);
+            tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_L(0)));
+        } else {
+            tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                           s_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            gen_lane_mov(d_ofs, 0, v_ofs, 0);
+            tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+        }
+        gen_clear_ymmh(reg);
+        return;
+
+    case 0x128: /* vmovaps, vmovapd */
+    case 0x129:
+    case 0x12b: /* vmovntps, vmovntpd */
+        if (b1 >= 2) {
+            goto illegal_op;
+        }
+        goto vmov;
+    case 0x16f: /* vmovdqa, vmovdqu */
+    case 0x17f:
+        if (b1 != 1 && b1 != 2) {
+            goto illegal_op;
+        }
+        goto vmov;
+    case 0x1e7: /* vmovntdq */
+        if (b1 != 1) {
+            goto illegal_op;
+        }
+        goto vmov;
+    case 0x1f0: /* vlddqu */
+        if (b1 != 3) {
+            goto illegal_op;
+        }
+    vmov:
+        if (vvvv != 0) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            if (b & 1) {
+                gen_stx_env_A0(s, d_ofs, l);
+            } else {
+                gen_ldx_env_A0(s, d_ofs, l);
+                if (!l) {
+                    gen_clear_ymmh(reg);
+                }
+            }
+        } else {
+            if (b == 0x2b || b == 0xe7 || b == 0xf0) {
+                goto illegal_op;
+            }
+            if (b & 1) {
+                reg = rm;
+                s_ofs = d_ofs;
+                d_ofs = offsetof(CPUX86State, xmm_regs[reg]);
+            }
+            if (l) {
+                tcg_gen_gvec_mov(MO_64, d_ofs + ZMM_YMM_OFS,
+                                 s_ofs + ZMM_YMM_OFS, 32, 32);
+            } else {
+                gen_lane_mov(d_ofs, 0, s_ofs, 0);
+                gen_clear_ymmh(reg);
+            }
+        }
+        return;
+
+    case 0x112:
+    case 0x116:
+        if (b1 >= 2) {
+            /* vmovsldup, vmovddup, vmovshdup */
+            if (vvvv != 0 || (b == 0x16 && b1 == 3)) {
+                goto illegal_op;
+            }
+            if (mod != 3) {
+                gen_lea_modrm(env, s, modrm);
+                s_ofs = t0_ofs;
+                if (b1 == 3 && !l) {
+                    gen_ldq_env_A0(s, s_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+                } else {
+                    gen_ldx_env_A0(s, s_ofs, l);
+                }
+            }
+            /* Going upwards, no element is read after it was written */
+            if (b1 == 3) {
+                for (i = 0; i < (2 << l); i++) {
+                    tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                                   s_ofs + offsetof(ZMMReg, ZMM_Q(i & ~1)));
+                    tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                                   d_ofs + offsetof(ZMMReg, ZMM_Q(i)));
+                }
+            } else {
+                for (i = 0; i < (4 << l); i++) {
+                    int n = b == 0x12 ? i & ~1 : i | 1;
+
+                    tcg_gen_ld_i32(s->tmp2_i32, cpu_env,
+                                   s_ofs + offsetof(ZMMReg, ZMM_L(n)));
+                    tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                                   d_ofs + offsetof(ZMMReg, ZMM_L(i)));
+                }
+            }
+            if (!l) {
+                gen_clear_ymmh(reg);
+            }
+            return;
+        }
+        /* vmovlps, vmovlpd, vmovhlps; vmovhps, vmovhpd, vmovlhps */
+        if (l || (b1 == 1 && mod == 3)) {
+            goto illegal_op;
+        }
+        {
+            TCGv_i64 lo = tcg_temp_new_i64();
+            TCGv_i64 hi = tcg_temp_new_i64();
+            TCGv_i64 t = b == 0x12 ? lo : hi;
+
+            if (mod != 3) {
+                gen_lea_modrm(env, s, modrm);
+                tcg_gen_qemu_ld_i64(t, s->A0, s->mem_index, MO_LEQ);
+            } else {
+                tcg_gen_ld_i64(t, cpu_env, s_ofs + (b == 0x12
+                               ? offsetof(ZMMReg, ZMM_Q(1))
+                               : offsetof(ZMMReg, ZMM_Q(0))));
+            }
+            if (b == 0x12) {
+                tcg_gen_ld_i64(hi, cpu_env,
+                               v_ofs + offsetof(ZMMReg, ZMM_Q(1)));
+            } else {
+                tcg_gen_ld_i64(lo, cpu_env,
+                               v_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            }
+            tcg_gen_st_i64(lo, cpu_env, d_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            tcg_gen_st_i64(hi, cpu_env, d_ofs + offsetof(ZMMReg, ZMM_Q(1)));
+            tcg_temp_free_i64(lo);
+            tcg_temp_free_i64(hi);
+        }
+        gen_clear_ymmh(reg);
+        return;
+
+    case 0x113: /* vmovlps, vmovlpd */
+    case 0x117: /* vmovhps, vmovhpd */
+        if (b1 >= 2 || l || vvvv != 0 || mod == 3) {
+            goto illegal_op;
+        }
+        gen_lea_modrm(env, s, modrm);
+        gen_stq_env_A0(s, d_ofs + (b == 0x13
+                                   ? offsetof(ZMMReg, ZMM_Q(0))
+                                   : offsetof(ZMMReg, ZMM_Q(1))));
+        return;
+
+    case 0x12a: /* vcvtsi2ss, vcvtsi2sd */
+        if (b1 < 2) {
+            goto illegal_op;
+        }
+        /* Read the source before VEX.vvvv is merged into the destination */
+        ot = mo_64_32(s->dflag);
+        gen_ldst_modrm(env, s, modrm, ot, OR_TMP0, 0);
+        gen_lane_mov(d_ofs, 0, v_ofs, 0);
+        tcg_gen_addi_ptr(s->ptr0, cpu_env, d_ofs);
+        if (ot == MO_32) {
+            tcg_gen_trunc_tl_i32(s->tmp2_i32, s->T0);
+            sse_op_table3ai[b1 - 2](cpu_env, s->ptr0, s->tmp2_i32);
+        } else {
+#ifdef TARGET_X86_64
+            sse_op_table3aq[b1 - 2](cpu_env, s->ptr0, s->T0);
+#else
+            goto illegal_op;
+#endif
+        }
+        gen_clear_ymmh(reg);
+        return;
+
+    case 0x12c: /* vcvttss2si, vcvttsd2si */
+    case 0x12d: /* vcvtss2si, vcvtsd2si */
+        if (b1 < 2 || vvvv != 0) {
+            goto illegal_op;
+        }
+        goto legacy;
+
+    case 0x12e: /* vucomiss, vucomisd */
+    case 0x12f: /* vcomiss, vcomisd */
+        if (b1 >= 2 || vvvv != 0) {
+            goto illegal_op;
+        }
+        goto legacy;
+
+    case 0x150: /* vmovmskps, vmovmskpd */
+    case 0x1d7: /* vpmovmskb */
+        if (mod != 3 || vvvv != 0 || b1 >= 2 || (b == 0xd7 && b1 != 1)) {
+            goto illegal_op;
+        }
+        for (k = 0; k <= l; k++) {
+            if (k) {
+                gen_lane_mov(t0_ofs, 0, s_ofs, k);
+                s_ofs = t0_ofs;
+            }
+            tcg_gen_addi_ptr(s->ptr0, cpu_env, s_ofs);
+            if (b == 0xd7) {
+                gen_helper_pmovmskb_xmm(s->tmp2_i32, cpu_env, s->ptr0);
+            } else if (b1) {
+                gen_helper_movmskpd(s->tmp2_i32, cpu_env, s->ptr0);
+            } else {
+                gen_helper_movmskps(s->tmp2_i32, cpu_env, s->ptr0);
+            }
+            if (k) {
+                tcg_gen_shli_i32(s->tmp2_i32, s->tmp2_i32,
+                                 b == 0xd7 ? 16 : b1 ? 2 : 4);
+                tcg_gen_or_i32(s->tmp3_i32, s->tmp3_i32, s->tmp2_i32);
+            } else {
+                tcg_gen_mov_i32(s->tmp3_i32, s->tmp2_i32);
+            }
+        }
+        tcg_gen_extu_i32_tl(cpu_regs[reg], s->tmp3_i32);
+        return;
+
+    case 0x15a: /* vcvtps2pd, vcvtpd2ps */
+    case 0x1e6: /* vcvttpd2dq, vcvtdq2pd, vcvtpd2dq */
+        if (!l || (b == 0x5a ? b1 >= 2 : b1 == 0)) {
+            break;
+        }
+        if (vvvv != 0) {
+            goto illegal_op;
+        }
+        sse_fn_epp = sse_op_table1[b][b1];
+        if (b1 == 0 || b1 == 2) {
+            /* vcvtps2pd, vcvtdq2pd: each half of xmm/m128 gives a lane */
+            if (mod != 3) {
+                gen_lea_modrm(env, s, modrm);
+                gen_ldo_env_A0(s, t0_ofs);
+            } else {
+                gen_lane_mov(t0_ofs, 0, s_ofs, 0);
+            }
+            tcg_gen_addi_ptr(s->ptr0, cpu_env, t1_ofs);
+            tcg_gen_addi_ptr(s->ptr1, cpu_env, t0_ofs);
+            sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+            gen_lane_mov(d_ofs, 0, t1_ofs, 0);
+            tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                           t0_ofs + offsetof(ZMMReg, ZMM_Q(1)));
+            tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                           t0_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+            gen_lane_mov(d_ofs, 1, t1_ofs, 0);
+        } else {
+            /* vcvtpd2ps, vcvt(t)pd2dq: each lane gives a half of xmm */
+            TCGv_i64 lo = tcg_temp_new_i64();
+
+            if (mod != 3) {
+                gen_lea_modrm(env, s, modrm);
+                s_ofs = t0_ofs;
+                gen_ldx_env_A0(s, s_ofs, l);
+            }
+            tcg_gen_addi_ptr(s->ptr0, cpu_env, t1_ofs);
+            tcg_gen_addi_ptr(s->ptr1, cpu_env, s_ofs);
+            sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+            tcg_gen_ld_i64(lo, cpu_env, t1_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            gen_lane_mov(t0_ofs, 0, s_ofs, 1);
+            tcg_gen_addi_ptr(s->ptr1, cpu_env, t0_ofs);
+            sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+            tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                           t1_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            tcg_gen_st_i64(lo, cpu_env, d_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_Q(1)));
+            tcg_temp_free_i64(lo);
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x16e: /* vmovd, vmovq */
+        if (b1 != 1 || l || vvvv != 0) {
+            goto illegal_op;
+        }
+        dest = reg;
+        goto legacy;
+
+    case 0x17e: /* vmovd, vmovq; vmovq */
+    case 0x1d6: /* vmovq */
+        if ((b1 != 1 && (b1 != 2 || b == 0xd6)) || l || vvvv != 0) {
+            goto illegal_op;
+        }
+        if (b == 0x7e) {
+            dest = b1 == 2 ? reg : -1;
+        } else {
+            dest = mod == 3 ? rm : -1;
+        }
+        goto legacy;
+
+    case 0x171: /* shift xmm, im */
+    case 0x172:
+    case 0x173:
+        if (b1 != 1 || mod != 3) {
+            goto illegal_op;
+        }
+        val = x86_ldub_code(env, s);
+        k = (modrm >> 3) & 7;
+        sse_fn_epp = sse_op_table2[((b - 1) & 3) * 8 + k][1];
+        if (!sse_fn_epp) {
+            goto illegal_op;
+        }
+        if (!gen_sse_shifti_gvec(b, k, val, v_ofs + (l ? ZMM_YMM_OFS
+                                                         : ZMM_XMM_OFS),
+                                 s_ofs + (l ? ZMM_YMM_OFS : ZMM_XMM_OFS),
+                                 16 << l)) {
+            /* vpsrldq, vpslldq */
+            tcg_gen_movi_i64(s->tmp1_i64, val);
+            tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                           t0_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            for (k = 0; k <= l; k++) {
+                gen_lane_mov(t1_ofs, 0, s_ofs, k);
+                tcg_gen_addi_ptr(s->ptr0, cpu_env, t1_ofs);
+                tcg_gen_addi_ptr(s->ptr1, cpu_env, t0_ofs);
+                sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+                gen_lane_mov(v_ofs, k, t1_ofs, 0);
+            }
+        }
+        if (!l) {
+            gen_clear_ymmh(vvvv);
+        }
+        return;
+
+    case 0x1c4: /* vpinsrw */
+        if (b1 != 1 || l) {
+            goto illegal_op;
+        }
+        gen_ldst_modrm(env, s, modrm, MO_16, OR_TMP0, 0);
+        val = x86_ldub_code(env, s);
+        gen_lane_mov(d_ofs, 0, v_ofs, 0);
+        tcg_gen_st16_tl(s->T0, cpu_env,
+                        d_ofs + offsetof(ZMMReg, ZMM_W(val & 7)));
+        gen_clear_ymmh(reg);
+        return;
+
+    case 0x1c5: /* vpextrw */
+        if (b1 != 1 || l || vvvv != 0) {
+            goto illegal_op;
+        }
+        goto legacy;
+
+    case 0x178: /* extrq, insertq */
+    case 0x179:
+        goto illegal_op;
+
+    case 0x1f7: /* vmaskmovdqu */
+        if (b1 != 1 || l || vvvv != 0 || mod != 3) {
+            goto illegal_op;
+        }
+        goto legacy;
+
+    case 0x20c: /* vpermilps */
+    case 0x20d: /* vpermilpd */
+        if (s->vex_w) {
+            goto illegal_op;
+        }
+        sse_fn_epp = (b == 0x0c ? gen_helper_vpermilps_xmm
+                      : gen_helper_vpermilpd_xmm);
+        goto lanes;
+
+    case 0x20e: /* vtestps */
+    case 0x20f: /* vtestpd */
+    case 0x217: /* vptest */
+        if (vvvv != 0 || (b != 0x17 && s->vex_w)) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        a_ofs = d_ofs;
+        if (b != 0x17) {
+            /* vtestps and vtestpd are vptest on the sign bits only */
+            TCGMemOp vece = b == 0x0e ? MO_32 : MO_64;
+            int64_t sign = b == 0x0e ? 0x80000000 : INT64_MIN;
+            int ofs = l ? ZMM_YMM_OFS : ZMM_XMM_OFS;
+
+            tcg_gen_gvec_andi(vece, t1_ofs + ofs, d_ofs + ofs, sign,
+                              16 << l, 16 << l);
+            tcg_gen_gvec_andi(vece, t0_ofs + ofs, s_ofs + ofs, sign,
+                              16 << l, 16 << l);
+            a_ofs = t1_ofs;
+            s_ofs = t0_ofs;
+        }
+        for (k = 0; k <= l; k++) {
+            if (k) {
+                gen_lane_mov(t1_ofs, 0, a_ofs, k);
+                gen_lane_mov(t0_ofs, 0, s_ofs, k);
+                a_ofs = t1_ofs;
+                s_ofs = t0_ofs;
+                tcg_gen_mov_tl(s->tmp4, cpu_cc_src);
+            }
+            tcg_gen_addi_ptr(s->ptr0, cpu_env, a_ofs);
+            tcg_gen_addi_ptr(s->ptr1, cpu_env, s_ofs);
+            gen_helper_ptest_xmm(cpu_env, s->ptr0, s->ptr1);
+            if (k) {
+                /* ZF and CF are only set if they are set for both lanes */
+                tcg_gen_and_tl(cpu_cc_src, cpu_cc_src, s->tmp4);
+            }
+        }
+        set_cc_op(s, CC_OP_EFLAGS);
+        return;
+
+    case 0x218: /* vbroadcastss */
+    case 0x219: /* vbroadcastsd */
+    case 0x21a: /* vbroadcastf128 */
+    case 0x258: /* vpbroadcastd */
+    case 0x259: /* vpbroadcastq */
+    case 0x25a: /* vbroadcasti128 */
+    case 0x278: /* vpbroadcastb */
+    case 0x279: /* vpbroadcastw */
+        if (vvvv != 0 || s->vex_w) {
+            goto illegal_op;
+        }
+        /* The register forms of vbroadcastss/sd are AVX2 */
+        if (mod == 3 && !(s->cpuid_7_0_ebx_features & CPUID_7_0_EBX_AVX2)) {
+            goto illegal_op;
+        }
+        if (b == 0x1a || b == 0x5a) {
+            if (!l || mod == 3) {
+                goto illegal_op;
+            }
+            gen_lea_modrm(env, s, modrm);
+            gen_ldo_env_A0(s, t0_ofs);
+            gen_lane_mov(d_ofs, 0, t0_ofs, 0);
+            gen_lane_mov(d_ofs, 1, t0_ofs, 0);
+            return;
+        }
+        if (b == 0x19 && !l) {
+            goto illegal_op;
+        }
+        {
+            TCGMemOp vece = (b == 0x78 ? MO_8 : b == 0x79 ? MO_16
+                             : b == 0x18 || b == 0x58 ? MO_32 : MO_64);
+            int ofs = d_ofs + (l ? ZMM_YMM_OFS : ZMM_XMM_OFS);
+
+            if (mod != 3) {
+                gen_lea_modrm(env, s, modrm);
+            }
+            if (vece == MO_64) {
+                if (mod != 3) {
+                    tcg_gen_qemu_ld_i64(s->tmp1_i64, s->A0,
+                                        s->mem_index, MO_LEQ);
+                } else {
+                    tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                                   s_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+                }
+                tcg_gen_gvec_dup_i64(MO_64, ofs, 16 << l, 16 << l,
+                                     s->tmp1_i64);
+            } else {
+                if (mod != 3) {
+                    tcg_gen_qemu_ld_i32(s->tmp2_i32, s->A0,
+                                        s->mem_index, vece | MO_LE);
+                } else if (vece == MO_8) {
+                    tcg_gen_ld8u_i32(s->tmp2_i32, cpu_env,
+                                     s_ofs + offsetof(ZMMReg, ZMM_B(0)));
+                } else if (vece == MO_16) {
+                    tcg_gen_ld16u_i32(s->tmp2_i32, cpu_env,
+                                      s_ofs + offsetof(ZMMReg, ZMM_W(0)));
+                } else {
+                    tcg_gen_ld_i32(s->tmp2_i32, cpu_env,
+                                   s_ofs + offsetof(ZMMReg, ZMM_L(0)));
+                }
+                tcg_gen_gvec_dup_i32(vece, ofs, 16 << l, 16 << l,
+                                     s->tmp2_i32);
+            }
+        }
+        if (!l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x216: /* vpermps */
+    case 0x236: /* vpermd */
+        if (!l || s->vex_w) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        tcg_gen_gvec_mov(MO_64, t1_ofs + ZMM_YMM_OFS, v_ofs + ZMM_YMM_OFS,
+                         32, 32);
+        tcg_gen_addi_ptr(s->ptr0, cpu_env, t1_ofs);
+        tcg_gen_addi_ptr(s->ptr1, cpu_env, s_ofs);
+        gen_helper_vpermd(cpu_env, s->ptr0, s->ptr1);
+        tcg_gen_gvec_mov(MO_64, d_ofs + ZMM_YMM_OFS, t1_ofs + ZMM_YMM_OFS,
+                         32, 32);
+        return;
+
+    case 0x220 ... 0x225: /* vpmovsx */
+    case 0x230 ... 0x235: /* vpmovzx */
+        if (vvvv != 0) {
+            goto illegal_op;
+        }
+        if (!l) {
+            dest = reg;
+            goto legacy;
+        }
+        /*
+         * Each lane of the result extends n bytes of the source: the
+         * low ones for lane 0, and the next ones for lane 1.
+         */
+        k = (b & 7) == 2 ? 2 : (b & 7) == 1 || (b & 7) == 4 ? 4 : 8;
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            if (k == 8) {
+                gen_ldo_env_A0(s, t0_ofs);
+            } else if (k == 4) {
+                gen_ldq_env_A0(s, t0_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            } else {
+                tcg_gen_qemu_ld_i32(s->tmp2_i32, s->A0, s->mem_index,
+                                    MO_LEUL);
+                tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                               t0_ofs + offsetof(ZMMReg, ZMM_L(0)));
+            }
+        } else {
+            gen_lane_mov(t0_ofs, 0, s_ofs, 0);
+        }
+        sse_fn_epp = sse_op_table6[b].op[1];
+        tcg_gen_addi_ptr(s->ptr0, cpu_env, t1_ofs);
+        tcg_gen_addi_ptr(s->ptr1, cpu_env, t0_ofs);
+        sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+        gen_lane_mov(d_ofs, 0, t1_ofs, 0);
+        if (k == 8) {
+            tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                           t0_ofs + offsetof(ZMMReg, ZMM_Q(1)));
+        } else {
+            tcg_gen_ld_i64(s->tmp1_i64, cpu_env,
+                           t0_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+            tcg_gen_shri_i64(s->tmp1_i64, s->tmp1_i64, k * 8);
+        }
+        tcg_gen_st_i64(s->tmp1_i64, cpu_env,
+                       t0_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+        sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+        gen_lane_mov(d_ofs, 1, t1_ofs, 0);
+        return;
+
+    case 0x22c: /* vmaskmovps */
+    case 0x22d: /* vmaskmovpd */
+    case 0x22e:
+    case 0x22f:
+    case 0x28c: /* vpmaskmovd, vpmaskmovq */
+    case 0x28e:
+        if (mod == 3) {
+            goto illegal_op;
+        }
+        if (!(b & 0x80) && s->vex_w) {
+            goto illegal_op;
+        }
+        gen_lea_modrm(env, s, modrm);
+        gen_maskmov(s, d_ofs, v_ofs, l,
+                    (b & 0x80 ? s->vex_w : b & 1) ? MO_64 : MO_32, b & 2);
+        if (!(b & 2) && !l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x245: /* vpsrlvd, vpsrlvq */
+    case 0x246: /* vpsravd */
+    case 0x247: /* vpsllvd, vpsllvq */
+        if (b == 0x46 && s->vex_w) {
+            goto illegal_op;
+        }
+        if (b == 0x45) {
+            sse_fn_epp = (s->vex_w ? gen_helper_vpsrlvq_xmm
+                          : gen_helper_vpsrlvd_xmm);
+        } else if (b == 0x46) {
+            sse_fn_epp = gen_helper_vpsravd_xmm;
+        } else {
+            sse_fn_epp = (s->vex_w ? gen_helper_vpsllvq_xmm
+                          : gen_helper_vpsllvd_xmm);
+        }
+        goto lanes;
+
+    case 0x290 ... 0x293: /* vpgather, vgather */
+        if (mod == 3 || (modrm & 7) != 4 || s->aflag == MO_16) {
+            goto illegal_op;
+        }
+        gen_vgather(env, s, b, modrm, reg, vvvv, l);
+        return;
+
+    case 0x22a: /* vmovntdqa */
+        if (mod == 3 || vvvv != 0) {
+            goto illegal_op;
+        }
+        gen_lea_modrm(env, s, modrm);
+        gen_ldx_env_A0(s, d_ofs, l);
+        if (!l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x300: /* vpermq */
+    case 0x301: /* vpermpd */
+        if (!l || !s->vex_w || vvvv != 0) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        val = x86_ldub_code(env, s);
+        {
+            TCGv_i64 t[4];
+
+            for (i = 0; i < 4; i++) {
+                t[i] = tcg_temp_new_i64();
+                tcg_gen_ld_i64(t[i], cpu_env, s_ofs +
+                               offsetof(ZMMReg, ZMM_Q((val >> (2 * i)) & 3)));
+            }
+            for (i = 0; i < 4; i++) {
+                tcg_gen_st_i64(t[i], cpu_env,
+                               d_ofs + offsetof(ZMMReg, ZMM_Q(i)));
+                tcg_temp_free_i64(t[i]);
+            }
+        }
+        return;
+
+    case 0x302: /* vpblendd */
+        if (s->vex_w) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        val = x86_ldub_code(env, s);
+        for (i = 0; i < (4 << l); i++) {
+            tcg_gen_ld_i32(s->tmp2_i32, cpu_env,
+                           ((val >> i) & 1 ? s_ofs : v_ofs)
+                           + offsetof(ZMMReg, ZMM_L(i)));
+            tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_L(i)));
+        }
+        if (!l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x304: /* vpermilps */
+        if (s->vex_w || vvvv != 0) {
+            goto illegal_op;
+        }
+        sse_fn_ppi = gen_helper_pshufd_xmm;
+        goto lanes;
+
+    case 0x305: /* vpermilpd */
+        if (s->vex_w || vvvv != 0) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        val = x86_ldub_code(env, s);
+        {
+            TCGv_i64 t[4];
+
+            for (i = 0; i < (2 << l); i++) {
+                t[i] = tcg_temp_new_i64();
+                tcg_gen_ld_i64(t[i], cpu_env, s_ofs + offsetof(ZMMReg,
+                               ZMM_Q((i & ~1) | ((val >> i) & 1))));
+            }
+            for (i = 0; i < (2 << l); i++) {
+                tcg_gen_st_i64(t[i], cpu_env,
+                               d_ofs + offsetof(ZMMReg, ZMM_Q(i)));
+                tcg_temp_free_i64(t[i]);
+            }
+        }
+        if (!l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x306: /* vperm2f128 */
+    case 0x346: /* vperm2i128 */
+        if (!l || s->vex_w) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        val = x86_ldub_code(env, s);
+        for (k = 0; k < 2; k++) {
+            int sel = val >> (4 * k);
+
+            if (sel & 8) {
+                tcg_gen_gvec_dup8i(t1_ofs + ZMM_LANE_OFS(k), 16, 16, 0);
+            } else {
+                gen_lane_mov(t1_ofs, k, sel & 2 ? s_ofs : v_ofs, sel & 1);
+            }
+        }
+        tcg_gen_gvec_mov(MO_64, d_ofs + ZMM_YMM_OFS, t1_ofs + ZMM_YMM_OFS,
+                         32, 32);
+        return;
+
+    case 0x314 ... 0x317: /* vpextrb, vpextrw, vpextrd/q, vextractps */
+        if (l || vvvv != 0) {
+            goto illegal_op;
+        }
+        goto legacy;
+
+    case 0x318: /* vinsertf128 */
+    case 0x338: /* vinserti128 */
+        if (!l || s->vex_w) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            gen_ldo_env_A0(s, t0_ofs);
+        } else {
+            gen_lane_mov(t0_ofs, 0, s_ofs, 0);
+        }
+        val = x86_ldub_code(env, s);
+        tcg_gen_gvec_mov(MO_64, d_ofs + ZMM_YMM_OFS, v_ofs + ZMM_YMM_OFS,
+                         32, 32);
+        gen_lane_mov(d_ofs, val & 1, t0_ofs, 0);
+        return;
+
+    case 0x319: /* vextractf128 */
+    case 0x339: /* vextracti128 */
+        if (!l || s->vex_w || vvvv != 0) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            val = x86_ldub_code(env, s);
+            gen_lane_mov(t0_ofs, 0, d_ofs, val & 1);
+            gen_sto_env_A0(s, t0_ofs);
+        } else {
+            val = x86_ldub_code(env, s);
+            gen_lane_mov(s_ofs, 0, d_ofs, val & 1);
+            gen_clear_ymmh(rm);
+        }
+        return;
+
+    case 0x320: /* vpinsrb */
+    case 0x322: /* vpinsrd, vpinsrq */
+        if (l) {
+            goto illegal_op;
+        }
+        ot = mo_64_32(s->dflag);
+        if (mod == 3) {
+            gen_op_mov_v_reg(s, ot, s->T0, rm);
+        } else {
+            gen_lea_modrm(env, s, modrm);
+            gen_op_ld_v(s, b == 0x20 ? MO_8 : ot, s->T0, s->A0);
+        }
+        val = x86_ldub_code(env, s);
+        gen_lane_mov(d_ofs, 0, v_ofs, 0);
+        if (b == 0x20) {
+            tcg_gen_st8_tl(s->T0, cpu_env,
+                           d_ofs + offsetof(ZMMReg, ZMM_B(val & 15)));
+        } else if (ot == MO_32) {
+            tcg_gen_st32_tl(s->T0, cpu_env,
+                            d_ofs + offsetof(ZMMReg, ZMM_L(val & 3)));
+        } else {
+            tcg_gen_st_tl(s->T0, cpu_env,
+                          d_ofs + offsetof(ZMMReg, ZMM_Q(val & 1)));
+        }
+        gen_clear_ymmh(reg);
+        return;
+
+    case 0x321: /* vinsertps */
+        if (l) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            val = x86_ldub_code(env, s);
+            tcg_gen_qemu_ld_i32(s->tmp2_i32, s->A0, s->mem_index, MO_LEUL);
+        } else {
+            val = x86_ldub_code(env, s);
+            tcg_gen_ld_i32(s->tmp2_i32, cpu_env, s_ofs +
+                           offsetof(ZMMReg, ZMM_L((val >> 6) & 3)));
+        }
+        gen_lane_mov(d_ofs, 0, v_ofs, 0);
+        tcg_gen_st_i32(s->tmp2_i32, cpu_env, d_ofs +
+                       offsetof(ZMMReg, ZMM_L((val >> 4) & 3)));
+        tcg_gen_movi_i32(s->tmp2_i32, 0);
+        for (i = 0; i < 4; i++) {
+            if ((val >> i) & 1) {
+                tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                               d_ofs + offsetof(ZMMReg, ZMM_L(i)));
+            }
+        }
+        gen_clear_ymmh(reg);
+        return;
+
+    case 0x34a: /* vblendvps */
+    case 0x34b: /* vblendvpd */
+    case 0x34c: /* vpblendvb */
+        if (s->vex_w) {
+            goto illegal_op;
+        }
+        if (mod != 3) {
+            gen_lea_modrm(env, s, modrm);
+            s_ofs = t0_ofs;
+            gen_ldx_env_A0(s, s_ofs, l);
+        }
+        val = x86_ldub_code(env, s);
+        {
+            TCGMemOp vece = b == 0x4a ? MO_32 : b == 0x4b ? MO_64 : MO_8;
+            int m_ofs = offsetof(CPUX86State,
+                                 xmm_regs[(val >> 4) & (CODE64(s) ? 15 : 7)]);
+            int ofs = l ? ZMM_YMM_OFS : ZMM_XMM_OFS;
+
+            /* Take the elements of s whose mask sign bit is set, else v */
+            tcg_gen_gvec_sari(vece, t1_ofs + ofs, m_ofs + ofs,
+                              (8 << vece) - 1, 16 << l, 16 << l);
+            tcg_gen_gvec_xor(MO_64, t0_ofs + ofs, v_ofs + ofs, s_ofs + ofs,
+                             16 << l, 16 << l);
+            tcg_gen_gvec_and(MO_64, t0_ofs + ofs, t0_ofs + ofs, t1_ofs + ofs,
+                             16 << l, 16 << l);
+            tcg_gen_gvec_xor(MO_64, d_ofs + ofs, v_ofs + ofs, t0_ofs + ofs,
+                             16 << l, 16 << l);
+        }
+        if (!l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+
+    case 0x360 ... 0x363: /* vpcmpestrm, vpcmpestri, vpcmpistrm, vpcmpistri */
+        if (l || vvvv != 0) {
+            goto illegal_op;
+        }
+        dest = b & 1 ? -1 : 0;
+        goto legacy;
+
+    default:
+        break;
+    }
+
+    /* Operations done by an ops_sse.h helper, one lane at a time */
+    if (op < 0x200) {
+        sse_fn_epp = sse_op_table1[b][b1];
+        if (!sse_fn_epp || sse_fn_epp == SSE_SPECIAL
+            || sse_fn_epp == SSE_DUMMY) {
+            goto illegal_op;
+        }
+        if (b1 == 0 && b >= 0x60 && b != 0xc2 && b != 0xc6) {
+            /* No VEX encoding for the MMX forms */
+            goto illegal_op;
+        }
+        scalar = (b1 >= 2
+                  && ((b >= 0x51 && b <= 0x5f && b != 0x5b) || b == 0xc2));
+        if (b == 0x70 || b == 0xc6) {
+            sse_fn_ppi = (SSEFunc_0_ppi)sse_fn_epp;
+            sse_fn_epp = NULL;
+        }
+        count = ((b >= 0xd1 && b <= 0xd3) || b == 0xe1 || b == 0xe2
+                 || (b >= 0xf1 && b <= 0xf3));
+    } else if (op < 0x300) {
+        sse_fn_epp = sse_op_table6[b].op[1];
+        if (!sse_fn_epp || sse_fn_epp == SSE_SPECIAL
+            || b == 0x10 || b == 0x14 || b == 0x15) {
+            goto illegal_op;
+        }
+        if (!(s->cpuid_ext_features & sse_op_table6[b].ext_mask)) {
+            goto illegal_op;
+        }
+        if (l && (b == 0x41 || b >= 0xdb)) {
+            goto illegal_op;
+        }
+    } else {
+        sse_fn_eppi = sse_op_table7[b].op[1];
+        if (!sse_fn_eppi || sse_fn_eppi == SSE_SPECIAL) {
+            goto illegal_op;
+        }
+        if (!(s->cpuid_ext_features & sse_op_table7[b].ext_mask)) {
+            goto illegal_op;
+        }
+        if (l && (b == 0x41 || b == 0x44 || b == 0xdf)) {
+            goto illegal_op;
+        }
+        scalar = (b == 0x0a || b == 0x0b);
+    }
+
+ lanes:
+    if (scalar) {
+        /* The scalar operations ignore VEX.L */
+        l = 0;
+    }
+    if (avx_is_nds(op, b1)) {
+        a_ofs = v_ofs;
+    } else if (vvvv != 0) {
+        goto illegal_op;
+    } else {
+        a_ofs = d_ofs;
+    }
+    if (mod != 3) {
+        gen_lea_modrm(env, s, modrm);
+        s_ofs = t0_ofs;
+        if (scalar && (b1 == 2 || b == 0x0a)) {
+            tcg_gen_qemu_ld_i32(s->tmp2_i32, s->A0, s->mem_index, MO_LEUL);
+            tcg_gen_st_i32(s->tmp2_i32, cpu_env,
+                           s_ofs + offsetof(ZMMReg, ZMM_L(0)));
+        } else if (scalar) {
+            gen_ldq_env_A0(s, s_ofs + offsetof(ZMMReg, ZMM_Q(0)));
+        } else {
+            /* The shift count is an m128 operand even with VEX.256 */
+            gen_ldx_env_A0(s, s_ofs, count ? 0 : l);
+        }
+    }
+    if (s->rip_offset) {
+        val = x86_ldub_code(env, s);
+        if (op == 0x1c2) {
+            /* The VEX forms have 32 comparison predicates */
+            val &= 0x1f;
+            sse_fn_eppi = sse_op_table_vcmp[b1];
+        }
+    } else {
+        val = 0;
+    }
+
+    if (op < 0x200
+        && gen_sse_gvec(b, d_ofs + (l ? ZMM_YMM_OFS : ZMM_XMM_OFS),
+                        a_ofs + (l ? ZMM_YMM_OFS : ZMM_XMM_OFS),
+                        s_ofs + (l ? ZMM_YMM_OFS : ZMM_XMM_OFS), 16 << l)) {
+        if (!l) {
+            gen_clear_ymmh(reg);
+        }
+        return;
+    }
+
+    if (count && l) {
+        /* The shift count is in the low lane, which may be overwritten */
+        gen_lane_mov(t0_ofs, 0, s_ofs, 0);
+        s_ofs = t0_ofs;
+    }
+    for (k = 0; k <= l; k++) {
+        int p0 = d_ofs, p1 = s_ofs;
+
+        if (k || a_ofs != d_ofs) {
+            gen_lane_mov(t1_ofs, 0, a_ofs, k);
+            p0 = t1_ofs;
+        }
+        if (k && !count) {
+            gen_lane_mov(t0_ofs, 0, s_ofs, k);
+            p1 = t0_ofs;
+        }
+        tcg_gen_addi_ptr(s->ptr0, cpu_env, p0);
+        tcg_gen_addi_ptr(s->ptr1, cpu_env, p1);
+        if (sse_fn_eppi) {
+            sse_fn_eppi(cpu_env, s->ptr0, s->ptr1,
+                        tcg_const_i32(avx_lane_imm(op, b1, val, k)));
+        } else if (sse_fn_ppi) {
+            sse_fn_ppi(s->ptr0, s->ptr1,
+                       tcg_const_i32(avx_lane_imm(op, b1, val, k)));
+        } else {
+            sse_fn_epp(cpu_env, s->ptr0, s->ptr1);
+        }
+        if (p0 != d_ofs) {
+            gen_lane_mov(d_ofs, k, t1_ofs, 0);
+        }
+    }
+    if (!l) {
+        gen_clear_ymmh(reg);
+    }
+    return;
+
+ legacy:
+    /*
+     * Same as the SSE encoding, except for zeroing the upper half of
+     * the destination.
+     */
+    s->pc = pc;
+    gen_sse_legacy(env, s, b0, pc_start, rex_r);
+    if (dest >= 0) {
+        gen_clear_ymmh(dest);
+    }
+    return;
+
+ illegal_op:
+    gen_illegal_opcode(s);
+}
+
+static void gen_sse(CPUX86State *env, DisasContext *s, int b,
+                    target_ulong pc_start, int rex_r)
+{
+    if (s->prefix & PREFIX_VEX) {
+        gen_avx(env, s, b, pc_start, rex_r);
+    } else {
+        gen_sse_legacy(env, s, b, pc_start, rex_r);
+    }
+}
+
+/* convert one instruction. s->base.is_jmp is set if the translation must
+   be stopped. Return the next pc value */
+static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
+{
+    CPUX86State *env = cpu->env_ptr;
+    int b, prefixes;
+    int shift;
+    TCGMemOp ot, aflag, dflag;
+    int modrm, reg, rm, mod, op, opreg, val;
+    target_ulong next_eip, tval;
+    int rex_w, rex_r;
+    target_ulong pc_start = s->base.pc_next;
+
+    s->pc_start = s->pc = pc_start;
+    s->override = -1;
+#ifdef TARGET_X86_64
+    s->rex_x = 0;
+    s->rex_b = 0;
+    s->x86_64_hregs = false;
+#endif
+    s->rip_offset = 0; /* for relative ip address */
+    s->vex_l = 0;
+    s->vex_v = 0;
+    if (sigsetjmp(s->jmpbuf, 0) != 0) {
+        gen_exception(s, EXCP0D_GPF, pc_start - s->cs_base);
+        return s->pc;
+    }
+
+    prefixes = 0;
+    rex_w = -1;
+    rex_r = 0;
+
+ next_byte:
+    b = x86_ldub_code(env, s);
+    /* Collect prefixes.  */
+    switch (b) {
+    case 0xf3:
+        prefixes |= PREFIX_REPZ;
+        goto next_byte;
+    case 0xf2:
+        prefixes |= PREFIX_REPNZ;
+        goto next_byte;
+    case 0xf0:
+        prefixes |= PREFIX_LOCK;
+        goto next_byte;
+    case 0x2e:
+        s->override = R_CS;
+        goto next_byte;
+    case 0x36:
+        s->override = R_SS;
+        goto next_byte;
+    case 0x3e:
+        s->override = R_DS;
+        goto next_byte;
+    case 0x26:
+        s->override = R_ES;
+        goto next_byte;
+    case 0x64:
+        s->override = R_FS;
+        goto next_byte;
+    case 0x65:
+        s->override = R_GS;
+        goto next_byte;
+    case 0x66:
+        prefixes |= PREFIX_DATA;
+        goto next_byte;
+    case 0x67:
+        prefixes |= PREFIX_ADR;
+        goto next_byte;
+#ifdef TARGET_X86_64
+    case 0x40 ... 0x4f:
+        if (CODE64(s)) {
+            /* REX prefix */
+            rex_w = (b >> 3) & 1;
+            rex_r = (b & 0x4) << 1;
+            s->rex_x = (b & 0x2) << 2;
+            REX_B(s) = (b & 0x1) << 3;
+            /* select uniform byte register addressing */
+            s->x86_64_hregs = true;
             goto next_byte;
         }
         break;
@@ -4610,6 +6319,7 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
             }
             s->vex_v = (~vex3 >> 3) & 0xf;
             s->vex_l = (vex3 >> 2) & 1;
+            s->vex_w = rex_w > 0;
             prefixes |= pp_prefix[vex3 & 3] | PREFIX_VEX;
         }
         break;
@@ -5053,6 +6763,7 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
             next_eip = s->pc - s->cs_base;
             tcg_gen_movi_tl(s->T1, next_eip);
             gen_push_v(s, s->T1);
+            translator_ras_push(&s->base, s->cs_base + next_eip);
             gen_op_jmp_v(s->T0);
             gen_bnd_jmp(s);
             gen_jr(s, s->T0);
@@ -6474,7 +8185,7 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
         /* Note that gen_pop_T0 uses a zero-extending load.  */
         gen_op_jmp_v(s->T0);
         gen_bnd_jmp(s);
-        gen_jr(s, s->T0);
+        gen_ret_jr(s, s->T0);
         break;
     case 0xc3: /* ret */
         ot = gen_pop_T0(s);
@@ -6482,7 +8193,7 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
         /* Note that gen_pop_T0 uses a zero-extending load.  */
         gen_op_jmp_v(s->T0);
         gen_bnd_jmp(s);
-        gen_jr(s, s->T0);
+        gen_ret_jr(s, s->T0);
         break;
     case 0xca: /* lret im */
         val = x86_ldsw_code(env, s);
@@ -6547,8 +8258,9 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
             }
             tcg_gen_movi_tl(s->T0, next_eip);
             gen_push_v(s, s->T0);
+            translator_ras_push(&s->base, s->cs_base + next_eip);
             gen_bnd_jmp(s);
-            gen_jmp(s, tval);
+            gen_jmp_direct(s, tval);
         }
         break;
     case 0x9a: /* lcall im */
@@ -6578,7 +8290,7 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
             tval &= 0xffffffff;
         }
         gen_bnd_jmp(s);
-        gen_jmp(s, tval);
+        gen_jmp_direct(s, tval);
         break;
     case 0xea: /* ljmp im */
         {
@@ -6600,7 +8312,7 @@ static target_ulong disas_insn(DisasContext *s, CPUState *cpu)
         if (dflag == MO_16) {
             tval &= 0xffff;
         }
-        gen_jmp(s, tval);
+        gen_jmp_direct(s, tval);
         break;
     case 0x70 ... 0x7f: /* jcc Jb */
         tval = (int8_t)insn_get(env, s, MO_8);
@@ -8441,8 +10153,10 @@ static void i386_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cpu)
     dc->cpl = (flags >> HF_CPL_SHIFT) & 3;
     dc->iopl = (flags >> IOPL_SHIFT) & 3;
     dc->tf = (flags >> TF_SHIFT) & 1;
-    dc->cc_op = CC_OP_DYNAMIC;
+    /* CC_OP is known on entry if it is one of the common values */
+    dc->cc_op = tb_flags_cc_op[(flags & HF_CC_OP_MASK) >> HF_CC_OP_SHIFT];
     dc->cc_op_dirty = false;
+    dc->cc_op_entry = dc->cc_op == CC_OP_DYNAMIC;
     dc->cs_base = cs_base;
     dc->popl_esp_hack = 0;
     /* select memory access functions */
@@ -8496,6 +10210,13 @@ static void i386_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cpu)
 
 static void i386_tr_tb_start(DisasContextBase *db, CPUState *cpu)
 {
+    DisasContext *dc = container_of(db, DisasContext, base);
+
+    /* CC_SRCT is not part of the cpu state; rebuild it from CC_SRC and
+       CC_DST as cc_compute_all does.  */
+    if (dc->cc_op >= CC_OP_SUBB && dc->cc_op <= CC_OP_SUBQ) {
+        tcg_gen_add_tl(dc->cc_srcT, cpu_cc_dst, cpu_cc_src);
+    }
 }
 
 static void i386_tr_insn_start(DisasContextBase *dcbase, CPUState *cpu)
@@ -1042,8 +1042,8 @@ struct CPUPPCState {
     /* Special purpose registers */
     target_ulong spr[1024];
     ppc_spr_t spr_cb[1024];
-    /* Altivec registers */
-    ppc_avr_t avr[32];
+    /* Altivec registers; aligned for use as TCG host vectors */
+    ppc_avr_t avr[32] QEMU_ALIGNED(16);
     uint32_t vscr;
     /* VSX registers */
     uint64_t vsr[32];
@@ -1147,6 +1147,13 @@ static void s390_max_cpu_model_initfn(Object *obj)
     cpu->model = g_new(S390CPUModel, 1);
     /* copy the CPU model so we can modify it */
     memcpy(cpu->model, max_model, sizeof(*cpu->model));
+    if (tcg_enabled()) {
+        /*
+         * The vector floating point instructions are not implemented yet,
+         * so the vector facility has to be requested explicitly (vx=on).
+         */
+        clear_bit(S390_FEAT_VECTOR, cpu->model->features);
+    }
 }
 
 static void s390_cpu_model_finalize(Object *obj)
@@ -598,6 +598,8 @@ static uint16_t qemu_MAX[] = {
     S390_FEAT_STFLE_53,
     /* generates a dependency warning, leave it out for now */
     S390_FEAT_MSA_EXT_5,
+    /* no floating point instructions yet, only enabled on request */
+    S390_FEAT_VECTOR,
     /* only with CONFIG_PCI */
     S390_FEAT_ZPCI,
 };
@@ -0,0 +1,441 @@
+/*
+ * QEMU TCG support -- s390x vector support instructions and
+ * vector integer instructions
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu-common.h"
+#include "cpu.h"
+#include "internal.h"
+#include "vec.h"
+#include "tcg/tcg.h"
+#include "tcg/tcg-gvec-desc.h"
+#include "exec/helper-proto.h"
+#include "exec/cpu_ldst.h"
+#include "exec/exec-all.h"
+
+void HELPER(vll)(CPUS390XState *env, void *v1, uint64_t addr, uint64_t bytes)
+{
+    S390Vector tmp = {};
+    int i;
+
+    /* Load into a temporary so a fault leaves the register untouched. */
+    bytes = MIN(bytes, 16);
+    for (i = 0; i < bytes; i++) {
+        const uint8_t byte = cpu_ldub_data_ra(env, addr, GETPC());
+
+        s390_vec_write_element(&tmp, i, ES_8, byte);
+        addr = wrap_address(env, addr + 1);
+    }
+    *(S390Vector *)v1 = tmp;
+}
+
+void HELPER(vstl)(CPUS390XState *env, void *v1, uint64_t addr,
+                  uint64_t bytes)
+{
+    int i;
+
+    /* Probe write access before actually modifying memory */
+    bytes = MIN(bytes, 16);
+    probe_write_access(env, addr, bytes, GETPC());
+
+    for (i = 0; i < bytes; i++) {
+        const uint8_t byte = s390_vec_read_element(v1, i, ES_8);
+
+        cpu_stb_data_ra(env, addr, byte, GETPC());
+        addr = wrap_address(env, addr + 1);
+    }
+}
+
+void HELPER(gvec_vperm)(void *v1, void *v2, void *v3,
+                        void *v4, uint32_t desc)
+{
+    S390Vector tmp;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        const uint8_t selector = s390_vec_read_element(v4, i, ES_8) & 0x1f;
+        uint8_t byte;
+
+        if (selector < 16) {
+            byte = s390_vec_read_element(v2, selector, ES_8);
+        } else {
+            byte = s390_vec_read_element(v3, selector - 16, ES_8);
+        }
+        s390_vec_write_element(&tmp, i, ES_8, byte);
+    }
+    *(S390Vector *)v1 = tmp;
+}
+
+static int64_t sext_element(uint64_t a, uint8_t es)
+{
+    const int bits = NUM_VEC_ELEMENT_BITS(es);
+
+    return (int64_t)(a << (64 - bits)) >> (64 - bits);
+}
+
+void HELPER(gvec_vpk)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    const uint8_t es = simd_data(desc);
+    const int n = NUM_VEC_ELEMENTS(es);
+    S390Vector tmp;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        s390_vec_write_element(&tmp, i, es - 1,
+                               s390_vec_read_element(v2, i, es));
+        s390_vec_write_element(&tmp, i + n, es - 1,
+                               s390_vec_read_element(v3, i, es));
+    }
+    *(S390Vector *)v1 = tmp;
+}
+
+/*
+ * Pack with saturation, and return the CC: 0 if no element saturated,
+ * 3 if all of them did and 1 otherwise.
+ */
+static int vpk_sat(S390Vector *v1, const S390Vector *v2, const S390Vector *v3,
+                   uint8_t es, bool logical)
+{
+    const int n = NUM_VEC_ELEMENTS(es);
+    const int bits = NUM_VEC_ELEMENT_BITS(es - 1);
+    const int64_t smax = (1ull << (bits - 1)) - 1;
+    const uint64_t umax = (1ull << (bits - 1) << 1) - 1;
+    S390Vector tmp;
+    int i, saturated = 0;
+
+    for (i = 0; i < 2 * n; i++) {
+        const S390Vector *v = i < n ? v2 : v3;
+        uint64_t a = s390_vec_read_element(v, i % n, es);
+
+        if (logical) {
+            if (a > umax) {
+                a = umax;
+                saturated++;
+            }
+        } else {
+            const int64_t sa = sext_element(a, es);
+
+            if (sa > smax) {
+                a = smax;
+                saturated++;
+            } else if (sa < -smax - 1) {
+                a = -smax - 1;
+                saturated++;
+            }
+        }
+        s390_vec_write_element(&tmp, i, es - 1, a);
+    }
+    *v1 = tmp;
+    return !saturated ? 0 : saturated == 2 * n ? 3 : 1;
+}
+
+#define DEF_VPK_SAT(NAME, LOGICAL)                                           \
+void HELPER(gvec_##NAME)(void *v1, void *v2, void *v3, uint32_t desc)        \
+{                                                                            \
+    vpk_sat(v1, v2, v3, simd_data(desc), LOGICAL);                           \
+}                                                                            \
+                                                                             \
+void HELPER(gvec_##NAME##_cc)(void *v1, void *v2, void *v3,                  \
+                              CPUS390XState *env, uint32_t desc)             \
+{                                                                            \
+    env->cc_op = vpk_sat(v1, v2, v3, simd_data(desc), LOGICAL);              \
+}
+DEF_VPK_SAT(vpks, false)
+DEF_VPK_SAT(vpkls, true)
+#undef DEF_VPK_SAT
+
+void HELPER(gvec_vlp)(void *v1, void *v2, uint32_t desc)
+{
+    const uint8_t es = simd_data(desc);
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        const int64_t a = sext_element(s390_vec_read_element(v2, i, es), es);
+
+        s390_vec_write_element(v1, i, es, a < 0 ? -a : a);
+    }
+}
+
+#define DEF_VMINMAX(NAME, SIGNED, MAX)                                       \
+void HELPER(gvec_##NAME)(void *v1, void *v2, void *v3, uint32_t desc)        \
+{                                                                            \
+    const uint8_t es = simd_data(desc);                                      \
+    int i;                                                                   \
+                                                                             \
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {                             \
+        uint64_t a = s390_vec_read_element(v2, i, es);                       \
+        uint64_t b = s390_vec_read_element(v3, i, es);                       \
+        bool b_greater;                                                      \
+                                                                             \
+        if (a == b) {                                                        \
+            b_greater = false;                                               \
+        } else if (SIGNED) {                                                 \
+            b_greater = sext_element(b, es) > sext_element(a, es);           \
+        } else {                                                             \
+            b_greater = b > a;                                               \
+        }                                                                    \
+        s390_vec_write_element(v1, i, es, b_greater == MAX ? b : a);         \
+    }                                                                        \
+}
+DEF_VMINMAX(vmx, true, true)
+DEF_VMINMAX(vmxl, false, true)
+DEF_VMINMAX(vmn, true, false)
+DEF_VMINMAX(vmnl, false, false)
+#undef DEF_VMINMAX
+
+void HELPER(gvec_vesl)(void *v1, void *v3, uint64_t count,
+                       uint32_t desc)
+{
+    const uint8_t es = simd_data(desc);
+    const int shift = count & (NUM_VEC_ELEMENT_BITS(es) - 1);
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        const uint64_t a = s390_vec_read_element(v3, i, es);
+
+        s390_vec_write_element(v1, i, es, a << shift);
+    }
+}
+
+void HELPER(gvec_vesra)(void *v1, void *v3, uint64_t count,
+                        uint32_t desc)
+{
+    const uint8_t es = simd_data(desc);
+    const int shift = count & (NUM_VEC_ELEMENT_BITS(es) - 1);
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        const int64_t a = sext_element(s390_vec_read_element(v3, i, es), es);
+
+        s390_vec_write_element(v1, i, es, a >> shift);
+    }
+}
+
+void HELPER(gvec_vesrl)(void *v1, void *v3, uint64_t count,
+                        uint32_t desc)
+{
+    const uint8_t es = simd_data(desc);
+    const int shift = count & (NUM_VEC_ELEMENT_BITS(es) - 1);
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        const uint64_t a = s390_vec_read_element(v3, i, es);
+
+        s390_vec_write_element(v1, i, es, a >> shift);
+    }
+}
+
+/* The average is computed without overflow, rounding halves upwards */
+#define DEF_VAVG(NAME, SIGNED)                                               \
+void HELPER(gvec_##NAME)(void *v1, void *v2, void *v3, uint32_t desc)        \
+{                                                                            \
+    const uint8_t es = simd_data(desc);                                      \
+    int i;                                                                   \
+                                                                             \
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {                             \
+        uint64_t a = s390_vec_read_element(v2, i, es);                       \
+        uint64_t b = s390_vec_read_element(v3, i, es);                       \
+        uint64_t r = (a | b) & 1;                                            \
+                                                                             \
+        if (SIGNED) {                                                        \
+            r += (sext_element(a, es) >> 1) + (sext_element(b, es) >> 1);    \
+        } else {                                                             \
+            r += (a >> 1) + (b >> 1);                                        \
+        }                                                                    \
+        s390_vec_write_element(v1, i, es, r);                                \
+    }                                                                        \
+}
+DEF_VAVG(vavg, true)
+DEF_VAVG(vavgl, false)
+#undef DEF_VAVG
+
+void HELPER(gvec_vcksm)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    uint64_t sum = s390_vec_read_element(v3, 1, ES_32);
+    S390Vector tmp = {};
+    int i;
+
+    /* 32-bit addition with end-around carry */
+    for (i = 0; i < 4; i++) {
+        sum += s390_vec_read_element(v2, i, ES_32);
+        sum = (uint32_t)sum + (sum >> 32);
+    }
+    s390_vec_write_element(&tmp, 1, ES_32, sum);
+    *(S390Vector *)v1 = tmp;
+}
+
+/* Carry-less multiplication of two elements of up to 64 bits */
+static void gfm(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo)
+{
+    uint64_t h = 0, l = 0;
+    int i;
+
+    for (i = 0; i < 64; i++) {
+        if (b & (1ull << i)) {
+            l ^= a << i;
+            h ^= i ? a >> (64 - i) : 0;
+        }
+    }
+    *hi = h;
+    *lo = l;
+}
+
+/*
+ * Each element of the result, twice as wide as the source elements, is
+ * the XOR of the carry-less products of an even-odd pair of elements,
+ * XORed with the element of V4 if there is one.
+ */
+static void vgfm(S390Vector *v1, const S390Vector *v2, const S390Vector *v3,
+                 const S390Vector *v4, uint8_t es)
+{
+    S390Vector tmp;
+    uint64_t h, l, hi, lo;
+    int i, j;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es) / 2; i++) {
+        hi = lo = 0;
+        for (j = 2 * i; j < 2 * i + 2; j++) {
+            gfm(s390_vec_read_element(v2, j, es),
+                s390_vec_read_element(v3, j, es), &h, &l);
+            hi ^= h;
+            lo ^= l;
+        }
+        if (es == ES_64) {
+            if (v4) {
+                hi ^= s390_vec_read_element(v4, 0, ES_64);
+                lo ^= s390_vec_read_element(v4, 1, ES_64);
+            }
+            s390_vec_write_element(&tmp, 0, ES_64, hi);
+            s390_vec_write_element(&tmp, 1, ES_64, lo);
+        } else {
+            if (v4) {
+                lo ^= s390_vec_read_element(v4, i, es + 1);
+            }
+            s390_vec_write_element(&tmp, i, es + 1, lo);
+        }
+    }
+    *v1 = tmp;
+}
+
+void HELPER(gvec_vgfm)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    vgfm(v1, v2, v3, NULL, simd_data(desc));
+}
+
+void HELPER(gvec_vgfma)(void *v1, void *v2, void *v3, void *v4,
+                        uint32_t desc)
+{
+    vgfm(v1, v2, v3, v4, simd_data(desc));
+}
+
+/*
+ * VSUM, VSUMG and VSUMQ: each element of the result, of size DST_ES, is
+ * the sum of the elements of V2 it covers, plus the rightmost element of
+ * V3 it covers.
+ */
+static void vsum(S390Vector *v1, const S390Vector *v2, const S390Vector *v3,
+                 uint8_t es, uint8_t dst_es)
+{
+    const int n = 1 << (dst_es - es);
+    S390Vector tmp;
+    uint64_t h, l;
+    int i, j;
+
+    if (dst_es == ES_128) {
+        h = 0;
+        l = s390_vec_read_element(v3, NUM_VEC_ELEMENTS(es) - 1, es);
+        for (j = 0; j < NUM_VEC_ELEMENTS(es); j++) {
+            const uint64_t a = s390_vec_read_element(v2, j, es);
+
+            l += a;
+            h += l < a;
+        }
+        s390_vec_write_element(&tmp, 0, ES_64, h);
+        s390_vec_write_element(&tmp, 1, ES_64, l);
+    } else {
+        for (i = 0; i < NUM_VEC_ELEMENTS(dst_es); i++) {
+            l = s390_vec_read_element(v3, (i + 1) * n - 1, es);
+            for (j = i * n; j < (i + 1) * n; j++) {
+                l += s390_vec_read_element(v2, j, es);
+            }
+            s390_vec_write_element(&tmp, i, dst_es, l);
+        }
+    }
+    *v1 = tmp;
+}
+
+void HELPER(gvec_vsum)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    vsum(v1, v2, v3, simd_data(desc), ES_32);
+}
+
+void HELPER(gvec_vsumg)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    vsum(v1, v2, v3, simd_data(desc), ES_64);
+}
+
+void HELPER(gvec_vsumq)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    vsum(v1, v2, v3, simd_data(desc), ES_128);
+}
+
+static uint64_t rotl_element(uint64_t a, unsigned count, uint8_t es)
+{
+    const int bits = NUM_VEC_ELEMENT_BITS(es);
+
+    count &= bits - 1;
+    return count ? a << count | a >> (bits - count) : a;
+}
+
+void HELPER(gvec_verll)(void *v1, void *v3, uint64_t count, uint32_t desc)
+{
+    const uint8_t es = simd_data(desc);
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        const uint64_t a = s390_vec_read_element(v3, i, es);
+
+        s390_vec_write_element(v1, i, es, rotl_element(a, count, es));
+    }
+}
+
+void HELPER(gvec_verim)(void *v1, void *v2, void *v3, uint32_t desc)
+{
+    const uint8_t es = simd_data(desc) & 0xf;
+    const uint8_t count = simd_data(desc) >> 4;
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        const uint64_t a = s390_vec_read_element(v2, i, es);
+        const uint64_t mask = s390_vec_read_element(v3, i, es);
+        const uint64_t d = s390_vec_read_element(v1, i, es);
+
+        s390_vec_write_element(v1, i, es,
+                               (rotl_element(a, count, es) & mask) |
+                               (d & ~mask));
+    }
+}
+
+/* The element shifts and rotates by the corresponding element of V3 */
+#define DEF_VESV(NAME, OP)                                                   \
+void HELPER(gvec_##NAME)(void *v1, void *v2, void *v3, uint32_t desc)        \
+{                                                                            \
+    const uint8_t es = simd_data(desc);                                      \
+    int i;                                                                   \
+                                                                             \
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {                             \
+        const uint64_t a = s390_vec_read_element(v2, i, es);                 \
+        const int shift = s390_vec_read_element(v3, i, es) &                 \
+                          (NUM_VEC_ELEMENT_BITS(es) - 1);                    \
+                                                                             \
+        s390_vec_write_element(v1, i, es, OP);                               \
+    }                                                                        \
+}
+DEF_VESV(veslv, a << shift)
+DEF_VESV(vesrav, sext_element(a, es) >> shift)
+DEF_VESV(vesrlv, a >> shift)
+DEF_VESV(verllv, rotl_element(a, shift, es))
+#undef DEF_VESV
@@ -0,0 +1,250 @@
+/*
+ * QEMU TCG support -- s390x vector string instruction support
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu-common.h"
+#include "cpu.h"
+#include "internal.h"
+#include "vec.h"
+#include "tcg/tcg.h"
+#include "tcg/tcg-gvec-desc.h"
+#include "exec/helper-proto.h"
+
+/* The flags shared by the vector string instructions (M5/M6 field). */
+#define VSTR_IN     0x8     /* invert result */
+#define VSTR_RT     0x4     /* result type: element mask instead of index */
+#define VSTR_ZS     0x2     /* zero search */
+#define VSTR_CS     0x1     /* condition code set */
+
+static inline uint8_t vstr_es(uint32_t desc)
+{
+    return simd_data(desc) & 0xf;
+}
+
+static inline uint8_t vstr_flags(uint32_t desc)
+{
+    return simd_data(desc) >> 4;
+}
+
+/*
+ * Store the result of a search: either the byte index of the first match
+ * in byte 7 (all other bytes zero), or the mask of matching elements.
+ */
+static void vstr_store_result(S390Vector *v1, const bool *match, int first,
+                              uint8_t es, bool rt)
+{
+    S390Vector tmp = {};
+    int i;
+
+    if (rt) {
+        for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+            if (match[i]) {
+                s390_vec_write_element(&tmp, i, es, -1ull);
+            }
+        }
+    } else {
+        s390_vec_write_element(&tmp, 0, ES_64,
+                               first * NUM_VEC_ELEMENT_BYTES(es));
+    }
+    *v1 = tmp;
+}
+
+/* CC of VFAE/VFEE/VSTRC from the first matching and first zero element */
+static int vstr_match_cc(int first_match, int first_zero, int n)
+{
+    if (first_zero == n && first_match == n) {
+        return 3;   /* no match, no zero element */
+    } else if (first_zero == n) {
+        return 1;   /* match, no zero element */
+    } else if (first_match < first_zero) {
+        return 2;   /* match before the zero element */
+    }
+    return 0;       /* zero element first */
+}
+
+static int vstr_find_zero(const S390Vector *v2, uint8_t es)
+{
+    int i;
+
+    for (i = 0; i < NUM_VEC_ELEMENTS(es); i++) {
+        if (!s390_vec_read_element(v2, i, es)) {
+            break;
+        }
+    }
+    return i;
+}
+
+void HELPER(gvec_vfae)(void *v1, void *v2, void *v3, CPUS390XState *env,
+                       uint32_t desc)
+{
+    const uint8_t es = vstr_es(desc);
+    const uint8_t flags = vstr_flags(desc);
+    const int n = NUM_VEC_ELEMENTS(es);
+    bool match[16];
+    int first_match = n, first_zero = n;
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        const uint64_t a = s390_vec_read_element(v2, i, es);
+        bool any = false;
+
+        for (j = 0; j < n; j++) {
+            if (a == s390_vec_read_element(v3, j, es)) {
+                any = true;
+                break;
+            }
+        }
+        match[i] = any != !!(flags & VSTR_IN);
+        if (match[i] && first_match == n) {
+            first_match = i;
+        }
+    }
+    if (flags & VSTR_ZS) {
+        first_zero = vstr_find_zero(v2, es);
+    }
+
+    vstr_store_result(v1, match, MIN(first_match, first_zero), es,
+                      flags & VSTR_RT);
+    if (flags & VSTR_CS) {
+        env->cc_op = vstr_match_cc(first_match, first_zero, n);
+    }
+}
+
+void HELPER(gvec_vfee)(void *v1, void *v2, void *v3, CPUS390XState *env,
+                       uint32_t desc)
+{
+    const uint8_t es = vstr_es(desc);
+    const uint8_t flags = vstr_flags(desc);
+    const int n = NUM_VEC_ELEMENTS(es);
+    int first_equal, first_zero = n;
+
+    for (first_equal = 0; first_equal < n; first_equal++) {
+        if (s390_vec_read_element(v2, first_equal, es) ==
+            s390_vec_read_element(v3, first_equal, es)) {
+            break;
+        }
+    }
+    if (flags & VSTR_ZS) {
+        first_zero = vstr_find_zero(v2, es);
+    }
+
+    vstr_store_result(v1, NULL, MIN(first_equal, first_zero), es, false);
+    if (flags & VSTR_CS) {
+        env->cc_op = vstr_match_cc(first_equal, first_zero, n);
+    }
+}
+
+void HELPER(gvec_vfene)(void *v1, void *v2, void *v3, CPUS390XState *env,
+                        uint32_t desc)
+{
+    const uint8_t es = vstr_es(desc);
+    const uint8_t flags = vstr_flags(desc);
+    const int n = NUM_VEC_ELEMENTS(es);
+    int first_inequal, first_zero = n;
+    uint64_t a = 0, b = 0;
+    int cc;
+
+    for (first_inequal = 0; first_inequal < n; first_inequal++) {
+        a = s390_vec_read_element(v2, first_inequal, es);
+        b = s390_vec_read_element(v3, first_inequal, es);
+        if (a != b) {
+            break;
+        }
+    }
+    if (flags & VSTR_ZS) {
+        first_zero = vstr_find_zero(v2, es);
+    }
+
+    if (first_zero == n && first_inequal == n) {
+        cc = 3;     /* all elements equal, no zero element */
+    } else if (first_zero < first_inequal) {
+        cc = 0;     /* zero element before any inequality */
+    } else {
+        cc = a < b ? 1 : 2;
+    }
+
+    vstr_store_result(v1, NULL, MIN(first_inequal, first_zero), es, false);
+    if (flags & VSTR_CS) {
+        env->cc_op = cc;
+    }
+}
+
+void HELPER(gvec_vistr)(void *v1, void *v2, CPUS390XState *env, uint32_t desc)
+{
+    const uint8_t es = vstr_es(desc);
+    const uint8_t flags = vstr_flags(desc);
+    const int n = NUM_VEC_ELEMENTS(es);
+    const int first_zero = vstr_find_zero(v2, es);
+    S390Vector tmp = {};
+    int i;
+
+    for (i = 0; i < first_zero; i++) {
+        s390_vec_write_element(&tmp, i, es,
+                               s390_vec_read_element(v2, i, es));
+    }
+    *(S390Vector *)v1 = tmp;
+
+    if (flags & VSTR_CS) {
+        env->cc_op = first_zero == n ? 3 : 0;
+    }
+}
+
+/* The range control bits live in the leftmost bits of each control element */
+static bool vstrc_compare(uint64_t data, uint64_t bound, uint64_t ctrl,
+                          uint8_t es)
+{
+    const int bits = NUM_VEC_ELEMENT_BITS(es);
+    const bool equal = extract64(ctrl, bits - 1, 1);
+    const bool lower = extract64(ctrl, bits - 2, 1);
+    const bool higher = extract64(ctrl, bits - 3, 1);
+
+    if (data < bound) {
+        return lower;
+    } else if (data > bound) {
+        return higher;
+    }
+    return equal;
+}
+
+void HELPER(gvec_vstrc)(void *v1, void *v2, void *v3, void *v4,
+                        CPUS390XState *env, uint32_t desc)
+{
+    const uint8_t es = vstr_es(desc);
+    const uint8_t flags = vstr_flags(desc);
+    const int n = NUM_VEC_ELEMENTS(es);
+    bool match[16];
+    int first_match = n, first_zero = n;
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        const uint64_t a = s390_vec_read_element(v2, i, es);
+        bool any = false;
+
+        /* v3/v4 hold pairs of range bounds and their controls */
+        for (j = 0; j < n; j += 2) {
+            if (vstrc_compare(a, s390_vec_read_element(v3, j, es),
+                              s390_vec_read_element(v4, j, es), es) &&
+                vstrc_compare(a, s390_vec_read_element(v3, j + 1, es),
+                              s390_vec_read_element(v4, j + 1, es), es)) {
+                any = true;
+                break;
+            }
+        }
+        match[i] = any != !!(flags & VSTR_IN);
+        if (match[i] && first_match == n) {
+            first_match = i;
+        }
+    }
+    if (flags & VSTR_ZS) {
+        first_zero = vstr_find_zero(v2, es);
+    }
+
+    vstr_store_result(v1, match, MIN(first_match, first_zero), es,
+                      flags & VSTR_RT);
+    if (flags & VSTR_CS) {
+        env->cc_op = vstr_match_cc(first_match, first_zero, n);
+    }
+}
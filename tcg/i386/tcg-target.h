@@ -27,6 +27,10 @@
 
 #define TCG_TARGET_INSN_UNIT_SIZE  1
 #define TCG_TARGET_TLB_DISPLACEMENT_BITS 31
+#define TCG_TARGET_IMPLEMENTS_DYN_TLB 1
+#define TCG_TARGET_HAS_TB_CACHE (TCG_TARGET_REG_BITS == 64)
+/* Slow paths and constant pools are reached with 32-bit displacements */
+#define TCG_TARGET_HAS_COLD_CODE 1
 
 #ifdef __x86_64__
 # define TCG_TARGET_REG_BITS  64
@@ -130,6 +134,14 @@ extern bool have_avx2;
 #define TCG_TARGET_HAS_muluh_i32        0
 #define TCG_TARGET_HAS_mulsh_i32        0
 #define TCG_TARGET_HAS_goto_ptr         1
+/* Grouped TLB checks and fastmem need the softmmu path of a 64-bit host */
+#if defined(CONFIG_SOFTMMU) && TCG_TARGET_REG_BITS == 64
+#define TCG_TARGET_HAS_qemu_page        1
+#define TCG_TARGET_HAS_fastmem          1
+#else
+#define TCG_TARGET_HAS_qemu_page        0
+#define TCG_TARGET_HAS_fastmem          0
+#endif
 #define TCG_TARGET_HAS_direct_jump      1
 
 #if TCG_TARGET_REG_BITS == 64
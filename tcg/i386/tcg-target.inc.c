@@ -330,6 +330,7 @@ static inline int tcg_target_const_match(tcg_target_long val, TCGType type,
 #define OPC_ARITH_GvEv	(0x03)		/* ... plus (ARITH_FOO << 3) */
 #define OPC_ANDN        (0xf2 | P_EXT38)
 #define OPC_ADD_GvEv	(OPC_ARITH_GvEv | (ARITH_ADD << 3))
+#define OPC_AND_GvEv	(OPC_ARITH_GvEv | (ARITH_AND << 3))
 #define OPC_BLENDPS     (0x0c | P_EXT3A | P_DATA16)
 #define OPC_BSF         (0xbc | P_EXT)
 #define OPC_BSR         (0xbd | P_EXT)
@@ -943,9 +944,10 @@ static void tcg_out_movi(TCGContext *s, TCGType type,
         return;
     }
 
-    /* Try a 7 byte pc-relative lea before the 10 byte movq.  */
+    /* Try a 7 byte pc-relative lea before the 10 byte movq.  Code that may
+       be saved to the TB cache must not depend on its own position.  */
     diff = arg - ((uintptr_t)s->code_ptr + 7);
-    if (diff == (int32_t)diff) {
+    if (diff == (int32_t)diff && !s->tbc_recording) {
         tcg_out_opc(s, OPC_LEA | P_REXW, ret, 0, 0);
         tcg_out8(s, (LOWREGMASK(ret) << 3) | 5);
         tcg_out32(s, diff);
@@ -956,6 +958,18 @@ static void tcg_out_movi(TCGContext *s, TCGType type,
     tcg_out64(s, arg);
 }
 
+/* Load a host address that the TB cache must be able to relocate.  */
+static void tcg_out_movi_ptr(TCGContext *s, TCGReg ret, const void *ptr)
+{
+    if (TCG_TARGET_HAS_TB_CACHE && unlikely(s->tbc_recording)) {
+        tcg_out_opc(s, OPC_MOVL_Iv + P_REXW + LOWREGMASK(ret), 0, ret, 0);
+        tcg_out64(s, (uintptr_t)ptr);
+        tcg_tbc_reloc(s, s->code_ptr - 8, TCG_TBC_RELOC_ABS64, ptr);
+        return;
+    }
+    tcg_out_movi(s, TCG_TYPE_PTR, ret, (uintptr_t)ptr);
+}
+
 static inline void tcg_out_pushi(TCGContext *s, tcg_target_long val)
 {
     if (val == (int8_t)val) {
@@ -1516,6 +1530,9 @@ static void tcg_out_branch(TCGContext *s, int call, tcg_insn_unit *dest)
     if (disp == (int32_t)disp) {
         tcg_out_opc(s, call ? OPC_CALL_Jz : OPC_JMP_long, 0, 0, 0);
         tcg_out32(s, disp);
+        if (unlikely(s->tbc_recording)) {
+            tcg_tbc_reloc(s, s->code_ptr - 4, TCG_TBC_RELOC_PC32, dest);
+        }
     } else {
         /* rip-relative addressing into the constant pool.
            This is 6 + 8 = 14 bytes, as compared to using an
@@ -1525,6 +1542,7 @@ static void tcg_out_branch(TCGContext *s, int call, tcg_insn_unit *dest)
         tcg_out8(s, (call ? EXT5_CALLN_Ev : EXT5_JMPN_Ev) << 3 | 5);
         new_pool_label(s, (uintptr_t)dest, R_386_PC32, s->code_ptr, -4);
         tcg_out32(s, 0);
+        s->tbc_unsafe = true;
     }
 }
 
@@ -1625,7 +1643,7 @@ static inline void tcg_out_tlb_load(TCGContext *s, TCGReg addrlo, TCGReg addrhi,
         }
         if (TCG_TYPE_PTR == TCG_TYPE_I64) {
             hrexw = P_REXW;
-            if (TARGET_PAGE_BITS + CPU_TLB_BITS > 32) {
+            if (TARGET_PAGE_BITS + CPU_TLB_DYN_MAX_BITS > 32) {
                 tlbtype = TCG_TYPE_I64;
                 tlbrexw = P_REXW;
             }
@@ -1633,6 +1651,15 @@ static inline void tcg_out_tlb_load(TCGContext *s, TCGReg addrlo, TCGReg addrhi,
     }
 
     tcg_out_mov(s, tlbtype, r0, addrlo);
+    tcg_out_shifti(s, SHIFT_SHR + tlbrexw, r0,
+                   TARGET_PAGE_BITS - CPU_TLB_ENTRY_BITS);
+
+    tcg_out_modrm_offset(s, OPC_AND_GvEv + hrexw, r0, TCG_AREG0,
+                         offsetof(CPUArchState, tlb_mask[mem_index]));
+
+    tcg_out_modrm_offset(s, OPC_ADD_GvEv + hrexw, r0, TCG_AREG0,
+                         offsetof(CPUArchState, tlb_table[mem_index]));
+
     /* If the required alignment is at least as large as the access, simply
        copy the address and mask.  For lesser alignments, check that we don't
        cross pages for the complete access.  */
@@ -1642,20 +1669,10 @@ static inline void tcg_out_tlb_load(TCGContext *s, TCGReg addrlo, TCGReg addrhi,
         tcg_out_modrm_offset(s, OPC_LEA + trexw, r1, addrlo, s_mask - a_mask);
     }
     tlb_mask = (target_ulong)TARGET_PAGE_MASK | a_mask;
-
-    tcg_out_shifti(s, SHIFT_SHR + tlbrexw, r0,
-                   TARGET_PAGE_BITS - CPU_TLB_ENTRY_BITS);
-
     tgen_arithi(s, ARITH_AND + trexw, r1, tlb_mask, 0);
-    tgen_arithi(s, ARITH_AND + tlbrexw, r0,
-                (CPU_TLB_SIZE - 1) << CPU_TLB_ENTRY_BITS, 0);
-
-    tcg_out_modrm_sib_offset(s, OPC_LEA + hrexw, r0, TCG_AREG0, r0, 0,
-                             offsetof(CPUArchState, tlb_table[mem_index][0])
-                             + which);
 
     /* cmp 0(r0), r1 */
-    tcg_out_modrm_offset(s, OPC_CMP_GvEv + trexw, r1, r0, 0);
+    tcg_out_modrm_offset(s, OPC_CMP_GvEv + trexw, r1, r0, which);
 
     /* Prepare for both the fast path add of the tlb addend, and the slow
        path function argument setup.  There are two cases worth note:
@@ -1672,7 +1689,7 @@ static inline void tcg_out_tlb_load(TCGContext *s, TCGReg addrlo, TCGReg addrhi,
 
     if (TARGET_LONG_BITS > TCG_TARGET_REG_BITS) {
         /* cmp 4(r0), addrhi */
-        tcg_out_modrm_offset(s, OPC_CMP_GvEv, addrhi, r0, 4);
+        tcg_out_modrm_offset(s, OPC_CMP_GvEv, addrhi, r0, which + 4);
 
         /* jne slow_path */
         tcg_out_opc(s, OPC_JCC_long + JCC_JNE, 0, 0, 0);
@@ -1684,7 +1701,7 @@ static inline void tcg_out_tlb_load(TCGContext *s, TCGReg addrlo, TCGReg addrhi,
 
     /* add addend(r0), r1 */
     tcg_out_modrm_offset(s, OPC_ADD_GvEv + hrexw, r1, r0,
-                         offsetof(CPUTLBEntry, addend) - which);
+                         offsetof(CPUTLBEntry, addend));
 }
 
 /*
@@ -1750,8 +1767,7 @@ static void tcg_out_qemu_ld_slow_path(TCGContext *s, TCGLabelQemuLdst *l)
         tcg_out_mov(s, TCG_TYPE_PTR, tcg_target_call_iarg_regs[0], TCG_AREG0);
         /* The second argument is already loaded with addrlo.  */
         tcg_out_movi(s, TCG_TYPE_I32, tcg_target_call_iarg_regs[2], oi);
-        tcg_out_movi(s, TCG_TYPE_PTR, tcg_target_call_iarg_regs[3],
-                     (uintptr_t)l->raddr);
+        tcg_out_movi_ptr(s, tcg_target_call_iarg_regs[3], l->raddr);
     }
 
     tcg_out_call(s, qemu_ld_helpers[opc & (MO_BSWAP | MO_SIZE)]);
@@ -1849,10 +1865,10 @@ static void tcg_out_qemu_st_slow_path(TCGContext *s, TCGLabelQemuLdst *l)
 
         if (ARRAY_SIZE(tcg_target_call_iarg_regs) > 4) {
             retaddr = tcg_target_call_iarg_regs[4];
-            tcg_out_movi(s, TCG_TYPE_PTR, retaddr, (uintptr_t)l->raddr);
+            tcg_out_movi_ptr(s, retaddr, l->raddr);
         } else {
             retaddr = TCG_REG_RAX;
-            tcg_out_movi(s, TCG_TYPE_PTR, retaddr, (uintptr_t)l->raddr);
+            tcg_out_movi_ptr(s, retaddr, l->raddr);
             tcg_out_st(s, TCG_TYPE_PTR, retaddr, TCG_REG_ESP,
                        TCG_TARGET_CALL_STACK_OFFSET);
         }
@@ -1981,6 +1997,26 @@ static void tcg_out_qemu_ld_direct(TCGContext *s, TCGReg datalo, TCGReg datahi,
     }
 }
 
+#if TCG_FASTMEM
+/* Unless the TB must go through the TLB, set L1 to the host address of
+   the access in the fastmem window of MEM_INDEX and return true.  If the
+   page is not mapped there, the access faults and tlb_fastmem_fault takes
+   over.  Accesses that must be aligned still check it in the slow path.  */
+static bool tcg_out_fastmem_addr(TCGContext *s, TCGReg addrlo,
+                                 int mem_index, TCGMemOp opc)
+{
+    if (!tcg_fastmem || (s->tb_cflags & CF_NOFASTMEM)
+        || get_alignment_bits(opc) > 0) {
+        return false;
+    }
+
+    tcg_out_ext32u(s, TCG_REG_L1, addrlo);
+    tcg_out_modrm_offset(s, OPC_ADD_GvEv + P_REXW, TCG_REG_L1, TCG_AREG0,
+                         offsetof(CPUArchState, fastmem_base[mem_index]));
+    return true;
+}
+#endif
+
 /* XXX: qemu_ld and qemu_st could be modified to clobber only EDX and
    EAX. It will be useful once fixed registers globals are less
    common. */
@@ -2005,6 +2041,13 @@ static void tcg_out_qemu_ld(TCGContext *s, const TCGArg *args, bool is64)
 #if defined(CONFIG_SOFTMMU)
     mem_index = get_mmuidx(oi);
 
+#if TCG_FASTMEM
+    if (tcg_out_fastmem_addr(s, addrlo, mem_index, opc)) {
+        tcg_out_qemu_ld_direct(s, datalo, datahi, TCG_REG_L1, -1, 0, 0, opc);
+        return;
+    }
+#endif
+
     tcg_out_tlb_load(s, addrlo, addrhi, mem_index, opc,
                      label_ptr, offsetof(CPUTLBEntry, addr_read));
 
@@ -2145,6 +2188,13 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, bool is64)
 #if defined(CONFIG_SOFTMMU)
     mem_index = get_mmuidx(oi);
 
+#if TCG_FASTMEM
+    if (tcg_out_fastmem_addr(s, addrlo, mem_index, opc)) {
+        tcg_out_qemu_st_direct(s, datalo, datahi, TCG_REG_L1, 0, 0, opc);
+        return;
+    }
+#endif
+
     tcg_out_tlb_load(s, addrlo, addrhi, mem_index, opc,
                      label_ptr, offsetof(CPUTLBEntry, addr_write));
 
@@ -2190,6 +2240,117 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, bool is64)
 #endif
 }
 
+#if TCG_TARGET_HAS_qemu_page
+/* Check that the LEN bytes at guest address ADDR + OFS are in a single
+   page, whose TLB entry allows the accesses in WHICH without going through
+   the slow path.  Set HOST to the host address of ADDR + OFS if so, and
+   to 0 otherwise.  The TLB lookup is the same as in tcg_out_tlb_load,
+   where the page crossing test uses the last byte of the range.  */
+static void tcg_out_qemu_page_check(TCGContext *s, const TCGArg *args)
+{
+    const TCGReg r0 = TCG_REG_L0;
+    const TCGReg r1 = TCG_REG_L1;
+    TCGReg host = args[0];
+    TCGReg addr = args[1];
+    tcg_target_long ofs = args[2];
+    tcg_target_long len = args[3];
+    int mem_index = args[4];
+    int which = args[5];
+    int trexw = 0, hrexw = 0, tlbrexw = 0;
+    tcg_insn_unit *label_miss[2], *label_done;
+    int i, n = 0;
+
+    if (TARGET_LONG_BITS == 64) {
+        trexw = P_REXW;
+    }
+    if (TCG_TYPE_PTR == TCG_TYPE_I64) {
+        hrexw = P_REXW;
+        if (TARGET_PAGE_BITS + CPU_TLB_DYN_MAX_BITS > 32) {
+            tlbrexw = P_REXW;
+        }
+    }
+
+    tcg_out_modrm_offset(s, OPC_LEA + trexw, r0, addr, ofs);
+    tcg_out_modrm_offset(s, OPC_LEA + trexw, r1, addr, ofs + len - 1);
+
+    tcg_out_shifti(s, SHIFT_SHR + tlbrexw, r0,
+                   TARGET_PAGE_BITS - CPU_TLB_ENTRY_BITS);
+    tcg_out_modrm_offset(s, OPC_AND_GvEv + hrexw, r0, TCG_AREG0,
+                         offsetof(CPUArchState, tlb_mask[mem_index]));
+    tcg_out_modrm_offset(s, OPC_ADD_GvEv + hrexw, r0, TCG_AREG0,
+                         offsetof(CPUArchState, tlb_table[mem_index]));
+
+    tgen_arithi(s, ARITH_AND + trexw, r1, (target_ulong)TARGET_PAGE_MASK, 0);
+    if (which & TCG_PAGE_CHECK_LD) {
+        tcg_out_modrm_offset(s, OPC_CMP_GvEv + trexw, r1, r0,
+                             offsetof(CPUTLBEntry, addr_read));
+        tcg_out8(s, OPC_JCC_short + JCC_JNE);
+        label_miss[n++] = s->code_ptr;
+        s->code_ptr += 1;
+    }
+    if (which & TCG_PAGE_CHECK_ST) {
+        tcg_out_modrm_offset(s, OPC_CMP_GvEv + trexw, r1, r0,
+                             offsetof(CPUTLBEntry, addr_write));
+        tcg_out8(s, OPC_JCC_short + JCC_JNE);
+        label_miss[n++] = s->code_ptr;
+        s->code_ptr += 1;
+    }
+
+    /* TLB Hit.  As in tcg_out_tlb_load, the LEA zero-extends the address
+       of a 32-bit guest before the ADD of the addend.  */
+    tcg_out_modrm_offset(s, OPC_LEA + trexw, r1, addr, ofs);
+    tcg_out_modrm_offset(s, OPC_ADD_GvEv + hrexw, r1, r0,
+                         offsetof(CPUTLBEntry, addend));
+    tcg_out8(s, OPC_JMP_short);
+    label_done = s->code_ptr;
+    s->code_ptr += 1;
+
+    /* TLB Miss.  */
+    for (i = 0; i < n; i++) {
+        tcg_patch8(label_miss[i], s->code_ptr - label_miss[i] - 1);
+    }
+    tgen_arithr(s, ARITH_XOR, r1, r1);
+
+    tcg_patch8(label_done, s->code_ptr - label_done - 1);
+    tcg_out_mov(s, TCG_TYPE_PTR, host, r1);
+}
+
+/* A load or store of a group checked by qemu_page_check.  If the check
+   succeeded, access HOST + OFS directly; otherwise, go through the usual
+   slow path for the guest address ADDR.  */
+static void tcg_out_qemu_ldst_page(TCGContext *s, const TCGArg *args,
+                                   bool is_ld)
+{
+    TCGReg data = args[0];
+    TCGReg addr = args[1];
+    TCGReg host = args[2];
+    TCGMemOpIdx oi = args[3];
+    intptr_t ofs = args[4];
+    TCGMemOp opc = get_memop(oi);
+    tcg_insn_unit *label_ptr[2];
+
+    /* The slow path expects the guest address in the second argument
+       register; see tcg_out_tlb_load.  */
+    tcg_out_mov(s, TARGET_LONG_BITS == 64 ? TCG_TYPE_I64 : TCG_TYPE_I32,
+                TCG_REG_L1, addr);
+
+    /* test host, host; je slow_path */
+    tcg_out_modrm(s, OPC_TESTL + P_REXW, host, host);
+    tcg_out_opc(s, OPC_JCC_long + JCC_JE, 0, 0, 0);
+    label_ptr[0] = s->code_ptr;
+    s->code_ptr += 4;
+
+    if (is_ld) {
+        tcg_out_qemu_ld_direct(s, data, 0, host, -1, ofs, 0, opc);
+    } else {
+        tcg_out_qemu_st_direct(s, data, 0, host, ofs, 0, opc);
+    }
+
+    add_qemu_ldst_label(s, is_ld, oi, data, 0, addr, 0,
+                        s->code_ptr, label_ptr);
+}
+#endif
+
 static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
                               const TCGArg *args, const int *const_args)
 {
@@ -2218,7 +2379,7 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
         if (a0 == 0) {
             tcg_out_jmp(s, s->code_gen_epilogue);
         } else {
-            tcg_out_movi(s, TCG_TYPE_PTR, TCG_REG_EAX, a0);
+            tcg_out_movi_ptr(s, TCG_REG_EAX, (void *)a0);
             tcg_out_jmp(s, tb_ret_addr);
         }
         break;
@@ -2474,6 +2635,19 @@ static inline void tcg_out_op(TCGContext *s, TCGOpcode opc,
     case INDEX_op_qemu_st_i64:
         tcg_out_qemu_st(s, args, 1);
         break;
+#if TCG_TARGET_HAS_qemu_page
+    case INDEX_op_qemu_page_check:
+        tcg_out_qemu_page_check(s, args);
+        break;
+    case INDEX_op_qemu_ld_page_i32:
+    case INDEX_op_qemu_ld_page_i64:
+        tcg_out_qemu_ldst_page(s, args, true);
+        break;
+    case INDEX_op_qemu_st_page_i32:
+    case INDEX_op_qemu_st_page_i64:
+        tcg_out_qemu_ldst_page(s, args, false);
+        break;
+#endif
 
     OP_32_64(mulu2):
         tcg_out_modrm(s, OPC_GRP3_Ev + rexw, EXT3_MUL, args[3]);
@@ -3014,6 +3188,14 @@ static const TCGTargetOpDef *tcg_target_op_def(TCGOpcode op)
         return (TCG_TARGET_REG_BITS == 64 ? &L_L
                 : TARGET_LONG_BITS <= TCG_TARGET_REG_BITS ? &L_L_L
                 : &L_L_L_L);
+    case INDEX_op_qemu_page_check:
+        return &r_L;
+    case INDEX_op_qemu_ld_page_i32:
+    case INDEX_op_qemu_ld_page_i64:
+        return &r_L_L;
+    case INDEX_op_qemu_st_page_i32:
+    case INDEX_op_qemu_st_page_i64:
+        return &L_L_L;
 
     case INDEX_op_brcond2_i32:
         {
@@ -204,6 +204,22 @@ DEF(qemu_ld_i64, DATA64_ARGS, TLADDR_ARGS, 1,
 DEF(qemu_st_i64, 0, TLADDR_ARGS + DATA64_ARGS, 1,
     TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS | TCG_OPF_64BIT)
 
+/* Same-page access groups, created by tcg_gen_code; softmmu only.  */
+DEF(qemu_page_check, 1, TLADDR_ARGS, 4,
+    TCG_OPF_CALL_CLOBBER | IMPL(TCG_TARGET_HAS_qemu_page))
+DEF(qemu_ld_page_i32, 1, TLADDR_ARGS + 1, 2,
+    TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS
+    | IMPL(TCG_TARGET_HAS_qemu_page))
+DEF(qemu_st_page_i32, 0, TLADDR_ARGS + 2, 2,
+    TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS
+    | IMPL(TCG_TARGET_HAS_qemu_page))
+DEF(qemu_ld_page_i64, DATA64_ARGS, TLADDR_ARGS + 1, 2,
+    TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS | TCG_OPF_64BIT
+    | IMPL(TCG_TARGET_HAS_qemu_page))
+DEF(qemu_st_page_i64, 0, TLADDR_ARGS + DATA64_ARGS + 1, 2,
+    TCG_OPF_CALL_CLOBBER | TCG_OPF_SIDE_EFFECTS | TCG_OPF_64BIT
+    | IMPL(TCG_TARGET_HAS_qemu_page))
+
 /* Host vector support.  */
 
 #define IMPLVEC  TCG_OPF_VECTOR | IMPL(TCG_TARGET_MAYBE_vec)
@@ -60,6 +60,9 @@
 #include "elf.h"
 #include "exec/log.h"
 #include "sysemu/sysemu.h"
+#ifdef CONFIG_LINUX
+#include "accel/tcg/perf.h"
+#endif
 
 /* Forward declarations for functions declared in tcg-target.inc.c and
    used here. */
@@ -132,6 +135,25 @@ static bool tcg_out_ldst_finalize(TCGContext *s);
 
 #define TCG_HIGHWATER 1024
 
+/* When the buffer is full, evict this fraction of the regions at a time */
+#define TCG_REGION_EVICT_DIV 8
+
+/*
+ * Put the slow paths and constant pools of the TBs in the last fraction of
+ * each region, so that the hot code is denser in the host iTLB and icache.
+ * This is only done in system mode, which is where the slow paths are; the
+ * persistent TB cache of user mode also expects TBs to be contiguous.
+ */
+#if TCG_TARGET_HAS_COLD_CODE && defined(CONFIG_SOFTMMU)
+#define TCG_COLD_CODE 1
+#else
+#define TCG_COLD_CODE 0
+#endif
+#define TCG_COLD_CODE_DIV 4
+
+/* The space at the end of a region, or of each of its parts, left unused */
+#define TCG_REGION_HIGHWATER (TCG_HIGHWATER * (TCG_COLD_CODE ? 2 : 1))
+
 static TCGContext **tcg_ctxs;
 static unsigned int n_tcg_ctxs;
 TCGv_env cpu_env = 0;
@@ -147,6 +169,10 @@ struct tcg_region_tree {
  * dynamically allocate from as demand dictates. Given appropriate region
  * sizing, this minimizes flushes even when some TCG threads generate a lot
  * more code than others.
+ *
+ * Once all regions have been handed out, the ones that were filled up
+ * first are evicted and recycled (see tcg_region_evict), so that most of
+ * the translated code survives when the buffer runs out of space.
  */
 struct tcg_region_state {
     QemuMutex lock;
@@ -162,6 +188,12 @@ struct tcg_region_state {
     /* fields protected by the lock */
     size_t current; /* current region index */
     size_t agg_size_full; /* aggregate size of full regions */
+    size_t *full_size; /* contribution of each region to agg_size_full */
+    size_t *full; /* ring of full regions, in the order they filled up */
+    size_t full_head;
+    size_t n_full;
+    size_t *free; /* stack of evicted regions, ready to be reused */
+    size_t n_free;
 };
 
 static struct tcg_region_state region;
@@ -315,6 +347,47 @@ static void set_jmp_reset_offset(TCGContext *s, int which)
     assert(s->tb_jmp_reset_offset[which] == off);
 }
 
+/*
+ * Note a reference from the code of the TB being generated to @target,
+ * for use by the persistent TB cache.  References to the prologue and to
+ * the TB itself are recorded relative to those; anything else must be a
+ * function in the QEMU executable, which is relocated as a whole, so we
+ * record it relative to the address of this function.
+ */
+void tcg_tbc_reloc(TCGContext *s, tcg_insn_unit *where,
+                   TCGTBCRelocType type, const void *target)
+{
+    TCGTBCReloc *r;
+    TCGTBCBase base;
+    intptr_t addend;
+
+    if (target >= s->code_gen_prologue && target < s->code_gen_buffer) {
+        base = TCG_TBC_BASE_PROLOGUE;
+        addend = target - s->code_gen_prologue;
+    } else if (target >= s->code_gen_buffer &&
+               target < s->code_gen_buffer + s->code_gen_buffer_size) {
+        /* pc-relative references within the TB move along with it */
+        if (type == TCG_TBC_RELOC_PC32) {
+            return;
+        }
+        base = TCG_TBC_BASE_SELF;
+        addend = target - (void *)s->code_buf;
+    } else {
+        base = TCG_TBC_BASE_BINARY;
+        addend = (uintptr_t)target - (uintptr_t)tcg_tbc_reloc;
+    }
+
+    if (unlikely(s->tbc_nb_relocs == TCG_MAX_TBC_RELOCS)) {
+        s->tbc_unsafe = true;
+        return;
+    }
+    r = &s->tbc_relocs[s->tbc_nb_relocs++];
+    r->offset = tcg_ptr_byte_diff(where, s->code_buf);
+    r->type = type;
+    r->base = base;
+    r->addend = addend;
+}
+
 #include "tcg-target.inc.c"
 
 /* compare a pointer @ptr and a tb_tc @s */
@@ -373,22 +446,23 @@ static void tcg_region_trees_init(void)
     }
 }
 
-static struct tcg_region_tree *tc_ptr_to_region_tree(void *p)
+static size_t tc_ptr_to_region_idx(void *p)
 {
-    size_t region_idx;
+    ptrdiff_t offset;
 
     if (p < region.start_aligned) {
-        region_idx = 0;
-    } else {
-        ptrdiff_t offset = p - region.start_aligned;
-
-        if (offset > region.stride * (region.n - 1)) {
-            region_idx = region.n - 1;
-        } else {
-            region_idx = offset / region.stride;
-        }
+        return 0;
+    }
+    offset = p - region.start_aligned;
+    if (offset > region.stride * (region.n - 1)) {
+        return region.n - 1;
     }
-    return region_trees + region_idx * tree_size;
+    return offset / region.stride;
+}
+
+static struct tcg_region_tree *tc_ptr_to_region_tree(void *p)
+{
+    return region_trees + tc_ptr_to_region_idx(p) * tree_size;
 }
 
 void tcg_tb_insert(TranslationBlock *tb)
@@ -518,11 +592,27 @@ static void tcg_region_assign(TCGContext *s, size_t curr_region)
     s->code_gen_buffer = start;
     s->code_gen_ptr = start;
     s->code_gen_buffer_size = end - start;
+#if TCG_COLD_CODE
+    {
+        void *cold = QEMU_ALIGN_PTR_DOWN(end - (end - start) / TCG_COLD_CODE_DIV,
+                                         qemu_real_host_page_size);
+
+        s->code_gen_highwater = cold - TCG_HIGHWATER;
+        s->code_gen_cold_buffer = cold;
+        s->code_gen_cold_ptr = cold;
+        s->code_gen_cold_highwater = end - TCG_HIGHWATER;
+    }
+#else
     s->code_gen_highwater = end - TCG_HIGHWATER;
+#endif
 }
 
 static bool tcg_region_alloc__locked(TCGContext *s)
 {
+    if (region.n_free) {
+        tcg_region_assign(s, region.free[--region.n_free]);
+        return false;
+    }
     if (region.current == region.n) {
         return true;
     }
@@ -538,13 +628,17 @@ static bool tcg_region_alloc__locked(TCGContext *s)
 static bool tcg_region_alloc(TCGContext *s)
 {
     bool err;
-    /* read the region size now; alloc__locked will overwrite it on success */
-    size_t size_full = s->code_gen_buffer_size;
+    /* read the region now; alloc__locked will overwrite it on success */
+    size_t size_full = s->code_gen_buffer_size - TCG_REGION_HIGHWATER;
+    size_t idx_full = tc_ptr_to_region_idx(s->code_gen_buffer);
 
     qemu_mutex_lock(&region.lock);
     err = tcg_region_alloc__locked(s);
     if (!err) {
-        region.agg_size_full += size_full - TCG_HIGHWATER;
+        region.agg_size_full += size_full;
+        region.full_size[idx_full] = size_full;
+        region.full[(region.full_head + region.n_full) % region.n] = idx_full;
+        region.n_full++;
     }
     qemu_mutex_unlock(&region.lock);
     return err;
@@ -568,6 +662,9 @@ void tcg_region_reset_all(void)
     qemu_mutex_lock(&region.lock);
     region.current = 0;
     region.agg_size_full = 0;
+    region.full_head = 0;
+    region.n_full = 0;
+    region.n_free = 0;
 
     for (i = 0; i < n_ctxs; i++) {
         TCGContext *s = atomic_read(&tcg_ctxs[i]);
@@ -580,6 +677,57 @@ void tcg_region_reset_all(void)
     tcg_region_tree_reset_all();
 }
 
+/*
+ * Evict the regions that filled up first, so that their memory can be
+ * reused without throwing away the rest of the translated code.  @func
+ * is called on every TB of the evicted regions, with the region tree
+ * lock held, so that the caller can unlink them; @func must return false.
+ * Regions currently assigned to a TCG context are never evicted.
+ *
+ * Returns the number of regions that were evicted, which is zero if
+ * another thread already made room in the meantime, or -1 if there is
+ * nothing to evict and the caller must resort to tcg_region_reset_all.
+ *
+ * Call from a safe-work context.
+ */
+int tcg_region_evict(GTraverseFunc func, gpointer user_data)
+{
+    size_t n_evict;
+    size_t i;
+
+    qemu_mutex_lock(&region.lock);
+    if (region.n_free || region.current < region.n) {
+        qemu_mutex_unlock(&region.lock);
+        return 0;
+    }
+    if (region.n_full == 0) {
+        qemu_mutex_unlock(&region.lock);
+        return -1;
+    }
+
+    n_evict = MIN(MAX(region.n / TCG_REGION_EVICT_DIV, 1), region.n_full);
+    for (i = 0; i < n_evict; i++) {
+        size_t idx = region.full[region.full_head];
+        struct tcg_region_tree *rt = region_trees + idx * tree_size;
+
+        region.full_head = (region.full_head + 1) % region.n;
+        region.n_full--;
+
+        qemu_mutex_lock(&rt->lock);
+        g_tree_foreach(rt->tree, func, user_data);
+        /* Increment the refcount first so that destroy acts as a reset */
+        g_tree_ref(rt->tree);
+        g_tree_destroy(rt->tree);
+        qemu_mutex_unlock(&rt->lock);
+
+        region.agg_size_full -= region.full_size[idx];
+        region.full_size[idx] = 0;
+        region.free[region.n_free++] = idx;
+    }
+    qemu_mutex_unlock(&region.lock);
+    return n_evict;
+}
+
 #ifdef CONFIG_USER_ONLY
 static size_t tcg_n_regions(void)
 {
@@ -594,27 +742,29 @@ static size_t tcg_n_regions(void)
  */
 static size_t tcg_n_regions(void)
 {
+    size_t n_threads = qemu_tcg_mttcg_enabled() ? max_cpus : 1;
+    size_t min_size = MAX(2 * 1024u * 1024,
+                          2 * tcg_init_ctx.code_gen_buffer_page_size);
     size_t i;
 
-    /* Use a single region if all we have is one vCPU thread */
-    if (max_cpus == 1 || !qemu_tcg_mttcg_enabled()) {
-        return 1;
-    }
-
-    /* Try to have more regions than max_cpus, with each region being >= 2 MB */
+    /*
+     * Try to have more regions than threads, with each region being >= 2 MB.
+     * This is worthwhile even with a single thread, since it is what
+     * allows evicting part of the code instead of flushing all of it.
+     */
     for (i = 8; i > 0; i--) {
         size_t regions_per_thread = i;
         size_t region_size;
 
         region_size = tcg_init_ctx.code_gen_buffer_size;
-        region_size /= max_cpus * regions_per_thread;
+        region_size /= n_threads * regions_per_thread;
 
-        if (region_size >= 2 * 1024u * 1024) {
-            return max_cpus * regions_per_thread;
+        if (region_size >= min_size) {
+            return n_threads * regions_per_thread;
         }
     }
     /* If we can't, then just allocate one region per vCPU thread */
-    return max_cpus;
+    return n_threads;
 }
 #endif
 
@@ -629,7 +779,10 @@ static size_t tcg_n_regions(void)
  * code in parallel without synchronization.
  *
  * In softmmu the number of TCG threads is bounded by max_cpus, so we use at
- * least max_cpus regions in MTTCG. In !MTTCG we use a single region.
+ * least max_cpus regions in MTTCG. In !MTTCG we use at least one region.
+ * When there are more regions than threads, running out of space in
+ * code_gen_buffer only evicts the oldest regions instead of flushing
+ * everything.
  * Note that the TCG options from the command-line (i.e. -accel accel=tcg,[...])
  * must have been parsed before calling this function, since it calls
  * qemu_tcg_mttcg_enabled().
@@ -651,23 +804,38 @@ void tcg_region_init(void)
     void *buf = tcg_init_ctx.code_gen_buffer;
     void *aligned;
     size_t size = tcg_init_ctx.code_gen_buffer_size;
+    size_t huge_size = tcg_init_ctx.code_gen_buffer_huge_size;
     size_t page_size = qemu_real_host_page_size;
+    size_t align;
     size_t region_size;
     size_t n_regions;
     size_t i;
 
+    /* With explicit huge pages, the guard pages must be huge pages too */
+    if (tcg_init_ctx.code_gen_buffer_page_size) {
+        page_size = tcg_init_ctx.code_gen_buffer_page_size;
+    }
     n_regions = tcg_n_regions();
 
+    /*
+     * Start the regions on a huge page boundary if they span a few of them,
+     * so that the guard page of a region only splits its last huge page.
+     */
+    align = page_size;
+    if (huge_size > page_size && size / n_regions >= 4 * huge_size) {
+        align = huge_size;
+    }
+
     /* The first region will be 'aligned - buf' bytes larger than the others */
-    aligned = QEMU_ALIGN_PTR_UP(buf, page_size);
+    aligned = QEMU_ALIGN_PTR_UP(buf, align);
     g_assert(aligned < tcg_init_ctx.code_gen_buffer + size);
     /*
-     * Make region_size a multiple of page_size, using aligned as the start.
+     * Make region_size a multiple of align, using aligned as the start.
      * As a result of this we might end up with a few extra pages at the end of
      * the buffer; we will assign those to the last region.
      */
     region_size = (size - (aligned - buf)) / n_regions;
-    region_size = QEMU_ALIGN_DOWN(region_size, page_size);
+    region_size = QEMU_ALIGN_DOWN(region_size, align);
 
     /* A region must have at least 2 pages; one code, one guard */
     g_assert(region_size >= 2 * page_size);
@@ -683,6 +851,9 @@ void tcg_region_init(void)
     region.end = QEMU_ALIGN_PTR_DOWN(buf + size, page_size);
     /* account for that last guard page */
     region.end -= page_size;
+    region.full_size = g_new0(size_t, region.n);
+    region.full = g_new(size_t, region.n);
+    region.free = g_new(size_t, region.n);
 
     /* set guard pages */
     for (i = 0; i < region.n; i++) {
@@ -779,6 +950,9 @@ size_t tcg_code_size(void)
         size = atomic_read(&s->code_gen_ptr) - s->code_gen_buffer;
         g_assert(size <= s->code_gen_buffer_size);
         total += size;
+#if TCG_COLD_CODE
+        total += atomic_read(&s->code_gen_cold_ptr) - s->code_gen_cold_buffer;
+#endif
     }
     qemu_mutex_unlock(&region.lock);
     return total;
@@ -796,7 +970,7 @@ size_t tcg_code_capacity(void)
     /* no need for synchronization; these variables are set at init time */
     guard_size = region.stride - region.size;
     capacity = region.end + guard_size - region.start;
-    capacity -= region.n * (guard_size + TCG_HIGHWATER);
+    capacity -= region.n * (guard_size + TCG_REGION_HIGHWATER);
     return capacity;
 }
 
@@ -1033,6 +1207,10 @@ void tcg_prologue_init(TCGContext *s)
     total_size -= prologue_size;
     s->code_gen_buffer_size = total_size;
 
+#ifdef CONFIG_LINUX
+    perf_report_prologue(s->code_gen_prologue, prologue_size);
+#endif
+
     tcg_register_jit(s->code_gen_buffer, total_size);
 
 #ifdef DEBUG_DISAS
@@ -1088,6 +1266,9 @@ void tcg_func_start(TCGContext *s)
     s->goto_tb_issue_mask = 0;
 #endif
 
+    s->tbc_unsafe = false;
+    s->tbc_nb_relocs = 0;
+
     QTAILQ_INIT(&s->ops);
     QTAILQ_INIT(&s->free_ops);
 }
@@ -1374,6 +1555,13 @@ bool tcg_op_supported(TCGOpcode op)
     case INDEX_op_goto_ptr:
         return TCG_TARGET_HAS_goto_ptr;
 
+    case INDEX_op_qemu_page_check:
+    case INDEX_op_qemu_ld_page_i32:
+    case INDEX_op_qemu_st_page_i32:
+    case INDEX_op_qemu_ld_page_i64:
+    case INDEX_op_qemu_st_page_i64:
+        return TCG_TARGET_HAS_qemu_page;
+
     case INDEX_op_mov_i32:
     case INDEX_op_movi_i32:
     case INDEX_op_setcond_i32:
@@ -1982,6 +2170,10 @@ void tcg_dump_ops(TCGContext *s)
             case INDEX_op_qemu_st_i32:
             case INDEX_op_qemu_ld_i64:
             case INDEX_op_qemu_st_i64:
+            case INDEX_op_qemu_ld_page_i32:
+            case INDEX_op_qemu_st_page_i32:
+            case INDEX_op_qemu_ld_page_i64:
+            case INDEX_op_qemu_st_page_i64:
                 {
                     TCGMemOpIdx oi = op->args[k++];
                     TCGMemOp op = get_memop(oi);
@@ -2219,6 +2411,274 @@ TCGOp *tcg_op_insert_after(TCGContext *s, TCGOp *old_op,
     return new_op;
 }
 
+#if TCG_TARGET_HAS_qemu_page
+/* Same-page access groups.  The TLB is checked once for all accesses of
+   a group, which then use the resulting host address directly.
+
+   The guest address of an access is tracked as a constant offset from the
+   value that some temp had at a given point, identified by a generation
+   number that is incremented whenever the temp is written.  Accesses with
+   the same base value and close offsets, such as those to a stack frame
+   or to the fields of a structure, most likely hit the same page.
+
+   A group ends at any other guest access, call or basic block boundary,
+   because these could modify the TLB behind the back of the group.  Only
+   implemented by 64-bit hosts, so that all addresses and data are held in
+   a single argument.  */
+
+/* Maximum number of accesses, and of bytes spanned, by a group.  */
+#define PAGE_GROUP_MAX   16
+#define PAGE_GROUP_SPAN  256
+
+typedef struct PageGroupTemp {
+    unsigned epoch;
+    unsigned gen;
+    bool is_const;
+    int64_t val;
+    /* If base is not NULL, the temp holds base + ofs, with base_gen
+       being the generation of base at the time.  */
+    TCGTemp *base;
+    unsigned base_gen;
+    int64_t ofs;
+} PageGroupTemp;
+
+typedef struct PageGroupState {
+    /* Incremented at each basic block, to lazily reset temps[].  */
+    unsigned epoch;
+    PageGroupTemp *temps;
+
+    /* The current group, whose accesses span [lo, hi) from base.  */
+    int n;
+    TCGOp *ops[PAGE_GROUP_MAX];
+    int64_t ofs[PAGE_GROUP_MAX];
+    TCGTemp *base;
+    unsigned base_gen;
+    int64_t lo, hi;
+    unsigned mmu_idx;
+    int which;
+} PageGroupState;
+
+static PageGroupTemp *page_group_temp(PageGroupState *st, TCGTemp *ts)
+{
+    PageGroupTemp *t = &st->temps[temp_idx(ts)];
+
+    if (t->epoch != st->epoch) {
+        memset(t, 0, sizeof(*t));
+        t->epoch = st->epoch;
+    }
+    return t;
+}
+
+/* Describe in N the value of TS plus OFS.  */
+static void page_group_derive(PageGroupState *st, PageGroupTemp *n,
+                              TCGTemp *ts, int64_t ofs)
+{
+    PageGroupTemp *t = page_group_temp(st, ts);
+
+    if (t->is_const) {
+        n->is_const = true;
+        n->val = t->val + ofs;
+    } else if (t->base) {
+        n->base = t->base;
+        n->base_gen = t->base_gen;
+        n->ofs = t->ofs + ofs;
+    } else {
+        n->base = ts;
+        n->base_gen = t->gen;
+        n->ofs = ofs;
+    }
+}
+
+/* Record the value written by OP to its output argument I.  */
+static void page_group_def(PageGroupState *st, TCGOp *op, int i)
+{
+    TCGTemp *out = arg_temp(op->args[i]);
+    PageGroupTemp *a, *b, n = { 0 };
+    bool is32 = false;
+
+    switch (op->opc) {
+    case INDEX_op_movi_i32:
+        is32 = true;
+        /* fall through */
+    case INDEX_op_movi_i64:
+        n.is_const = true;
+        n.val = op->args[1];
+        break;
+    case INDEX_op_mov_i32:
+        is32 = true;
+        /* fall through */
+    case INDEX_op_mov_i64:
+        page_group_derive(st, &n, arg_temp(op->args[1]), 0);
+        break;
+    case INDEX_op_add_i32:
+        is32 = true;
+        /* fall through */
+    case INDEX_op_add_i64:
+        a = page_group_temp(st, arg_temp(op->args[1]));
+        b = page_group_temp(st, arg_temp(op->args[2]));
+        if (b->is_const) {
+            page_group_derive(st, &n, arg_temp(op->args[1]), b->val);
+        } else if (a->is_const) {
+            page_group_derive(st, &n, arg_temp(op->args[2]), a->val);
+        }
+        break;
+    case INDEX_op_sub_i32:
+        is32 = true;
+        /* fall through */
+    case INDEX_op_sub_i64:
+        b = page_group_temp(st, arg_temp(op->args[2]));
+        if (b->is_const) {
+            page_group_derive(st, &n, arg_temp(op->args[1]), -b->val);
+        }
+        break;
+    default:
+        break;
+    }
+    if (is32) {
+        n.val = (int32_t)n.val;
+        n.ofs = (int32_t)n.ofs;
+    }
+
+    /* The inputs have been read; only now can OUT change generation.  */
+    n.epoch = st->epoch;
+    n.gen = page_group_temp(st, out)->gen + 1;
+    st->temps[temp_idx(out)] = n;
+}
+
+/* Rewrite the current group, if it is worth it, and start a new one.  */
+static void page_group_finish(TCGContext *s, PageGroupState *st)
+{
+    TCGTemp *host;
+    TCGOp *op;
+    int i;
+
+    if (st->n < 2 || s->nb_temps >= TCG_MAX_TEMPS) {
+        st->n = 0;
+        return;
+    }
+
+    host = tcg_temp_alloc(s);
+    host->base_type = TCG_TYPE_PTR;
+    host->type = TCG_TYPE_PTR;
+    host->temp_allocated = 1;
+
+    op = tcg_op_insert_before(s, st->ops[0], INDEX_op_qemu_page_check, 6);
+    op->args[0] = temp_arg(host);
+    op->args[1] = st->ops[0]->args[1];
+    op->args[2] = st->lo - st->ofs[0];
+    op->args[3] = st->hi - st->lo;
+    op->args[4] = st->mmu_idx;
+    op->args[5] = st->which;
+
+    for (i = 0; i < st->n; i++) {
+        op = st->ops[i];
+        switch (op->opc) {
+        case INDEX_op_qemu_ld_i32:
+            op->opc = INDEX_op_qemu_ld_page_i32;
+            break;
+        case INDEX_op_qemu_st_i32:
+            op->opc = INDEX_op_qemu_st_page_i32;
+            break;
+        case INDEX_op_qemu_ld_i64:
+            op->opc = INDEX_op_qemu_ld_page_i64;
+            break;
+        case INDEX_op_qemu_st_i64:
+            op->opc = INDEX_op_qemu_st_page_i64;
+            break;
+        default:
+            g_assert_not_reached();
+        }
+        op->args[3] = op->args[2];
+        op->args[2] = temp_arg(host);
+        op->args[4] = st->ofs[i] - st->lo;
+    }
+    st->n = 0;
+}
+
+/* Add the guest access OP to the current group, or start a new one.  */
+static void page_group_access(TCGContext *s, PageGroupState *st, TCGOp *op)
+{
+    TCGMemOpIdx oi = op->args[2];
+    TCGMemOp memop = get_memop(oi);
+    unsigned mmu_idx = get_mmuidx(oi);
+    PageGroupTemp addr = { 0 };
+    int64_t lo, hi;
+
+    page_group_derive(st, &addr, arg_temp(op->args[1]), 0);
+    if (!addr.base || get_alignment_bits(memop) != 0) {
+        page_group_finish(s, st);
+        return;
+    }
+
+    lo = addr.ofs;
+    hi = addr.ofs + (1 << (memop & MO_SIZE));
+    if (st->n > 0) {
+        if (addr.base == st->base && addr.base_gen == st->base_gen
+            && mmu_idx == st->mmu_idx && st->n < PAGE_GROUP_MAX
+            && MAX(hi, st->hi) - MIN(lo, st->lo) <= PAGE_GROUP_SPAN) {
+            lo = MIN(lo, st->lo);
+            hi = MAX(hi, st->hi);
+        } else {
+            page_group_finish(s, st);
+        }
+    }
+    if (st->n == 0) {
+        st->base = addr.base;
+        st->base_gen = addr.base_gen;
+        st->mmu_idx = mmu_idx;
+        st->which = 0;
+    }
+
+    st->ops[st->n] = op;
+    st->ofs[st->n] = addr.ofs;
+    st->n++;
+    st->lo = lo;
+    st->hi = hi;
+    if (op->opc == INDEX_op_qemu_ld_i32 || op->opc == INDEX_op_qemu_ld_i64) {
+        st->which |= TCG_PAGE_CHECK_LD;
+    } else {
+        st->which |= TCG_PAGE_CHECK_ST;
+    }
+}
+
+static void page_group_pass(TCGContext *s)
+{
+    PageGroupState st = { .epoch = 1 };
+    TCGOp *op;
+
+    st.temps = tcg_malloc(sizeof(PageGroupTemp) * s->nb_temps);
+    memset(st.temps, 0, sizeof(PageGroupTemp) * s->nb_temps);
+
+    QTAILQ_FOREACH(op, &s->ops, link) {
+        TCGOpcode opc = op->opc;
+        const TCGOpDef *def = &tcg_op_defs[opc];
+        int i;
+
+        switch (opc) {
+        case INDEX_op_qemu_ld_i32:
+        case INDEX_op_qemu_st_i32:
+        case INDEX_op_qemu_ld_i64:
+        case INDEX_op_qemu_st_i64:
+            page_group_access(s, &st, op);
+            break;
+        default:
+            if (def->flags & (TCG_OPF_BB_END | TCG_OPF_CALL_CLOBBER)) {
+                /* Calls can also write any global.  */
+                page_group_finish(s, &st);
+                st.epoch++;
+                continue;
+            }
+            break;
+        }
+
+        for (i = 0; i < def->nb_oargs; i++) {
+            page_group_def(&st, op, i);
+        }
+    }
+    page_group_finish(s, &st);
+}
+#endif
+
 #define TS_DEAD  1
 #define TS_MEM   2
 
@@ -2838,6 +3298,24 @@ static TCGReg tcg_reg_alloc(TCGContext *s, TCGRegSet desired_regs,
     tcg_abort();
 }
 
+/*
+ * Load a constant into @reg.  While recording for the TB cache, the
+ * address of the TB itself (see tcg_const_tb_ptr) is loaded with a
+ * relocation, so that the TB can still be cached.
+ */
+static void tcg_out_movi_const(TCGContext *s, TCGType type, TCGReg reg,
+                               tcg_target_ulong val)
+{
+#if TCG_TARGET_HAS_TB_CACHE
+    if (unlikely(s->tbc_recording) && type == TCG_TYPE_PTR &&
+        val == (uintptr_t)s->tbc_tb) {
+        tcg_out_movi_ptr(s, reg, s->tbc_tb);
+        return;
+    }
+#endif
+    tcg_out_movi(s, type, reg, val);
+}
+
 /* Make sure the temporary is in a register.  If needed, allocate the register
    from DESIRED while avoiding ALLOCATED.  */
 static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
@@ -2850,7 +3328,7 @@ static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
         return;
     case TEMP_VAL_CONST:
         reg = tcg_reg_alloc(s, desired_regs, allocated_regs, ts->indirect_base);
-        tcg_out_movi(s, ts->type, reg, ts->val);
+        tcg_out_movi_const(s, ts->type, reg, ts->val);
         ts->mem_coherent = 0;
         break;
     case TEMP_VAL_MEM:
@@ -2928,7 +3406,7 @@ static void tcg_reg_alloc_do_movi(TCGContext *s, TCGTemp *ots,
 {
     if (ots->fixed_reg) {
         /* For fixed registers, we do not do any constant propagation.  */
-        tcg_out_movi(s, ots->type, ots->reg, val);
+        tcg_out_movi_const(s, ots->type, ots->reg, val);
         return;
     }
 
@@ -3377,8 +3855,6 @@ void tcg_profile_snapshot(TCGProfile *prof, bool counters, bool table)
             PROF_ADD(prof, orig, code_time);
             PROF_ADD(prof, orig, la_time);
             PROF_ADD(prof, orig, opt_time);
-            PROF_ADD(prof, orig, restore_count);
-            PROF_ADD(prof, orig, restore_time);
         }
         if (table) {
             int i;
@@ -3442,6 +3918,34 @@ int64_t tcg_cpu_exec_time(void)
 }
 #endif
 
+#if TCG_COLD_CODE
+/* Emit the out-of-line code and data of the TB into the cold area.  */
+static tcg_insn_unit *tcg_out_cold_begin(TCGContext *s)
+{
+    tcg_insn_unit *hot_end = s->code_ptr;
+
+    s->code_ptr = s->code_gen_cold_ptr;
+    s->cold_gen_ptr = s->code_ptr;
+    s->code_gen_highwater = s->code_gen_cold_highwater;
+    return hot_end;
+}
+
+static void tcg_out_cold_end(TCGContext *s, tcg_insn_unit *hot_end, bool ok)
+{
+    s->code_gen_highwater = s->code_gen_cold_buffer - TCG_HIGHWATER;
+    if (likely(ok)) {
+        s->cold_gen_size = tcg_ptr_byte_diff(s->code_ptr, s->cold_gen_ptr);
+        flush_icache_range((uintptr_t)s->cold_gen_ptr,
+                           (uintptr_t)s->code_ptr);
+        atomic_set(&s->code_gen_cold_ptr,
+                   (void *)ROUND_UP((uintptr_t)s->code_ptr, CODE_GEN_ALIGN));
+    } else {
+        /* The cold area is full: make tcg_tb_alloc move to a new region */
+        s->code_gen_highwater = s->code_gen_ptr;
+    }
+    s->code_ptr = hot_end;
+}
+#endif
 
 int tcg_gen_code(TCGContext *s, TranslationBlock *tb)
 {
@@ -3450,6 +3954,10 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb)
 #endif
     int i, num_insns;
     TCGOp *op;
+    bool ok = true;
+#if TCG_COLD_CODE
+    tcg_insn_unit *hot_end;
+#endif
 
 #ifdef CONFIG_PROFILER
     {
@@ -3488,6 +3996,15 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb)
 
 #ifdef USE_TCG_OPTIMIZATIONS
     tcg_optimize(s);
+#if TCG_TARGET_HAS_qemu_page
+    /*
+     * Fastmem accesses do not look up the TLB at all; grouping them would
+     * send them back through it.
+     */
+    if (!TCG_FASTMEM || !tcg_fastmem || (s->tb_cflags & CF_NOFASTMEM)) {
+        page_group_pass(s);
+    }
+#endif
 #endif
 
 #ifdef CONFIG_PROFILER
@@ -3534,6 +4051,7 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb)
 
     s->code_buf = tb->tc.ptr;
     s->code_ptr = tb->tc.ptr;
+    s->tbc_tb = tb;
 
 #ifdef TCG_TARGET_NEED_LDST_LABELS
     QSIMPLEQ_INIT(&s->ldst_labels);
@@ -3613,16 +4131,21 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb)
     s->gen_insn_end_off[num_insns] = tcg_current_code_size(s);
 
     /* Generate TB finalization at the end of block */
+#if TCG_COLD_CODE
+    hot_end = tcg_out_cold_begin(s);
+#endif
 #ifdef TCG_TARGET_NEED_LDST_LABELS
-    if (!tcg_out_ldst_finalize(s)) {
-        return -1;
-    }
+    ok = tcg_out_ldst_finalize(s);
 #endif
 #ifdef TCG_TARGET_NEED_POOL_LABELS
-    if (!tcg_out_pool_finalize(s)) {
+    ok = ok && tcg_out_pool_finalize(s);
+#endif
+#if TCG_COLD_CODE
+    tcg_out_cold_end(s, hot_end, ok);
+#endif
+    if (!ok) {
         return -1;
     }
-#endif
 
     /* flush instruction cache */
     flush_icache_range((uintptr_t)s->code_buf, (uintptr_t)s->code_ptr);
@@ -3682,10 +4205,6 @@ void tcg_dump_info(FILE *f, fprintf_function cpu_fprintf)
                 * 100.0);
     cpu_fprintf(f, "liveness/code time  %0.1f%%\n", 
                 (double)s->la_time / (s->code_time ? s->code_time : 1) * 100.0);
-    cpu_fprintf(f, "cpu_restore count   %" PRId64 "\n",
-                s->restore_count);
-    cpu_fprintf(f, "  avg cycles        %0.1f\n",
-                s->restore_count ? (double)s->restore_time / s->restore_count : 0);
 }
 #else
 void tcg_dump_info(FILE *f, fprintf_function cpu_fprintf)
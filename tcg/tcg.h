@@ -87,6 +87,18 @@ typedef uint64_t tcg_target_ulong;
 #define TCG_OVERSIZED_GUEST 0
 #endif
 
+/*
+ * Fastmem accesses guest RAM through per-vCPU host mappings of the whole
+ * guest virtual address space, so it needs a guest address space that is
+ * small enough to be mirrored.
+ */
+#if defined(CONFIG_SOFTMMU) && defined(CONFIG_LINUX) && \
+    TCG_TARGET_HAS_fastmem && TARGET_LONG_BITS == 32
+#define TCG_FASTMEM 1
+#else
+#define TCG_FASTMEM 0
+#endif
+
 #if TCG_TARGET_NB_REGS <= 32
 typedef uint32_t TCGRegSet;
 #elif TCG_TARGET_NB_REGS <= 64
@@ -196,6 +208,13 @@ typedef uint64_t TCGRegSet;
 #define TCG_TARGET_HAS_v256             0
 #endif
 
+#ifndef TCG_TARGET_HAS_TB_CACHE
+#define TCG_TARGET_HAS_TB_CACHE         0
+#endif
+#ifndef TCG_TARGET_HAS_COLD_CODE
+#define TCG_TARGET_HAS_COLD_CODE        0
+#endif
+
 #ifndef TARGET_INSN_START_EXTRA_WORDS
 # define TARGET_INSN_START_WORDS 1
 #else
@@ -416,6 +435,10 @@ static inline unsigned get_alignment_bits(TCGMemOp memop)
     return a;
 }
 
+/* Accesses that qemu_page_check must allow, for its 'which' argument.  */
+#define TCG_PAGE_CHECK_LD  1
+#define TCG_PAGE_CHECK_ST  2
+
 typedef tcg_target_ulong TCGArg;
 
 /* Define type and accessor macros for TCG variables.
@@ -629,6 +652,31 @@ typedef struct TCGOp {
 /* Make sure operands fit in the bitfields above.  */
 QEMU_BUILD_BUG_ON(NB_OPS > (1 << 8));
 
+/*
+ * Relocations of host code that is saved to the persistent TB cache.
+ * Each one records where a reference to something outside of the TB
+ * lives, so that the code can be fixed up when it is loaded again.
+ */
+typedef enum TCGTBCRelocType {
+    TCG_TBC_RELOC_PC32,     /* 32-bit displacement from the end of the field */
+    TCG_TBC_RELOC_ABS64,    /* 64-bit absolute address */
+} TCGTBCRelocType;
+
+typedef enum TCGTBCBase {
+    TCG_TBC_BASE_SELF,      /* start of the TB's host code */
+    TCG_TBC_BASE_PROLOGUE,  /* tcg_ctx->code_gen_prologue */
+    TCG_TBC_BASE_BINARY,    /* the QEMU executable, see tcg_tbc_reloc() */
+} TCGTBCBase;
+
+typedef struct TCGTBCReloc {
+    uint32_t offset;
+    uint8_t type;
+    uint8_t base;
+    int64_t addend;
+} TCGTBCReloc;
+
+#define TCG_MAX_TBC_RELOCS 256
+
 typedef struct TCGProfile {
     int64_t cpu_exec_time;
     int64_t tb_count1;
@@ -645,8 +693,6 @@ typedef struct TCGProfile {
     int64_t code_time;
     int64_t la_time;
     int64_t opt_time;
-    int64_t restore_count;
-    int64_t restore_time;
     int64_t table_op_count[NB_OPS];
 } TCGProfile;
 
@@ -691,12 +737,26 @@ struct TCGContext {
     void *code_gen_epilogue;
     void *code_gen_buffer;
     size_t code_gen_buffer_size;
+    /* Page size of the mapping if not the host one, and the huge page
+       size to align regions to; 0 when not backed by huge pages.  */
+    size_t code_gen_buffer_page_size;
+    size_t code_gen_buffer_huge_size;
     void *code_gen_ptr;
     void *data_gen_ptr;
 
     /* Threshold to flush the translated code buffer.  */
     void *code_gen_highwater;
 
+    /* Out-of-line code and data of the TBs, kept at the end of the region
+       so that it does not dilute the hot code; see tcg_region_assign.
+       NULL if they follow each TB.  */
+    void *code_gen_cold_buffer;
+    void *code_gen_cold_ptr;
+    void *code_gen_cold_highwater;
+    /* The cold part of the last TB generated.  */
+    void *cold_gen_ptr;
+    size_t cold_gen_size;
+
     size_t tb_phys_invalidate_count;
 
     /* Track which vCPU triggers events */
@@ -712,6 +772,15 @@ struct TCGContext {
 
     TCGLabel *exitreq_label;
 
+    /* Persistent TB cache.  While recording, the backend notes every
+       reference from the TB to code outside of it in tbc_relocs[].
+       TBs that cannot be relocated are marked as unsafe.  */
+    bool tbc_recording;
+    bool tbc_unsafe;
+    TranslationBlock *tbc_tb;
+    int tbc_nb_relocs;
+    TCGTBCReloc tbc_relocs[TCG_MAX_TBC_RELOCS];
+
     TCGTempSet free_temps[TCG_TYPE_COUNT * 2];
     TCGTemp temps[TCG_MAX_TEMPS]; /* globals first, temps after */
 
@@ -868,6 +937,7 @@ TranslationBlock *tcg_tb_alloc(TCGContext *s);
 
 void tcg_region_init(void);
 void tcg_region_reset_all(void);
+int tcg_region_evict(GTraverseFunc func, gpointer user_data);
 
 size_t tcg_code_size(void);
 size_t tcg_code_capacity(void);
@@ -904,6 +974,8 @@ void tcg_prologue_init(TCGContext *s);
 void tcg_func_start(TCGContext *s);
 
 int tcg_gen_code(TCGContext *s, TranslationBlock *tb);
+void tcg_tbc_reloc(TCGContext *s, tcg_insn_unit *where,
+                   TCGTBCRelocType type, const void *target);
 
 void tcg_set_frame(TCGContext *s, TCGReg reg, intptr_t start, intptr_t size);
 
@@ -1090,12 +1162,37 @@ TCGv_vec tcg_const_ones_vec(TCGType);
 TCGv_vec tcg_const_zeros_vec_matching(TCGv_vec);
 TCGv_vec tcg_const_ones_vec_matching(TCGv_vec);
 
+/*
+ * Host pointers embedded in the generated code cannot be relocated, so
+ * keep TBs that use them out of the persistent TB cache.
+ */
+static inline intptr_t tcg_host_ptr_const(intptr_t ptr)
+{
+    tcg_ctx->tbc_unsafe = true;
+    return ptr;
+}
+
+#if UINTPTR_MAX == UINT32_MAX
+# define tcg_const_ptr(x)        \
+    ((TCGv_ptr)tcg_const_i32(tcg_host_ptr_const((intptr_t)(x))))
+# define tcg_const_local_ptr(x)  \
+    ((TCGv_ptr)tcg_const_local_i32(tcg_host_ptr_const((intptr_t)(x))))
+#else
+# define tcg_const_ptr(x)        \
+    ((TCGv_ptr)tcg_const_i64(tcg_host_ptr_const((intptr_t)(x))))
+# define tcg_const_local_ptr(x)  \
+    ((TCGv_ptr)tcg_const_local_i64(tcg_host_ptr_const((intptr_t)(x))))
+#endif
+
+/*
+ * The TB being translated is the one host pointer that can be relocated:
+ * it lives right before its code, also when the code is restored from the
+ * TB cache.  The backend records a relocation when it loads this constant.
+ */
 #if UINTPTR_MAX == UINT32_MAX
-# define tcg_const_ptr(x)        ((TCGv_ptr)tcg_const_i32((intptr_t)(x)))
-# define tcg_const_local_ptr(x)  ((TCGv_ptr)tcg_const_local_i32((intptr_t)(x)))
+# define tcg_const_tb_ptr(tb)    ((TCGv_ptr)tcg_const_i32((intptr_t)(tb)))
 #else
-# define tcg_const_ptr(x)        ((TCGv_ptr)tcg_const_i64((intptr_t)(x)))
-# define tcg_const_local_ptr(x)  ((TCGv_ptr)tcg_const_local_i64((intptr_t)(x)))
+# define tcg_const_tb_ptr(tb)    ((TCGv_ptr)tcg_const_i64((intptr_t)(tb)))
 #endif
 
 TCGLabel *gen_new_label(void);
@@ -43,6 +43,7 @@
 #define TCG_TARGET_INTERPRETER 1
 #define TCG_TARGET_INSN_UNIT_SIZE 1
 #define TCG_TARGET_TLB_DISPLACEMENT_BITS 32
+#define TCG_TARGET_IMPLEMENTS_DYN_TLB 1
 
 #if UINTPTR_MAX == UINT32_MAX
 # define TCG_TARGET_REG_BITS 32
@@ -86,6 +87,8 @@
 #define TCG_TARGET_HAS_muluh_i32        0
 #define TCG_TARGET_HAS_mulsh_i32        0
 #define TCG_TARGET_HAS_goto_ptr         0
+#define TCG_TARGET_HAS_qemu_page        0
+#define TCG_TARGET_HAS_fastmem          0
 #define TCG_TARGET_HAS_direct_jump      1
 
 #if TCG_TARGET_REG_BITS == 64
@@ -174,8 +177,6 @@ typedef enum {
     TCG_REG_R31,
 #endif
 #endif
-    /* Special value UINT8_MAX is used by TCI to encode constant values. */
-    TCG_CONST = UINT8_MAX
 } TCGReg;
 
 #define TCG_AREG0                       (TCG_TARGET_NB_REGS - 2)
@@ -185,10 +186,30 @@ typedef enum {
 #define TCG_TARGET_CALL_STACK_OFFSET    0
 #define TCG_TARGET_STACK_ALIGN          16
 
+/*
+ * Each operation is pre-decoded when the TB is translated, into a record
+ * that keeps its register numbers and small constants (conditions, bit
+ * positions) at fixed positions, followed by its immediates (constants,
+ * offsets, labels) as host words.  All operands are registers, constants
+ * are loaded with movi first.  Records are padded to a multiple of the
+ * host word size, so that the interpreter never parses operands.
+ */
+typedef struct TCIOp {
+    uint8_t opc;            /* TCGOpcode */
+    uint8_t size;           /* size of the record, in bytes */
+    uint8_t r[6];
+    uintptr_t i[];
+} TCIOp;
+
 void tci_disas(uint8_t opc);
 
 #define HAVE_TCG_QEMU_TB_EXEC
 
+#ifndef NEED_CPU_H
+/* For code that cannot include tcg/tcg.h, such as tests/tci-bench.c */
+uintptr_t tcg_qemu_tb_exec(void *env, uint8_t *tb_ptr);
+#endif
+
 static inline void flush_icache_range(uintptr_t start, uintptr_t stop)
 {
 }
@@ -0,0 +1,150 @@
+/*
+ * Compare RangeIndex lookups with a walk of a list, as done for RAMBlocks
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu/rcu.h"
+#include "qemu/timer.h"
+#include "qemu/range-index.h"
+
+struct block {
+    uint64_t start;
+    uint64_t size;
+    struct block *next;
+};
+
+static unsigned int n_blocks = 512;
+static unsigned int n_lookups = 10 * 1000 * 1000;
+static struct block *blocks;
+static struct block *list;
+static RangeIndex ri;
+static uint64_t *addrs;
+
+static const char commands_string[] =
+    " -n = number of blocks\n"
+    " -l = number of lookups";
+
+static void usage_complete(char *argv[])
+{
+    fprintf(stderr, "Usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "options:\n%s\n", commands_string);
+}
+
+/*
+ * From: https://en.wikipedia.org/wiki/Xorshift
+ * This is faster than rand_r(), and gives us a wider range (RAND_MAX is only
+ * guaranteed to be >= INT_MAX).
+ */
+static uint64_t xorshift64star(uint64_t x)
+{
+    x ^= x >> 12; /* a */
+    x ^= x << 25; /* b */
+    x ^= x >> 27; /* c */
+    return x * UINT64_C(2685821657736338717);
+}
+
+static void create_blocks(void)
+{
+    uint64_t r = 1, start = 0;
+    unsigned int i;
+    bool inserted;
+
+    blocks = g_new(struct block, n_blocks);
+    for (i = 0; i < n_blocks; i++) {
+        struct block *b = &blocks[i];
+
+        /* Sizes from 2 MiB to 1 GiB, separated by gaps like RAMBlocks */
+        r = xorshift64star(r);
+        b->start = start;
+        b->size = (1 + r % 512) << 21;
+        start += b->size + (r & (1 << 21));
+
+        b->next = list;
+        list = b;
+        inserted = range_index_insert(&ri, b->start, b->size, b);
+        g_assert(inserted);
+    }
+
+    addrs = g_new(uint64_t, n_lookups);
+    for (i = 0; i < n_lookups; i++) {
+        struct block *b;
+
+        r = xorshift64star(r);
+        b = &blocks[r % n_blocks];
+        addrs[i] = b->start + (r >> 16) % b->size;
+    }
+}
+
+static struct block *list_lookup(uint64_t addr)
+{
+    struct block *b;
+
+    for (b = list; b; b = b->next) {
+        if (addr - b->start < b->size) {
+            return b;
+        }
+    }
+    return NULL;
+}
+
+static double run_test(bool use_index)
+{
+    int64_t t;
+    unsigned int i;
+
+    t = get_clock();
+    rcu_read_lock();
+    for (i = 0; i < n_lookups; i++) {
+        struct block *b;
+
+        if (use_index) {
+            b = range_index_lookup(&ri, addrs[i]);
+        } else {
+            b = list_lookup(addrs[i]);
+        }
+        g_assert(b && addrs[i] - b->start < b->size);
+    }
+    rcu_read_unlock();
+    t = get_clock() - t;
+
+    return (double)n_lookups / t * 1e3;
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    int c;
+
+    for (;;) {
+        c = getopt(argc, argv, "hn:l:");
+        if (c < 0) {
+            break;
+        }
+        switch (c) {
+        case 'h':
+            usage_complete(argv);
+            exit(0);
+        case 'n':
+            n_blocks = atoi(optarg);
+            break;
+        case 'l':
+            n_lookups = atoi(optarg);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    create_blocks();
+
+    printf("Parameters:\n");
+    printf(" # of blocks:        %u\n", n_blocks);
+    printf(" # of lookups:       %u\n", n_lookups);
+    printf("Results:\n");
+    printf(" List walk:          %.2f Mlookups/s\n", run_test(false));
+    printf(" RangeIndex:         %.2f Mlookups/s\n", run_test(true));
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ *  x86 flags across TB boundaries
+ *
+ *  TCG specializes TBs on the CC_OP that is live on entry.  Each test
+ *  below leaves a TB through the same exit with different CC_OPs in env,
+ *  depending on its inputs, and consumes the flags in the next TB.  The
+ *  inputs alternate, so that a successor chained for one CC_OP would be
+ *  reached with the other.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+#define CC_C    0x0001
+#define CC_Z    0x0040
+#define CC_S    0x0080
+#define CC_O    0x0800
+#define CC_MASK (CC_C | CC_Z | CC_S | CC_O)
+
+struct flags {
+    unsigned long eflags;
+    uint8_t l, a;
+};
+
+/*
+ * Consume the flags with an inline condition and with a full
+ * computation of EFLAGS.
+ */
+#define CONSUME                                 \
+    "setl %[l]\n\t"                             \
+    "seta %[a]\n\t"                             \
+    "pushf\n\t"                                 \
+    "pop %[fl]\n\t"
+
+#define OUTPUTS(f) \
+    [l] "=m" (f.l), [a] "=m" (f.a), [fl] "=&r" (f.eflags)
+
+/*
+ * Each test first compares 0x100 with 1, which leaves CC_OP_SUBL.  The
+ * byte operations leave CC_OP_SUBB, and interpreting one as the other
+ * gives different results for L and A.
+ */
+
+/* With N == 0 the rep insn leaves the flags of the cmpl.  */
+static struct flags repe_cmpsb(uint8_t x, uint8_t y, unsigned long n)
+{
+    struct flags f;
+    uint8_t *p1 = &x, *p2 = &y;
+
+    asm volatile("cmpl $1, %%edx\n\t"
+                 "repe cmpsb\n\t"
+                 CONSUME
+                 : "+S" (p1), "+D" (p2), "+c" (n), OUTPUTS(f)
+                 : "d" (0x100)
+                 : "cc", "memory");
+    return f;
+}
+
+static struct flags repne_scasb(uint8_t x, uint8_t y, unsigned long n)
+{
+    struct flags f;
+    uint8_t *p = &y;
+
+    asm volatile("cmpl $1, %%edx\n\t"
+                 "repne scasb\n\t"
+                 CONSUME
+                 : "+D" (p), "+c" (n), OUTPUTS(f)
+                 : "a" (x), "d" (0x100)
+                 : "cc", "memory");
+    return f;
+}
+
+/* A shift by zero leaves the flags of the cmpl.  */
+static struct flags shl_cl(uint32_t x, uint8_t count)
+{
+    struct flags f;
+
+    asm volatile("cmpl $1, %%edx\n\t"
+                 "shll %%cl, %[x]\n\t"
+                 "jmp 1f\n"
+                 "1:\n\t"
+                 CONSUME
+                 : [x] "+r" (x), OUTPUTS(f)
+                 : "c" (count), "d" (0x100)
+                 : "cc");
+    return f;
+}
+
+static struct flags sar_cl(uint32_t x, uint8_t count)
+{
+    struct flags f;
+
+    asm volatile("cmpl $1, %%edx\n\t"
+                 "sarl %%cl, %[x]\n\t"
+                 "jmp 1f\n"
+                 "1:\n\t"
+                 CONSUME
+                 : [x] "+r" (x), OUTPUTS(f)
+                 : "c" (count), "d" (0x100)
+                 : "cc");
+    return f;
+}
+
+enum op {
+    OP_REPE_CMPSB,
+    OP_REPNE_SCASB,
+    OP_SHL_CL,
+    OP_SAR_CL,
+};
+
+struct test {
+    const char *name;
+    enum op op;
+    uint32_t x, y, n;
+    unsigned long eflags;
+    uint8_t l, a;
+};
+
+static const struct test tests[] = {
+    /* 0x80 - 0x01 overflows as a byte, but not as a long.  */
+    { "repe cmpsb, mismatch", OP_REPE_CMPSB, 0x80, 0x01, 1, CC_O, 1, 1 },
+    { "repe cmpsb, ecx=0", OP_REPE_CMPSB, 0x80, 0x01, 0, 0, 0, 1 },
+    { "repe cmpsb, match", OP_REPE_CMPSB, 0x80, 0x80, 1, CC_Z, 0, 0 },
+    { "repne scasb, ecx=0", OP_REPNE_SCASB, 0x80, 0x01, 0, 0, 0, 1 },
+    { "repne scasb, mismatch", OP_REPNE_SCASB, 0x80, 0x01, 1, CC_O, 1, 1 },
+    { "repne scasb, match", OP_REPNE_SCASB, 0x01, 0x01, 1, CC_Z, 0, 0 },
+    { "shl %cl, count=1", OP_SHL_CL, 0x80000001, 0, 1, CC_C | CC_O, 1, 0 },
+    { "shl %cl, count=0", OP_SHL_CL, 0x80000001, 0, 0, 0, 0, 1 },
+    { "sar %cl, count=0", OP_SAR_CL, 0x80000000, 0, 0, 0, 0, 1 },
+    { "sar %cl, count=1", OP_SAR_CL, 0x80000000, 0, 1, CC_S, 1, 1 },
+};
+
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+    int i, j;
+
+    /* Let the TBs be chained, then reach them with the other CC_OP.  */
+    for (j = 0; j < 4; j++) {
+        for (i = 0; i < ARRAY_SIZE(tests); i++) {
+            const struct test *t = &tests[i];
+            struct flags f;
+
+            switch (t->op) {
+            case OP_REPE_CMPSB:
+                f = repe_cmpsb(t->x, t->y, t->n);
+                break;
+            case OP_REPNE_SCASB:
+                f = repne_scasb(t->x, t->y, t->n);
+                break;
+            case OP_SHL_CL:
+                f = shl_cl(t->x, t->n);
+                break;
+            case OP_SAR_CL:
+                f = sar_cl(t->x, t->n);
+                break;
+            }
+            if ((f.eflags & CC_MASK) != t->eflags ||
+                f.l != t->l || f.a != t->a) {
+                printf("FAIL %s (pass %d): eflags %04lx l %d a %d, "
+                       "expected eflags %04lx l %d a %d\n",
+                       t->name, j, f.eflags & CC_MASK, f.l, f.a,
+                       t->eflags, t->l, t->a);
+                ret = 1;
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,342 @@
+/*
+ *  x86 MMX/SSE2 integer test - checks the results of the integer, logical,
+ *  compare, shift by immediate and shuffle instructions that are expanded
+ *  inline by the translator against values computed in C, then prints how
+ *  long a fixed sequence of each of them takes.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+typedef union {
+    uint8_t b[16];
+    int8_t sb[16];
+    uint16_t w[8];
+    int16_t sw[8];
+    uint32_t d[4];
+    int32_t sd[4];
+    uint64_t q[2];
+} __attribute__((aligned(16))) V128;
+
+#define NB_INPUTS 12
+
+static V128 inputs[NB_INPUTS];
+static int failures;
+
+static void init_inputs(void)
+{
+    static const uint8_t edges[] = { 0x00, 0x01, 0x7f, 0x80, 0x81, 0xff };
+    uint32_t seed = 0x12345678;
+    int i, j;
+
+    /* Saturation and sign edge cases in every lane size, then noise.  */
+    for (i = 0; i < ARRAY_SIZE(edges); i++) {
+        for (j = 0; j < 16; j++) {
+            inputs[i].b[j] = (j & 1) ? edges[i] : edges[(i + j) % 6];
+        }
+    }
+    for (; i < NB_INPUTS; i++) {
+        for (j = 0; j < 16; j++) {
+            seed = seed * 1103515245 + 12345;
+            inputs[i].b[j] = seed >> 16;
+        }
+    }
+}
+
+static void check(const char *insn, int len, const V128 *a, const V128 *b,
+                  const V128 *r, const V128 *e)
+{
+    int i;
+
+    if (!memcmp(r, e, len)) {
+        return;
+    }
+    failures++;
+    printf("FAIL %s\n  a:", insn);
+    for (i = len - 1; i >= 0; i--) {
+        printf(" %02x", a->b[i]);
+    }
+    if (b) {
+        printf("\n  b:");
+        for (i = len - 1; i >= 0; i--) {
+            printf(" %02x", b->b[i]);
+        }
+    }
+    printf("\n  got:");
+    for (i = len - 1; i >= 0; i--) {
+        printf(" %02x", r->b[i]);
+    }
+    printf("\n  expected:");
+    for (i = len - 1; i >= 0; i--) {
+        printf(" %02x", e->b[i]);
+    }
+    printf("\n");
+}
+
+static int sat(int x, int min, int max)
+{
+    return x < min ? min : x > max ? max : x;
+}
+
+/* dest = xmm0 (A), source = xmm1 (B) */
+#define XMM_OP(insn, r, a, b)                                   \
+    asm volatile("movdqu %1, %%xmm0\n\t"                        \
+                 "movdqu %2, %%xmm1\n\t"                        \
+                 insn " %%xmm1, %%xmm0\n\t"                     \
+                 "movdqu %%xmm0, %0"                            \
+                 : "=m" (r) : "m" (a), "m" (b) : "xmm0", "xmm1")
+
+/* Same, with the source in memory */
+#define XMM_OP_MEM(insn, r, a, b)                               \
+    asm volatile("movdqu %1, %%xmm0\n\t"                        \
+                 insn " %2, %%xmm0\n\t"                         \
+                 "movdqu %%xmm0, %0"                            \
+                 : "=m" (r) : "m" (a), "m" (b) : "xmm0")
+
+#define MMX_OP(insn, r, a, b)                                   \
+    asm volatile("movq %1, %%mm0\n\t"                           \
+                 "movq %2, %%mm1\n\t"                           \
+                 insn " %%mm1, %%mm0\n\t"                       \
+                 "movq %%mm0, %0\n\t"                           \
+                 "emms"                                         \
+                 : "=m" (*(uint64_t *)&r)                       \
+                 : "m" (*(uint64_t *)&a), "m" (*(uint64_t *)&b) \
+                 : "mm0", "mm1")
+
+/*
+ * Run INSN on every pair of inputs, and compare with EXPR evaluated on the
+ * lanes X and Y of field F of both inputs.
+ */
+#define TEST_BIN(OP, len, insn, f, expr)                                \
+    do {                                                                \
+        int i_, j_, k_;                                                 \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (j_ = 0; j_ < NB_INPUTS; j_++) {                        \
+                const V128 *a = &inputs[i_], *b = &inputs[j_];          \
+                V128 r, e;                                              \
+                OP(insn, r, *a, *b);                                    \
+                for (k_ = 0; k_ < len / sizeof(e.f[0]); k_++) {         \
+                    __typeof__(e.f[0]) x = a->f[k_], y = b->f[k_];      \
+                    e.f[k_] = (expr);                                   \
+                }                                                       \
+                check(insn, len, a, b, &r, &e);                         \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define TEST_XMM(insn, f, expr)                                         \
+    do {                                                                \
+        TEST_BIN(XMM_OP, 16, insn, f, expr);                            \
+        TEST_BIN(XMM_OP_MEM, 16, insn, f, expr);                        \
+    } while (0)
+
+#define TEST_MMX(insn, f, expr) TEST_BIN(MMX_OP, 8, insn, f, expr)
+
+/* Shifts by an immediate, of xmm0 (X) in place */
+#define TEST_SHIFT(insn, imm, f, expr)                                  \
+    do {                                                                \
+        int i_, k_;                                                     \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            const V128 *a = &inputs[i_];                                \
+            V128 r, e;                                                  \
+            asm volatile("movdqu %1, %%xmm0\n\t"                        \
+                         insn " $" #imm ", %%xmm0\n\t"                  \
+                         "movdqu %%xmm0, %0"                            \
+                         : "=m" (r) : "m" (*a) : "xmm0");               \
+            for (k_ = 0; k_ < ARRAY_SIZE(e.f); k_++) {                  \
+                __typeof__(e.f[0]) x = a->f[k_];                        \
+                (void)x;                                                \
+                e.f[k_] = (expr);                                       \
+            }                                                           \
+            check(insn " $" #imm, 16, a, NULL, &r, &e);                 \
+        }                                                               \
+    } while (0)
+
+/*
+ * Shuffles of xmm1 (A) or of memory into xmm0, which holds B beforehand so
+ * that the lanes that must be copied from A are seen to be.
+ */
+#define TEST_SHUF(insn, imm, f, lo, hi)                                 \
+    do {                                                                \
+        int i_, k_;                                                     \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            const V128 *a = &inputs[i_];                                \
+            const V128 *b = &inputs[NB_INPUTS - 1 - i_];                \
+            V128 r, s, e = *a;                                          \
+            asm volatile("movdqu %2, %%xmm0\n\t"                        \
+                         "movdqu %1, %%xmm1\n\t"                        \
+                         insn " $" #imm ", %%xmm1, %%xmm0\n\t"          \
+                         "movdqu %%xmm0, %0"                            \
+                         : "=m" (r) : "m" (*a), "m" (*b)                \
+                         : "xmm0", "xmm1");                             \
+            asm volatile("movdqu %2, %%xmm0\n\t"                        \
+                         insn " $" #imm ", %1, %%xmm0\n\t"              \
+                         "movdqu %%xmm0, %0"                            \
+                         : "=m" (s) : "m" (*a), "m" (*b) : "xmm0");     \
+            for (k_ = lo; k_ < hi; k_++) {                              \
+                e.f[k_] = a->f[lo + ((imm >> ((k_ - lo) * 2)) & 3)];    \
+            }                                                           \
+            check(insn " $" #imm, 16, a, b, &r, &e);                    \
+            check(insn " $" #imm " (mem)", 16, a, b, &s, &e);           \
+        }                                                               \
+    } while (0)
+
+static void test_pshufw(void)
+{
+    int i, k;
+
+    for (i = 0; i < NB_INPUTS; i++) {
+        const V128 *a = &inputs[i];
+        V128 r, e = *a;
+
+        asm volatile("movq %1, %%mm1\n\t"
+                     "pshufw $0x1b, %%mm1, %%mm0\n\t"
+                     "movq %%mm0, %0\n\t"
+                     "emms"
+                     : "=m" (*(uint64_t *)&r) : "m" (*(uint64_t *)a)
+                     : "mm0", "mm1");
+        for (k = 0; k < 4; k++) {
+            e.w[k] = a->w[3 - k];
+        }
+        check("pshufw $0x1b", 8, a, NULL, &r, &e);
+    }
+}
+
+static void test_results(void)
+{
+    TEST_XMM("paddb", b, x + y);
+    TEST_XMM("paddw", w, x + y);
+    TEST_XMM("paddd", d, x + y);
+    TEST_XMM("paddq", q, x + y);
+    TEST_XMM("paddsb", sb, sat(x + y, INT8_MIN, INT8_MAX));
+    TEST_XMM("paddsw", sw, sat(x + y, INT16_MIN, INT16_MAX));
+    TEST_XMM("paddusb", b, sat(x + y, 0, UINT8_MAX));
+    TEST_XMM("paddusw", w, sat(x + y, 0, UINT16_MAX));
+    TEST_XMM("psubb", b, x - y);
+    TEST_XMM("psubw", w, x - y);
+    TEST_XMM("psubd", d, x - y);
+    TEST_XMM("psubq", q, x - y);
+    TEST_XMM("psubsb", sb, sat(x - y, INT8_MIN, INT8_MAX));
+    TEST_XMM("psubsw", sw, sat(x - y, INT16_MIN, INT16_MAX));
+    TEST_XMM("psubusb", b, sat(x - y, 0, UINT8_MAX));
+    TEST_XMM("psubusw", w, sat(x - y, 0, UINT16_MAX));
+    TEST_XMM("pmullw", sw, x * y);
+
+    TEST_XMM("pcmpeqb", b, x == y ? -1 : 0);
+    TEST_XMM("pcmpeqw", w, x == y ? -1 : 0);
+    TEST_XMM("pcmpeqd", d, x == y ? -1 : 0);
+    TEST_XMM("pcmpgtb", sb, x > y ? -1 : 0);
+    TEST_XMM("pcmpgtw", sw, x > y ? -1 : 0);
+    TEST_XMM("pcmpgtd", sd, x > y ? -1 : 0);
+
+    TEST_XMM("pand", q, x & y);
+    TEST_XMM("pandn", q, ~x & y);
+    TEST_XMM("por", q, x | y);
+    TEST_XMM("pxor", q, x ^ y);
+    TEST_XMM("andps", q, x & y);
+    TEST_XMM("andnpd", q, ~x & y);
+    TEST_XMM("orps", q, x | y);
+    TEST_XMM("xorpd", q, x ^ y);
+
+    TEST_MMX("paddb", b, x + y);
+    TEST_MMX("paddsw", sw, sat(x + y, INT16_MIN, INT16_MAX));
+    TEST_MMX("psubusb", b, sat(x - y, 0, UINT8_MAX));
+    TEST_MMX("pcmpgtw", sw, x > y ? -1 : 0);
+    TEST_MMX("pandn", q, ~x & y);
+    TEST_MMX("pxor", q, x ^ y);
+
+    TEST_SHIFT("psrlw", 3, w, x >> 3);
+    TEST_SHIFT("psrlw", 16, w, 0);
+    TEST_SHIFT("psraw", 15, sw, x >> 15);
+    TEST_SHIFT("psraw", 200, sw, x >> 15);
+    TEST_SHIFT("psllw", 9, w, x << 9);
+    TEST_SHIFT("psrld", 31, d, x >> 31);
+    TEST_SHIFT("psrad", 7, sd, x >> 7);
+    TEST_SHIFT("psrad", 32, sd, x >> 31);
+    TEST_SHIFT("pslld", 32, d, 0);
+    TEST_SHIFT("psrlq", 63, q, x >> 63);
+    TEST_SHIFT("psllq", 1, q, x << 1);
+    TEST_SHIFT("psllq", 64, q, 0);
+
+    TEST_SHUF("pshufd", 0x1b, d, 0, 4);
+    TEST_SHUF("pshufd", 0x00, d, 0, 4);
+    TEST_SHUF("pshufd", 0xe4, d, 0, 4);
+    TEST_SHUF("pshuflw", 0x1b, w, 0, 4);
+    TEST_SHUF("pshuflw", 0x5f, w, 0, 4);
+    TEST_SHUF("pshufhw", 0x1b, w, 4, 8);
+    TEST_SHUF("pshufhw", 0xa0, w, 4, 8);
+    test_pshufw();
+}
+
+#define TIME_LOOPS 1000000
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Time TIME_LOOPS iterations of eight INSNs on xmm0 and xmm1 */
+#define TIME_XMM(name, insn)                                            \
+    do {                                                                \
+        double t = now();                                               \
+        int i_;                                                         \
+        asm volatile("movdqu %0, %%xmm0\n\t"                            \
+                     "movdqu %1, %%xmm1"                                \
+                     : : "m" (inputs[6]), "m" (inputs[7])               \
+                     : "xmm0", "xmm1");                                 \
+        for (i_ = 0; i_ < TIME_LOOPS; i_++) {                           \
+            asm volatile(insn "\n\t" insn "\n\t" insn "\n\t" insn "\n\t" \
+                         insn "\n\t" insn "\n\t" insn "\n\t" insn       \
+                         : : : "xmm0", "xmm1");                         \
+        }                                                               \
+        t = now() - t;                                                  \
+        printf("%-8s %6.2f ns/insn\n", name, t * 1e9 / TIME_LOOPS / 8); \
+    } while (0)
+
+static void time_insns(void)
+{
+    TIME_XMM("paddw", "paddw %%xmm1, %%xmm0");
+    TIME_XMM("paddusb", "paddusb %%xmm1, %%xmm0");
+    TIME_XMM("psubsw", "psubsw %%xmm1, %%xmm0");
+    TIME_XMM("pcmpeqd", "pcmpeqd %%xmm1, %%xmm0");
+    TIME_XMM("pcmpgtb", "pcmpgtb %%xmm1, %%xmm0");
+    TIME_XMM("pxor", "pxor %%xmm1, %%xmm0");
+    TIME_XMM("pandn", "pandn %%xmm1, %%xmm0");
+    TIME_XMM("psrlw", "psrlw $3, %%xmm0");
+    TIME_XMM("psrad", "psrad $7, %%xmm0");
+    TIME_XMM("pshufd", "pshufd $0x1b, %%xmm1, %%xmm0");
+    TIME_XMM("pshuflw", "pshuflw $0x1b, %%xmm1, %%xmm0");
+    TIME_XMM("pshufhw", "pshufhw $0x1b, %%xmm1, %%xmm0");
+}
+
+int main(int argc, char *argv[])
+{
+    init_inputs();
+    test_results();
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    time_insns();
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ *  ppc64le Altivec/VSX test - checks the logical, modulo add/sub, compare,
+ *  splat, merge and shift-by-octet instructions that are expanded inline
+ *  against values computed in C.  The VSX forms are run both on VSRs 32-63,
+ *  which alias the Altivec registers, and on VSRs 0-31.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+/*
+ * The arrays are in little-endian element order, as the compiler loads
+ * them.  BE() gives the bytes in the big-endian order of the ISA.
+ */
+typedef union {
+    __vector unsigned char v;
+    uint8_t b[16];
+    int8_t sb[16];
+    uint16_t h[8];
+    int16_t sh[8];
+    uint32_t w[4];
+    int32_t sw[4];
+    uint64_t d[2];
+    int64_t sd[2];
+} V128;
+
+#define BE(x, i) ((x)->b[15 - (i)])
+
+#define NB_INPUTS 10
+
+static V128 inputs[NB_INPUTS];
+static int failures;
+
+static void init_inputs(void)
+{
+    static const uint8_t edges[] = { 0x00, 0x01, 0x7f, 0x80, 0xff };
+    uint32_t seed = 0x12345678;
+    int i, j;
+
+    /* Sign and equality edge cases in every lane size, then noise.  */
+    for (i = 0; i < ARRAY_SIZE(edges); i++) {
+        for (j = 0; j < 16; j++) {
+            inputs[i].b[j] = (j & 1) ? edges[i] : edges[(i + j) % 5];
+        }
+    }
+    for (; i < NB_INPUTS; i++) {
+        for (j = 0; j < 16; j++) {
+            seed = seed * 1103515245 + 12345;
+            inputs[i].b[j] = seed >> 16;
+        }
+    }
+}
+
+static void dump(const char *name, const V128 *v)
+{
+    int i;
+
+    printf("  %s:", name);
+    for (i = 0; i < 16; i++) {
+        printf(" %02x", BE(v, i));
+    }
+    printf("\n");
+}
+
+static void check(const char *insn, const char *form, const V128 *a,
+                  const V128 *b, const V128 *r, const V128 *e)
+{
+    if (!memcmp(r, e, sizeof(*r))) {
+        return;
+    }
+    failures++;
+    printf("FAIL %s (%s)\n", insn, form);
+    dump("a", a);
+    if (b) {
+        dump("b", b);
+    }
+    dump("got", r);
+    dump("expected", e);
+}
+
+/* All operands in Altivec registers, i.e. VSRs 32-63 */
+#define VR_OP(insn, r, a, b)                                    \
+    asm(insn " %0,%1,%2" : "=v" (r.v) : "v" (a.v), "v" (b.v))
+
+#define VSR_HI_OP(insn, r, a, b)                                \
+    asm(insn " %x0,%x1,%x2" : "=v" (r.v) : "v" (a.v), "v" (b.v))
+
+/* All operands in VSRs 0-31, which overlay the FPRs */
+#define VSR_LO_OP(insn, r, a, b)                                \
+    asm("xxlor 0,%x1,%x1\n\t"                                   \
+        "xxlor 1,%x2,%x2\n\t"                                   \
+        insn " 2,0,1\n\t"                                       \
+        "xxlor %x0,2,2"                                         \
+        : "=wa" (r.v) : "wa" (a.v), "wa" (b.v)                  \
+        : "vs0", "vs1", "vs2")
+
+/*
+ * Run INSN on every pair of inputs, and compare with EXPR evaluated on the
+ * lanes X and Y of field F of both inputs.  The lanewise operations do not
+ * depend on the element order.
+ */
+#define TEST_BIN(OP, insn, f, expr)                                     \
+    do {                                                                \
+        int i_, j_, k_;                                                 \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (j_ = 0; j_ < NB_INPUTS; j_++) {                        \
+                const V128 *a = &inputs[i_], *b = &inputs[j_];          \
+                V128 r, e;                                              \
+                OP(insn, r, (*a), (*b));                                \
+                for (k_ = 0; k_ < ARRAY_SIZE(e.f); k_++) {              \
+                    __typeof__(e.f[0]) x = a->f[k_], y = b->f[k_];      \
+                    e.f[k_] = (expr);                                   \
+                }                                                       \
+                check(insn, #OP, a, b, &r, &e);                         \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define TEST_VSX_LOGICAL(insn, expr)                                    \
+    do {                                                                \
+        TEST_BIN(VSR_HI_OP, insn, d, expr);                             \
+        TEST_BIN(VSR_LO_OP, insn, d, expr);                             \
+    } while (0)
+
+static void test_logical(void)
+{
+    TEST_BIN(VR_OP, "vand", d, x & y);
+    TEST_BIN(VR_OP, "vandc", d, x & ~y);
+    TEST_BIN(VR_OP, "vor", d, x | y);
+    TEST_BIN(VR_OP, "vxor", d, x ^ y);
+    TEST_BIN(VR_OP, "vnor", d, ~(x | y));
+    TEST_BIN(VR_OP, "veqv", d, ~(x ^ y));
+    TEST_BIN(VR_OP, "vnand", d, ~(x & y));
+    TEST_BIN(VR_OP, "vorc", d, x | ~y);
+
+    TEST_VSX_LOGICAL("xxland", x & y);
+    TEST_VSX_LOGICAL("xxlandc", x & ~y);
+    TEST_VSX_LOGICAL("xxlor", x | y);
+    TEST_VSX_LOGICAL("xxlxor", x ^ y);
+    TEST_VSX_LOGICAL("xxlnor", ~(x | y));
+    TEST_VSX_LOGICAL("xxleqv", ~(x ^ y));
+    TEST_VSX_LOGICAL("xxlnand", ~(x & y));
+    TEST_VSX_LOGICAL("xxlorc", x | ~y);
+}
+
+static void test_arith(void)
+{
+    TEST_BIN(VR_OP, "vaddubm", b, x + y);
+    TEST_BIN(VR_OP, "vadduhm", h, x + y);
+    TEST_BIN(VR_OP, "vadduwm", w, x + y);
+    TEST_BIN(VR_OP, "vaddudm", d, x + y);
+    TEST_BIN(VR_OP, "vsububm", b, x - y);
+    TEST_BIN(VR_OP, "vsubuhm", h, x - y);
+    TEST_BIN(VR_OP, "vsubuwm", w, x - y);
+    TEST_BIN(VR_OP, "vsubudm", d, x - y);
+    TEST_BIN(VR_OP, "vmuluwm", w, x * y);
+
+    TEST_BIN(VR_OP, "vcmpequb", b, x == y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpequh", h, x == y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpequw", w, x == y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpequd", d, x == y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtub", b, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtuh", h, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtuw", w, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtud", d, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtsb", sb, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtsh", sh, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtsw", sw, x > y ? -1 : 0);
+    TEST_BIN(VR_OP, "vcmpgtsd", sd, x > y ? -1 : 0);
+}
+
+/* Element i of the result of vmrgh/vmrgl on elements of SIZE bytes */
+static void ref_vmrg(V128 *r, const V128 *a, const V128 *b, int size,
+                     int high)
+{
+    int n = 16 / size;
+    int i, k;
+
+    for (i = 0; i < n / 2; i++) {
+        int src = high ? i : i + n / 2;
+
+        for (k = 0; k < size; k++) {
+            BE(r, 2 * i * size + k) = BE(a, src * size + k);
+            BE(r, (2 * i + 1) * size + k) = BE(b, src * size + k);
+        }
+    }
+}
+
+#define TEST_VMRG(insn, size, high)                                     \
+    do {                                                                \
+        int i_, j_;                                                     \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (j_ = 0; j_ < NB_INPUTS; j_++) {                        \
+                const V128 *a = &inputs[i_], *b = &inputs[j_];          \
+                V128 r, e;                                              \
+                VR_OP(insn, r, (*a), (*b));                             \
+                ref_vmrg(&e, a, b, size, high);                         \
+                check(insn, "VR_OP", a, b, &r, &e);                     \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define TEST_VSLDOI(sh)                                                 \
+    do {                                                                \
+        int i_, j_, k_;                                                 \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (j_ = 0; j_ < NB_INPUTS; j_++) {                        \
+                const V128 *a = &inputs[i_], *b = &inputs[j_];          \
+                V128 r, e;                                              \
+                asm("vsldoi %0,%1,%2," #sh                              \
+                    : "=v" (r.v) : "v" (a->v), "v" (b->v));             \
+                for (k_ = 0; k_ < 16; k_++) {                           \
+                    BE(&e, k_) = k_ + sh < 16 ? BE(a, k_ + sh)          \
+                                              : BE(b, k_ + sh - 16);    \
+                }                                                       \
+                check("vsldoi " #sh, "VR_OP", a, b, &r, &e);            \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+static void test_permute(void)
+{
+    TEST_VMRG("vmrghb", 1, 1);
+    TEST_VMRG("vmrghh", 2, 1);
+    TEST_VMRG("vmrghw", 4, 1);
+    TEST_VMRG("vmrglb", 1, 0);
+    TEST_VMRG("vmrglh", 2, 0);
+    TEST_VMRG("vmrglw", 4, 0);
+
+    TEST_VSLDOI(0);
+    TEST_VSLDOI(1);
+    TEST_VSLDOI(3);
+    TEST_VSLDOI(7);
+    TEST_VSLDOI(8);
+    TEST_VSLDOI(9);
+    TEST_VSLDOI(12);
+    TEST_VSLDOI(15);
+}
+
+/* Splat big-endian word UIM of B into every word */
+#define TEST_SPLTW(uim)                                                 \
+    do {                                                                \
+        int i_, k_;                                                     \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            const V128 *b = &inputs[i_];                                \
+            V128 r, e;                                                  \
+            for (k_ = 0; k_ < 4; k_++) {                                \
+                e.w[k_] = b->w[3 - uim];                                \
+            }                                                           \
+            asm("vspltw %0,%1," #uim : "=v" (r.v) : "v" (b->v));        \
+            check("vspltw " #uim, "VR_OP", b, NULL, &r, &e);            \
+            asm("xxspltw %x0,%x1," #uim : "=v" (r.v) : "v" (b->v));     \
+            check("xxspltw " #uim, "VSR_HI_OP", b, NULL, &r, &e);       \
+            asm("xxlor 0,%x1,%x1\n\t"                                   \
+                "xxspltw 1,0," #uim "\n\t"                              \
+                "xxlor %x0,1,1"                                         \
+                : "=wa" (r.v) : "wa" (b->v) : "vs0", "vs1");            \
+            check("xxspltw " #uim, "VSR_LO_OP", b, NULL, &r, &e);       \
+        }                                                               \
+    } while (0)
+
+#define TEST_SPLTB(uim)                                                 \
+    do {                                                                \
+        int i_, k_;                                                     \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            const V128 *b = &inputs[i_];                                \
+            V128 r, e;                                                  \
+            for (k_ = 0; k_ < 16; k_++) {                               \
+                e.b[k_] = BE(b, uim);                                   \
+            }                                                           \
+            asm("vspltb %0,%1," #uim : "=v" (r.v) : "v" (b->v));        \
+            check("vspltb " #uim, "VR_OP", b, NULL, &r, &e);            \
+        }                                                               \
+    } while (0)
+
+#define TEST_SPLTI(insn, imm, f)                                        \
+    do {                                                                \
+        V128 r, e;                                                      \
+        int k_;                                                         \
+        for (k_ = 0; k_ < ARRAY_SIZE(e.f); k_++) {                      \
+            e.f[k_] = imm;                                              \
+        }                                                               \
+        asm(insn " %0," #imm : "=v" (r.v));                             \
+        check(insn " " #imm, "VR_OP", &e, NULL, &r, &e);                \
+    } while (0)
+
+static void test_splat(void)
+{
+    TEST_SPLTW(0);
+    TEST_SPLTW(1);
+    TEST_SPLTW(2);
+    TEST_SPLTW(3);
+
+    TEST_SPLTB(0);
+    TEST_SPLTB(6);
+    TEST_SPLTB(15);
+
+    TEST_SPLTI("vspltisb", -16, sb);
+    TEST_SPLTI("vspltish", 15, sh);
+    TEST_SPLTI("vspltisw", -1, sw);
+}
+
+static void test_xxspltib(void)
+{
+    V128 r, e;
+
+    memset(&e, 0xa5, sizeof(e));
+    asm("xxspltib %x0,0xa5" : "=v" (r.v));
+    check("xxspltib", "VSR_HI_OP", &e, NULL, &r, &e);
+    asm("xxspltib 0,0xa5\n\t"
+        "xxlor %x0,0,0" : "=wa" (r.v) : : "vs0");
+    check("xxspltib", "VSR_LO_OP", &e, NULL, &r, &e);
+}
+
+int main(void)
+{
+    init_inputs();
+    test_logical();
+    test_arith();
+    test_permute();
+    test_splat();
+    test_xxspltib();
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
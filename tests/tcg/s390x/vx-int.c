@@ -0,0 +1,676 @@
+/*
+ * Vector integer instructions, checked against C reference code
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "vx.h"
+
+static const S390Vector inputs[] = {
+    { .d = { 0x0123456789abcdefull, 0xfedcba9876543210ull } },
+    { .d = { 0x7f80ff0001fe8001ull, 0x8000000000000001ull } },
+    { .d = { 0xffffffffffffffffull, 0x7fffffff80000000ull } },
+    { .d = { 0x0000000000000000ull, 0x5a5aa5a50f0ff0f0ull } },
+};
+#define NUM_INPUTS (sizeof(inputs) / sizeof(inputs[0]))
+
+typedef void (*VecOp2)(S390Vector *r, const S390Vector *a, int es);
+typedef void (*VecOp3)(S390Vector *r, const S390Vector *a,
+                       const S390Vector *b, int es);
+typedef int (*VecOp3CC)(S390Vector *r, const S390Vector *a,
+                        const S390Vector *b, int es);
+
+/*
+ * The element size is an immediate, so every instruction gets a wrapper
+ * that switches over it.
+ */
+#define VRR_A(insn, m3, r, a)                                   \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 insn " %%v18,%%v16,%[m]\n"                     \
+                 "vst %%v18,%[vr]\n"                            \
+                 : [vr] "=Q" (*(r))                             \
+                 : [va] "Q" (*(a)), [m] "i" (m3)                \
+                 : "v16", "v18")
+
+#define VRR_C(insn, m4, r, a, b)                                \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 insn " %%v18,%%v16,%%v17,%[m]\n"               \
+                 "vst %%v18,%[vr]\n"                            \
+                 : [vr] "=Q" (*(r))                             \
+                 : [va] "Q" (*(a)), [vb] "Q" (*(b)), [m] "i" (m4) \
+                 : "v16", "v17", "v18")
+
+#define VRR_B_CC(insn, m4, r, a, b, cc)                         \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 insn " %%v18,%%v16,%%v17,%[m],1\n"             \
+                 "vst %%v18,%[vr]\n"                            \
+                 "ipm %[cc]\n"                                  \
+                 "srl %[cc],28\n"                               \
+                 : [vr] "=Q" (*(r)), [cc] "=d" (cc)             \
+                 : [va] "Q" (*(a)), [vb] "Q" (*(b)), [m] "i" (m4) \
+                 : "v16", "v17", "v18", "cc")
+
+#define DEF_VRR_A(name, insn)                                   \
+static void name(S390Vector *r, const S390Vector *a, int es)    \
+{                                                               \
+    switch (es) {                                               \
+    case 0:                                                     \
+        VRR_A(insn, 0, r, a);                                   \
+        break;                                                  \
+    case 1:                                                     \
+        VRR_A(insn, 1, r, a);                                   \
+        break;                                                  \
+    case 2:                                                     \
+        VRR_A(insn, 2, r, a);                                   \
+        break;                                                  \
+    default:                                                    \
+        VRR_A(insn, 3, r, a);                                   \
+        break;                                                  \
+    }                                                           \
+}
+
+#define DEF_VRR_C(name, insn)                                   \
+static void name(S390Vector *r, const S390Vector *a,            \
+                 const S390Vector *b, int es)                   \
+{                                                               \
+    switch (es) {                                               \
+    case 0:                                                     \
+        VRR_C(insn, 0, r, a, b);                                \
+        break;                                                  \
+    case 1:                                                     \
+        VRR_C(insn, 1, r, a, b);                                \
+        break;                                                  \
+    case 2:                                                     \
+        VRR_C(insn, 2, r, a, b);                                \
+        break;                                                  \
+    case 3:                                                     \
+        VRR_C(insn, 3, r, a, b);                                \
+        break;                                                  \
+    default:                                                    \
+        VRR_C(insn, 4, r, a, b);                                \
+        break;                                                  \
+    }                                                           \
+}
+
+#define DEF_VRR_B_CC(name, insn)                                \
+static int name(S390Vector *r, const S390Vector *a,             \
+                const S390Vector *b, int es)                    \
+{                                                               \
+    int cc;                                                     \
+                                                                \
+    switch (es) {                                               \
+    case 0:                                                     \
+        VRR_B_CC(insn, 0, r, a, b, cc);                         \
+        break;                                                  \
+    case 1:                                                     \
+        VRR_B_CC(insn, 1, r, a, b, cc);                         \
+        break;                                                  \
+    case 2:                                                     \
+        VRR_B_CC(insn, 2, r, a, b, cc);                         \
+        break;                                                  \
+    default:                                                    \
+        VRR_B_CC(insn, 3, r, a, b, cc);                         \
+        break;                                                  \
+    }                                                           \
+    return cc;                                                  \
+}
+
+DEF_VRR_A(do_vlc, "vlc")
+DEF_VRR_A(do_vlp, "vlp")
+DEF_VRR_C(do_va, "va")
+DEF_VRR_C(do_vs, "vs")
+DEF_VRR_C(do_vavg, "vavg")
+DEF_VRR_C(do_vavgl, "vavgl")
+DEF_VRR_C(do_vmx, "vmx")
+DEF_VRR_C(do_vmxl, "vmxl")
+DEF_VRR_C(do_vmn, "vmn")
+DEF_VRR_C(do_vmnl, "vmnl")
+DEF_VRR_C(do_vml, "vml")
+DEF_VRR_C(do_veslv, "veslv")
+DEF_VRR_C(do_vesrav, "vesrav")
+DEF_VRR_C(do_vesrlv, "vesrlv")
+DEF_VRR_C(do_verllv, "verllv")
+DEF_VRR_C(do_vpk, "vpk")
+DEF_VRR_C(do_vsum, "vsum")
+DEF_VRR_C(do_vsumg, "vsumg")
+DEF_VRR_C(do_vsumq, "vsumq")
+DEF_VRR_C(do_vgfm, "vgfm")
+DEF_VRR_B_CC(do_vceq, "vceq")
+DEF_VRR_B_CC(do_vch, "vch")
+DEF_VRR_B_CC(do_vchl, "vchl")
+DEF_VRR_B_CC(do_vpks, "vpks")
+DEF_VRR_B_CC(do_vpkls, "vpkls")
+
+static uint64_t ref_vlc(uint64_t a, uint64_t b, int es)
+{
+    return -a;
+}
+
+static uint64_t ref_vlp(uint64_t a, uint64_t b, int es)
+{
+    return vx_sext(a, es) < 0 ? -a : a;
+}
+
+static uint64_t ref_va(uint64_t a, uint64_t b, int es)
+{
+    return a + b;
+}
+
+static uint64_t ref_vs(uint64_t a, uint64_t b, int es)
+{
+    return a - b;
+}
+
+static uint64_t ref_vavg(uint64_t a, uint64_t b, int es)
+{
+    return ((__int128)vx_sext(a, es) + vx_sext(b, es) + 1) >> 1;
+}
+
+static uint64_t ref_vavgl(uint64_t a, uint64_t b, int es)
+{
+    return ((unsigned __int128)a + b + 1) >> 1;
+}
+
+static uint64_t ref_vmx(uint64_t a, uint64_t b, int es)
+{
+    return vx_sext(a, es) > vx_sext(b, es) ? a : b;
+}
+
+static uint64_t ref_vmxl(uint64_t a, uint64_t b, int es)
+{
+    return a > b ? a : b;
+}
+
+static uint64_t ref_vmn(uint64_t a, uint64_t b, int es)
+{
+    return vx_sext(a, es) < vx_sext(b, es) ? a : b;
+}
+
+static uint64_t ref_vmnl(uint64_t a, uint64_t b, int es)
+{
+    return a < b ? a : b;
+}
+
+static uint64_t ref_vml(uint64_t a, uint64_t b, int es)
+{
+    return a * b;
+}
+
+static uint64_t ref_veslv(uint64_t a, uint64_t b, int es)
+{
+    return a << (b % ELEMENT_BITS(es));
+}
+
+static uint64_t ref_vesrav(uint64_t a, uint64_t b, int es)
+{
+    return vx_sext(a, es) >> (b % ELEMENT_BITS(es));
+}
+
+static uint64_t ref_vesrlv(uint64_t a, uint64_t b, int es)
+{
+    return a >> (b % ELEMENT_BITS(es));
+}
+
+static uint64_t ref_verllv(uint64_t a, uint64_t b, int es)
+{
+    const int count = b % ELEMENT_BITS(es);
+
+    if (!count) {
+        return a;
+    }
+    return (a << count) | (a >> (ELEMENT_BITS(es) - count));
+}
+
+static uint64_t ref_vceq(uint64_t a, uint64_t b, int es)
+{
+    return a == b ? -1ull : 0;
+}
+
+static uint64_t ref_vch(uint64_t a, uint64_t b, int es)
+{
+    return vx_sext(a, es) > vx_sext(b, es) ? -1ull : 0;
+}
+
+static uint64_t ref_vchl(uint64_t a, uint64_t b, int es)
+{
+    return a > b ? -1ull : 0;
+}
+
+typedef uint64_t (*RefOp)(uint64_t a, uint64_t b, int es);
+
+static void ref_elementwise(S390Vector *r, const S390Vector *a,
+                            const S390Vector *b, int es, RefOp ref)
+{
+    int i;
+
+    for (i = 0; i < NUM_ELEMENTS(es); i++) {
+        vx_set(r, es, i, ref(vx_get(a, es, i), vx_get(b, es, i), es) &
+                         vx_mask(es));
+    }
+}
+
+static const struct {
+    const char *name;
+    VecOp3 insn;
+    RefOp ref;
+    int max_es;
+} elementwise[] = {
+    { "va", do_va, ref_va, 3 },
+    { "vs", do_vs, ref_vs, 3 },
+    { "vavg", do_vavg, ref_vavg, 3 },
+    { "vavgl", do_vavgl, ref_vavgl, 3 },
+    { "vmx", do_vmx, ref_vmx, 3 },
+    { "vmxl", do_vmxl, ref_vmxl, 3 },
+    { "vmn", do_vmn, ref_vmn, 3 },
+    { "vmnl", do_vmnl, ref_vmnl, 3 },
+    { "vml", do_vml, ref_vml, 2 },
+    { "veslv", do_veslv, ref_veslv, 3 },
+    { "vesrav", do_vesrav, ref_vesrav, 3 },
+    { "vesrlv", do_vesrlv, ref_vesrlv, 3 },
+    { "verllv", do_verllv, ref_verllv, 3 },
+};
+
+static const struct {
+    const char *name;
+    VecOp3CC insn;
+    RefOp ref;
+} compares[] = {
+    { "vceq", do_vceq, ref_vceq },
+    { "vch", do_vch, ref_vch },
+    { "vchl", do_vchl, ref_vchl },
+};
+
+static void test_elementwise(void)
+{
+    S390Vector r, exp;
+    int i, j, k, es, cc;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (es = 0; es <= 3; es++) {
+            do_vlc(&r, &inputs[i], es);
+            ref_elementwise(&exp, &inputs[i], &inputs[i], es, ref_vlc);
+            vx_check("vlc", es, &r, &exp);
+            do_vlp(&r, &inputs[i], es);
+            ref_elementwise(&exp, &inputs[i], &inputs[i], es, ref_vlp);
+            vx_check("vlp", es, &r, &exp);
+        }
+        for (j = 0; j < NUM_INPUTS; j++) {
+            for (k = 0; k < sizeof(elementwise) / sizeof(elementwise[0]);
+                 k++) {
+                for (es = 0; es <= elementwise[k].max_es; es++) {
+                    elementwise[k].insn(&r, &inputs[i], &inputs[j], es);
+                    ref_elementwise(&exp, &inputs[i], &inputs[j], es,
+                                    elementwise[k].ref);
+                    vx_check(elementwise[k].name, es, &r, &exp);
+                }
+            }
+            for (k = 0; k < sizeof(compares) / sizeof(compares[0]); k++) {
+                for (es = 0; es <= 3; es++) {
+                    int n = 0, l;
+
+                    cc = compares[k].insn(&r, &inputs[i], &inputs[j], es);
+                    ref_elementwise(&exp, &inputs[i], &inputs[j], es,
+                                    compares[k].ref);
+                    vx_check(compares[k].name, es, &r, &exp);
+                    for (l = 0; l < NUM_ELEMENTS(es); l++) {
+                        n += !!vx_get(&exp, es, l);
+                    }
+                    vx_check_cc(compares[k].name, es, cc,
+                                n == NUM_ELEMENTS(es) ? 0 : n ? 1 : 3);
+                }
+            }
+        }
+    }
+}
+
+static unsigned __int128 vx_get128(const S390Vector *v)
+{
+    return (unsigned __int128)v->d[0] << 64 | v->d[1];
+}
+
+static void vx_set128(S390Vector *v, unsigned __int128 x)
+{
+    v->d[0] = x >> 64;
+    v->d[1] = x;
+}
+
+static void test_quadword(void)
+{
+    S390Vector r, exp;
+    int i, j;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            do_va(&r, &inputs[i], &inputs[j], 4);
+            vx_set128(&exp, vx_get128(&inputs[i]) + vx_get128(&inputs[j]));
+            vx_check("va", 4, &r, &exp);
+            do_vs(&r, &inputs[i], &inputs[j], 4);
+            vx_set128(&exp, vx_get128(&inputs[i]) - vx_get128(&inputs[j]));
+            vx_check("vs", 4, &r, &exp);
+        }
+    }
+}
+
+/* Pack the elements of a and b into the next smaller element size */
+static int ref_pack(S390Vector *r, const S390Vector *a, const S390Vector *b,
+                    int es, int saturate)
+{
+    const int n = NUM_ELEMENTS(es);
+    const uint64_t max = vx_mask(es - 1);
+    int i, sat = 0;
+
+    for (i = 0; i < 2 * n; i++) {
+        uint64_t x = i < n ? vx_get(a, es, i) : vx_get(b, es, i - n);
+
+        if (saturate == 1) {
+            const int64_t s = vx_sext(x, es);
+            const int64_t smax = max >> 1;
+
+            if (s > smax || s < -smax - 1) {
+                x = s > smax ? smax : -smax - 1;
+                sat++;
+            }
+        } else if (saturate == 2 && x > max) {
+            x = max;
+            sat++;
+        }
+        vx_set(r, es - 1, i, x & max);
+    }
+    return sat == 0 ? 0 : sat == 2 * n ? 3 : 1;
+}
+
+static void test_pack(void)
+{
+    S390Vector r, exp;
+    int i, j, es, cc;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            for (es = 1; es <= 3; es++) {
+                do_vpk(&r, &inputs[i], &inputs[j], es);
+                ref_pack(&exp, &inputs[i], &inputs[j], es, 0);
+                vx_check("vpk", es, &r, &exp);
+                cc = do_vpks(&r, &inputs[i], &inputs[j], es);
+                vx_check_cc("vpks", es, cc,
+                            ref_pack(&exp, &inputs[i], &inputs[j], es, 1));
+                vx_check("vpks", es, &r, &exp);
+                cc = do_vpkls(&r, &inputs[i], &inputs[j], es);
+                vx_check_cc("vpkls", es, cc,
+                            ref_pack(&exp, &inputs[i], &inputs[j], es, 2));
+                vx_check("vpkls", es, &r, &exp);
+            }
+        }
+    }
+}
+
+/*
+ * Sum the elements of a within each result element of size res_es and
+ * add the rightmost element of b within the same result element.
+ */
+static void ref_sum(S390Vector *r, const S390Vector *a, const S390Vector *b,
+                    int es, int res_es)
+{
+    const int per = 1 << (res_es - es);
+    int i, j;
+
+    memset(r, 0, sizeof(*r));
+    for (i = 0; i < 16 >> res_es; i++) {
+        unsigned __int128 sum = vx_get(b, es, (i + 1) * per - 1);
+
+        for (j = 0; j < per; j++) {
+            sum += vx_get(a, es, i * per + j);
+        }
+        if (res_es == 4) {
+            vx_set128(r, sum);
+        } else {
+            vx_set(r, res_es, i, sum);
+        }
+    }
+}
+
+static void test_sum(void)
+{
+    S390Vector r, exp;
+    int i, j, es;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            for (es = 0; es <= 1; es++) {
+                do_vsum(&r, &inputs[i], &inputs[j], es);
+                ref_sum(&exp, &inputs[i], &inputs[j], es, 2);
+                vx_check("vsum", es, &r, &exp);
+            }
+            for (es = 1; es <= 2; es++) {
+                do_vsumg(&r, &inputs[i], &inputs[j], es);
+                ref_sum(&exp, &inputs[i], &inputs[j], es, 3);
+                vx_check("vsumg", es, &r, &exp);
+            }
+            for (es = 2; es <= 3; es++) {
+                do_vsumq(&r, &inputs[i], &inputs[j], es);
+                ref_sum(&exp, &inputs[i], &inputs[j], es, 4);
+                vx_check("vsumq", es, &r, &exp);
+            }
+        }
+    }
+}
+
+static void test_vcksm(void)
+{
+    S390Vector r, exp;
+    int i, j, k;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            uint32_t sum = inputs[j].w[1];
+
+            for (k = 0; k < 4; k++) {
+                const uint64_t s = (uint64_t)sum + inputs[i].w[k];
+
+                sum = s + (s >> 32);
+            }
+            memset(&exp, 0, sizeof(exp));
+            exp.w[1] = sum;
+            asm volatile("vl %%v16,%[va]\n"
+                         "vl %%v17,%[vb]\n"
+                         "vcksm %%v18,%%v16,%%v17\n"
+                         "vst %%v18,%[vr]\n"
+                         : [vr] "=Q" (r)
+                         : [va] "Q" (inputs[i]), [vb] "Q" (inputs[j])
+                         : "v16", "v17", "v18");
+            vx_check("vcksm", 2, &r, &exp);
+        }
+    }
+}
+
+/* Carry-less multiplication of two elements of at most 64 bits */
+static unsigned __int128 clmul(uint64_t a, uint64_t b)
+{
+    unsigned __int128 r = 0;
+    int i;
+
+    for (i = 0; i < 64; i++) {
+        if (b & (1ull << i)) {
+            r ^= (unsigned __int128)a << i;
+        }
+    }
+    return r;
+}
+
+static void ref_vgfm(S390Vector *r, const S390Vector *a, const S390Vector *b,
+                     const S390Vector *c, int es)
+{
+    int i;
+
+    for (i = 0; i < NUM_ELEMENTS(es) / 2; i++) {
+        unsigned __int128 x;
+
+        x = clmul(vx_get(a, es, 2 * i), vx_get(b, es, 2 * i)) ^
+            clmul(vx_get(a, es, 2 * i + 1), vx_get(b, es, 2 * i + 1));
+        if (es == 3) {
+            vx_set128(r, x ^ (c ? vx_get128(c) : 0));
+        } else {
+            vx_set(r, es + 1, i, x ^ (c ? vx_get(c, es + 1, i) : 0));
+        }
+    }
+}
+
+#define VGFMA(m5, r, a, b, c)                                   \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 "vl %%v19,%[vc]\n"                             \
+                 "vgfma %%v18,%%v16,%%v17,%%v19,%[m]\n"         \
+                 "vst %%v18,%[vr]\n"                            \
+                 : [vr] "=Q" (*(r))                             \
+                 : [va] "Q" (*(a)), [vb] "Q" (*(b)),            \
+                   [vc] "Q" (*(c)), [m] "i" (m5)                \
+                 : "v16", "v17", "v18", "v19")
+
+static void do_vgfma(S390Vector *r, const S390Vector *a, const S390Vector *b,
+                     const S390Vector *c, int es)
+{
+    switch (es) {
+    case 0:
+        VGFMA(0, r, a, b, c);
+        break;
+    case 1:
+        VGFMA(1, r, a, b, c);
+        break;
+    case 2:
+        VGFMA(2, r, a, b, c);
+        break;
+    default:
+        VGFMA(3, r, a, b, c);
+        break;
+    }
+}
+
+static void test_vgfm(void)
+{
+    S390Vector r, exp;
+    int i, j, es;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            const S390Vector *c = &inputs[(i + j) % NUM_INPUTS];
+
+            for (es = 0; es <= 3; es++) {
+                do_vgfm(&r, &inputs[i], &inputs[j], es);
+                ref_vgfm(&exp, &inputs[i], &inputs[j], NULL, es);
+                vx_check("vgfm", es, &r, &exp);
+                do_vgfma(&r, &inputs[i], &inputs[j], c, es);
+                ref_vgfm(&exp, &inputs[i], &inputs[j], c, es);
+                vx_check("vgfma", es, &r, &exp);
+            }
+        }
+    }
+}
+
+/* Rotate each element of v2 left by 5 and insert it under the mask v3 */
+#define VERIM(m5, r, a, b)                                      \
+    asm volatile("vl %%v18,%[vr]\n"                             \
+                 "vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 "verim %%v18,%%v16,%%v17,5,%[m]\n"             \
+                 "vst %%v18,%[vr]\n"                            \
+                 : [vr] "+Q" (*(r))                             \
+                 : [va] "Q" (*(a)), [vb] "Q" (*(b)), [m] "i" (m5) \
+                 : "v16", "v17", "v18")
+
+static void test_verim(void)
+{
+    S390Vector r, exp;
+    int i, j, k, es;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            for (es = 0; es <= 3; es++) {
+                r = inputs[(i + j) % NUM_INPUTS];
+                for (k = 0; k < NUM_ELEMENTS(es); k++) {
+                    const uint64_t rot = ref_verllv(vx_get(&inputs[i], es, k),
+                                                    5, es) & vx_mask(es);
+                    const uint64_t mask = vx_get(&inputs[j], es, k);
+
+                    vx_set(&exp, es, k,
+                           (vx_get(&r, es, k) & ~mask) | (rot & mask));
+                }
+                switch (es) {
+                case 0:
+                    VERIM(0, &r, &inputs[i], &inputs[j]);
+                    break;
+                case 1:
+                    VERIM(1, &r, &inputs[i], &inputs[j]);
+                    break;
+                case 2:
+                    VERIM(2, &r, &inputs[i], &inputs[j]);
+                    break;
+                default:
+                    VERIM(3, &r, &inputs[i], &inputs[j]);
+                    break;
+                }
+                vx_check("verim", es, &r, &exp);
+            }
+        }
+    }
+}
+
+#define VRR_C_NOM(insn, r, a, b)                                \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 insn " %%v18,%%v16,%%v17\n"                    \
+                 "vst %%v18,%[vr]\n"                            \
+                 : [vr] "=Q" (*(r))                             \
+                 : [va] "Q" (*(a)), [vb] "Q" (*(b))             \
+                 : "v16", "v17", "v18")
+
+static void test_logical(void)
+{
+    S390Vector r, exp;
+    int i, j, k;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        for (j = 0; j < NUM_INPUTS; j++) {
+            const uint64_t *a = inputs[i].d, *b = inputs[j].d;
+
+            VRR_C_NOM("vn", &r, &inputs[i], &inputs[j]);
+            for (k = 0; k < 2; k++) {
+                exp.d[k] = a[k] & b[k];
+            }
+            vx_check("vn", 3, &r, &exp);
+            VRR_C_NOM("vnc", &r, &inputs[i], &inputs[j]);
+            for (k = 0; k < 2; k++) {
+                exp.d[k] = a[k] & ~b[k];
+            }
+            vx_check("vnc", 3, &r, &exp);
+            VRR_C_NOM("vo", &r, &inputs[i], &inputs[j]);
+            for (k = 0; k < 2; k++) {
+                exp.d[k] = a[k] | b[k];
+            }
+            vx_check("vo", 3, &r, &exp);
+            VRR_C_NOM("vno", &r, &inputs[i], &inputs[j]);
+            for (k = 0; k < 2; k++) {
+                exp.d[k] = ~(a[k] | b[k]);
+            }
+            vx_check("vno", 3, &r, &exp);
+            VRR_C_NOM("vx", &r, &inputs[i], &inputs[j]);
+            for (k = 0; k < 2; k++) {
+                exp.d[k] = a[k] ^ b[k];
+            }
+            vx_check("vx", 3, &r, &exp);
+        }
+    }
+}
+
+int main(void)
+{
+    test_elementwise();
+    test_quadword();
+    test_pack();
+    test_sum();
+    test_vcksm();
+    test_vgfm();
+    test_verim();
+    test_logical();
+    return vx_errors ? 1 : 0;
+}
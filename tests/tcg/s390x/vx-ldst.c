@@ -0,0 +1,307 @@
+/*
+ * Vector load/store and element move instructions
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "vx.h"
+
+static const S390Vector src = {
+    .b = { 0x80, 0x01, 0x82, 0x03, 0x84, 0x05, 0x86, 0x07,
+           0x88, 0x09, 0x8a, 0x0b, 0x8c, 0x0d, 0x8e, 0x0f },
+};
+static const S390Vector ones = { .d = { -1ull, -1ull } };
+
+static void test_vl_vst(void)
+{
+    S390Vector r;
+
+    asm volatile("vl %%v16,%[va]\n"
+                 "vlr %%v17,%%v16\n"
+                 "vst %%v17,%[vr]\n"
+                 : [vr] "=Q" (r)
+                 : [va] "Q" (src)
+                 : "v16", "v17");
+    vx_check("vl/vlr/vst", 0, &r, &src);
+}
+
+static void test_vlm_vstm(void)
+{
+    S390Vector in[3] = { src, ones, { .d = { 1, 2 } } };
+    S390Vector out[3];
+    int i;
+
+    asm volatile("vlm %%v16,%%v18,%[in]\n"
+                 "vstm %%v16,%%v18,%[out]\n"
+                 : [out] "=Q" (out)
+                 : [in] "Q" (in)
+                 : "v16", "v17", "v18");
+    for (i = 0; i < 3; i++) {
+        vx_check("vlm/vstm", 0, &out[i], &in[i]);
+    }
+}
+
+static void test_vll_vstl(void)
+{
+    S390Vector r, exp;
+    uint64_t len;
+
+    for (len = 0; len < 18; len++) {
+        const int n = len > 15 ? 16 : len + 1;
+
+        memset(&exp, 0, sizeof(exp));
+        memcpy(&exp, &src, n);
+        asm volatile("vl %%v16,%[ones]\n"
+                     "vll %%v16,%[len],%[va]\n"
+                     "vst %%v16,%[vr]\n"
+                     : [vr] "=Q" (r)
+                     : [va] "Q" (src), [ones] "Q" (ones), [len] "d" (len)
+                     : "v16");
+        vx_check("vll", 0, &r, &exp);
+
+        r = ones;
+        memcpy(&exp, &src, n);
+        memcpy(&exp.b[n], &ones, 16 - n);
+        asm volatile("vl %%v16,%[va]\n"
+                     "vstl %%v16,%[len],%[vr]\n"
+                     : [vr] "+Q" (r)
+                     : [va] "Q" (src), [len] "d" (len)
+                     : "v16");
+        vx_check("vstl", 0, &r, &exp);
+    }
+}
+
+#define VLREP(m3, r, a)                                         \
+    asm volatile("vlrep %%v16,%[va],%[m]\n"                     \
+                 "vst %%v16,%[vr]\n"                            \
+                 : [vr] "=Q" (r)                                \
+                 : [va] "Q" (a), [m] "i" (m3)                   \
+                 : "v16")
+
+#define VLLEZ(m3, r, a)                                         \
+    asm volatile("vllez %%v16,%[va],%[m]\n"                     \
+                 "vst %%v16,%[vr]\n"                            \
+                 : [vr] "=Q" (r)                                \
+                 : [va] "Q" (a), [m] "i" (m3)                   \
+                 : "v16")
+
+static void test_vlrep_vllez(void)
+{
+    S390Vector r, exp;
+    int es, i;
+
+    for (es = 0; es <= 3; es++) {
+        const uint64_t elem = vx_get(&src, es, 0);
+
+        for (i = 0; i < NUM_ELEMENTS(es); i++) {
+            vx_set(&exp, es, i, elem);
+        }
+        switch (es) {
+        case 0:
+            VLREP(0, r, src);
+            break;
+        case 1:
+            VLREP(1, r, src);
+            break;
+        case 2:
+            VLREP(2, r, src);
+            break;
+        default:
+            VLREP(3, r, src);
+            break;
+        }
+        vx_check("vlrep", es, &r, &exp);
+
+        /* The element goes to the rightmost element of doubleword 0 */
+        memset(&exp, 0, sizeof(exp));
+        vx_set(&exp, es, NUM_ELEMENTS(es) / 2 - 1, elem);
+        switch (es) {
+        case 0:
+            VLLEZ(0, r, src);
+            break;
+        case 1:
+            VLLEZ(1, r, src);
+            break;
+        case 2:
+            VLLEZ(2, r, src);
+            break;
+        default:
+            VLLEZ(3, r, src);
+            break;
+        }
+        vx_check("vllez", es, &r, &exp);
+    }
+}
+
+static void test_vle_vste(void)
+{
+    S390Vector r, exp;
+    S390Vector mem = ones;
+
+    exp = ones;
+    exp.d[0] = src.d[0];
+    exp.w[1] = src.w[0];
+    exp.b[5] = src.b[0];
+    exp.h[6] = src.h[0];
+    asm volatile("vl %%v16,%[ones]\n"
+                 "vleg %%v16,%[va],0\n"
+                 "vlef %%v16,%[va],1\n"
+                 "vleb %%v16,%[va],5\n"
+                 "vleh %%v16,%[va],6\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r)
+                 : [va] "Q" (src), [ones] "Q" (ones)
+                 : "v16");
+    vx_check("vle", 0, &r, &exp);
+
+    exp = ones;
+    exp.b[0] = src.b[15];
+    exp.h[1] = src.h[7];
+    exp.w[1] = src.w[3];
+    exp.d[1] = src.d[1];
+    asm volatile("vl %%v16,%[va]\n"
+                 "vsteb %%v16,0(%[p]),15\n"
+                 "vsteh %%v16,2(%[p]),7\n"
+                 "vstef %%v16,4(%[p]),3\n"
+                 "vsteg %%v16,8(%[p]),1\n"
+                 :
+                 : [va] "Q" (src), [p] "a" (&mem)
+                 : "v16", "memory");
+    vx_check("vste", 0, &mem, &exp);
+}
+
+static void test_vlei(void)
+{
+    S390Vector r, exp = ones;
+
+    exp.b[0] = 0x81;
+    exp.b[1] = 0x7f;
+    exp.h[1] = 0xfffe;
+    exp.w[1] = 0xffff8000;
+    exp.d[1] = 0x7fff;
+    asm volatile("vl %%v16,%[ones]\n"
+                 "vleib %%v16,-127,0\n"
+                 "vleib %%v16,127,1\n"
+                 "vleih %%v16,-2,1\n"
+                 "vleif %%v16,-32768,1\n"
+                 "vleig %%v16,32767,1\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r)
+                 : [ones] "Q" (ones)
+                 : "v16");
+    vx_check("vlei", 0, &r, &exp);
+}
+
+static void test_vlgv_vlvg(void)
+{
+    S390Vector r, exp;
+    uint64_t val, x = 0x1122334455667788ull;
+    int es, i;
+
+    for (es = 0; es <= 3; es++) {
+        for (i = 0; i < NUM_ELEMENTS(es); i++) {
+            /* The element number is taken from the address, modulo */
+            const uint64_t idx = i + NUM_ELEMENTS(es);
+
+            switch (es) {
+            case 0:
+                asm volatile("vl %%v16,%[va]\n"
+                             "vlgvb %[val],%%v16,0(%[idx])\n"
+                             "vlvgb %%v16,%[x],0(%[idx])\n"
+                             "vst %%v16,%[vr]\n"
+                             : [vr] "=Q" (r), [val] "=&d" (val)
+                             : [va] "Q" (src), [idx] "a" (idx), [x] "d" (x)
+                             : "v16");
+                break;
+            case 1:
+                asm volatile("vl %%v16,%[va]\n"
+                             "vlgvh %[val],%%v16,0(%[idx])\n"
+                             "vlvgh %%v16,%[x],0(%[idx])\n"
+                             "vst %%v16,%[vr]\n"
+                             : [vr] "=Q" (r), [val] "=&d" (val)
+                             : [va] "Q" (src), [idx] "a" (idx), [x] "d" (x)
+                             : "v16");
+                break;
+            case 2:
+                asm volatile("vl %%v16,%[va]\n"
+                             "vlgvf %[val],%%v16,0(%[idx])\n"
+                             "vlvgf %%v16,%[x],0(%[idx])\n"
+                             "vst %%v16,%[vr]\n"
+                             : [vr] "=Q" (r), [val] "=&d" (val)
+                             : [va] "Q" (src), [idx] "a" (idx), [x] "d" (x)
+                             : "v16");
+                break;
+            default:
+                asm volatile("vl %%v16,%[va]\n"
+                             "vlgvg %[val],%%v16,0(%[idx])\n"
+                             "vlvgg %%v16,%[x],0(%[idx])\n"
+                             "vst %%v16,%[vr]\n"
+                             : [vr] "=Q" (r), [val] "=&d" (val)
+                             : [va] "Q" (src), [idx] "a" (idx), [x] "d" (x)
+                             : "v16");
+                break;
+            }
+            if (val != vx_get(&src, es, i)) {
+                printf("vlgv (es %d): element %d is %llx\n", es, i,
+                       (unsigned long long)val);
+                vx_errors++;
+            }
+            exp = src;
+            vx_set(&exp, es, i, x);
+            vx_check("vlvg", es, &r, &exp);
+        }
+    }
+
+    exp.d[0] = x;
+    exp.d[1] = ~x;
+    asm volatile("vlvgp %%v16,%[x],%[y]\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r)
+                 : [x] "d" (x), [y] "d" (~x)
+                 : "v16");
+    vx_check("vlvgp", 3, &r, &exp);
+}
+
+static void test_generate(void)
+{
+    const S390Vector gbm = {
+        .b = { 0xff, 0, 0, 0, 0, 0, 0, 0xff, 0, 0xff, 0, 0, 0, 0, 0, 0 },
+    };
+    const S390Vector gm = { .w = { 0x00fff000, 0x00fff000,
+                                   0x00fff000, 0x00fff000 } };
+    const S390Vector gm_wrap = { .h = { 0xe007, 0xe007, 0xe007, 0xe007,
+                                        0xe007, 0xe007, 0xe007, 0xe007 } };
+    const S390Vector repi = { .h = { 0xff85, 0xff85, 0xff85, 0xff85,
+                                     0xff85, 0xff85, 0xff85, 0xff85 } };
+    S390Vector r;
+
+    asm volatile("vgbm %%v16,0x8140\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r) : : "v16");
+    vx_check("vgbm", 0, &r, &gbm);
+    asm volatile("vgm %%v16,8,19,2\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r) : : "v16");
+    vx_check("vgm", 2, &r, &gm);
+    asm volatile("vgm %%v16,13,2,1\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r) : : "v16");
+    vx_check("vgm wrap", 1, &r, &gm_wrap);
+    asm volatile("vrepi %%v16,-123,1\n"
+                 "vst %%v16,%[vr]\n"
+                 : [vr] "=Q" (r) : : "v16");
+    vx_check("vrepi", 1, &r, &repi);
+}
+
+int main(void)
+{
+    test_vl_vst();
+    test_vlm_vstm();
+    test_vll_vstl();
+    test_vlrep_vllez();
+    test_vle_vste();
+    test_vlei();
+    test_vlgv_vlvg();
+    test_generate();
+    return vx_errors ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Vector string instructions
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "vx.h"
+
+/* Flags of the M5/M6 field */
+#define IN  8
+#define RT  4
+#define ZS  2
+#define CS  1
+
+#define VRR_B(insn, m4, m5, r, a, b, cc)                        \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 insn " %%v18,%%v16,%%v17,%[m],%[f]\n"          \
+                 "vst %%v18,%[vr]\n"                            \
+                 "ipm %[cc]\n"                                  \
+                 "srl %[cc],28\n"                               \
+                 : [vr] "=Q" (r), [cc] "=d" (cc)                \
+                 : [va] "Q" (a), [vb] "Q" (b),                  \
+                   [m] "i" (m4), [f] "i" (m5)                   \
+                 : "v16", "v17", "v18", "cc")
+
+#define VISTR(m3, r, a, cc)                                     \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vistr %%v18,%%v16,%[m],1\n"                   \
+                 "vst %%v18,%[vr]\n"                            \
+                 "ipm %[cc]\n"                                  \
+                 "srl %[cc],28\n"                               \
+                 : [vr] "=Q" (r), [cc] "=d" (cc)                \
+                 : [va] "Q" (a), [m] "i" (m3)                   \
+                 : "v16", "v18", "cc")
+
+#define VSTRC(m6, r, a, b, c, cc)                               \
+    asm volatile("vl %%v16,%[va]\n"                             \
+                 "vl %%v17,%[vb]\n"                             \
+                 "vl %%v19,%[vc]\n"                             \
+                 "vstrc %%v18,%%v16,%%v17,%%v19,0,%[f]\n"       \
+                 "vst %%v18,%[vr]\n"                            \
+                 "ipm %[cc]\n"                                  \
+                 "srl %[cc],28\n"                               \
+                 : [vr] "=Q" (r), [cc] "=d" (cc)                \
+                 : [va] "Q" (a), [vb] "Q" (b), [vc] "Q" (c),    \
+                   [f] "i" (m6)                                 \
+                 : "v16", "v17", "v18", "v19", "cc")
+
+/* The search instructions return a byte index in byte 7 */
+static void check_index(const char *name, int es, const S390Vector *r,
+                        int cc, uint64_t index, int exp_cc)
+{
+    const S390Vector exp = { .d = { index, 0 } };
+
+    vx_check(name, es, r, &exp);
+    vx_check_cc(name, es, cc, exp_cc);
+}
+
+static void test_vfee(void)
+{
+    const S390Vector a = { .b = "abcdefghijklmnop" };
+    const S390Vector az = { .b = "abc\0efghijklmnop" };
+    const S390Vector e = { .b = "xxxxexxxxxxxxxxx" };
+    const S390Vector ea = { .b = "axxxexxxxxxxxxxx" };
+    const S390Vector x = { .b = "xxxxxxxxxxxxxxxx" };
+    const S390Vector h = { .h = { 1, 2, 3, 4, 5, 6, 7, 8 } };
+    const S390Vector h6 = { .h = { 0, 0, 0, 0, 0, 6, 0, 0 } };
+    S390Vector r;
+    int cc;
+
+    VRR_B("vfee", 0, CS, r, a, e, cc);
+    check_index("vfee", 0, &r, cc, 4, 1);
+    VRR_B("vfee", 0, ZS | CS, r, a, e, cc);
+    check_index("vfee zs", 0, &r, cc, 4, 1);
+    VRR_B("vfee", 0, ZS | CS, r, az, e, cc);
+    check_index("vfee zs", 0, &r, cc, 3, 0);
+    VRR_B("vfee", 0, ZS | CS, r, az, ea, cc);
+    check_index("vfee zs", 0, &r, cc, 0, 2);
+    VRR_B("vfee", 0, CS, r, a, x, cc);
+    check_index("vfee", 0, &r, cc, 16, 3);
+    VRR_B("vfee", 1, CS, r, h, h6, cc);
+    check_index("vfee", 1, &r, cc, 10, 1);
+}
+
+static void test_vfene(void)
+{
+    const S390Vector a = { .b = "abcdefghijklmnop" };
+    const S390Vector az = { .b = "abc\0efghijklmnop" };
+    const S390Vector hi = { .b = "abcdefgzijklmnop" };
+    const S390Vector lo = { .b = "abcdefgaijklmnop" };
+    const S390Vector azhi = { .b = "abc\0efgzijklmnop" };
+    S390Vector r;
+    int cc;
+
+    VRR_B("vfene", 0, CS, r, a, hi, cc);
+    check_index("vfene", 0, &r, cc, 7, 1);
+    VRR_B("vfene", 0, CS, r, a, lo, cc);
+    check_index("vfene", 0, &r, cc, 7, 2);
+    VRR_B("vfene", 0, CS, r, a, a, cc);
+    check_index("vfene", 0, &r, cc, 16, 3);
+    VRR_B("vfene", 0, ZS | CS, r, az, azhi, cc);
+    check_index("vfene zs", 0, &r, cc, 3, 0);
+}
+
+static void test_vfae(void)
+{
+    const S390Vector a = { .b = "abcdefghijklmnop" };
+    const S390Vector az = { .b = "abc\0efghijklmnop" };
+    const S390Vector set = { .b = "zyxkzzzzzzzzzzzz" };
+    const S390Vector b = { .b = "bbbbbbbbbbbbbbbb" };
+    const S390Vector z = { .b = "zzzzzzzzzzzzzzzz" };
+    const S390Vector mask = { .b = { [10] = 0xff } };
+    S390Vector r;
+    int cc;
+
+    VRR_B("vfae", 0, CS, r, a, set, cc);
+    check_index("vfae", 0, &r, cc, 10, 1);
+    VRR_B("vfae", 0, RT | CS, r, a, set, cc);
+    vx_check("vfae rt", 0, &r, &mask);
+    vx_check_cc("vfae rt", 0, cc, 1);
+    VRR_B("vfae", 0, IN | CS, r, a, set, cc);
+    check_index("vfae in", 0, &r, cc, 0, 1);
+    VRR_B("vfae", 0, ZS | CS, r, az, set, cc);
+    check_index("vfae zs", 0, &r, cc, 3, 0);
+    VRR_B("vfae", 0, ZS | CS, r, az, b, cc);
+    check_index("vfae zs", 0, &r, cc, 1, 2);
+    VRR_B("vfae", 0, CS, r, a, z, cc);
+    check_index("vfae", 0, &r, cc, 16, 3);
+}
+
+static void test_vistr(void)
+{
+    const S390Vector a = { .b = "abcdefghijklmnop" };
+    const S390Vector az = { .b = "abc\0efghijklmnop" };
+    const S390Vector az_exp = { .b = "abc" };
+    const S390Vector h = { .h = { 1, 2, 0, 4, 5, 6, 7, 8 } };
+    const S390Vector h_exp = { .h = { 1, 2 } };
+    S390Vector r;
+    int cc;
+
+    VISTR(0, r, az, cc);
+    vx_check("vistr", 0, &r, &az_exp);
+    vx_check_cc("vistr", 0, cc, 0);
+    VISTR(0, r, a, cc);
+    vx_check("vistr", 0, &r, &a);
+    vx_check_cc("vistr", 0, cc, 3);
+    VISTR(1, r, h, cc);
+    vx_check("vistr", 1, &r, &h_exp);
+    vx_check_cc("vistr", 1, cc, 0);
+}
+
+static void test_vstrc(void)
+{
+    /* One range, 'a' <= x <= 'z'; the other pairs never match */
+    const S390Vector range = { .b = { 'a', 'z' } };
+    const S390Vector ctrl = { .b = { 0xa0, 0xc0 } };
+    const S390Vector a = { .b = "ABCdefGHIJKLMNOP" };
+    const S390Vector az = { .b = "AB\0defGHIJKLMNOP" };
+    const S390Vector upper = { .b = "ABCDEFGHIJKLMNOP" };
+    const S390Vector mask = { .b = { [3] = 0xff, [4] = 0xff, [5] = 0xff } };
+    S390Vector r;
+    int cc;
+
+    VSTRC(CS, r, a, range, ctrl, cc);
+    check_index("vstrc", 0, &r, cc, 3, 1);
+    VSTRC(RT | CS, r, a, range, ctrl, cc);
+    vx_check("vstrc rt", 0, &r, &mask);
+    vx_check_cc("vstrc rt", 0, cc, 1);
+    VSTRC(IN | CS, r, a, range, ctrl, cc);
+    check_index("vstrc in", 0, &r, cc, 0, 1);
+    VSTRC(ZS | CS, r, az, range, ctrl, cc);
+    check_index("vstrc zs", 0, &r, cc, 2, 0);
+    VSTRC(CS, r, upper, range, ctrl, cc);
+    check_index("vstrc", 0, &r, cc, 16, 3);
+}
+
+int main(void)
+{
+    test_vfee();
+    test_vfene();
+    test_vfae();
+    test_vistr();
+    test_vstrc();
+    return vx_errors ? 1 : 0;
+}
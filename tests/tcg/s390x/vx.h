@@ -0,0 +1,91 @@
+/*
+ * Helpers shared by the s390x vector facility tests
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#ifndef TESTS_TCG_S390X_VX_H
+#define TESTS_TCG_S390X_VX_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Element i of each array is vector element i, the host is big endian */
+typedef union S390Vector {
+    uint64_t d[2];
+    uint32_t w[4];
+    uint16_t h[8];
+    uint8_t b[16];
+} S390Vector;
+
+#define NUM_ELEMENTS(es)    (16 >> (es))
+#define ELEMENT_BITS(es)    (8 << (es))
+
+static inline uint64_t vx_mask(int es)
+{
+    return es == 3 ? -1ull : (1ull << ELEMENT_BITS(es)) - 1;
+}
+
+static inline int64_t vx_sext(uint64_t x, int es)
+{
+    const int shift = 64 - ELEMENT_BITS(es);
+
+    return (int64_t)(x << shift) >> shift;
+}
+
+static inline uint64_t vx_get(const S390Vector *v, int es, int i)
+{
+    switch (es) {
+    case 0:
+        return v->b[i];
+    case 1:
+        return v->h[i];
+    case 2:
+        return v->w[i];
+    default:
+        return v->d[i];
+    }
+}
+
+static inline void vx_set(S390Vector *v, int es, int i, uint64_t x)
+{
+    switch (es) {
+    case 0:
+        v->b[i] = x;
+        break;
+    case 1:
+        v->h[i] = x;
+        break;
+    case 2:
+        v->w[i] = x;
+        break;
+    default:
+        v->d[i] = x;
+        break;
+    }
+}
+
+static int vx_errors;
+
+static void vx_check(const char *name, int es, const S390Vector *res,
+                     const S390Vector *exp)
+{
+    if (memcmp(res, exp, sizeof(*res))) {
+        printf("%s (es %d): got %016llx%016llx, expected %016llx%016llx\n",
+               name, es,
+               (unsigned long long)res->d[0], (unsigned long long)res->d[1],
+               (unsigned long long)exp->d[0], (unsigned long long)exp->d[1]);
+        vx_errors++;
+    }
+}
+
+static void vx_check_cc(const char *name, int es, int cc, int exp)
+{
+    if (cc != exp) {
+        printf("%s (es %d): got cc %d, expected cc %d\n", name, es, cc, exp);
+        vx_errors++;
+    }
+}
+
+#endif /* TESTS_TCG_S390X_VX_H */
@@ -0,0 +1,533 @@
+/*
+ *  x86 AVX/AVX2 test - checks the VEX.128 and VEX.256 forms of integer,
+ *  logical, shift, shuffle, insert and gather instructions against values
+ *  computed in C, including the zeroing of bits 255:128 by the VEX.128
+ *  forms and the precise exceptions of the inserts.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+typedef union {
+    uint8_t b[32];
+    int8_t sb[32];
+    uint16_t w[16];
+    int16_t sw[16];
+    uint32_t d[8];
+    int32_t sd[8];
+    uint64_t q[4];
+    int64_t sq[4];
+    double f64[4];
+    float f32[8];
+} __attribute__((aligned(32))) V256;
+
+#define NB_INPUTS 12
+
+static V256 inputs[NB_INPUTS];
+static V256 dirty;
+static int failures;
+
+static void init_inputs(void)
+{
+    static const uint8_t edges[] = { 0x00, 0x01, 0x7f, 0x80, 0x81, 0xff };
+    uint32_t seed = 0x12345678;
+    int i, j;
+
+    /* Saturation and sign edge cases in every lane size, then noise.  */
+    for (i = 0; i < ARRAY_SIZE(edges); i++) {
+        for (j = 0; j < 32; j++) {
+            inputs[i].b[j] = (j & 1) ? edges[i] : edges[(i + j) % 6];
+        }
+    }
+    for (; i < NB_INPUTS; i++) {
+        for (j = 0; j < 32; j++) {
+            seed = seed * 1103515245 + 12345;
+            inputs[i].b[j] = seed >> 16;
+        }
+    }
+    /* What the destination holds before each instruction */
+    memset(&dirty, 0xa5, sizeof(dirty));
+}
+
+static void dump(const char *name, const V256 *v)
+{
+    int i;
+
+    printf("  %s:", name);
+    for (i = 31; i >= 0; i--) {
+        printf(" %02x", v->b[i]);
+    }
+    printf("\n");
+}
+
+static void check(const char *insn, const char *form, const V256 *a,
+                  const V256 *b, const V256 *r, const V256 *e)
+{
+    if (!memcmp(r, e, sizeof(*r))) {
+        return;
+    }
+    failures++;
+    printf("FAIL %s (%s)\n", insn, form);
+    dump("a", a);
+    if (b) {
+        dump("b", b);
+    }
+    dump("got", r);
+    dump("expected", e);
+}
+
+static int sat(int x, int min, int max)
+{
+    return x < min ? min : x > max ? max : x;
+}
+
+/*
+ * dest = ymm0, which holds garbage beforehand, first source = ymm1 (A),
+ * second source = ymm2 (B) or memory.
+ */
+#define XMM_OP(insn, r, a, b)                                   \
+    asm volatile("vmovdqu %3, %%ymm0\n\t"                       \
+                 "vmovdqu %1, %%ymm1\n\t"                       \
+                 "vmovdqu %2, %%ymm2\n\t"                       \
+                 insn " %%xmm2, %%xmm1, %%xmm0\n\t"             \
+                 "vmovdqu %%ymm0, %0"                           \
+                 : "=m" (r) : "m" (a), "m" (b), "m" (dirty)     \
+                 : "xmm0", "xmm1", "xmm2")
+
+#define XMM_OP_MEM(insn, r, a, b)                               \
+    asm volatile("vmovdqu %3, %%ymm0\n\t"                       \
+                 "vmovdqu %1, %%ymm1\n\t"                       \
+                 insn " %2, %%xmm1, %%xmm0\n\t"                 \
+                 "vmovdqu %%ymm0, %0"                           \
+                 : "=m" (r) : "m" (a), "m" (b), "m" (dirty)     \
+                 : "xmm0", "xmm1")
+
+#define YMM_OP(insn, r, a, b)                                   \
+    asm volatile("vmovdqu %3, %%ymm0\n\t"                       \
+                 "vmovdqu %1, %%ymm1\n\t"                       \
+                 "vmovdqu %2, %%ymm2\n\t"                       \
+                 insn " %%ymm2, %%ymm1, %%ymm0\n\t"             \
+                 "vmovdqu %%ymm0, %0"                           \
+                 : "=m" (r) : "m" (a), "m" (b), "m" (dirty)     \
+                 : "xmm0", "xmm1", "xmm2")
+
+#define YMM_OP_MEM(insn, r, a, b)                               \
+    asm volatile("vmovdqu %3, %%ymm0\n\t"                       \
+                 "vmovdqu %1, %%ymm1\n\t"                       \
+                 insn " %2, %%ymm1, %%ymm0\n\t"                 \
+                 "vmovdqu %%ymm0, %0"                           \
+                 : "=m" (r) : "m" (a), "m" (b), "m" (dirty)     \
+                 : "xmm0", "xmm1")
+
+/*
+ * Run INSN on every pair of inputs, and compare with EXPR evaluated on the
+ * lanes X and Y of field F of both inputs.  The VEX.128 forms (L = 0) must
+ * zero bits 255:128 of the destination.
+ */
+#define TEST_BIN(OP, l, insn, f, expr)                                  \
+    do {                                                                \
+        int i_, j_, k_;                                                 \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (j_ = 0; j_ < NB_INPUTS; j_++) {                        \
+                const V256 *a = &inputs[i_], *b = &inputs[j_];          \
+                V256 r, e;                                              \
+                memset(&e, 0, sizeof(e));                               \
+                OP(insn, r, *a, *b);                                    \
+                for (k_ = 0; k_ < (16 << l) / sizeof(e.f[0]); k_++) {   \
+                    __typeof__(e.f[0]) x = a->f[k_], y = b->f[k_];      \
+                    e.f[k_] = (expr);                                   \
+                }                                                       \
+                check(insn, #OP, a, b, &r, &e);                         \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define TEST_AVX(insn, f, expr)                                         \
+    do {                                                                \
+        TEST_BIN(XMM_OP, 0, insn, f, expr);                             \
+        TEST_BIN(XMM_OP_MEM, 0, insn, f, expr);                         \
+        TEST_BIN(YMM_OP, 1, insn, f, expr);                             \
+        TEST_BIN(YMM_OP_MEM, 1, insn, f, expr);                         \
+    } while (0)
+
+/* Shifts by an immediate of ymm1 (X) into ymm0 */
+#define SHIFT_OP(insn, imm, reg, r, a)                                  \
+    asm volatile("vmovdqu %2, %%ymm0\n\t"                               \
+                 "vmovdqu %1, %%ymm1\n\t"                               \
+                 insn " $" #imm ", %%" reg "1, %%" reg "0\n\t"          \
+                 "vmovdqu %%ymm0, %0"                                   \
+                 : "=m" (r) : "m" (*a), "m" (dirty) : "xmm0", "xmm1")
+
+#define TEST_SHIFT(insn, imm, f, expr)                                  \
+    do {                                                                \
+        int i_, k_, l_;                                                 \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (l_ = 0; l_ < 2; l_++) {                                \
+                const V256 *a = &inputs[i_];                            \
+                V256 r, e;                                              \
+                memset(&e, 0, sizeof(e));                               \
+                if (l_) {                                               \
+                    SHIFT_OP(insn, imm, "ymm", r, a);                   \
+                } else {                                                \
+                    SHIFT_OP(insn, imm, "xmm", r, a);                   \
+                }                                                       \
+                for (k_ = 0; k_ < (16 << l_) / sizeof(e.f[0]); k_++) {  \
+                    __typeof__(e.f[0]) x = a->f[k_];                    \
+                    (void)x;                                            \
+                    e.f[k_] = (expr);                                   \
+                }                                                       \
+                check(insn " $" #imm, l_ ? "ymm" : "xmm", a, NULL,      \
+                      &r, &e);                                          \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+/* Shuffles within each 128-bit lane, of N elements starting at LO */
+#define TEST_SHUF(insn, imm, f, n, lo, hi)                              \
+    do {                                                                \
+        int i_, k_, l_, base_;                                          \
+        for (i_ = 0; i_ < NB_INPUTS; i_++) {                            \
+            for (l_ = 0; l_ < 2; l_++) {                                \
+                const V256 *a = &inputs[i_];                            \
+                V256 r, e = *a;                                         \
+                if (l_) {                                               \
+                    SHIFT_OP(insn, imm, "ymm", r, a);                   \
+                } else {                                                \
+                    SHIFT_OP(insn, imm, "xmm", r, a);                   \
+                    memset(&e.b[16], 0, 16);                            \
+                }                                                       \
+                for (base_ = 0; base_ < n << l_; base_ += n) {          \
+                    for (k_ = lo; k_ < hi; k_++) {                      \
+                        e.f[base_ + k_] = a->f[base_ + lo +             \
+                            ((imm >> ((k_ - lo) * 2)) & 3)];            \
+                    }                                                   \
+                }                                                       \
+                check(insn " $" #imm, l_ ? "ymm" : "xmm", a, NULL,      \
+                      &r, &e);                                          \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+static void test_results(void)
+{
+    /* Expanded inline */
+    TEST_AVX("vpaddb", b, x + y);
+    TEST_AVX("vpaddw", w, x + y);
+    TEST_AVX("vpaddd", d, x + y);
+    TEST_AVX("vpaddq", q, x + y);
+    TEST_AVX("vpaddsb", sb, sat(x + y, INT8_MIN, INT8_MAX));
+    TEST_AVX("vpaddusw", w, sat(x + y, 0, UINT16_MAX));
+    TEST_AVX("vpsubb", b, x - y);
+    TEST_AVX("vpsubq", q, x - y);
+    TEST_AVX("vpsubsw", sw, sat(x - y, INT16_MIN, INT16_MAX));
+    TEST_AVX("vpsubusb", b, sat(x - y, 0, UINT8_MAX));
+    TEST_AVX("vpmullw", sw, x * y);
+    TEST_AVX("vpcmpeqb", b, x == y ? -1 : 0);
+    TEST_AVX("vpcmpeqd", d, x == y ? -1 : 0);
+    TEST_AVX("vpcmpgtw", sw, x > y ? -1 : 0);
+    TEST_AVX("vpcmpgtd", sd, x > y ? -1 : 0);
+    TEST_AVX("vpand", q, x & y);
+    TEST_AVX("vpandn", q, ~x & y);
+    TEST_AVX("vpor", q, x | y);
+    TEST_AVX("vpxor", q, x ^ y);
+    TEST_AVX("vandps", q, x & y);
+    TEST_AVX("vxorpd", q, x ^ y);
+
+    /* Run through the SSE helpers, one lane at a time */
+    TEST_AVX("vpavgb", b, (x + y + 1) >> 1);
+    TEST_AVX("vpminub", b, x < y ? x : y);
+    TEST_AVX("vpmaxsw", sw, x > y ? x : y);
+    TEST_AVX("vpmaxsd", sd, x > y ? x : y);
+    TEST_AVX("vpminud", d, x < y ? x : y);
+
+    TEST_SHIFT("vpsrlw", 3, w, x >> 3);
+    TEST_SHIFT("vpsrlw", 16, w, 0);
+    TEST_SHIFT("vpsraw", 15, sw, x >> 15);
+    TEST_SHIFT("vpsraw", 200, sw, x >> 15);
+    TEST_SHIFT("vpsllw", 9, w, x << 9);
+    TEST_SHIFT("vpsrld", 31, d, x >> 31);
+    TEST_SHIFT("vpsrad", 7, sd, x >> 7);
+    TEST_SHIFT("vpslld", 32, d, 0);
+    TEST_SHIFT("vpsrlq", 63, q, x >> 63);
+    TEST_SHIFT("vpsllq", 1, q, x << 1);
+
+    TEST_SHUF("vpshufd", 0x1b, d, 4, 0, 4);
+    TEST_SHUF("vpshufd", 0xe4, d, 4, 0, 4);
+    TEST_SHUF("vpshuflw", 0x1b, w, 8, 0, 4);
+    TEST_SHUF("vpshufhw", 0xa0, w, 8, 4, 8);
+}
+
+/* Legacy SSE leaves bits 255:128 alone, vzeroupper clears them */
+static void test_upper(void)
+{
+    const V256 *a = &inputs[6], *b = &inputs[7];
+    V256 r, e;
+    int k;
+
+    asm volatile("vmovdqu %1, %%ymm0\n\t"
+                 "movdqu %2, %%xmm1\n\t"
+                 "paddb %%xmm1, %%xmm0\n\t"
+                 "vmovdqu %%ymm0, %0"
+                 : "=m" (r) : "m" (*a), "m" (*b) : "xmm0", "xmm1");
+    e = *a;
+    for (k = 0; k < 16; k++) {
+        e.b[k] = a->b[k] + b->b[k];
+    }
+    check("paddb", "sse", a, b, &r, &e);
+
+    asm volatile("vmovdqu %1, %%ymm0\n\t"
+                 "vzeroupper\n\t"
+                 "vmovdqu %%ymm0, %0"
+                 : "=m" (r) : "m" (*a) : "xmm0");
+    e = *a;
+    memset(&e.b[16], 0, 16);
+    check("vzeroupper", "ymm", a, NULL, &r, &e);
+}
+
+/*
+ * Inserts and conversions into the low element, merged with ymm1 (A) into
+ * ymm0, from a register or from memory.
+ */
+#define INSERT(insn, r, a, src, dst)                                    \
+    do {                                                                \
+        uint64_t v_ = src;                                              \
+        asm volatile("vmovdqu %2, %%ymm0\n\t"                           \
+                     "vmovdqu %1, %%ymm1\n\t"                           \
+                     insn "\n\t"                                        \
+                     "vmovdqu %%ymm0, %0"                               \
+                     : "=m" (r) : "m" (*a), "m" (dirty), "r" (v_),      \
+                       "m" (v_)                                         \
+                     : "xmm0", "xmm1");                                 \
+        e = *a;                                                         \
+        memset(&e.b[16], 0, 16);                                        \
+        dst;                                                            \
+        check(insn, "xmm", a, NULL, &r, &e);                            \
+    } while (0)
+
+static void test_insert(void)
+{
+    const uint64_t x = 0x8123456789abcdefull;
+    int i;
+
+    for (i = 0; i < NB_INPUTS; i++) {
+        const V256 *a = &inputs[i];
+        V256 r, e;
+
+        INSERT("vpinsrb $13, %k3, %%xmm1, %%xmm0", r, a, x,
+               e.b[13] = x);
+        INSERT("vpinsrb $2, %4, %%xmm1, %%xmm0", r, a, x,
+               e.b[2] = x);
+        INSERT("vpinsrw $5, %k3, %%xmm1, %%xmm0", r, a, x,
+               e.w[5] = x);
+        INSERT("vpinsrw $0, %4, %%xmm1, %%xmm0", r, a, x,
+               e.w[0] = x);
+        INSERT("vpinsrd $2, %k3, %%xmm1, %%xmm0", r, a, x,
+               e.d[2] = x);
+        INSERT("vpinsrd $3, %4, %%xmm1, %%xmm0", r, a, x,
+               e.d[3] = x);
+        INSERT("vpinsrq $1, %3, %%xmm1, %%xmm0", r, a, x,
+               e.q[1] = x);
+        INSERT("vpinsrq $0, %4, %%xmm1, %%xmm0", r, a, x,
+               e.q[0] = x);
+        INSERT("vcvtsi2sdl %k3, %%xmm1, %%xmm0", r, a, x,
+               e.f64[0] = (int32_t)x);
+        INSERT("vcvtsi2sdq %4, %%xmm1, %%xmm0", r, a, x,
+               e.f64[0] = (int64_t)x);
+        INSERT("vcvtsi2ssl %4, %%xmm1, %%xmm0", r, a, 1000,
+               e.f32[0] = 1000);
+        INSERT("vcvtsi2ssq %3, %%xmm1, %%xmm0", r, a, -77,
+               e.f32[0] = -77);
+    }
+}
+
+static sigjmp_buf fault_env;
+static uint8_t fault_xmm0[16];
+
+static void segv_handler(int sig, siginfo_t *info, void *puc)
+{
+    ucontext_t *uc = puc;
+
+    memcpy(fault_xmm0, &uc->uc_mcontext.fpregs->_xmm[0], 16);
+    siglongjmp(fault_env, 1);
+}
+
+/* A faulting load must leave the destination as it was */
+#define FAULT(insn, a, b, p)                                            \
+    do {                                                                \
+        if (sigsetjmp(fault_env, 1) == 0) {                             \
+            asm volatile("vmovdqu %0, %%xmm0\n\t"                       \
+                         "vmovdqu %1, %%xmm1\n\t"                       \
+                         insn " (%2), %%xmm1, %%xmm0"                   \
+                         : : "m" (*a), "m" (*b), "r" (p)                \
+                         : "xmm0", "xmm1", "memory");                   \
+            printf("FAIL %s did not fault\n", insn);                    \
+            failures++;                                                 \
+        } else if (memcmp(fault_xmm0, a, 16)) {                         \
+            printf("FAIL %s changed its destination\n", insn);          \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static void test_fault(void)
+{
+    struct sigaction act, old;
+    void *p;
+
+    p = mmap(NULL, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        failures++;
+        return;
+    }
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = segv_handler;
+    act.sa_flags = SA_SIGINFO;
+    sigaction(SIGSEGV, &act, &old);
+
+    FAULT("vpinsrb $1,", &inputs[6], &inputs[7], p);
+    FAULT("vpinsrw $1,", &inputs[6], &inputs[7], p);
+    FAULT("vpinsrd $1,", &inputs[6], &inputs[7], p);
+    FAULT("vpinsrq $1,", &inputs[6], &inputs[7], p);
+    FAULT("vcvtsi2sdl", &inputs[6], &inputs[7], p);
+    FAULT("vcvtsi2ssq", &inputs[6], &inputs[7], p);
+
+    sigaction(SIGSEGV, &old, NULL);
+    munmap(p, 4096);
+}
+
+/*
+ * Gathers: the elements whose mask element is negative are loaded, the
+ * others keep the value the destination had, the mask is cleared and so
+ * is the destination above the result.
+ */
+static uint8_t table[512];
+
+#define GATHER(insn, dreg, ireg, scale, r, rm, d, i, m)                 \
+    asm volatile("vmovdqu %2, %%ymm0\n\t"                               \
+                 "vmovdqu %3, %%ymm1\n\t"                               \
+                 "vmovdqu %4, %%ymm2\n\t"                               \
+                 insn " %%" dreg "2, (%5,%%" ireg "1," #scale "), %%"   \
+                 dreg "0\n\t"                                           \
+                 "vmovdqu %%ymm0, %0\n\t"                               \
+                 "vmovdqu %%ymm2, %1"                                   \
+                 : "=m" (r), "=m" (rm)                                  \
+                 : "m" (d), "m" (i), "m" (m), "r" (&table[256])         \
+                 : "xmm0", "xmm1", "xmm2", "memory")
+
+static void ref_gather(V256 *e, const V256 *d, const V256 *idx,
+                       const V256 *mask, int osz, int isz, int l)
+{
+    int n = (16 << l) / (osz > isz ? osz : isz);
+    int i;
+
+    memset(e, 0, sizeof(*e));
+    for (i = 0; i < n; i++) {
+        int64_t index = isz == 4 ? idx->sd[i] : idx->sq[i];
+        int sign = osz == 4 ? mask->sd[i] < 0 : mask->sq[i] < 0;
+
+        if (sign) {
+            memcpy(&e->b[i * osz], &table[256 + index * osz], osz);
+        } else {
+            memcpy(&e->b[i * osz], &d->b[i * osz], osz);
+        }
+    }
+}
+
+static void test_gather(void)
+{
+    static const int32_t idx32[8] = { -20, 0, 5, 17, -3, 30, 1, 9 };
+    V256 idx_d, idx_q, masks[3], r, rm, e, zero;
+    int i, j;
+
+    for (i = 0; i < sizeof(table); i++) {
+        table[i] = i * 7 + 3;
+    }
+    for (i = 0; i < 8; i++) {
+        idx_d.sd[i] = idx32[i];
+    }
+    for (i = 0; i < 4; i++) {
+        idx_q.sq[i] = idx32[7 - i];
+    }
+    memset(&masks[0], 0xff, sizeof(V256));
+    memset(&masks[1], 0, sizeof(V256));
+    for (i = 0; i < 32; i++) {
+        masks[2].b[i] = (i >> 2) % 3 == 1 ? 0x80 : 0x7f;
+    }
+    memset(&zero, 0, sizeof(zero));
+
+    for (j = 0; j < ARRAY_SIZE(masks); j++) {
+        const V256 *d = &inputs[6 + j], *m = &masks[j];
+
+        GATHER("vpgatherdd", "xmm", "xmm", 4, r, rm, *d, idx_d, *m);
+        ref_gather(&e, d, &idx_d, m, 4, 4, 0);
+        check("vpgatherdd", "xmm", d, m, &r, &e);
+        check("vpgatherdd mask", "xmm", d, m, &rm, &zero);
+        GATHER("vpgatherdd", "ymm", "ymm", 4, r, rm, *d, idx_d, *m);
+        ref_gather(&e, d, &idx_d, m, 4, 4, 1);
+        check("vpgatherdd", "ymm", d, m, &r, &e);
+        check("vpgatherdd mask", "ymm", d, m, &rm, &zero);
+
+        GATHER("vpgatherdq", "xmm", "xmm", 8, r, rm, *d, idx_d, *m);
+        ref_gather(&e, d, &idx_d, m, 8, 4, 0);
+        check("vpgatherdq", "xmm", d, m, &r, &e);
+        check("vpgatherdq mask", "xmm", d, m, &rm, &zero);
+        GATHER("vpgatherdq", "ymm", "xmm", 8, r, rm, *d, idx_d, *m);
+        ref_gather(&e, d, &idx_d, m, 8, 4, 1);
+        check("vpgatherdq", "ymm", d, m, &r, &e);
+        check("vpgatherdq mask", "ymm", d, m, &rm, &zero);
+
+        GATHER("vpgatherqd", "xmm", "xmm", 4, r, rm, *d, idx_q, *m);
+        ref_gather(&e, d, &idx_q, m, 4, 8, 0);
+        check("vpgatherqd", "xmm", d, m, &r, &e);
+        check("vpgatherqd mask", "xmm", d, m, &rm, &zero);
+        GATHER("vpgatherqd", "xmm", "ymm", 4, r, rm, *d, idx_q, *m);
+        ref_gather(&e, d, &idx_q, m, 4, 8, 1);
+        check("vpgatherqd", "ymm", d, m, &r, &e);
+        check("vpgatherqd mask", "ymm", d, m, &rm, &zero);
+
+        GATHER("vpgatherqq", "xmm", "xmm", 8, r, rm, *d, idx_q, *m);
+        ref_gather(&e, d, &idx_q, m, 8, 8, 0);
+        check("vpgatherqq", "xmm", d, m, &r, &e);
+        check("vpgatherqq mask", "xmm", d, m, &rm, &zero);
+        GATHER("vpgatherqq", "ymm", "ymm", 8, r, rm, *d, idx_q, *m);
+        ref_gather(&e, d, &idx_q, m, 8, 8, 1);
+        check("vpgatherqq", "ymm", d, m, &r, &e);
+        check("vpgatherqq mask", "ymm", d, m, &rm, &zero);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    init_inputs();
+    test_results();
+    test_upper();
+    test_insert();
+    test_fault();
+    test_gather();
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    return 0;
+}
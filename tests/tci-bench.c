@@ -0,0 +1,237 @@
+/*
+ * Time the TCG interpreter on a hand-encoded loop
+ *
+ * The loop is encoded the way the TCI backend emits it, and is run by
+ * tcg_qemu_tb_exec() from the tcg/tci.o of a linux-user target.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu/timer.h"
+#include "tcg-target.h"
+
+typedef enum TCGOpcode {
+#define DEF(name, oargs, iargs, cargs, flags) INDEX_op_ ## name,
+#include "tcg-opc.h"
+#undef DEF
+    NB_OPS,
+} TCGOpcode;
+
+/* TCG_COND_LTU; tcg/tcg.h needs the headers of a target */
+#define COND_LTU 4
+
+/* Only used by qemu_ld/qemu_st, which the loop does not have */
+unsigned long guest_base;
+
+static unsigned int n_iterations = 20 * 1000 * 1000;
+static unsigned int n_repeats = 5;
+static bool hoist;
+
+static uintptr_t code[64];
+static uint8_t *code_ptr;
+static unsigned int n_ops;
+
+static const char commands_string[] =
+    " -n = number of loop iterations\n"
+    " -r = number of runs, the best one is reported\n"
+    " -m = load the constants once, before the loop";
+
+static void usage_complete(char *argv[])
+{
+    fprintf(stderr, "Usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "options:\n%s\n", commands_string);
+}
+
+static TCIOp *out_op(TCGOpcode opc)
+{
+    TCIOp *op = (TCIOp *)code_ptr;
+
+    memset(op, 0, sizeof(*op));
+    op->opc = opc;
+    code_ptr += sizeof(*op);
+    return op;
+}
+
+static void out_i(uintptr_t v)
+{
+    memcpy(code_ptr, &v, sizeof(v));
+    code_ptr += sizeof(v);
+}
+
+static void out_end(TCIOp *op)
+{
+    op->size = code_ptr - (uint8_t *)op;
+    g_assert(code_ptr <= (uint8_t *)&code[ARRAY_SIZE(code)]);
+}
+
+static void out_ldst(TCGOpcode opc, int r, int base, intptr_t ofs)
+{
+    TCIOp *op = out_op(opc);
+
+    op->r[0] = r;
+    op->r[1] = base;
+    out_i(ofs);
+    out_end(op);
+}
+
+static void out_op3(TCGOpcode opc, int d, int a, int b)
+{
+    TCIOp *op = out_op(opc);
+
+    op->r[0] = d;
+    op->r[1] = a;
+    op->r[2] = b;
+    out_end(op);
+}
+
+static void out_movi(int r, uint64_t v)
+{
+    TCIOp *op = out_op(v == (uint32_t)v ? INDEX_op_movi_i32
+                                        : INDEX_op_movi_i64);
+
+    op->r[0] = r;
+    out_i(v);
+    out_end(op);
+}
+
+/* Registers 3 to 6 hold the constants */
+static const uint64_t consts[] = { 0x5a5a, 3, 1 };
+
+static void out_const(int i, bool in_loop)
+{
+    if (hoist != in_loop) {
+        out_movi(3 + i, i < ARRAY_SIZE(consts) ? consts[i] : n_iterations);
+        n_ops += in_loop;
+    }
+}
+
+/*
+ * do {
+ *     x = (env[1] + env[0]) ^ 0x5a5a;
+ *     env[1] = (x << 3) - x;
+ * } while (++env[0] < n);
+ */
+static void build_tb(void)
+{
+    uint8_t *loop;
+    TCIOp *op;
+    int i;
+
+    code_ptr = (uint8_t *)code;
+    n_ops = 0;
+    for (i = 0; i <= ARRAY_SIZE(consts); i++) {
+        out_const(i, false);
+    }
+
+    loop = code_ptr;
+    out_ldst(INDEX_op_ld_i64, 0, TCG_AREG0, 0);
+    out_ldst(INDEX_op_ld_i64, 1, TCG_AREG0, 8);
+    out_op3(INDEX_op_add_i64, 1, 1, 0);
+    out_const(0, true);
+    out_op3(INDEX_op_xor_i64, 1, 1, 3);
+    out_const(1, true);
+    out_op3(INDEX_op_shl_i64, 2, 1, 4);
+    out_op3(INDEX_op_sub_i64, 1, 2, 1);
+    out_ldst(INDEX_op_st_i64, 1, TCG_AREG0, 8);
+    out_const(2, true);
+    out_op3(INDEX_op_add_i64, 0, 0, 5);
+    out_ldst(INDEX_op_st_i64, 0, TCG_AREG0, 0);
+    out_const(3, true);
+    op = out_op(INDEX_op_brcond_i64);
+    op->r[0] = 0;
+    op->r[1] = 6;
+    op->r[2] = COND_LTU;
+    out_i((uintptr_t)loop);
+    out_end(op);
+    n_ops += 10;
+
+    op = out_op(INDEX_op_exit_tb);
+    out_i(0);
+    out_end(op);
+}
+
+static uint64_t expected_result(void)
+{
+    uint64_t x = 0, i;
+
+    for (i = 0; i < n_iterations; i++) {
+        x = (x + i) ^ consts[0];
+        x = (x << consts[1]) - x;
+    }
+    return x;
+}
+
+static int64_t run_test(uint64_t expected)
+{
+    uint64_t env[2] = { 0, 0 };
+    int64_t t;
+
+    t = get_clock();
+    tcg_qemu_tb_exec(env, (uint8_t *)code);
+    t = get_clock() - t;
+
+    g_assert(env[0] == n_iterations);
+    g_assert(env[1] == expected);
+    return t;
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    int c;
+
+    for (;;) {
+        c = getopt(argc, argv, "hmn:r:");
+        if (c < 0) {
+            break;
+        }
+        switch (c) {
+        case 'h':
+            usage_complete(argv);
+            exit(0);
+        case 'm':
+            hoist = true;
+            break;
+        case 'n':
+            n_iterations = atoi(optarg);
+            break;
+        case 'r':
+            n_repeats = atoi(optarg);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t expected;
+    int64_t best = INT64_MAX;
+    unsigned int i;
+
+    if (TCG_TARGET_REG_BITS != 64) {
+        fprintf(stderr, "%s: the loop needs a 64-bit host\n", argv[0]);
+        return 0;
+    }
+    parse_args(argc, argv);
+    if (!n_iterations || !n_repeats) {
+        usage_complete(argv);
+        return 1;
+    }
+    build_tb();
+    expected = expected_result();
+
+    for (i = 0; i < n_repeats; i++) {
+        best = MIN(best, run_test(expected));
+    }
+
+    printf("Parameters:\n");
+    printf(" # of iterations:    %u\n", n_iterations);
+    printf(" # of runs:          %u\n", n_repeats);
+    printf(" constants:          %s\n",
+           hoist ? "before the loop" : "in the loop");
+    printf(" ops per iteration:  %u\n", n_ops);
+    printf("Results (best run):\n");
+    printf(" ns/iteration:       %.2f\n", (double)best / n_iterations);
+    printf(" ns/op:              %.2f\n", (double)best / n_iterations / n_ops);
+    return 0;
+}
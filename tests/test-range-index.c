@@ -0,0 +1,233 @@
+/*
+ * RangeIndex unit tests
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu/atomic.h"
+#include "qemu/rcu.h"
+#include "qemu/thread.h"
+#include "qemu/range-index.h"
+
+#define N_RANGES 64
+#define RANGE_SIZE 0x1000
+#define RANGE_STRIDE 0x3000
+
+static int values[N_RANGES];
+
+static uint64_t range_start(int i)
+{
+    return RANGE_STRIDE * i;
+}
+
+static void *lookup(RangeIndex *ri, uint64_t addr)
+{
+    void *p;
+
+    rcu_read_lock();
+    p = range_index_lookup(ri, addr);
+    rcu_read_unlock();
+    return p;
+}
+
+/* Check that range @i maps to its value, and its neighbourhood to nothing */
+static void check_range(RangeIndex *ri, int i, bool present)
+{
+    uint64_t start = range_start(i);
+    void *expected = present ? &values[i] : NULL;
+
+    g_assert(lookup(ri, start) == expected);
+    g_assert(lookup(ri, start + RANGE_SIZE / 2) == expected);
+    g_assert(lookup(ri, start + RANGE_SIZE - 1) == expected);
+    g_assert(lookup(ri, start + RANGE_SIZE) == NULL);
+    if (start) {
+        g_assert(lookup(ri, start - 1) == NULL);
+    }
+}
+
+static void test_empty(void)
+{
+    RangeIndex ri = { };
+
+    g_assert(lookup(&ri, 0) == NULL);
+    g_assert(lookup(&ri, UINT64_MAX) == NULL);
+    range_index_destroy(&ri);
+}
+
+static void test_insert(void)
+{
+    RangeIndex ri = { };
+    int i;
+
+    /* Insert out of order, so that entries move within the array */
+    for (i = 0; i < N_RANGES; i += 2) {
+        g_assert_true(range_index_insert(&ri, range_start(i), RANGE_SIZE,
+                                         &values[i]));
+    }
+    for (i = N_RANGES - 1; i > 0; i -= 2) {
+        g_assert_true(range_index_insert(&ri, range_start(i), RANGE_SIZE,
+                                         &values[i]));
+    }
+    for (i = 0; i < N_RANGES; i++) {
+        check_range(&ri, i, true);
+    }
+    g_assert(lookup(&ri, range_start(N_RANGES)) == NULL);
+    g_assert(lookup(&ri, UINT64_MAX) == NULL);
+    range_index_destroy(&ri);
+}
+
+static void test_insert_limits(void)
+{
+    RangeIndex ri = { };
+    int a, b;
+
+    /* A range may end at the very end of the address space */
+    g_assert_true(range_index_insert(&ri, UINT64_MAX - RANGE_SIZE + 1,
+                                     RANGE_SIZE, &a));
+    g_assert_true(range_index_insert(&ri, 0, 1, &b));
+    g_assert(lookup(&ri, UINT64_MAX) == &a);
+    g_assert(lookup(&ri, UINT64_MAX - RANGE_SIZE) == NULL);
+    g_assert(lookup(&ri, 0) == &b);
+    g_assert(lookup(&ri, 1) == NULL);
+    range_index_destroy(&ri);
+}
+
+static void test_overlap(void)
+{
+    RangeIndex ri = { };
+    uint64_t start = range_start(1);
+    int other;
+
+    g_assert_true(range_index_insert(&ri, start, RANGE_SIZE, &values[1]));
+
+    /* Same range, contained, containing, and overlapping either end */
+    g_assert_false(range_index_insert(&ri, start, RANGE_SIZE, &other));
+    g_assert_false(range_index_insert(&ri, start + 1, 1, &other));
+    g_assert_false(range_index_insert(&ri, start - 1, RANGE_SIZE + 2,
+                                      &other));
+    g_assert_false(range_index_insert(&ri, start - 1, 2, &other));
+    g_assert_false(range_index_insert(&ri, start + RANGE_SIZE - 1, 2,
+                                      &other));
+
+    /* A failed insertion leaves the index unchanged */
+    check_range(&ri, 1, true);
+
+    /* Adjacent ranges do not overlap */
+    g_assert_true(range_index_insert(&ri, start - 1, 1, &other));
+    g_assert_true(range_index_insert(&ri, start + RANGE_SIZE, 1, &other));
+    g_assert(lookup(&ri, start - 1) == &other);
+    g_assert(lookup(&ri, start) == &values[1]);
+    g_assert(lookup(&ri, start + RANGE_SIZE - 1) == &values[1]);
+    g_assert(lookup(&ri, start + RANGE_SIZE) == &other);
+    range_index_destroy(&ri);
+}
+
+static void test_remove(void)
+{
+    RangeIndex ri = { };
+    int i;
+
+    for (i = 0; i < N_RANGES; i++) {
+        g_assert_true(range_index_insert(&ri, range_start(i), RANGE_SIZE,
+                                         &values[i]));
+    }
+    for (i = 0; i < N_RANGES; i += 3) {
+        range_index_remove(&ri, range_start(i));
+    }
+    for (i = 0; i < N_RANGES; i++) {
+        check_range(&ri, i, i % 3 != 0);
+    }
+
+    /* The space of a removed range can be reused */
+    g_assert_true(range_index_insert(&ri, range_start(0), RANGE_SIZE,
+                                     &values[0]));
+    check_range(&ri, 0, true);
+
+    for (i = 0; i < N_RANGES; i++) {
+        if (i == 0 || i % 3 != 0) {
+            range_index_remove(&ri, range_start(i));
+        }
+    }
+    for (i = 0; i < N_RANGES; i++) {
+        check_range(&ri, i, false);
+    }
+    range_index_destroy(&ri);
+}
+
+/*
+ * A reader looks up the even ranges, which are always present, and the
+ * odd ones, which the updater keeps inserting and removing.  It must
+ * never see a stable range missing or a wrong value, whatever table it
+ * is reading while the updater publishes new ones.
+ */
+static RangeIndex rcu_ri;
+static bool rcu_stop;
+static unsigned long rcu_lookups;
+
+static void *rcu_reader(void *opaque)
+{
+    unsigned long n = 0;
+
+    rcu_register_thread();
+    while (!atomic_read(&rcu_stop)) {
+        int i = n % N_RANGES;
+        void *p;
+
+        rcu_read_lock();
+        p = range_index_lookup(&rcu_ri, range_start(i) + RANGE_SIZE / 2);
+        if (i % 2) {
+            g_assert(p == NULL || p == &values[i]);
+        } else {
+            g_assert(p == &values[i]);
+        }
+        g_assert(range_index_lookup(&rcu_ri,
+                                    range_start(i) + RANGE_SIZE) == NULL);
+        rcu_read_unlock();
+        atomic_set(&rcu_lookups, ++n);
+    }
+    rcu_unregister_thread();
+    return NULL;
+}
+
+static void test_rcu_update(void)
+{
+    QemuThread thread;
+    int i, round;
+
+    for (i = 0; i < N_RANGES; i += 2) {
+        g_assert_true(range_index_insert(&rcu_ri, range_start(i), RANGE_SIZE,
+                                         &values[i]));
+    }
+
+    qemu_thread_create(&thread, "reader", rcu_reader, NULL,
+                       QEMU_THREAD_JOINABLE);
+    /* Make sure that the reader overlaps with many updates */
+    for (round = 0; round < 100 || atomic_read(&rcu_lookups) < 10000;
+         round++) {
+        for (i = 1; i < N_RANGES; i += 2) {
+            g_assert_true(range_index_insert(&rcu_ri, range_start(i),
+                                             RANGE_SIZE, &values[i]));
+        }
+        for (i = 1; i < N_RANGES; i += 2) {
+            range_index_remove(&rcu_ri, range_start(i));
+        }
+    }
+    atomic_set(&rcu_stop, true);
+    qemu_thread_join(&thread);
+
+    /* The reader is gone, so the current table can be freed directly */
+    range_index_destroy(&rcu_ri);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/range-index/empty", test_empty);
+    g_test_add_func("/range-index/insert", test_insert);
+    g_test_add_func("/range-index/insert-limits", test_insert_limits);
+    g_test_add_func("/range-index/overlap", test_overlap);
+    g_test_add_func("/range-index/remove", test_remove);
+    g_test_add_func("/range-index/rcu-update", test_rcu_update);
+    return g_test_run();
+}
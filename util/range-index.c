@@ -0,0 +1,122 @@
+/*
+ * RCU-safe index of disjoint ranges
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/atomic.h"
+#include "qemu/rcu.h"
+#include "qemu/range-index.h"
+
+typedef struct RangeIndexEntry {
+    uint64_t start;
+    uint64_t size;
+    void *opaque;
+} RangeIndexEntry;
+
+struct RangeIndexTable {
+    struct rcu_head rcu;
+    unsigned nr;
+    RangeIndexEntry entries[];
+};
+
+static RangeIndexTable *range_index_table_new(unsigned nr)
+{
+    RangeIndexTable *table;
+
+    table = g_malloc(sizeof(*table) + nr * sizeof(table->entries[0]));
+    table->nr = nr;
+    return table;
+}
+
+static void range_index_publish(RangeIndex *ri, RangeIndexTable *table)
+{
+    RangeIndexTable *old = ri->table;
+
+    atomic_rcu_set(&ri->table, table);
+    if (old) {
+        g_free_rcu(old, rcu);
+    }
+}
+
+/* Return the index of the first entry that ends at or after @addr */
+static unsigned range_index_search(RangeIndexTable *table, uint64_t addr)
+{
+    unsigned lo = 0, hi = table ? table->nr : 0;
+
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+        RangeIndexEntry *e = &table->entries[mid];
+
+        if (addr - e->start < e->size || addr < e->start) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+void range_index_destroy(RangeIndex *ri)
+{
+    g_free(ri->table);
+    ri->table = NULL;
+}
+
+bool range_index_insert(RangeIndex *ri, uint64_t start, uint64_t size,
+                        void *opaque)
+{
+    RangeIndexTable *old = ri->table;
+    unsigned nr = old ? old->nr : 0;
+    unsigned pos = range_index_search(old, start);
+    RangeIndexTable *table;
+
+    assert(size);
+    assert(start + size - 1 >= start);
+    if (pos < nr && old->entries[pos].start <= start + size - 1) {
+        return false;
+    }
+
+    table = range_index_table_new(nr + 1);
+    if (old) {
+        memcpy(table->entries, old->entries, pos * sizeof(old->entries[0]));
+        memcpy(table->entries + pos + 1, old->entries + pos,
+               (nr - pos) * sizeof(old->entries[0]));
+    }
+    table->entries[pos] = (RangeIndexEntry) {
+        .start = start,
+        .size = size,
+        .opaque = opaque,
+    };
+    range_index_publish(ri, table);
+    return true;
+}
+
+void range_index_remove(RangeIndex *ri, uint64_t start)
+{
+    RangeIndexTable *old = ri->table;
+    RangeIndexTable *table;
+    unsigned pos = range_index_search(old, start);
+
+    assert(old && pos < old->nr && old->entries[pos].start == start);
+
+    table = range_index_table_new(old->nr - 1);
+    memcpy(table->entries, old->entries, pos * sizeof(old->entries[0]));
+    memcpy(table->entries + pos, old->entries + pos + 1,
+           (old->nr - pos - 1) * sizeof(old->entries[0]));
+    range_index_publish(ri, table);
+}
+
+void *range_index_lookup(RangeIndex *ri, uint64_t addr)
+{
+    RangeIndexTable *table = atomic_rcu_read(&ri->table);
+    unsigned pos = range_index_search(table, addr);
+
+    if (table && pos < table->nr &&
+        addr - table->entries[pos].start < table->entries[pos].size) {
+        return table->entries[pos].opaque;
+    }
+    return NULL;
+}
@@ -312,6 +312,52 @@ static QemuOptsList qemu_accel_opts = {
             .type = QEMU_OPT_STRING,
             .help = "Enable/disable multi-threaded TCG",
         },
+        {
+            .name = "perfmap",
+            .type = QEMU_OPT_BOOL,
+            .help = "Write a perf map of the translated code",
+        },
+        {
+            .name = "jitdump",
+            .type = QEMU_OPT_BOOL,
+            .help = "Write a perf jitdump of the translated code",
+        },
+        {
+            .name = "superblocks",
+            .type = QEMU_OPT_BOOL,
+            .help = "Retranslate hot code as superblocks",
+        },
+        {
+            .name = "return-stack",
+            .type = QEMU_OPT_BOOL,
+            .help = "Predict guest returns with a return address stack",
+        },
+        {
+            .name = "atomic-locks",
+            .type = QEMU_OPT_BOOL,
+            .help = "Emulate unaligned atomics with address locks",
+        },
+        {
+            .name = "fastmem",
+            .type = QEMU_OPT_BOOL,
+            .help = "Access guest RAM through host mappings of the guest "
+                    "address space",
+        },
+        {
+            .name = "halt-poll-max-ns",
+            .type = QEMU_OPT_NUMBER,
+            .help = "Maximum time an idle vCPU polls before halting",
+        },
+        {
+            .name = "halt-poll-grow",
+            .type = QEMU_OPT_NUMBER,
+            .help = "Factor by which the halt polling time grows",
+        },
+        {
+            .name = "halt-poll-shrink",
+            .type = QEMU_OPT_NUMBER,
+            .help = "Factor by which the halt polling time shrinks",
+        },
         { /* end of list */ }
     },
 };